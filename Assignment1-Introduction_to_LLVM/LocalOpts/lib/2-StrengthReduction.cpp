@@ -1,113 +1,606 @@
-#include "llvm/IR/IRBuilder.h"
-#include <llvm-12/llvm/IR/Constants.h>
-#include <llvm-12/llvm/IR/InstrTypes.h>
-#include <llvm-12/llvm/IR/Instruction.h>
-#include <llvm-12/llvm/Support/Casting.h>
-#include <llvm/IR/Module.h>
+#include <llvm/IR/PatternMatch.h>
 #include <llvm/Pass.h>
-#include <vector>
+#include <llvm/Support/CommandLine.h>
+#include <llvm/Support/MathExtras.h>
 
-using namespace llvm;
+#include <algorithm>
+#include <tuple>
 
-// returns the power value if power of 2, else returns 0
-int isPowerofTwo(int n) {
-  if (n == 0)
-    return 0;
+#include "PeepholeEngine.h"
 
-  int power = 0;
-  while (n != 1) {
-    if (n % 2 != 0)
-      return 0;
-    power++;
-    n = n / 2;
-  }
+using namespace llvm::PatternMatch;
+
+// The latencies (in cycles) of the integer instructions on 64-bit operands,
+// by default those of x86-64. Wider operands are split into 64-bit parts, at
+// a cost linear in the number of parts, except for the multiplications whose
+// cost is quadratic.
+static cl::opt<unsigned> MulLatency("mul-latency", cl::init(3),
+                                    cl::desc("Latency of a multiplication"));
+static cl::opt<unsigned>
+    VectorMulLatency("vector-mul-latency", cl::init(10),
+                     cl::desc("Latency of a vector multiplication"));
+static cl::opt<unsigned> ShiftLatency("shift-latency", cl::init(1),
+                                      cl::desc("Latency of a shift"));
+static cl::opt<unsigned>
+    AddLatency("add-latency", cl::init(1),
+               cl::desc("Latency of an addition or a subtraction"));
+static cl::opt<unsigned> MulDecompositionMaxInsts(
+    "mul-decomposition-max-insts", cl::init(4),
+    cl::desc("Maximum number of instructions that a multiplication by a "
+             "constant may be decomposed into"));
 
-  return power;
+void printMulCostModel(raw_ostream &Outs) {
+  Outs << "Multiplication Cost Model: mul=" << MulLatency
+       << ", vector-mul=" << VectorMulLatency << ", shift=" << ShiftLatency
+       << ", add=" << AddLatency << ", max-insts=" << MulDecompositionMaxInsts
+       << "\n";
 }
 
 namespace {
 
-class StrengthReduction final : public FunctionPass {
-public:
-  static char ID;
+/**
+ * @brief Collect the values of the lanes of the integer constant @c C , or
+ *        the value of @c C itself if it is a scalar.
+ * @return false if some lane is not a constant integer, e.g., undef
+ */
+bool getLanes(const Constant &C, SmallVectorImpl<APInt> &Lanes) {
+  if (const ConstantInt *const CI = dyn_cast<ConstantInt>(&C)) {
+    Lanes.push_back(CI->getValue());
+    return true;
+  }
+  const FixedVectorType *const VecTy = dyn_cast<FixedVectorType>(C.getType());
+  if (!VecTy) {
+    return false;
+  }
+  for (unsigned LaneIdx = 0; LaneIdx < VecTy->getNumElements(); ++LaneIdx) {
+    const ConstantInt *const Lane =
+        dyn_cast_or_null<ConstantInt>(C.getAggregateElement(LaneIdx));
+    if (!Lane) {
+      return false;
+    }
+    Lanes.push_back(Lane->getValue());
+  }
+  return true;
+}
 
-  StrengthReduction() : FunctionPass(ID) {}
+/**
+ * @brief Return the constant of type @c Ty whose lanes are @c Lanes .
+ */
+Constant *getConstant(Type *const Ty, ArrayRef<APInt> Lanes) {
+  if (!Ty->isVectorTy()) {
+    return ConstantInt::get(Ty, Lanes.front());
+  }
+  SmallVector<Constant *, 8> LaneConstants;
+  for (const APInt &Lane : Lanes) {
+    LaneConstants.push_back(ConstantInt::get(Ty->getScalarType(), Lane));
+  }
+  return ConstantVector::get(LaneConstants);
+}
 
-  virtual void getAnalysisUsage(AnalysisUsage &AU) const override {}
+/**
+ * @brief Return the constant whose lanes are the base-2 logarithms of those
+ *        of @c C , or nullptr if they are not all powers of 2.
+ */
+Constant *getLogBase2(const Constant &C) {
+  SmallVector<APInt, 4> Lanes;
+  if (!getLanes(C, Lanes)) {
+    return nullptr;
+  }
+  for (APInt &Lane : Lanes) {
+    if (!Lane.isPowerOf2()) {
+      return nullptr;
+    }
+    Lane = APInt(Lane.getBitWidth(), Lane.logBase2());
+  }
+  return getConstant(C.getType(), Lanes);
+}
 
-  void removeDeadCode(const std::vector<Instruction *> &deadInstructions) {
-    for (auto &deadInst : deadInstructions) {
-      if (deadInst->isSafeToRemove()) {
-        deadInst->eraseFromParent();
-      }
+/**
+ * @brief The magic number to divide by a constant with, as in Granlund and
+ *        Montgomery, "Division by Invariant Integers using Multiplication",
+ *        and Hacker's Delight, Chapter 10.
+ */
+struct MagicNumber {
+  APInt Multiplier;
+  unsigned Shift;
+  // (Unsigned Division Only) Whether the multiplier has one more bit than the
+  // dividend, whose contribution is then added separately.
+  bool IsAdd;
+};
+
+/**
+ * @brief Return the magic number of the signed division by @c D , where
+ *        @c D is neither 0, 1 nor -1.
+ */
+MagicNumber getSignedMagic(const APInt &D) {
+  const unsigned BitWidth = D.getBitWidth();
+  const APInt SignedMin = APInt::getSignedMinValue(BitWidth);
+  const APInt AbsD = D.abs();
+  const APInt T = SignedMin + D.lshr(BitWidth - 1);
+  // |nc|, the largest value such that nc mod |d| = |d| - 1
+  const APInt AbsNC = T - 1 - T.urem(AbsD);
+  unsigned P = BitWidth - 1;
+  // 2^P / |nc| and 2^P / |d|, with their remainders
+  APInt Q1 = SignedMin.udiv(AbsNC), R1 = SignedMin - Q1 * AbsNC;
+  APInt Q2 = SignedMin.udiv(AbsD), R2 = SignedMin - Q2 * AbsD;
+  APInt Delta;
+  do {
+    ++P;
+    Q1 <<= 1;
+    R1 <<= 1;
+    if (R1.uge(AbsNC)) {
+      ++Q1;
+      R1 -= AbsNC;
+    }
+    Q2 <<= 1;
+    R2 <<= 1;
+    if (R2.uge(AbsD)) {
+      ++Q2;
+      R2 -= AbsD;
     }
+    Delta = AbsD - R2;
+  } while (Q1.ult(Delta) || (Q1 == Delta && R1.isNullValue()));
+
+  APInt Multiplier = Q2 + 1;
+  if (D.isNegative()) {
+    Multiplier.negate();
   }
+  return {Multiplier, P - BitWidth, false};
+}
 
-  virtual bool runOnFunction(Function &F) override {
-    std::vector<Instruction *> deadInstructionList;
-    bool deadCodePresent = false;
-    for (auto &B : F) {
-      for (auto &I : B) {
-        if (auto *op = dyn_cast<BinaryOperator>(&I)) {
-          Value *lhs = op->getOperand(0);
-          Value *rhs = op->getOperand(1);
-          switch (op->getOpcode()) {
-          case Instruction::Mul: {
-            if (auto *constOperand0 = dyn_cast<ConstantInt>(lhs)) {
-              // 8 * x
-              int power = isPowerofTwo(constOperand0->getSExtValue());
-              if (power > 0) {
-                // Insert at the point "before" where the instruction `op`
-                // appears.
-                // https://llvm.org/docs/ProgrammersManual.html#creating-and-inserting-new-instructions
-                IRBuilder<> builder(op);
-                Value *newLeftShiftInst = builder.CreateLShr(rhs, power);
-                I.replaceAllUsesWith(newLeftShiftInst);
-                deadCodePresent = true;
-                deadInstructionList.push_back(&I);
-              }
-            } else if (auto *constOperand1 = dyn_cast<ConstantInt>(rhs)) {
-              // x * 8
-              int power = isPowerofTwo(constOperand1->getSExtValue());
-              if (power > 0) {
-                IRBuilder<> builder(op);
-                Value *newLeftShiftInst = builder.CreateLShr(lhs, power);
-                I.replaceAllUsesWith(newLeftShiftInst);
-                deadCodePresent = true;
-                deadInstructionList.push_back(&I);
-              }
-            }
-            break;
-          }
-          case Instruction::SDiv: {
-            if (auto *constOperand1 = dyn_cast<ConstantInt>(rhs)) {
-              int power = isPowerofTwo(constOperand1->getSExtValue());
-              if (power > 0) {
-                IRBuilder<> builder(op);
-                Value *newRightShiftInst = builder.CreateAShr(lhs, power);
-                I.replaceAllUsesWith(newRightShiftInst);
-                deadCodePresent = true;
-                deadInstructionList.push_back(&I);
-              }
-            }
-            break;
-          }
-          default: {
-            break;
-          }
-          }
-        }
+/**
+ * @brief Return the magic number of the unsigned division by @c D , where
+ *        @c D is neither 0 nor a power of 2.
+ */
+MagicNumber getUnsignedMagic(const APInt &D) {
+  const unsigned BitWidth = D.getBitWidth();
+  const APInt AllOnes = APInt::getAllOnesValue(BitWidth),
+              SignedMin = APInt::getSignedMinValue(BitWidth),
+              SignedMax = APInt::getSignedMaxValue(BitWidth);
+  // nc, the largest value such that nc mod d = d - 1
+  const APInt NC = AllOnes - (AllOnes - D).urem(D);
+  unsigned P = BitWidth - 1;
+  // 2^P / nc and (2^P - 1) / d, with their remainders
+  APInt Q1 = SignedMin.udiv(NC), R1 = SignedMin - Q1 * NC;
+  APInt Q2 = SignedMax.udiv(D), R2 = SignedMax - Q2 * D;
+  APInt Delta;
+  bool IsAdd = false;
+  do {
+    ++P;
+    if (R1.uge(NC - R1)) {
+      Q1 = Q1 + Q1 + 1;
+      R1 = R1 + R1 - NC;
+    } else {
+      Q1 = Q1 + Q1;
+      R1 = R1 + R1;
+    }
+    if ((R2 + 1).uge(D - R2)) {
+      IsAdd |= Q2.uge(SignedMax);
+      Q2 = Q2 + Q2 + 1;
+      R2 = R2 + R2 + 1 - D;
+    } else {
+      IsAdd |= Q2.uge(SignedMin);
+      Q2 = Q2 + Q2;
+      R2 = R2 + R2 + 1;
+    }
+    Delta = D - 1 - R2;
+  } while (P < 2 * BitWidth &&
+           (Q1.ult(Delta) || (Q1 == Delta && R1.isNullValue())));
+  return {Q2 + 1, P - BitWidth, IsAdd};
+}
+
+/**
+ * @brief Return the inverse of the odd number @c D modulo 2^BitWidth .
+ */
+APInt getMultiplicativeInverse(const APInt &D) {
+  // Newton's iteration, which doubles the number of correct low bits each
+  // time, starting from the 3 bits where every odd number is its own inverse.
+  APInt Inverse = D;
+  while (D * Inverse != 1) {
+    Inverse *= 2 - D * Inverse;
+  }
+  return Inverse;
+}
+
+/**
+ * @brief Create the high half of the product of @c X and @c C , computed in
+ *        twice the bit width.
+ */
+Value *createMulHigh(IRBuilderBase &Builder, Value *const X, const APInt &C,
+                     const bool IsSigned) {
+  Type *const Ty = X->getType();
+  Type *const WideTy = Ty->getExtendedType();
+  const unsigned BitWidth = C.getBitWidth();
+  Value *const WideX =
+      IsSigned ? Builder.CreateSExt(X, WideTy) : Builder.CreateZExt(X, WideTy);
+  const APInt WideC = IsSigned ? C.sext(2 * BitWidth) : C.zext(2 * BitWidth);
+  Value *const Product =
+      Builder.CreateMul(WideX, ConstantInt::get(WideTy, WideC));
+  return Builder.CreateTrunc(Builder.CreateLShr(Product, BitWidth), Ty);
+}
+
+/**
+ * @brief Create x / d for the signed division by the constant @c D , which
+ *        is neither 0 nor 1.
+ */
+Value *createSDiv(IRBuilderBase &Builder, Value *const X, const APInt &D,
+                  const bool IsExact) {
+  Type *const Ty = X->getType();
+  const unsigned BitWidth = D.getBitWidth();
+  if (D.isAllOnesValue()) {
+    return Builder.CreateNeg(X);
+  }
+  if (D.isMinSignedValue()) {
+    return Builder.CreateZExt(Builder.CreateICmpEQ(X, ConstantInt::get(Ty, D)),
+                              Ty);
+  }
+  const APInt AbsD = D.abs();
+  Value *Quotient;
+  if (IsExact) {
+    // x / d = (x >> k) * (d / 2^k)^-1 , where 2^k is the largest power of 2
+    // that divides d, as x is a multiple of d.
+    const unsigned K = AbsD.countTrailingZeros();
+    Quotient = K != 0 ? Builder.CreateAShr(X, K, "", /*isExact=*/true) : X;
+    if (!AbsD.isPowerOf2()) {
+      Quotient = Builder.CreateMul(
+          Quotient,
+          ConstantInt::get(Ty, getMultiplicativeInverse(AbsD.lshr(K))));
+    }
+  } else if (AbsD.isPowerOf2()) {
+    // x / 2^k = (x + (x < 0 ? 2^k - 1 : 0)) >> k
+    //
+    // The arithmetic shift alone rounds towards negative infinity, while the
+    // division rounds towards zero, hence negative dividends are biased
+    // first.
+    const unsigned K = AbsD.logBase2();
+    Value *const Sign = K > 1 ? Builder.CreateAShr(X, K - 1) : X;
+    Value *const Bias = Builder.CreateLShr(Sign, BitWidth - K);
+    Quotient = Builder.CreateAShr(Builder.CreateAdd(X, Bias), K);
+  } else {
+    // x / d = mulhs(x, m) >> s, plus one if negative, where m is scaled to
+    // be within the bit width, hence might have the wrong sign, in which case
+    // x gets added (subtracted) to make up for it.
+    const MagicNumber Magic = getSignedMagic(D);
+    Quotient = createMulHigh(Builder, X, Magic.Multiplier, /*IsSigned=*/true);
+    if (D.isStrictlyPositive() && Magic.Multiplier.isNegative()) {
+      Quotient = Builder.CreateAdd(Quotient, X);
+    } else if (D.isNegative() && Magic.Multiplier.isStrictlyPositive()) {
+      Quotient = Builder.CreateSub(Quotient, X);
+    }
+    if (Magic.Shift != 0) {
+      Quotient = Builder.CreateAShr(Quotient, Magic.Shift);
+    }
+    return Builder.CreateAdd(Quotient,
+                             Builder.CreateLShr(Quotient, BitWidth - 1));
+  }
+  return D.isNegative() ? Builder.CreateNeg(Quotient) : Quotient;
+}
+
+/**
+ * @brief Create x / d for the unsigned division by the constant @c D , which
+ *        is neither 0 nor 1.
+ */
+Value *createUDiv(IRBuilderBase &Builder, Value *const X, const APInt &D,
+                  const bool IsExact) {
+  Type *const Ty = X->getType();
+  if (D.isPowerOf2()) {
+    return Builder.CreateLShr(X, D.logBase2(), "", IsExact);
+  }
+  if (IsExact) {
+    const unsigned K = D.countTrailingZeros();
+    Value *const Shifted =
+        K != 0 ? Builder.CreateLShr(X, K, "", /*isExact=*/true) : X;
+    return Builder.CreateMul(
+        Shifted, ConstantInt::get(Ty, getMultiplicativeInverse(D.lshr(K))));
+  }
+  if (D.isNegative()) {
+    // The quotient is either 0 or 1.
+    return Builder.CreateZExt(Builder.CreateICmpUGE(X, ConstantInt::get(Ty, D)),
+                              Ty);
+  }
+  // x / d = mulhu(x, m) >> s, where m might need one more bit than x, in
+  // which case x gets added to the high half of the product, halved first so
+  // as not to overflow.
+  const MagicNumber Magic = getUnsignedMagic(D);
+  Value *const Quotient =
+      createMulHigh(Builder, X, Magic.Multiplier, /*IsSigned=*/false);
+  if (!Magic.IsAdd) {
+    return Magic.Shift != 0 ? Builder.CreateLShr(Quotient, Magic.Shift)
+                            : Quotient;
+  }
+  Value *const Sum = Builder.CreateAdd(
+      Builder.CreateLShr(Builder.CreateSub(X, Quotient), 1), Quotient);
+  return Builder.CreateLShr(Sum, Magic.Shift - 1);
+}
+
+/**
+ * @brief The decomposition of x * c into shifts, additions and subtractions.
+ *
+ * The terms x << k come from the non-adjacent form of c, i.e., its signed
+ * binary digits, no two consecutive ones of which are nonzero, so that there
+ * are as few terms as possible. They are summed up pairwise, as a balanced
+ * tree, to shorten the critical path. Optionally, the trailing zeros of c are
+ * factored out into a final shift, which saves one shift per term at the
+ * expense of the critical path.
+ */
+class MulDecomposition {
+private:
+  struct Term {
+    Value *V;
+    bool IsNegative;
+    unsigned Latency;
+  };
+
+  IRBuilderBase *const Builder;
+  const unsigned ShiftCost, AddCost;
+  unsigned NumInsts = 0;
+  Term Result;
+
+  Term combine(const Term &A, const Term &B) {
+    ++NumInsts;
+    Value *V = nullptr;
+    if (Builder) {
+      V = A.IsNegative == B.IsNegative
+              ? Builder->CreateAdd(A.V, B.V)
+              : (A.IsNegative ? Builder->CreateSub(B.V, A.V)
+                              : Builder->CreateSub(A.V, B.V));
+    }
+    return {V, A.IsNegative && B.IsNegative,
+            std::max(A.Latency, B.Latency) + AddCost};
+  }
+
+public:
+  /**
+   * @brief Decompose @c X * @c C , but only estimate the cost of doing so if
+   *        @c Builder is null.
+   */
+  MulDecomposition(IRBuilderBase *const Builder, Value *const X,
+                   const APInt &C, const bool FactorTrailingZeros)
+      : Builder(Builder),
+        ShiftCost(ShiftLatency * divideCeil(C.getBitWidth(), 64)),
+        AddCost(AddLatency * divideCeil(C.getBitWidth(), 64)) {
+    const unsigned BitWidth = C.getBitWidth();
+    const unsigned NumTrailingZeros =
+        FactorTrailingZeros ? C.countTrailingZeros() : 0;
+    APInt Multiplier = C.ashr(NumTrailingZeros);
+    const bool IsNegative = Multiplier.isNegative();
+    if (IsNegative) {
+      Multiplier.negate();
+    }
+
+    std::vector<Term> Terms;
+    APInt Remaining = Multiplier.zext(BitWidth + 1);
+    for (unsigned K = 0; !Remaining.isNullValue();
+         ++K, Remaining.lshrInPlace(1)) {
+      if (!Remaining[0]) {
+        continue;
+      }
+      // The digit is 1 if the remaining value is 1 modulo 4, and -1 if it is
+      // 3, so that the next one is 0.
+      const bool IsDigitNegative = Remaining[1];
+      if (IsDigitNegative) {
+        ++Remaining;
+      } else {
+        --Remaining;
+      }
+      NumInsts += K != 0;
+      Terms.push_back({Builder && K != 0 ? Builder->CreateShl(X, K) : X,
+                       IsDigitNegative != IsNegative, K != 0 ? ShiftCost : 0});
+    }
+    while (Terms.size() > 1) {
+      std::vector<Term> Combined;
+      for (unsigned TermIdx = 0; TermIdx + 1 < Terms.size(); TermIdx += 2) {
+        Combined.push_back(combine(Terms[TermIdx], Terms[TermIdx + 1]));
+      }
+      if (Terms.size() % 2 == 1) {
+        Combined.push_back(Terms.back());
       }
+      Terms = std::move(Combined);
     }
 
-    if (deadCodePresent) {
-      removeDeadCode(deadInstructionList);
-      // Code modified
-      return true;
+    Result = Terms.front();
+    if (Result.IsNegative) {
+      ++NumInsts;
+      Result = {Builder ? Builder->CreateNeg(Result.V) : nullptr, false,
+                Result.Latency + AddCost};
     }
+    if (NumTrailingZeros != 0) {
+      ++NumInsts;
+      Result = {Builder ? Builder->CreateShl(Result.V, NumTrailingZeros)
+                        : nullptr,
+                false, Result.Latency + ShiftCost};
+    }
+  }
+
+  Value *getValue() const { return Result.V; }
+  unsigned getLatency() const { return Result.Latency; }
+  unsigned getNumInsts() const { return NumInsts; }
+};
+
+} // anonymous namespace
+
+const std::vector<PeepholeRule> &getStrengthReductionRules() {
+  static const std::vector<PeepholeRule> Rules = {
+      {"mul-pow2",
+       [](Instruction &Inst, IRBuilderBase &Builder) -> Value * {
+         // x * 2^k, 2^k * x → x << k
+         Value *X;
+         Constant *C;
+         if (!match(&Inst, m_c_Mul(m_Value(X), m_Constant(C))) ||
+             match(C, m_One())) {
+           return nullptr;
+         }
+         Constant *const Log2 = getLogBase2(*C);
+         return Log2 ? Builder.CreateShl(X, Log2) : nullptr;
+       }},
+      {"mul-decompose",
+       [](Instruction &Inst, IRBuilderBase &Builder) -> Value * {
+         // x * c → Σ ±(x << k), if cheaper than the multiplication
+         Value *X;
+         const APInt *C;
+         if (!match(&Inst, m_c_Mul(m_Value(X), m_APInt(C))) ||
+             C->isNullValue() || C->isPowerOf2()) {
+           return nullptr;
+         }
+         const unsigned NumParts = divideCeil(C->getBitWidth(), 64),
+                        MulCost = Inst.getType()->isVectorTy()
+                                      ? VectorMulLatency
+                                      : MulLatency * NumParts * NumParts;
+         const MulDecomposition Plain(nullptr, X, *C,
+                                      /*FactorTrailingZeros=*/false),
+             Factored(nullptr, X, *C, /*FactorTrailingZeros=*/true);
+         const bool IsFactoredBetter =
+             std::make_tuple(Factored.getLatency(), Factored.getNumInsts()) <
+             std::make_tuple(Plain.getLatency(), Plain.getNumInsts());
+         const MulDecomposition &Best = IsFactoredBetter ? Factored : Plain;
+         if (Best.getLatency() >= MulCost ||
+             Best.getNumInsts() > MulDecompositionMaxInsts) {
+           return nullptr;
+         }
+         return MulDecomposition(&Builder, X, *C, IsFactoredBetter).getValue();
+       }},
+      {"sdiv-pow2",
+       [](Instruction &Inst, IRBuilderBase &Builder) -> Value * {
+         // x / ±2^k → ±((x + (x < 0 ? 2^k - 1 : 0)) >> k)
+         Value *X;
+         Constant *C;
+         if (!match(&Inst, m_SDiv(m_Value(X), m_Constant(C)))) {
+           return nullptr;
+         }
+         const bool IsExact = cast<BinaryOperator>(Inst).isExact();
+         const APInt *Splat;
+         if (match(C, m_APInt(Splat))) {
+           if (Splat->isOneValue() || Splat->isMinSignedValue() ||
+               !Splat->abs().isPowerOf2()) {
+             return nullptr;
+           }
+           return createSDiv(Builder, X, *Splat, IsExact);
+         }
+         // Different powers of 2 in each lane, none of which is 1 nor
+         // negative.
+         SmallVector<APInt, 4> Lanes;
+         Constant *const Log2 = getLogBase2(*C);
+         if (!Log2 || !getLanes(*C, Lanes) ||
+             any_of(Lanes, [](const APInt &Lane) {
+               return Lane.isOneValue() || Lane.isNegative();
+             })) {
+           return nullptr;
+         }
+         if (IsExact) {
+           return Builder.CreateAShr(X, Log2, "", /*isExact=*/true);
+         }
+         const unsigned BitWidth = X->getType()->getScalarSizeInBits();
+         Value *const Sign = Builder.CreateAShr(X, BitWidth - 1);
+         Value *const Bias = Builder.CreateLShr(
+             Sign, ConstantExpr::getSub(
+                       ConstantInt::get(X->getType(), BitWidth), Log2));
+         return Builder.CreateAShr(Builder.CreateAdd(X, Bias), Log2);
+       }},
+      {"sdiv-magic",
+       [](Instruction &Inst, IRBuilderBase &Builder) -> Value * {
+         // x / d → mulhs(x, m) >> s, rounded towards zero
+         Value *X;
+         const APInt *C;
+         if (!match(&Inst, m_SDiv(m_Value(X), m_APInt(C))) ||
+             C->isNullValue() || C->isOneValue()) {
+           return nullptr;
+         }
+         return createSDiv(Builder, X, *C,
+                           cast<BinaryOperator>(Inst).isExact());
+       }},
+      {"udiv-pow2",
+       [](Instruction &Inst, IRBuilderBase &Builder) -> Value * {
+         // x / 2^k → x >> k
+         Value *X;
+         Constant *C;
+         if (!match(&Inst, m_UDiv(m_Value(X), m_Constant(C))) ||
+             match(C, m_One())) {
+           return nullptr;
+         }
+         Constant *const Log2 = getLogBase2(*C);
+         return Log2 ? Builder.CreateLShr(X, Log2, "",
+                                          cast<BinaryOperator>(Inst).isExact())
+                     : nullptr;
+       }},
+      {"udiv-magic",
+       [](Instruction &Inst, IRBuilderBase &Builder) -> Value * {
+         // x / d → mulhu(x, m) >> s
+         Value *X;
+         const APInt *C;
+         if (!match(&Inst, m_UDiv(m_Value(X), m_APInt(C))) ||
+             C->isNullValue() || C->isOneValue()) {
+           return nullptr;
+         }
+         return createUDiv(Builder, X, *C,
+                           cast<BinaryOperator>(Inst).isExact());
+       }},
+      {"urem-pow2",
+       [](Instruction &Inst, IRBuilderBase &Builder) -> Value * {
+         // x % 2^k → x & (2^k - 1)
+         Value *X;
+         Constant *C;
+         if (!match(&Inst, m_URem(m_Value(X), m_Constant(C))) ||
+             !getLogBase2(*C)) {
+           return nullptr;
+         }
+         return Builder.CreateAnd(
+             X, ConstantExpr::getSub(C, ConstantInt::get(C->getType(), 1)));
+       }},
+      {"srem-const",
+       [](Instruction &Inst, IRBuilderBase &Builder) -> Value * {
+         // x % d → x - x / d * d
+         Value *X;
+         const APInt *C;
+         if (!match(&Inst, m_SRem(m_Value(X), m_APInt(C))) ||
+             C->isNullValue() || C->isOneValue() || C->isAllOnesValue()) {
+           return nullptr;
+         }
+         Value *const Quotient = createSDiv(Builder, X, *C, /*IsExact=*/false);
+         return Builder.CreateSub(
+             X,
+             Builder.CreateMul(Quotient, ConstantInt::get(X->getType(), *C)));
+       }},
+      {"urem-const",
+       [](Instruction &Inst, IRBuilderBase &Builder) -> Value * {
+         // x % d → x - x / d * d
+         Value *X;
+         const APInt *C;
+         if (!match(&Inst, m_URem(m_Value(X), m_APInt(C))) ||
+             C->isNullValue() || C->isOneValue()) {
+           return nullptr;
+         }
+         Value *const Quotient = createUDiv(Builder, X, *C, /*IsExact=*/false);
+         return Builder.CreateSub(
+             X,
+             Builder.CreateMul(Quotient, ConstantInt::get(X->getType(), *C)));
+       }},
+  };
+  return Rules;
+}
+
+namespace {
+
+class StrengthReduction final : public FunctionPass {
+public:
+  static char ID;
+
+  StrengthReduction() : FunctionPass(ID) {}
 
+  virtual void getAnalysisUsage(AnalysisUsage &AU) const override {
+    AU.setPreservesCFG();
+  }
+
+  virtual bool doInitialization(Module &M) override {
+    printMulCostModel(errs());
     return false;
   }
+
+  virtual bool runOnFunction(Function &F) override {
+    PeepholeEngine Engine(getStrengthReductionRules());
+    bool Changed = Engine.run(F);
+    Engine.printHits(errs(), F);
+    return Changed;
+  }
 }; // class StrengthReduction
 
 char StrengthReduction::ID = 0;
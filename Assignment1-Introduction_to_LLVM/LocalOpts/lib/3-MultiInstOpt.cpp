@@ -1,10 +1,24 @@
-#include <llvm-12/llvm/IR/InstrTypes.h>
-#include <llvm-12/llvm/IR/Instruction.h>
-#include <llvm-12/llvm/Support/Casting.h>
-#include <llvm/IR/Module.h>
+#include <llvm/IR/PatternMatch.h>
 #include <llvm/Pass.h>
 
-using namespace llvm;
+#include "PeepholeEngine.h"
+
+using namespace llvm::PatternMatch;
+
+const std::vector<PeepholeRule> &getMultiInstOptRules() {
+  static const std::vector<PeepholeRule> Rules = {
+      {"add-sub-cancel",
+       [](Instruction &Inst, IRBuilderBase &) -> Value * {
+         // (b - t) + t, t + (b - t) → b
+         Value *B, *T = nullptr;
+         return match(&Inst,
+                      m_c_Add(m_Sub(m_Value(B), m_Value(T)), m_Deferred(T)))
+                    ? B
+                    : nullptr;
+       }},
+  };
+  return Rules;
+}
 
 namespace {
 
@@ -14,75 +28,15 @@ public:
 
   MultiInstOpt() : FunctionPass(ID) {}
 
-  virtual void getAnalysisUsage(AnalysisUsage &AU) const override {}
-
-  void removeDeadCode(const std::vector<Instruction *> &deadInstructions) {
-    for (auto &deadInst : deadInstructions) {
-      if (deadInst->isSafeToRemove()) {
-        deadInst->eraseFromParent();
-      }
-    }
+  virtual void getAnalysisUsage(AnalysisUsage &AU) const override {
+    AU.setPreservesCFG();
   }
 
   virtual bool runOnFunction(Function &F) override {
-    std::vector<Instruction *> deadInstructionList;
-    bool deadCodePresent = false;
-    for (auto &B : F) {
-      for (auto &I : B) {
-        if (auto *op = dyn_cast<BinaryOperator>(&I)) {
-          Value *lhs = op->getOperand(0);
-          Value *rhs = op->getOperand(1);
-          switch (op->getOpcode()) {
-          case Instruction::Add: {
-            if (auto *operand0Instr = dyn_cast<BinaryOperator>(lhs)) {
-              // c = a + t, a = b - t
-              // lhs is "a", and its a BinaryOp
-              Value *operand0InstrLhs = operand0Instr->getOperand(0);
-              Value *operand0InstrRhs = operand0Instr->getOperand(1);
-              if ((operand0Instr->getOpcode() == Instruction::Sub) &&
-                  (operand0InstrRhs == rhs)) {
-                I.replaceAllUsesWith(operand0InstrLhs);
-                deadCodePresent = true;
-                deadInstructionList.push_back(&I);
-                /*
-                errs() << "Instruction: " << I << "\n";
-                errs() << "Instruction LHS: " << *lhs << "\n";
-                errs() << "Instruction RHS: " << *rhs << "\n";
-                errs() << "==================" << "\n";
-                errs() << "Operand-0 Instruction: " << *operand0Instr << "\n";
-                errs() << "Operand-0 Instruction LHS: " << *operand0InstrLhs
-                       << "\n";
-                errs() << "Operand-0 Instruction RHS: " << *operand0InstrRhs
-                       << "\n";
-                */
-                continue;
-              }
-            }
-            if (auto *operand1Instr = dyn_cast<BinaryOperator>(rhs)) {
-              // c = t + a, a = b - t
-              Value *operand1InstrLhs = operand1Instr->getOperand(0);
-              Value *operand1InstrRhs = operand1Instr->getOperand(1);
-              if ((operand1Instr->getOpcode() == Instruction::Sub) &&
-                  (lhs == operand1InstrRhs)) {
-                I.replaceAllUsesWith(operand1InstrLhs);
-                deadCodePresent = true;
-                deadInstructionList.push_back(&I);
-              }
-            }
-          } break;
-          default: {
-            break;
-          }
-          }
-        }
-      }
-    }
-    if (deadCodePresent) {
-      removeDeadCode(deadInstructionList);
-      // Code modified
-      return true;
-    }
-    return false;
+    PeepholeEngine Engine(getMultiInstOptRules());
+    bool Changed = Engine.run(F);
+    Engine.printHits(errs(), F);
+    return Changed;
   }
 }; // class MultiInstOpt
 
@@ -0,0 +1,49 @@
+#include <llvm/Pass.h>
+
+#include "PeepholeEngine.h"
+
+namespace {
+
+/**
+ * @brief All the local optimizations at once, so that the rewrites of one
+ *        kind can enable the ones of the others.
+ */
+class Peephole final : public FunctionPass {
+private:
+  static std::vector<PeepholeRule> getRules() {
+    std::vector<PeepholeRule> Rules;
+    for (const std::vector<PeepholeRule> *RuleSet :
+         {&getAlgebraicIdentityRules(), &getMultiInstOptRules(),
+          &getBitIdiomRules(), &getStrengthReductionRules(),
+          &getFastMathRules()}) {
+      Rules.insert(Rules.end(), RuleSet->begin(), RuleSet->end());
+    }
+    return Rules;
+  }
+
+public:
+  static char ID;
+
+  Peephole() : FunctionPass(ID) {}
+
+  virtual void getAnalysisUsage(AnalysisUsage &AU) const override {
+    AU.setPreservesCFG();
+  }
+
+  virtual bool doInitialization(Module &M) override {
+    printMulCostModel(errs());
+    return false;
+  }
+
+  virtual bool runOnFunction(Function &F) override {
+    PeepholeEngine Engine(getRules());
+    bool Changed = Engine.run(F);
+    Engine.printHits(errs(), F);
+    return Changed;
+  }
+}; // class Peephole
+
+char Peephole::ID = 0;
+RegisterPass<Peephole> X("peephole", "CSCD70: Peephole Optimizations");
+
+} // anonymous namespace
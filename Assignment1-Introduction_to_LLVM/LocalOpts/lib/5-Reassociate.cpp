@@ -0,0 +1,381 @@
+#include <llvm/ADT/DenseMap.h>
+#include <llvm/ADT/PostOrderIterator.h>
+#include <llvm/IR/Constants.h>
+#include <llvm/IR/IRBuilder.h>
+#include <llvm/IR/PatternMatch.h>
+#include <llvm/IR/ValueHandle.h>
+#include <llvm/Pass.h>
+#include <llvm/Transforms/Utils/Local.h>
+
+#include <algorithm>
+#include <cstdlib>
+
+using namespace llvm;
+using namespace llvm::PatternMatch;
+
+namespace {
+
+/**
+ * @brief Reassociate the trees of associative and commutative operations.
+ *
+ * Each tree of additions (and subtractions), multiplications, ands, ors or
+ * xors is flattened into the list of its leaves, i.e., the operands that are
+ * not themselves part of the tree. The constant leaves are folded together,
+ * the leaves that cancel each other out are dropped, and the tree is rebuilt
+ * as a left-leaning chain with the leaves sorted by rank, and the constant
+ * last, e.g.,
+ *
+ *     (c + 3) - (a - b) + 5 → ((b - a) + c) + 8
+ *
+ * where the rank of a value is the position of its definition in the
+ * function. Sorting the leaves this way gives the same shape to all the trees
+ * over the same leaves, so that their common subexpressions become apparent,
+ * and combines first the values that are available first.
+ *
+ * A tree only extends through the operations with a single use in the same
+ * basic block as its root, as the others have to be computed anyway.
+ */
+class Reassociate final : public FunctionPass {
+private:
+  /**
+   * @brief A leaf of a tree, i.e., a value with its coefficient, which is the
+   *        number of times that it is added (subtracted if negative) for
+   *        additions, and the number of times that it occurs otherwise.
+   */
+  struct Leaf {
+    Value *V;
+    int64_t Coefficient;
+  };
+
+  // Value-Rank Mapping
+  DenseMap<const Value *, unsigned> RankMap;
+  unsigned NumTrees, NumFoldedConstants, NumCancelledPairs;
+
+  static bool isAddOrSub(const Value *const V) {
+    const Instruction *const Inst = dyn_cast<Instruction>(V);
+    return Inst && (Inst->getOpcode() == Instruction::Add ||
+                    Inst->getOpcode() == Instruction::Sub);
+  }
+  /**
+   * @brief Whether @c V is an operation of the tree of @c Opcode rooted at
+   *        @c Root , rather than a leaf.
+   */
+  static bool isTreeNode(const Value *const V, const unsigned Opcode,
+                         const Instruction &Root) {
+    const Instruction *const Inst = dyn_cast<Instruction>(V);
+    if (!Inst || Inst->getParent() != Root.getParent()) {
+      return false;
+    }
+    return Opcode == Instruction::Add ? isAddOrSub(Inst)
+                                      : Inst->getOpcode() == Opcode;
+  }
+  /**
+   * @brief Whether @c Inst is the root of a tree, i.e., whether it is an
+   *        operation that is not itself an inner node of a larger tree.
+   */
+  static bool isTreeRoot(const Instruction &Inst) {
+    switch (Inst.getOpcode()) {
+    case Instruction::Add:
+    case Instruction::Sub:
+    case Instruction::Mul:
+    case Instruction::And:
+    case Instruction::Or:
+    case Instruction::Xor:
+      break;
+    default:
+      return false;
+    }
+    if (!Inst.getType()->isIntOrIntVectorTy()) {
+      return false;
+    }
+    if (!Inst.hasOneUse()) {
+      return true;
+    }
+    const Instruction *const User = cast<Instruction>(Inst.user_back());
+    return !isTreeNode(User, getTreeOpcode(Inst), *User) ||
+           User->getParent() != Inst.getParent();
+  }
+  static unsigned getTreeOpcode(const Instruction &Inst) {
+    return Inst.getOpcode() == Instruction::Sub ? Instruction::Add
+                                                : Inst.getOpcode();
+  }
+
+  unsigned getRank(const Value *const V) const {
+    auto RankIt = RankMap.find(V);
+    return RankIt != RankMap.end() ? RankIt->second : 0;
+  }
+
+  /**
+   * @brief Collect the leaves of the tree of @c Opcode under @c V , each
+   *        with the coefficient @c Coefficient .
+   */
+  void collectLeaves(Value *const V, const unsigned Opcode,
+                     const Instruction &Root, const int64_t Coefficient,
+                     SmallVectorImpl<Leaf> &Leaves) const {
+    if (V != &Root && (!V->hasOneUse() || !isTreeNode(V, Opcode, Root))) {
+      Leaves.push_back({V, Coefficient});
+      return;
+    }
+    const Instruction *const Inst = cast<Instruction>(V);
+    collectLeaves(Inst->getOperand(0), Opcode, Root, Coefficient, Leaves);
+    collectLeaves(Inst->getOperand(1), Opcode, Root,
+                  Inst->getOpcode() == Instruction::Sub ? -Coefficient
+                                                        : Coefficient,
+                  Leaves);
+  }
+
+  /**
+   * @brief Fold the constants among @c Leaves into one, merge the duplicate
+   *        leaves, and drop the ones that cancel each other out.
+   * @return the folded constant, or nullptr if it is the identity
+   */
+  Constant *simplifyLeaves(const unsigned Opcode, Type *const Ty,
+                           SmallVectorImpl<Leaf> &Leaves) {
+    Constant *Folded = ConstantExpr::getBinOpIdentity(Opcode, Ty);
+    unsigned NumConstants = 0;
+    SmallVector<Leaf, 8> Merged;
+    DenseMap<Value *, unsigned> LeafIdxMap;
+    for (const Leaf &L : Leaves) {
+      if (Constant *const C = dyn_cast<Constant>(L.V)) {
+        Constant *Term = C;
+        if (Opcode == Instruction::Add) {
+          Term = ConstantExpr::getMul(
+              C, ConstantInt::get(Ty, L.Coefficient, /*isSigned=*/true));
+        }
+        Folded = ConstantExpr::get(Opcode, Folded, Term);
+        ++NumConstants;
+        continue;
+      }
+      auto Inserted = LeafIdxMap.try_emplace(L.V, Merged.size());
+      if (Inserted.second) {
+        Merged.push_back(L);
+        continue;
+      }
+      // The same value occurs more than once.
+      Leaf &Existing = Merged[Inserted.first->second];
+      switch (Opcode) {
+      case Instruction::Add:
+        if ((Existing.Coefficient > 0) != (L.Coefficient > 0)) {
+          ++NumCancelledPairs;
+        }
+        Existing.Coefficient += L.Coefficient;
+        break;
+      case Instruction::Xor:
+        // x ^ x = 0
+        if (Existing.Coefficient % 2 == 1) {
+          ++NumCancelledPairs;
+        }
+        ++Existing.Coefficient;
+        break;
+      case Instruction::Mul:
+        ++Existing.Coefficient;
+        break;
+      default:
+        // x & x = x , x | x = x
+        break;
+      }
+    }
+    if (NumConstants > 1) {
+      NumFoldedConstants += NumConstants - 1;
+    }
+
+    Leaves.clear();
+    for (const Leaf &L : Merged) {
+      if (Opcode == Instruction::Mul) {
+        for (int64_t Occurrence = 0; Occurrence < L.Coefficient;
+             ++Occurrence) {
+          Leaves.push_back({L.V, 1});
+        }
+      } else if (Opcode == Instruction::Add) {
+        if (L.Coefficient != 0) {
+          Leaves.push_back(L);
+        }
+      } else if (Opcode != Instruction::Xor || L.Coefficient % 2 == 1) {
+        Leaves.push_back({L.V, 1});
+      }
+    }
+    // x & ~x = 0 , x | ~x = -1
+    if (Opcode == Instruction::And || Opcode == Instruction::Or) {
+      for (const Leaf &L : Leaves) {
+        Value *X;
+        if (match(L.V, m_Not(m_Value(X))) && LeafIdxMap.count(X)) {
+          ++NumCancelledPairs;
+          Leaves.clear();
+          return ConstantExpr::getBinOpAbsorber(Opcode, Ty);
+        }
+      }
+    }
+    if (Constant *const Absorber =
+            ConstantExpr::getBinOpAbsorber(Opcode, Ty)) {
+      if (Folded == Absorber) {
+        Leaves.clear();
+        return Folded;
+      }
+    }
+    return Folded == ConstantExpr::getBinOpIdentity(Opcode, Ty) ? nullptr
+                                                                : Folded;
+  }
+
+  /**
+   * @brief The chain of operations that a tree is rebuilt into, i.e., the
+   *        leftmost operand, followed by the operations that apply the others
+   *        one after the other.
+   */
+  struct Chain {
+    Value *Start;
+    SmallVector<std::pair<Instruction::BinaryOps, Value *>, 8> Steps;
+  };
+
+  /**
+   * @brief Return the chain of @c Leaves followed by @c Folded , where the
+   *        coefficients of the leaves are all either 1 or -1.
+   */
+  static Chain getChain(const unsigned Opcode, Type *const Ty,
+                        ArrayRef<Leaf> Leaves, Constant *Folded) {
+    const Instruction::BinaryOps BinOp =
+        static_cast<Instruction::BinaryOps>(Opcode);
+    Chain C;
+    // Start from a positive leaf, to avoid a negation, or from the constant
+    // if there are none.
+    auto StartIt =
+        find_if(Leaves, [](const Leaf &L) { return L.Coefficient > 0; });
+    if (StartIt != Leaves.end()) {
+      C.Start = StartIt->V;
+    } else {
+      C.Start = Folded ? Folded : Constant::getNullValue(Ty);
+      Folded = nullptr;
+    }
+    for (auto LeafIt = Leaves.begin(); LeafIt != Leaves.end(); ++LeafIt) {
+      if (LeafIt != StartIt) {
+        C.Steps.emplace_back(
+            LeafIt->Coefficient < 0 ? Instruction::Sub : BinOp, LeafIt->V);
+      }
+    }
+    if (Folded) {
+      C.Steps.emplace_back(BinOp, Folded);
+    }
+    return C;
+  }
+
+  /**
+   * @brief Whether the tree of @c Opcode rooted at @c Root already is the
+   *        chain @c C .
+   */
+  static bool isCanonical(const Instruction &Root, const unsigned Opcode,
+                          const Chain &C) {
+    const Value *Node = &Root;
+    for (auto StepIt = C.Steps.rbegin(); StepIt != C.Steps.rend(); ++StepIt) {
+      const Instruction *const Inst = dyn_cast<Instruction>(Node);
+      if (!Inst || Inst->getOpcode() != StepIt->first ||
+          Inst->getOperand(1) != StepIt->second ||
+          (Inst != &Root &&
+           (!Inst->hasOneUse() || !isTreeNode(Inst, Opcode, Root)))) {
+        return false;
+      }
+      Node = Inst->getOperand(0);
+    }
+    return Node == C.Start;
+  }
+
+  /**
+   * @brief Reassociate the tree rooted at @c Root .
+   * @return whether it has been changed
+   */
+  bool reassociate(Instruction &Root) {
+    const unsigned Opcode = getTreeOpcode(Root);
+    Type *const Ty = Root.getType();
+    SmallVector<Leaf, 8> Leaves;
+    collectLeaves(&Root, Opcode, Root, 1, Leaves);
+    Constant *const Folded = simplifyLeaves(Opcode, Ty, Leaves);
+    std::stable_sort(Leaves.begin(), Leaves.end(),
+                     [this](const Leaf &A, const Leaf &B) {
+                       return getRank(A.V) < getRank(B.V);
+                     });
+
+    Value *Replacement;
+    if (Leaves.empty()) {
+      Replacement =
+          Folded ? Folded : ConstantExpr::getBinOpIdentity(Opcode, Ty);
+    } else {
+      const bool HasMultiples = any_of(Leaves, [](const Leaf &L) {
+        return L.Coefficient != 1 && L.Coefficient != -1;
+      });
+      if (!HasMultiples &&
+          isCanonical(Root, Opcode, getChain(Opcode, Ty, Leaves, Folded))) {
+        return false;
+      }
+      IRBuilder<> Builder(&Root);
+      // The leaves that are added several times get multiplied first.
+      for (Leaf &L : Leaves) {
+        if (L.Coefficient != 1 && L.Coefficient != -1) {
+          Value *const Multiple = Builder.CreateMul(
+              L.V, ConstantInt::get(Ty, std::abs(L.Coefficient)));
+          RankMap[Multiple] = getRank(L.V);
+          L = {Multiple, L.Coefficient > 0 ? 1 : -1};
+        }
+      }
+      const Chain C = getChain(Opcode, Ty, Leaves, Folded);
+      Replacement = C.Start;
+      for (const std::pair<Instruction::BinaryOps, Value *> &Step : C.Steps) {
+        Replacement = Builder.CreateBinOp(Step.first, Replacement, Step.second);
+      }
+      RankMap[Replacement] = getRank(&Root);
+    }
+    Root.replaceAllUsesWith(Replacement);
+    RecursivelyDeleteTriviallyDeadInstructions(&Root);
+    ++NumTrees;
+    return true;
+  }
+
+public:
+  static char ID;
+
+  Reassociate() : FunctionPass(ID) {}
+
+  virtual void getAnalysisUsage(AnalysisUsage &AU) const override {
+    AU.setPreservesCFG();
+  }
+
+  virtual bool runOnFunction(Function &F) override {
+    NumTrees = NumFoldedConstants = NumCancelledPairs = 0;
+    bool Changed = false, IsRoundChanged;
+    // Rebuilding a tree may leave the other trees that it is a leaf of with a
+    // single use, hence make them part of a larger tree, in the next round.
+    do {
+      RankMap.clear();
+      unsigned Rank = 0;
+      for (const Argument &Arg : F.args()) {
+        RankMap[&Arg] = ++Rank;
+      }
+      std::vector<WeakVH> Roots;
+      for (BasicBlock *const BB : ReversePostOrderTraversal<Function *>(&F)) {
+        for (Instruction &Inst : *BB) {
+          RankMap[&Inst] = ++Rank;
+          if (isTreeRoot(Inst)) {
+            Roots.emplace_back(&Inst);
+          }
+        }
+      }
+      IsRoundChanged = false;
+      for (const WeakVH &Root : Roots) {
+        if (Root) {
+          IsRoundChanged |= reassociate(*cast<Instruction>(Root));
+        }
+      }
+      Changed |= IsRoundChanged;
+    } while (IsRoundChanged);
+    errs() << "Reassociated Trees (" << F.getName() << "): " << NumTrees
+           << "\n"
+           << "Folded Constants (" << F.getName()
+           << "): " << NumFoldedConstants << "\n"
+           << "Cancelled Pairs (" << F.getName() << "): " << NumCancelledPairs
+           << "\n";
+    return Changed;
+  }
+}; // class Reassociate
+
+char Reassociate::ID = 0;
+RegisterPass<Reassociate> X("local-reassociate",
+                            "CSCD70: Reassociation and Constant Folding");
+
+} // anonymous namespace
@@ -0,0 +1,169 @@
+#include <llvm/IR/IntrinsicInst.h>
+#include <llvm/IR/PatternMatch.h>
+#include <llvm/Pass.h>
+
+#include "PeepholeEngine.h"
+
+using namespace llvm::PatternMatch;
+
+namespace {
+
+/**
+ * @brief Return the reciprocal of the floating-point constant @c C , lane by
+ *        lane, or nullptr if it is not exactly representable in some lane and
+ *        @c AllowInexact is false.
+ */
+Constant *getReciprocal(Constant &C, const bool AllowInexact) {
+  FixedVectorType *const VecTy = dyn_cast<FixedVectorType>(C.getType());
+  const unsigned NumLanes = VecTy ? VecTy->getNumElements() : 1;
+  SmallVector<Constant *, 4> Reciprocals;
+  for (unsigned Lane = 0; Lane < NumLanes; ++Lane) {
+    const ConstantFP *const LaneC =
+        dyn_cast_or_null<ConstantFP>(VecTy ? C.getAggregateElement(Lane) : &C);
+    if (!LaneC) {
+      return nullptr;
+    }
+    const APFloat &Divisor = LaneC->getValueAPF();
+    APFloat Reciprocal(Divisor.getSemantics());
+    if (!Divisor.getExactInverse(&Reciprocal)) {
+      if (!AllowInexact) {
+        return nullptr;
+      }
+      Reciprocal = APFloat(Divisor.getSemantics(), 1);
+      Reciprocal.divide(Divisor, APFloat::rmNearestTiesToEven);
+    }
+    Reciprocals.push_back(ConstantFP::get(C.getContext(), Reciprocal));
+  }
+  return VecTy ? ConstantVector::get(Reciprocals) : Reciprocals.front();
+}
+
+/**
+ * @brief Whether @c V is a multiplication @c A*B that may be contracted into
+ *        its only user.
+ */
+bool matchContractibleFMul(Value *const V, Value *&A, Value *&B) {
+  Instruction *Mul;
+  return match(V, m_CombineAnd(m_Instruction(Mul),
+                               m_OneUse(m_FMul(m_Value(A), m_Value(B))))) &&
+         Mul->hasAllowContract();
+}
+
+} // anonymous namespace
+
+const std::vector<PeepholeRule> &getFastMathRules() {
+  // The rules only apply if the fast-math flags of the instruction allow for
+  // them, e.g., x+0.0 → x requires nsz, as -0.0+0.0 is 0.0, whereas x+(-0.0)
+  // → x holds regardless.
+  static const std::vector<PeepholeRule> Rules = {
+      {"fadd-zero",
+       [](Instruction &Inst, IRBuilderBase &) -> Value * {
+         // x + (-0.0), (-0.0) + x, and x + 0.0, 0.0 + x if nsz
+         Value *X;
+         return match(&Inst, m_c_FAdd(m_Value(X), m_NegZeroFP())) ||
+                        (match(&Inst, m_c_FAdd(m_Value(X), m_AnyZeroFP())) &&
+                         Inst.hasNoSignedZeros())
+                    ? X
+                    : nullptr;
+       }},
+      {"fsub-zero",
+       [](Instruction &Inst, IRBuilderBase &) -> Value * {
+         // x - 0.0, and x - (-0.0) if nsz
+         Value *X;
+         return match(&Inst, m_FSub(m_Value(X), m_PosZeroFP())) ||
+                        (match(&Inst, m_FSub(m_Value(X), m_AnyZeroFP())) &&
+                         Inst.hasNoSignedZeros())
+                    ? X
+                    : nullptr;
+       }},
+      {"fmul-one",
+       [](Instruction &Inst, IRBuilderBase &) -> Value * {
+         // x * 1.0, 1.0 * x
+         Value *X;
+         return match(&Inst, m_c_FMul(m_Value(X), m_FPOne())) ? X : nullptr;
+       }},
+      {"fmul-zero",
+       [](Instruction &Inst, IRBuilderBase &) -> Value * {
+         // x * 0.0, 0.0 * x if nnan and nsz, as inf*0.0 is NaN and -x*0.0 is
+         // -0.0
+         return match(&Inst, m_c_FMul(m_Value(), m_AnyZeroFP())) &&
+                        Inst.hasNoNaNs() && Inst.hasNoSignedZeros()
+                    ? Constant::getNullValue(Inst.getType())
+                    : nullptr;
+       }},
+      {"fdiv-one",
+       [](Instruction &Inst, IRBuilderBase &) -> Value * {
+         // x / 1.0
+         Value *X;
+         return match(&Inst, m_FDiv(m_Value(X), m_FPOne())) ? X : nullptr;
+       }},
+      {"fdiv-reciprocal",
+       [](Instruction &Inst, IRBuilderBase &Builder) -> Value * {
+         // x / c → x * (1.0/c) if 1.0/c is exact, i.e., c is a power of 2, or
+         // if arcp
+         Value *X;
+         Constant *C;
+         if (!match(&Inst, m_FDiv(m_Value(X), m_Constant(C)))) {
+           return nullptr;
+         }
+         Constant *const Reciprocal =
+             getReciprocal(*C, Inst.hasAllowReciprocal());
+         return Reciprocal ? Builder.CreateFMulFMF(X, Reciprocal, &Inst)
+                           : nullptr;
+       }},
+      {"fmuladd-contract",
+       [](Instruction &Inst, IRBuilderBase &Builder) -> Value * {
+         // a*b + c, c + a*b → fmuladd(a, b, c)
+         // a*b - c → fmuladd(a, b, -c)
+         // c - a*b → fmuladd(-a, b, c)
+         // if both the multiplication and the addition allow contraction
+         const unsigned Opcode = Inst.getOpcode();
+         if ((Opcode != Instruction::FAdd && Opcode != Instruction::FSub) ||
+             !Inst.hasAllowContract()) {
+           return nullptr;
+         }
+         Value *A, *B, *C;
+         if (matchContractibleFMul(Inst.getOperand(0), A, B)) {
+           C = Inst.getOperand(1);
+           if (Opcode == Instruction::FSub) {
+             C = Builder.CreateFNegFMF(C, &Inst);
+           }
+         } else if (matchContractibleFMul(Inst.getOperand(1), A, B)) {
+           C = Inst.getOperand(0);
+           if (Opcode == Instruction::FSub) {
+             A = Builder.CreateFNegFMF(A, &Inst);
+           }
+         } else {
+           return nullptr;
+         }
+         return Builder.CreateIntrinsic(Intrinsic::fmuladd, {Inst.getType()},
+                                        {A, B, C}, &Inst);
+       }},
+  };
+  return Rules;
+}
+
+namespace {
+
+class FastMath final : public FunctionPass {
+public:
+  static char ID;
+
+  FastMath() : FunctionPass(ID) {}
+
+  virtual void getAnalysisUsage(AnalysisUsage &AU) const override {
+    AU.setPreservesCFG();
+  }
+
+  virtual bool runOnFunction(Function &F) override {
+    PeepholeEngine Engine(getFastMathRules());
+    bool Changed = Engine.run(F);
+    Engine.printHits(errs(), F);
+    return Changed;
+  }
+}; // class FastMath
+
+char FastMath::ID = 0;
+RegisterPass<FastMath> X("fast-math-opt",
+                         "CSCD70: Floating-Point Fast-Math Optimizations");
+
+} // anonymous namespace
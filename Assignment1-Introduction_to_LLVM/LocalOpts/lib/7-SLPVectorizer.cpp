@@ -0,0 +1,438 @@
+#include <llvm/ADT/Optional.h>
+#include <llvm/ADT/STLExtras.h>
+#include <llvm/ADT/SmallPtrSet.h>
+#include <llvm/Analysis/AliasAnalysis.h>
+#include <llvm/Analysis/ScalarEvolution.h>
+#include <llvm/Analysis/ScalarEvolutionExpressions.h>
+#include <llvm/Analysis/TargetTransformInfo.h>
+#include <llvm/Analysis/ValueTracking.h>
+#include <llvm/IR/IRBuilder.h>
+#include <llvm/IR/Instructions.h>
+#include <llvm/IR/ValueHandle.h>
+#include <llvm/Pass.h>
+#include <llvm/Support/CommandLine.h>
+#include <llvm/Support/InstructionCost.h>
+#include <llvm/Transforms/Utils/Local.h>
+
+#include <algorithm>
+
+using namespace llvm;
+
+static cl::opt<unsigned> SLPMaxVectorBits(
+    "local-slp-max-vector-bits", cl::init(128),
+    cl::desc("Maximum width, in bits, of the vectors that the SLP vectorizer "
+             "packs the scalars into"));
+
+namespace {
+
+/**
+ * @brief Superword-Level Parallelism (SLP) Vectorizer
+ *
+ * The stores to consecutive addresses within a basic block are the seeds of
+ * the vectorization. From a bundle of them, the tree of the isomorphic
+ * operations that compute the stored values is grown bottom-up, one bundle of
+ * scalars (one per lane) at a time: binary operators with the same opcode
+ * become a vector operation over the bundles of their operands, loads from
+ * consecutive addresses a vector load, and any other bundle gets gathered
+ * from its scalars with insertelements, e.g.,
+ *
+ *     b[i]   = a[i]   + c[i]        %va = load <2 x float>, a+i
+ *     b[i+1] = a[i+1] + c[i+1]  →   %vc = load <2 x float>, c+i
+ *                                   store (fadd %va, %vc), b+i
+ *
+ * The tree gets vectorized if the target cost model says that it is cheaper
+ * than the scalars that it replaces.
+ *
+ * The operations of a tree must have a single use, so that none of them has
+ * to be extracted back from a vector. The vector code is placed at the last
+ * store, i.e., the loads and the stores of the tree are moved there, which is
+ * only done if no memory access in between may alias them.
+ */
+class SLPVectorizer final : public FunctionPass {
+private:
+  /**
+   * @brief A bundle of scalars, one per lane, that becomes a vector.
+   */
+  struct TreeEntry {
+    SmallVector<Value *, 8> Scalars;
+    // Whether the scalars get gathered into the vector, rather than
+    // vectorized themselves.
+    bool IsGather;
+    // Indices of the entries of the operands in the tree
+    SmallVector<unsigned, 2> Operands;
+  };
+
+  static constexpr unsigned MaxTreeDepth = 12;
+
+  const DataLayout *DL;
+  AAResults *AA;
+  ScalarEvolution *SE;
+  const TargetTransformInfo *TTI;
+  // The tree that is being vectorized, with the operands of the stores first
+  std::vector<TreeEntry> Tree;
+  unsigned NumTrees, NumScalars;
+
+  /**
+   * @brief Whether the scalars of type @c Ty can be packed into a vector and
+   *        accessed as such in memory.
+   */
+  bool isValidElementType(Type *const Ty) const {
+    return (Ty->isIntegerTy() || Ty->isFloatingPointTy()) &&
+           DL->typeSizeEqualsStoreSize(Ty) &&
+           DL->getTypeStoreSize(Ty) == DL->getTypeAllocSize(Ty);
+  }
+  /**
+   * @brief Return the distance, in bytes, from @c PtrA to @c PtrB , if it is
+   *        a constant.
+   */
+  Optional<int64_t> getPointerDiff(Value *const PtrA, Value *const PtrB) const {
+    if (PtrA->getType()->getPointerAddressSpace() !=
+        PtrB->getType()->getPointerAddressSpace()) {
+      return None;
+    }
+    const SCEVConstant *const Diff = dyn_cast<SCEVConstant>(
+        SE->getMinusSCEV(SE->getSCEV(PtrB), SE->getSCEV(PtrA)));
+    if (!Diff || Diff->getAPInt().getMinSignedBits() > 64) {
+      return None;
+    }
+    return Diff->getAPInt().getSExtValue();
+  }
+  /**
+   * @brief Whether @c Bundle can be vectorized, rather than gathered.
+   */
+  bool isVectorizable(ArrayRef<Value *> Bundle, const BasicBlock &BB) const {
+    const Instruction *const Lane0 = dyn_cast<Instruction>(Bundle.front());
+    if (!Lane0) {
+      return false;
+    }
+    SmallPtrSet<const Value *, 8> Seen;
+    for (Value *const Scalar : Bundle) {
+      const Instruction *const Inst = dyn_cast<Instruction>(Scalar);
+      if (!Inst || Inst->getParent() != &BB ||
+          Inst->getOpcode() != Lane0->getOpcode() || !Inst->hasOneUse() ||
+          !Seen.insert(Inst).second) {
+        return false;
+      }
+      if (const LoadInst *const Load = dyn_cast<LoadInst>(Inst)) {
+        if (!Load->isSimple()) {
+          return false;
+        }
+      } else if (!isa<BinaryOperator>(Inst)) {
+        return false;
+      }
+    }
+    if (!isa<LoadInst>(Lane0)) {
+      return true;
+    }
+    // The loads have to be from consecutive addresses, in the order of the
+    // lanes.
+    const int64_t EltSize = DL->getTypeStoreSize(Lane0->getType());
+    Value *const Ptr0 = cast<LoadInst>(Bundle.front())->getPointerOperand();
+    for (unsigned Lane = 1; Lane < Bundle.size(); ++Lane) {
+      const Optional<int64_t> Diff = getPointerDiff(
+          Ptr0, cast<LoadInst>(Bundle[Lane])->getPointerOperand());
+      if (!Diff || *Diff != Lane * EltSize) {
+        return false;
+      }
+    }
+    return true;
+  }
+  /**
+   * @brief Add the entry of @c Bundle , and those of its operands, to the
+   *        tree.
+   * @return the index of the entry
+   */
+  unsigned buildTree(ArrayRef<Value *> Bundle, const BasicBlock &BB,
+                     const unsigned Depth) {
+    const unsigned Idx = Tree.size();
+    Tree.push_back({{Bundle.begin(), Bundle.end()}, true, {}});
+    if (Depth == MaxTreeDepth || !isVectorizable(Bundle, BB)) {
+      return Idx;
+    }
+    Tree[Idx].IsGather = false;
+    if (isa<LoadInst>(Bundle.front())) {
+      return Idx;
+    }
+    for (unsigned OperandIdx = 0; OperandIdx < 2; ++OperandIdx) {
+      SmallVector<Value *, 8> OperandBundle;
+      for (Value *const Scalar : Bundle) {
+        OperandBundle.push_back(
+            cast<Instruction>(Scalar)->getOperand(OperandIdx));
+      }
+      const unsigned OperandEntryIdx = buildTree(OperandBundle, BB, Depth + 1);
+      Tree[Idx].Operands.push_back(OperandEntryIdx);
+    }
+    return Idx;
+  }
+  /**
+   * @brief Return the cost of the vector code of the tree rooted at
+   *        @c Stores , minus that of the scalars that it replaces.
+   */
+  InstructionCost getCostDiff(ArrayRef<StoreInst *> Stores) const {
+    Type *const EltTy = Stores.front()->getValueOperand()->getType();
+    FixedVectorType *const VecTy = FixedVectorType::get(EltTy, Stores.size());
+    const unsigned AddrSpace = Stores.front()->getPointerAddressSpace();
+    InstructionCost Cost =
+        TTI->getMemoryOpCost(Instruction::Store, VecTy,
+                             Stores.front()->getAlign(), AddrSpace);
+    for (const StoreInst *const Store : Stores) {
+      Cost -= TTI->getMemoryOpCost(Instruction::Store, EltTy, Store->getAlign(),
+                                   AddrSpace);
+    }
+    for (const TreeEntry &Entry : Tree) {
+      if (Entry.IsGather) {
+        for (unsigned Lane = 0; Lane < Entry.Scalars.size(); ++Lane) {
+          if (!isa<Constant>(Entry.Scalars[Lane])) {
+            Cost += TTI->getVectorInstrCost(Instruction::InsertElement, VecTy,
+                                            Lane);
+          }
+        }
+      } else if (const LoadInst *const Load =
+                     dyn_cast<LoadInst>(Entry.Scalars.front())) {
+        Cost += TTI->getMemoryOpCost(Instruction::Load, VecTy, Load->getAlign(),
+                                     AddrSpace);
+        for (const Value *const Scalar : Entry.Scalars) {
+          Cost -= TTI->getMemoryOpCost(Instruction::Load, EltTy,
+                                       cast<LoadInst>(Scalar)->getAlign(),
+                                       AddrSpace);
+        }
+      } else {
+        const unsigned Opcode =
+            cast<Instruction>(Entry.Scalars.front())->getOpcode();
+        Cost += TTI->getArithmeticInstrCost(Opcode, VecTy);
+        for (unsigned Lane = 0; Lane < Entry.Scalars.size(); ++Lane) {
+          Cost -= TTI->getArithmeticInstrCost(Opcode, EltTy);
+        }
+      }
+    }
+    return Cost;
+  }
+  /**
+   * @brief Whether the loads of the tree and the @c Stores can all be moved
+   *        down to @c InsertPt , i.e., whether none of the instructions in
+   *        between writes the memory that they access, or reads the memory
+   *        that the stores write.
+   */
+  bool isSafeToSink(ArrayRef<StoreInst *> Stores,
+                    const Instruction *const InsertPt) const {
+    const SmallPtrSet<const Instruction *, 8> StoreSet(Stores.begin(),
+                                                       Stores.end());
+    SmallVector<Instruction *, 16> MemInsts(Stores.begin(), Stores.end());
+    for (const TreeEntry &Entry : Tree) {
+      if (!Entry.IsGather && isa<LoadInst>(Entry.Scalars.front())) {
+        for (Value *const Scalar : Entry.Scalars) {
+          MemInsts.push_back(cast<Instruction>(Scalar));
+        }
+      }
+    }
+    for (Instruction *const MemInst : MemInsts) {
+      if (MemInst == InsertPt) {
+        continue;
+      }
+      const MemoryLocation Loc = MemoryLocation::get(MemInst);
+      const bool IsStore = isa<StoreInst>(MemInst);
+      for (auto InstIt = std::next(MemInst->getIterator());
+           &*InstIt != InsertPt; ++InstIt) {
+        // The stores of the tree write disjoint memory, and the loads keep
+        // coming before them.
+        if (StoreSet.count(&*InstIt)) {
+          continue;
+        }
+        if (!isGuaranteedToTransferExecutionToSuccessor(&*InstIt)) {
+          return false;
+        }
+        const ModRefInfo MRI = AA->getModRefInfo(&*InstIt, Loc);
+        if (IsStore ? isModOrRefSet(MRI) : isModSet(MRI)) {
+          return false;
+        }
+      }
+    }
+    return true;
+  }
+  /**
+   * @brief Return the vector of the entry @c Entry , created with
+   *        @c Builder .
+   */
+  Value *vectorizeEntry(const TreeEntry &Entry, IRBuilderBase &Builder) {
+    Type *const EltTy = Entry.Scalars.front()->getType();
+    FixedVectorType *const VecTy =
+        FixedVectorType::get(EltTy, Entry.Scalars.size());
+    if (Entry.IsGather) {
+      SmallVector<Constant *, 8> Constants;
+      for (Value *const Scalar : Entry.Scalars) {
+        Constant *const C = dyn_cast<Constant>(Scalar);
+        Constants.push_back(C ? C : UndefValue::get(EltTy));
+      }
+      Value *Vec = ConstantVector::get(Constants);
+      for (unsigned Lane = 0; Lane < Entry.Scalars.size(); ++Lane) {
+        if (!isa<Constant>(Entry.Scalars[Lane])) {
+          Vec = Builder.CreateInsertElement(Vec, Entry.Scalars[Lane], Lane);
+        }
+      }
+      return Vec;
+    }
+    Instruction *const Lane0 = cast<Instruction>(Entry.Scalars.front());
+    if (LoadInst *const Load = dyn_cast<LoadInst>(Lane0)) {
+      Value *const Ptr = Builder.CreateBitCast(
+          Load->getPointerOperand(),
+          VecTy->getPointerTo(Load->getPointerAddressSpace()));
+      return Builder.CreateAlignedLoad(VecTy, Ptr, Load->getAlign());
+    }
+    Value *const LHS = vectorizeEntry(Tree[Entry.Operands[0]], Builder);
+    Value *const RHS = vectorizeEntry(Tree[Entry.Operands[1]], Builder);
+    Value *const Vec = Builder.CreateBinOp(
+        static_cast<Instruction::BinaryOps>(Lane0->getOpcode()), LHS, RHS);
+    // Keep the flags, e.g., nsw or fast-math ones, that all the lanes have.
+    if (Instruction *const VecInst = dyn_cast<Instruction>(Vec)) {
+      VecInst->copyIRFlags(Lane0);
+      for (Value *const Scalar : drop_begin(Entry.Scalars, 1)) {
+        VecInst->andIRFlags(Scalar);
+      }
+    }
+    return Vec;
+  }
+  /**
+   * @brief Vectorize the tree rooted at the consecutive @c Stores , in the
+   *        order of their addresses, if it is profitable and safe.
+   * @return whether it has been vectorized
+   */
+  bool vectorizeStores(ArrayRef<StoreInst *> Stores, const BasicBlock &BB) {
+    SmallVector<Value *, 8> StoredValues;
+    for (StoreInst *const Store : Stores) {
+      StoredValues.push_back(Store->getValueOperand());
+    }
+    Tree.clear();
+    buildTree(StoredValues, BB, 0);
+    StoreInst *const InsertPt = *std::max_element(
+        Stores.begin(), Stores.end(),
+        [](const StoreInst *const A, const StoreInst *const B) {
+          return A->comesBefore(B);
+        });
+    if (!(getCostDiff(Stores) < 0) || !isSafeToSink(Stores, InsertPt)) {
+      return false;
+    }
+
+    IRBuilder<> Builder(InsertPt);
+    Value *const Vec = vectorizeEntry(Tree.front(), Builder);
+    StoreInst *const Store0 = Stores.front();
+    Value *const Ptr = Builder.CreateBitCast(
+        Store0->getPointerOperand(),
+        Vec->getType()->getPointerTo(Store0->getPointerAddressSpace()));
+    Builder.CreateAlignedStore(Vec, Ptr, Store0->getAlign());
+
+    ++NumTrees;
+    NumScalars += Stores.size();
+    for (const TreeEntry &Entry : Tree) {
+      if (!Entry.IsGather) {
+        NumScalars += Entry.Scalars.size();
+      }
+    }
+    SmallVector<WeakTrackingVH, 16> DeadValues;
+    for (StoreInst *const Store : Stores) {
+      DeadValues.emplace_back(Store->getValueOperand());
+      DeadValues.emplace_back(Store->getPointerOperand());
+      Store->eraseFromParent();
+    }
+    for (const WeakTrackingVH &DeadValue : DeadValues) {
+      if (DeadValue) {
+        RecursivelyDeleteTriviallyDeadInstructions(DeadValue);
+      }
+    }
+    return true;
+  }
+  bool vectorizeBlock(BasicBlock &BB) {
+    // Group the stores of the same type whose addresses are at constant
+    // distances from each other, along with their distance to the first one.
+    std::vector<SmallVector<std::pair<int64_t, StoreInst *>, 8>> Groups;
+    for (Instruction &Inst : BB) {
+      StoreInst *const Store = dyn_cast<StoreInst>(&Inst);
+      if (!Store || !Store->isSimple() ||
+          !isValidElementType(Store->getValueOperand()->getType())) {
+        continue;
+      }
+      bool IsGrouped = false;
+      for (SmallVector<std::pair<int64_t, StoreInst *>, 8> &Group : Groups) {
+        StoreInst *const Store0 = Group.front().second;
+        if (Store0->getValueOperand()->getType() !=
+            Store->getValueOperand()->getType()) {
+          continue;
+        }
+        if (const Optional<int64_t> Diff = getPointerDiff(
+                Store0->getPointerOperand(), Store->getPointerOperand())) {
+          Group.emplace_back(*Diff, Store);
+          IsGrouped = true;
+          break;
+        }
+      }
+      if (!IsGrouped) {
+        Groups.push_back({{0, Store}});
+      }
+    }
+
+    bool Changed = false;
+    for (SmallVector<std::pair<int64_t, StoreInst *>, 8> &Group : Groups) {
+      Type *const EltTy = Group.front().second->getValueOperand()->getType();
+      const int64_t EltSize = DL->getTypeStoreSize(EltTy);
+      const unsigned MaxVF = SLPMaxVectorBits / EltTy->getScalarSizeInBits();
+      llvm::stable_sort(Group, less_first());
+      // Vectorize the runs of consecutive stores, from their beginning, with
+      // the widest vectors that pay off.
+      for (unsigned Begin = 0, End; Begin < Group.size(); Begin = End) {
+        End = Begin + 1;
+        while (End < Group.size() &&
+               Group[End].first - Group[End - 1].first == EltSize) {
+          ++End;
+        }
+        for (unsigned Start = Begin; Start + 1 < End;) {
+          unsigned VF = PowerOf2Floor(std::min(End - Start, MaxVF));
+          for (; VF >= 2; VF /= 2) {
+            SmallVector<StoreInst *, 8> Stores;
+            for (unsigned Lane = 0; Lane < VF; ++Lane) {
+              Stores.push_back(Group[Start + Lane].second);
+            }
+            if (vectorizeStores(Stores, BB)) {
+              break;
+            }
+          }
+          Changed |= VF >= 2;
+          Start += VF >= 2 ? VF : 1;
+        }
+      }
+    }
+    return Changed;
+  }
+
+public:
+  static char ID;
+
+  SLPVectorizer() : FunctionPass(ID) {}
+
+  virtual void getAnalysisUsage(AnalysisUsage &AU) const override {
+    AU.addRequired<AAResultsWrapperPass>();
+    AU.addRequired<ScalarEvolutionWrapperPass>();
+    AU.addRequired<TargetTransformInfoWrapperPass>();
+    AU.setPreservesCFG();
+  }
+
+  virtual bool runOnFunction(Function &F) override {
+    DL = &F.getParent()->getDataLayout();
+    AA = &getAnalysis<AAResultsWrapperPass>().getAAResults();
+    SE = &getAnalysis<ScalarEvolutionWrapperPass>().getSE();
+    TTI = &getAnalysis<TargetTransformInfoWrapperPass>().getTTI(F);
+    NumTrees = NumScalars = 0;
+    bool Changed = false;
+    for (BasicBlock &BB : F) {
+      Changed |= vectorizeBlock(BB);
+    }
+    errs() << "Vectorized Trees (" << F.getName() << "): " << NumTrees << "\n"
+           << "Vectorized Scalars (" << F.getName() << "): " << NumScalars
+           << "\n";
+    return Changed;
+  }
+}; // class SLPVectorizer
+
+char SLPVectorizer::ID = 0;
+RegisterPass<SLPVectorizer>
+    X("local-slp", "CSCD70: Superword-Level Parallelism Vectorizer");
+
+} // anonymous namespace
@@ -0,0 +1,221 @@
+#include <llvm/ADT/STLExtras.h>
+#include <llvm/Analysis/TargetTransformInfo.h>
+#include <llvm/Analysis/ValueTracking.h>
+#include <llvm/IR/CFG.h>
+#include <llvm/IR/IRBuilder.h>
+#include <llvm/IR/Instructions.h>
+#include <llvm/IR/IntrinsicInst.h>
+#include <llvm/Pass.h>
+#include <llvm/Support/CommandLine.h>
+#include <llvm/Support/InstructionCost.h>
+#include <llvm/Transforms/Utils/BasicBlockUtils.h>
+
+#include <algorithm>
+
+using namespace llvm;
+
+static cl::opt<unsigned>
+    MispredictPenalty("branch-mispredict-penalty", cl::init(14),
+                      cl::desc("Cycles lost to a branch misprediction"));
+static cl::opt<unsigned> MispredictRate(
+    "branch-mispredict-rate", cl::init(25),
+    cl::desc("Percentage of the executions of a branch without profile "
+             "data that are mispredicted"));
+
+namespace {
+
+/**
+ * @brief Convert the small diamonds and triangles of the CFG into selects.
+ *
+ *     Head: br %c, T, F            Head: <T>
+ *     T:    <T>; br BB                   <F>
+ *     F:    <F>; br BB        →          %x = select %c, %t, %f
+ *     BB:   %x = phi [%t, T],            ...
+ *                    [%f, F]
+ *
+ * where a triangle is the same, with one of the arms empty. The instructions
+ * of the arms must be safe to execute speculatively, and the branch must be
+ * expensive enough to be worth executing both arms instead, i.e.,
+ *
+ *     cost(T) + cost(F) + cost(selects)
+ *       <= p * cost(T) + (1 - p) * cost(F) + penalty * mispredict rate
+ *
+ * where the costs are latencies from the target cost model, p is the
+ * probability of T, and the mispredict rate is that of the less likely arm
+ * if the branch has profile data (as a predictor does at least as well as
+ * always guessing the likely one), or a fixed rate otherwise.
+ */
+class IfConversion final : public FunctionPass {
+private:
+  const TargetTransformInfo *TTI;
+  unsigned NumDiamonds, NumTriangles;
+
+  /**
+   * @brief Return the block that branches to @c BB through @c Pred , i.e.,
+   *        the predecessor of @c Pred if @c Pred is an arm that only leads
+   *        from there to @c BB , and @c Pred itself otherwise.
+   */
+  static BasicBlock *getBranchBlock(BasicBlock *const Pred,
+                                    const BasicBlock &BB) {
+    BasicBlock *const PredPred = Pred->getSinglePredecessor();
+    return PredPred && Pred->getSingleSuccessor() == &BB ? PredPred : Pred;
+  }
+  /**
+   * @brief Return the latency of the instructions of @c Arm , or an invalid
+   *        cost if they cannot all be hoisted out of it.
+   */
+  InstructionCost getArmCost(const BasicBlock *const Arm) const {
+    InstructionCost Cost = 0;
+    if (!Arm) {
+      return Cost;
+    }
+    for (const Instruction &Inst : *Arm) {
+      if (Inst.isTerminator() || isa<DbgInfoIntrinsic>(Inst)) {
+        continue;
+      }
+      if (isa<PHINode>(Inst) || !isSafeToSpeculativelyExecute(&Inst)) {
+        return InstructionCost::getInvalid();
+      }
+      Cost += TTI->getInstructionCost(&Inst, TargetTransformInfo::TCK_Latency);
+    }
+    return Cost;
+  }
+  /**
+   * @brief If-convert the diamond or triangle that @c BB is the merge block
+   *        of, if there is one and it pays off.
+   * @return whether it has been converted
+   */
+  bool convert(BasicBlock &BB) {
+    if (!isa<PHINode>(BB.front()) || pred_size(&BB) != 2) {
+      return false;
+    }
+    BasicBlock *const Head = getBranchBlock(*pred_begin(&BB), BB);
+    if (Head == &BB ||
+        Head != getBranchBlock(*std::next(pred_begin(&BB)), BB)) {
+      return false;
+    }
+    BranchInst *const Br = dyn_cast<BranchInst>(Head->getTerminator());
+    if (!Br || !Br->isConditional() ||
+        Br->getSuccessor(0) == Br->getSuccessor(1)) {
+      return false;
+    }
+    // The arms, or nullptr for the edges that go straight from the head to
+    // the merge block
+    BasicBlock *const TrueArm =
+        Br->getSuccessor(0) == &BB ? nullptr : Br->getSuccessor(0);
+    BasicBlock *const FalseArm =
+        Br->getSuccessor(1) == &BB ? nullptr : Br->getSuccessor(1);
+    for (const BasicBlock *const Arm : {TrueArm, FalseArm}) {
+      if (Arm && (Arm->getSinglePredecessor() != Head ||
+                  Arm->getSingleSuccessor() != &BB)) {
+        return false;
+      }
+    }
+    BasicBlock *const TrueBlock = TrueArm ? TrueArm : Head;
+    BasicBlock *const FalseBlock = FalseArm ? FalseArm : Head;
+
+    const InstructionCost TrueCost = getArmCost(TrueArm);
+    const InstructionCost FalseCost = getArmCost(FalseArm);
+    if (!TrueCost.isValid() || !FalseCost.isValid()) {
+      return false;
+    }
+    InstructionCost SelectCost = 0;
+    for (const PHINode &Phi : BB.phis()) {
+      if (Phi.getIncomingValueForBlock(TrueBlock) !=
+          Phi.getIncomingValueForBlock(FalseBlock)) {
+        SelectCost += TTI->getCmpSelInstrCost(
+            Instruction::Select, Phi.getType(), Br->getCondition()->getType(),
+            CmpInst::BAD_ICMP_PREDICATE, TargetTransformInfo::TCK_Latency);
+      }
+    }
+    double TrueProb = 0.5, Rate = MispredictRate / 100.0;
+    uint64_t TrueWeight, FalseWeight;
+    if (Br->extractProfMetadata(TrueWeight, FalseWeight) &&
+        TrueWeight + FalseWeight != 0) {
+      TrueProb = static_cast<double>(TrueWeight) / (TrueWeight + FalseWeight);
+      Rate = std::min(TrueProb, 1 - TrueProb);
+    }
+    const double BranchlessCost =
+        *(TrueCost + FalseCost + SelectCost).getValue();
+    const double BranchyCost = TrueProb * *TrueCost.getValue() +
+                               (1 - TrueProb) * *FalseCost.getValue() +
+                               MispredictPenalty * Rate;
+    if (BranchlessCost > BranchyCost) {
+      return false;
+    }
+
+    for (BasicBlock *const Arm : {TrueArm, FalseArm}) {
+      if (!Arm) {
+        continue;
+      }
+      for (Instruction &Inst : make_early_inc_range(*Arm)) {
+        if (!Inst.isTerminator()) {
+          // The metadata may only hold when the arm is taken.
+          Inst.dropUnknownNonDebugMetadata();
+          Inst.moveBefore(Br);
+        }
+      }
+    }
+    IRBuilder<> Builder(Br);
+    for (PHINode &Phi : make_early_inc_range(BB.phis())) {
+      Value *const TrueV = Phi.getIncomingValueForBlock(TrueBlock);
+      Value *const FalseV = Phi.getIncomingValueForBlock(FalseBlock);
+      if (TrueV == FalseV) {
+        Phi.replaceAllUsesWith(TrueV);
+      } else {
+        Value *const Select =
+            Builder.CreateSelect(Br->getCondition(), TrueV, FalseV);
+        Select->takeName(&Phi);
+        Phi.replaceAllUsesWith(Select);
+      }
+      Phi.eraseFromParent();
+    }
+    Builder.CreateBr(&BB);
+    Br->eraseFromParent();
+    for (BasicBlock *const Arm : {TrueArm, FalseArm}) {
+      if (Arm) {
+        DeleteDeadBlock(Arm);
+      }
+    }
+    ++(TrueArm && FalseArm ? NumDiamonds : NumTriangles);
+    MergeBlockIntoPredecessor(&BB);
+    return true;
+  }
+
+public:
+  static char ID;
+
+  IfConversion() : FunctionPass(ID) {}
+
+  virtual void getAnalysisUsage(AnalysisUsage &AU) const override {
+    AU.addRequired<TargetTransformInfoWrapperPass>();
+  }
+
+  virtual bool runOnFunction(Function &F) override {
+    TTI = &getAnalysis<TargetTransformInfoWrapperPass>().getTTI(F);
+    NumDiamonds = NumTriangles = 0;
+    bool Changed = false, IsConverted;
+    // Start over after each conversion, as it deletes blocks, and may turn
+    // the arms of an enclosing diamond into single blocks.
+    do {
+      IsConverted = false;
+      for (BasicBlock &BB : F) {
+        if (convert(BB)) {
+          IsConverted = Changed = true;
+          break;
+        }
+      }
+    } while (IsConverted);
+    errs() << "If-Converted Diamonds (" << F.getName() << "): " << NumDiamonds
+           << "\n"
+           << "If-Converted Triangles (" << F.getName()
+           << "): " << NumTriangles << "\n";
+    return Changed;
+  }
+}; // class IfConversion
+
+char IfConversion::ID = 0;
+RegisterPass<IfConversion> X("if-conversion",
+                             "CSCD70: If-Conversion into Selects");
+
+} // anonymous namespace
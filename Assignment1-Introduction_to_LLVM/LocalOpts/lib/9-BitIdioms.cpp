@@ -0,0 +1,376 @@
+#include <llvm/ADT/Optional.h>
+#include <llvm/Analysis/LoopInfo.h>
+#include <llvm/IR/IntrinsicInst.h>
+#include <llvm/IR/PatternMatch.h>
+#include <llvm/Pass.h>
+#include <llvm/Transforms/Utils/BasicBlockUtils.h>
+#include <llvm/Transforms/Utils/Local.h>
+
+#include "PeepholeEngine.h"
+
+using namespace llvm::PatternMatch;
+
+namespace {
+
+/**
+ * @brief Return the funnel shift that @c (x<<ShlAmt)|(x>>LShrAmt) rotates
+ *        @c x with, by @c ShlAmt if fshl and @c LShrAmt if fshr, or None if
+ *        it is not a rotation of the @c W bits of @c x .
+ */
+Optional<Intrinsic::ID> getRotateID(Value *const ShlAmt, Value *const LShrAmt,
+                                    const unsigned W) {
+  // c1 + c2 == w
+  const APInt *C1, *C2;
+  if (match(ShlAmt, m_APInt(C1)) && match(LShrAmt, m_APInt(C2))) {
+    if (C1->ult(W) && C2->ult(W) &&
+        C1->getZExtValue() + C2->getZExtValue() == W) {
+      return Intrinsic::fshl;
+    }
+    return None;
+  }
+  // s, w - s
+  if (match(LShrAmt, m_Sub(m_SpecificInt(W), m_Specific(ShlAmt)))) {
+    return Intrinsic::fshl;
+  }
+  if (match(ShlAmt, m_Sub(m_SpecificInt(W), m_Specific(LShrAmt)))) {
+    return Intrinsic::fshr;
+  }
+  // s & (w - 1), -s & (w - 1), which is free of undefined behavior in C
+  if (!isPowerOf2_32(W)) {
+    return None;
+  }
+  Value *S = nullptr;
+  if (match(ShlAmt, m_And(m_Value(S), m_SpecificInt(W - 1))) &&
+      match(LShrAmt, m_And(m_Neg(m_Specific(S)), m_SpecificInt(W - 1)))) {
+    return Intrinsic::fshl;
+  }
+  if (match(LShrAmt, m_And(m_Value(S), m_SpecificInt(W - 1))) &&
+      match(ShlAmt, m_And(m_Neg(m_Specific(S)), m_SpecificInt(W - 1)))) {
+    return Intrinsic::fshr;
+  }
+  return None;
+}
+
+/**
+ * @brief Return @c x if @c V computes the population count of @c x with the
+ *        SWAR (SIMD Within A Register) sequence, or nullptr otherwise, i.e.,
+ *
+ *     x2 = x - ((x >> 1) & 0x55..55)
+ *     x3 = (x2 & 0x33..33) + ((x2 >> 2) & 0x33..33)
+ *     x4 = (x3 + (x3 >> 4)) & 0x0F..0F
+ *     V  = (x4 * 0x01..01) >> (w - 8)  (or x4 itself if w is 8)
+ */
+Value *matchPopCount(Value *const V) {
+  const unsigned W = V->getType()->getScalarSizeInBits();
+  if (!isPowerOf2_32(W) || W < 8 || W > 128) {
+    return nullptr;
+  }
+  auto getSplat = [W](const uint8_t Byte) {
+    return APInt::getSplat(W, APInt(8, Byte));
+  };
+  Value *X4 = V, *X3 = nullptr, *X2 = nullptr, *X = nullptr;
+  if (W > 8 &&
+      !match(V, m_LShr(m_Mul(m_Value(X4), m_SpecificInt(getSplat(0x01))),
+                       m_SpecificInt(W - 8)))) {
+    return nullptr;
+  }
+  if (match(X4, m_And(m_c_Add(m_Value(X3),
+                              m_LShr(m_Deferred(X3), m_SpecificInt(4))),
+                      m_SpecificInt(getSplat(0x0F)))) &&
+      match(X3, m_c_Add(m_And(m_Value(X2), m_SpecificInt(getSplat(0x33))),
+                        m_And(m_LShr(m_Deferred(X2), m_SpecificInt(2)),
+                              m_SpecificInt(getSplat(0x33))))) &&
+      match(X2, m_Sub(m_Value(X), m_And(m_LShr(m_Deferred(X), m_SpecificInt(1)),
+                                        m_SpecificInt(getSplat(0x55)))))) {
+    return X;
+  }
+  return nullptr;
+}
+
+/**
+ * @brief Return @c x if @c V smears the highest set bit of @c x over all the
+ *        lower ones, i.e.,
+ *
+ *     x |= x >> 1; x |= x >> 2; ...; x |= x >> (w / 2);
+ *
+ *        or nullptr otherwise.
+ */
+Value *matchSmear(Value *V) {
+  const unsigned W = V->getType()->getScalarSizeInBits();
+  if (!isPowerOf2_32(W) || W < 2) {
+    return nullptr;
+  }
+  for (unsigned Shift = W / 2; Shift != 0; Shift /= 2) {
+    Value *X = nullptr;
+    if (!match(V, m_c_Or(m_Value(X), m_LShr(m_Deferred(X),
+                                            m_SpecificInt(Shift))))) {
+      return nullptr;
+    }
+    V = X;
+  }
+  return V;
+}
+
+} // anonymous namespace
+
+const std::vector<PeepholeRule> &getBitIdiomRules() {
+  static const std::vector<PeepholeRule> Rules = {
+      {"rotate",
+       [](Instruction &Inst, IRBuilderBase &Builder) -> Value * {
+         // (x << s) | (x >> (w - s)) → fshl(x, x, s)
+         // (x << (w - s)) | (x >> s) → fshr(x, x, s)
+         Value *X, *ShlAmt, *LShrAmt;
+         if (!match(&Inst, m_c_Or(m_Shl(m_Value(X), m_Value(ShlAmt)),
+                                  m_LShr(m_Deferred(X), m_Value(LShrAmt))))) {
+           return nullptr;
+         }
+         const Optional<Intrinsic::ID> ID = getRotateID(
+             ShlAmt, LShrAmt, Inst.getType()->getScalarSizeInBits());
+         if (!ID) {
+           return nullptr;
+         }
+         return Builder.CreateIntrinsic(
+             *ID, {Inst.getType()},
+             {X, X, *ID == Intrinsic::fshl ? ShlAmt : LShrAmt});
+       }},
+      {"bswap",
+       [](Instruction &Inst, IRBuilderBase &) -> Value * {
+         // (x << 24) | ((x & 0xff00) << 8) | ((x >> 8) & 0xff00) | (x >> 24)
+         // → bswap(x)
+         // Only try the root of the tree of ors, rather than each of the
+         // partial byte swaps below it.
+         if (Inst.getOpcode() != Instruction::Or ||
+             (Inst.hasOneUse() &&
+              cast<Instruction>(*Inst.user_begin())->getOpcode() ==
+                  Instruction::Or)) {
+           return nullptr;
+         }
+         SmallVector<Instruction *, 4> InsertedInsts;
+         return recognizeBSwapOrBitReverseIdiom(&Inst, true, false,
+                                                InsertedInsts)
+                    ? InsertedInsts.back()
+                    : nullptr;
+       }},
+      {"popcount",
+       [](Instruction &Inst, IRBuilderBase &Builder) -> Value * {
+         // the SWAR population count of x → ctpop(x)
+         Value *const X = matchPopCount(&Inst);
+         return X ? Builder.CreateUnaryIntrinsic(Intrinsic::ctpop, X) : nullptr;
+       }},
+      {"cttz",
+       [](Instruction &Inst, IRBuilderBase &Builder) -> Value * {
+         // ctpop((x & -x) - 1), ctpop(~x & (x - 1)) → cttz(x)
+         Value *X = nullptr;
+         if (match(&Inst,
+                   m_Intrinsic<Intrinsic::ctpop>(m_Add(
+                       m_c_And(m_Value(X), m_Neg(m_Deferred(X))),
+                       m_AllOnes()))) ||
+             match(&Inst, m_Intrinsic<Intrinsic::ctpop>(m_c_And(
+                              m_Not(m_Value(X)),
+                              m_Add(m_Deferred(X), m_AllOnes()))))) {
+           return Builder.CreateBinaryIntrinsic(Intrinsic::cttz, X,
+                                                Builder.getFalse());
+         }
+         return nullptr;
+       }},
+      {"ctlz",
+       [](Instruction &Inst, IRBuilderBase &Builder) -> Value * {
+         // ctpop(~smear(x)) → ctlz(x)
+         Value *Smear;
+         Value *const X =
+             match(&Inst, m_Intrinsic<Intrinsic::ctpop>(m_Not(m_Value(Smear))))
+                 ? matchSmear(Smear)
+                 : nullptr;
+         return X ? Builder.CreateBinaryIntrinsic(Intrinsic::ctlz, X,
+                                                  Builder.getFalse())
+                  : nullptr;
+       }},
+  };
+  return Rules;
+}
+
+namespace {
+
+/**
+ * @brief Recognize the bit-manipulation idioms, i.e., the shift and mask
+ *        sequences of the peephole rules above, and the loops that count
+ *        the set bits or the significant bits of a value, e.g.,
+ *
+ *     do {                    c += umax(ctpop(x), 1)
+ *       x &= x - 1;     →
+ *       ++c;
+ *     } while (x != 0);
+ */
+class BitIdioms final : public FunctionPass {
+private:
+  unsigned NumPopCountLoops, NumCtlzLoops, NumCttzLoops;
+
+  /**
+   * @brief Replace the single-block loop @c L , which steps @c x until it
+   *        becomes 0 while counting the iterations, with the closed form of
+   *        the count, where the step is
+   *
+   *        - @c x&(x-1) , i.e., the count is @c ctpop(x) ,
+   *        - @c x>>1 , i.e., the count is @c w-ctlz(x) , or
+   *        - @c x<<1 , i.e., the count is @c w-cttz(x) ,
+   *
+   *        and at least 1, as the body is executed before the exit test.
+   * @return whether @c L has been replaced
+   */
+  bool convertCountingLoop(Loop &L) {
+    BasicBlock *const Header = L.getHeader();
+    // The block that enters the loop, which the closed form gets computed in
+    BasicBlock *const Pred = L.getLoopPredecessor();
+    BasicBlock *const Exit = L.getExitBlock();
+    if (L.getNumBlocks() != 1 || !Pred || !Exit) {
+      return false;
+    }
+    BranchInst *const Br = dyn_cast<BranchInst>(Header->getTerminator());
+    ICmpInst::Predicate CmpPred;
+    Value *XNext;
+    if (!Br || !Br->isConditional() ||
+        !match(Br->getCondition(),
+               m_OneUse(m_ICmp(CmpPred, m_Value(XNext), m_Zero())))) {
+      return false;
+    }
+    // The loop has to go on as long as x != 0.
+    if (!(CmpPred == ICmpInst::ICMP_NE && Br->getSuccessor(0) == Header) &&
+        !(CmpPred == ICmpInst::ICMP_EQ && Br->getSuccessor(1) == Header)) {
+      return false;
+    }
+    Value *X = nullptr;
+    Intrinsic::ID CountID;
+    if (match(XNext, m_c_And(m_Value(X), m_Add(m_Deferred(X), m_AllOnes())))) {
+      CountID = Intrinsic::ctpop;
+    } else if (match(XNext, m_LShr(m_Value(X), m_One()))) {
+      CountID = Intrinsic::ctlz;
+    } else if (match(XNext, m_Shl(m_Value(X), m_One()))) {
+      CountID = Intrinsic::cttz;
+    } else {
+      return false;
+    }
+    PHINode *const XPhi = dyn_cast<PHINode>(X);
+    if (!XPhi || XPhi->getParent() != Header ||
+        XPhi->getIncomingValueForBlock(Header) != XNext) {
+      return false;
+    }
+
+    // The other phis have to be counters, i.e., c = phi [c0, Pred],
+    // [c + 1, Header], and the only values used outside the loop, along with
+    // x, which is 0 by then.
+    SmallVector<PHINode *, 2> Counters;
+    for (PHINode &Phi : Header->phis()) {
+      if (&Phi != XPhi) {
+        if (!match(Phi.getIncomingValueForBlock(Header),
+                   m_c_Add(m_Specific(&Phi), m_One()))) {
+          return false;
+        }
+        Counters.push_back(&Phi);
+      }
+    }
+    for (Instruction &Inst : *Header) {
+      if (Inst.mayHaveSideEffects()) {
+        return false;
+      }
+      const bool IsLiveOut =
+          &Inst == XNext || is_contained(Counters, &Inst) ||
+          any_of(Counters, [&Inst](PHINode *const Counter) {
+            return &Inst == Counter->getIncomingValueForBlock(
+                                Counter->getParent());
+          });
+      if (!IsLiveOut && any_of(Inst.users(), [Header](const User *const U) {
+            return cast<Instruction>(U)->getParent() != Header;
+          })) {
+        return false;
+      }
+    }
+
+    IRBuilder<> Builder(Pred->getTerminator());
+    Value *const X0 = XPhi->getIncomingValueForBlock(Pred);
+    Type *const Ty = X0->getType();
+    Value *Count =
+        CountID == Intrinsic::ctpop
+            ? static_cast<Value *>(Builder.CreateUnaryIntrinsic(CountID, X0))
+            : Builder.CreateSub(
+                  ConstantInt::get(Ty, Ty->getScalarSizeInBits()),
+                  Builder.CreateBinaryIntrinsic(CountID, X0,
+                                                Builder.getFalse()));
+    Count = Builder.CreateBinaryIntrinsic(Intrinsic::umax, Count,
+                                          ConstantInt::get(Ty, 1));
+    auto isOutsideLoop = [Header](Use &U) {
+      return cast<Instruction>(U.getUser())->getParent() != Header;
+    };
+    XNext->replaceUsesWithIf(Constant::getNullValue(Ty), isOutsideLoop);
+    for (PHINode *const Counter : Counters) {
+      Value *const C0 = Counter->getIncomingValueForBlock(Pred);
+      Value *CNext = Builder.CreateZExtOrTrunc(Count, Counter->getType());
+      if (!match(C0, m_Zero())) {
+        CNext = Builder.CreateAdd(C0, CNext);
+      }
+      Counter->getIncomingValueForBlock(Header)->replaceUsesWithIf(
+          CNext, isOutsideLoop);
+      if (any_of(Counter->uses(), isOutsideLoop)) {
+        Counter->replaceUsesWithIf(
+            Builder.CreateSub(CNext, ConstantInt::get(Counter->getType(), 1)),
+            isOutsideLoop);
+      }
+    }
+
+    // Drop the back edge, which leaves the loop without any user.
+    Header->removePredecessor(Header);
+    BranchInst::Create(Exit, Br);
+    Br->eraseFromParent();
+    for (Instruction &Inst : make_early_inc_range(reverse(*Header))) {
+      if (isInstructionTriviallyDead(&Inst)) {
+        Inst.eraseFromParent();
+      }
+    }
+    MergeBlockIntoPredecessor(Header);
+    ++(CountID == Intrinsic::ctpop  ? NumPopCountLoops
+       : CountID == Intrinsic::ctlz ? NumCtlzLoops
+                                    : NumCttzLoops);
+    return true;
+  }
+
+public:
+  static char ID;
+
+  BitIdioms() : FunctionPass(ID) {}
+
+  virtual void getAnalysisUsage(AnalysisUsage &AU) const override {
+    AU.addRequired<LoopInfoWrapperPass>();
+  }
+
+  virtual bool runOnFunction(Function &F) override {
+    NumPopCountLoops = NumCtlzLoops = NumCttzLoops = 0;
+    bool Changed = false;
+    // Only the innermost loops may be single blocks, and converting them
+    // leaves the others as they are.
+    for (Loop *const L : getAnalysis<LoopInfoWrapperPass>()
+                             .getLoopInfo()
+                             .getLoopsInPreorder()) {
+      if (L->isInnermost()) {
+        Changed |= convertCountingLoop(*L);
+      }
+    }
+    PeepholeEngine Engine(getBitIdiomRules());
+    Changed |= Engine.run(F);
+    Engine.printHits(errs(), F);
+    for (const std::pair<const char *, unsigned> &NumLoops :
+         {std::make_pair("popcount-loop", NumPopCountLoops),
+          std::make_pair("ctlz-loop", NumCtlzLoops),
+          std::make_pair("cttz-loop", NumCttzLoops)}) {
+      if (NumLoops.second != 0) {
+        errs() << NumLoops.first << " (" << F.getName()
+               << "): " << NumLoops.second << "\n";
+      }
+    }
+    return Changed;
+  }
+}; // class BitIdioms
+
+char BitIdioms::ID = 0;
+RegisterPass<BitIdioms> X("bit-idioms",
+                          "CSCD70: Bit-Manipulation Idiom Recognition");
+
+} // anonymous namespace
@@ -0,0 +1,71 @@
+#include "PeepholeEngine.h"
+
+#include <llvm/IR/InstIterator.h>
+#include <llvm/Transforms/Utils/Local.h>
+
+void PeepholeEngine::eraseIfDead(Instruction *const Inst) {
+  if (!isInstructionTriviallyDead(Inst)) {
+    return;
+  }
+  SmallVector<Instruction *, 4> Operands;
+  for (Value *const Operand : Inst->operands()) {
+    if (Instruction *const OperandInst = dyn_cast<Instruction>(Operand)) {
+      Operands.push_back(OperandInst);
+    }
+  }
+  WL.remove(Inst);
+  Inst->eraseFromParent();
+  for (Instruction *const OperandInst : Operands) {
+    eraseIfDead(OperandInst);
+  }
+}
+
+bool PeepholeEngine::run(Function &F) {
+  std::fill(NumHits.begin(), NumHits.end(), 0);
+  // Push in reverse order, so that the instructions get visited in program
+  // order, the operands before their users.
+  std::vector<Instruction *> Insts;
+  for (Instruction &Inst : instructions(F)) {
+    Insts.push_back(&Inst);
+  }
+  for (auto InstIt = Insts.rbegin(); InstIt != Insts.rend(); ++InstIt) {
+    WL.push(*InstIt);
+  }
+
+  IRBuilder<ConstantFolder, IRBuilderCallbackInserter> Builder(
+      F.getContext(), ConstantFolder(),
+      IRBuilderCallbackInserter(
+          [this](Instruction *const NewInst) { WL.push(NewInst); }));
+  bool Changed = false;
+  while (Instruction *const Inst = WL.pop()) {
+    for (unsigned RuleIdx = 0; RuleIdx < Rules.size(); ++RuleIdx) {
+      Builder.SetInsertPoint(Inst);
+      Value *const Replacement = Rules[RuleIdx].Rewrite(*Inst, Builder);
+      if (!Replacement) {
+        continue;
+      }
+      ++NumHits[RuleIdx];
+      Changed = true;
+      for (User *const U : Inst->users()) {
+        WL.push(cast<Instruction>(U));
+      }
+      if (Instruction *const ReplacementInst =
+              dyn_cast<Instruction>(Replacement)) {
+        WL.push(ReplacementInst);
+      }
+      Inst->replaceAllUsesWith(Replacement);
+      eraseIfDead(Inst);
+      break;
+    }
+  }
+  return Changed;
+}
+
+void PeepholeEngine::printHits(raw_ostream &Outs, const Function &F) const {
+  for (unsigned RuleIdx = 0; RuleIdx < Rules.size(); ++RuleIdx) {
+    if (NumHits[RuleIdx] != 0) {
+      Outs << Rules[RuleIdx].Name << " (" << F.getName()
+           << "): " << NumHits[RuleIdx] << "\n";
+    }
+  }
+}
@@ -0,0 +1,120 @@
+#pragma once // NOLINT(llvm-header-guard)
+
+/**
+ * @file Worklist-Driven Peephole Engine
+ */
+#include <llvm/ADT/DenseMap.h>
+#include <llvm/ADT/StringRef.h>
+#include <llvm/IR/Function.h>
+#include <llvm/IR/IRBuilder.h>
+#include <llvm/Support/raw_ostream.h>
+
+#include <functional>
+#include <vector>
+
+using namespace llvm;
+
+/**
+ * @brief A peephole rewrite rule.
+ */
+struct PeepholeRule {
+  const char *Name;
+  /**
+   * @brief Return the value that @c Inst can be replaced with, or nullptr if
+   *        the rule does not apply. New instructions are created through
+   *        @c Builder , which inserts them right before @c Inst , and only
+   *        once the rule is known to apply.
+   */
+  std::function<Value *(Instruction &Inst, IRBuilderBase &Builder)> Rewrite;
+};
+
+/**
+ * @brief Apply a set of peephole rules on a function until none of them
+ *        applies anymore.
+ *
+ * Every instruction is visited once. Whenever one gets rewritten, its users,
+ * its replacement and the instructions created along the way are visited
+ * again, as the rewrite may enable further ones on them. The instructions
+ * left without users by the rewrites are deleted. The rules are tried in
+ * order, and the first one that applies wins.
+ */
+class PeepholeEngine {
+private:
+  /**
+   * @brief The instructions to be visited, each at most once.
+   */
+  class Worklist {
+  private:
+    std::vector<Instruction *> Insts;
+    DenseMap<Instruction *, unsigned> InstIdxMap;
+
+  public:
+    void push(Instruction *const Inst) {
+      if (InstIdxMap.try_emplace(Inst, Insts.size()).second) {
+        Insts.push_back(Inst);
+      }
+    }
+    void remove(Instruction *const Inst) {
+      auto InstIdxIt = InstIdxMap.find(Inst);
+      if (InstIdxIt != InstIdxMap.end()) {
+        Insts[InstIdxIt->second] = nullptr;
+        InstIdxMap.erase(InstIdxIt);
+      }
+    }
+    /**
+     * @brief Pop the last pushed instruction, or return nullptr if the
+     *        worklist is empty.
+     */
+    Instruction *pop() {
+      while (!Insts.empty()) {
+        Instruction *const Inst = Insts.back();
+        Insts.pop_back();
+        if (Inst) {
+          InstIdxMap.erase(Inst);
+          return Inst;
+        }
+      }
+      return nullptr;
+    }
+  };
+
+  std::vector<PeepholeRule> Rules;
+  // Rule-Number of Hits Mapping, indexed the same way as the rules
+  std::vector<unsigned> NumHits;
+  Worklist WL;
+
+  /**
+   * @brief Delete @c Inst if it has become dead, and then its operands that
+   *        have become dead along with it.
+   */
+  void eraseIfDead(Instruction *const Inst);
+
+public:
+  explicit PeepholeEngine(std::vector<PeepholeRule> Rules)
+      : Rules(std::move(Rules)), NumHits(this->Rules.size()) {}
+
+  /**
+   * @brief Rewrite @c F until fixpoint.
+   * @return whether @c F has been changed
+   */
+  bool run(Function &F);
+  /**
+   * @brief Print the number of times that each rule has applied on @c F .
+   */
+  void printHits(raw_ostream &Outs, const Function &F) const;
+};
+
+/// Algebraic identities, e.g., @c x+0 → @c x
+const std::vector<PeepholeRule> &getAlgebraicIdentityRules();
+/// Strength reductions, e.g., @c x*8 → @c x<<3
+const std::vector<PeepholeRule> &getStrengthReductionRules();
+/// Print the latencies that the strength reductions of the multiplications
+/// are based on.
+void printMulCostModel(raw_ostream &Outs);
+/// Multi-instruction optimizations, e.g., @c (b-t)+t → @c b
+const std::vector<PeepholeRule> &getMultiInstOptRules();
+/// Floating-point identities and contractions that the fast-math flags allow
+/// for, e.g., @c x/2.0 → @c x*0.5
+const std::vector<PeepholeRule> &getFastMathRules();
+/// Bit-manipulation idioms, e.g., @c (x<<8)|(x>>24) → @c fshl(x,x,8)
+const std::vector<PeepholeRule> &getBitIdiomRules();
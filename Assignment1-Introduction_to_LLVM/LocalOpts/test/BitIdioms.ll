@@ -0,0 +1,201 @@
+; RUN: opt -S -load %dylibdir/libLocalOpts.so -bit-idioms \
+; RUN:     %s -o %basename_t 2>%basename_t.log
+; RUN: FileCheck --match-full-lines %s --input-file=%basename_t
+; RUN: FileCheck --match-full-lines %s --input-file=%basename_t.log \
+; RUN:     --check-prefix=STATS
+
+; unsigned rotl(unsigned x, unsigned s) {
+;   return (x << 8 | x >> 24) + (x << s | x >> (32 - s)) +
+;          (x >> (s & 31) | x << (-s & 31));
+; }
+; STATS:      rotate (rotate): 3
+define i32 @rotate(i32 %x, i32 %s) {
+; CHECK-LABEL: define i32 @rotate(i32 %x, i32 %s) {
+; CHECK-NEXT:   %1 = call i32 @llvm.fshl.i32(i32 %x, i32 %x, i32 8)
+; CHECK-NEXT:   %2 = call i32 @llvm.fshl.i32(i32 %x, i32 %x, i32 %s)
+; CHECK-NEXT:   %3 = and i32 %s, 31
+; CHECK-NEXT:   %4 = call i32 @llvm.fshr.i32(i32 %x, i32 %x, i32 %3)
+; CHECK-NEXT:   %5 = add i32 %1, %2
+; CHECK-NEXT:   %6 = add i32 %5, %4
+; CHECK-NEXT:   ret i32 %6
+  %1 = shl i32 %x, 8
+  %2 = lshr i32 %x, 24
+  %3 = or i32 %1, %2
+  %4 = shl i32 %x, %s
+  %5 = sub i32 32, %s
+  %6 = lshr i32 %x, %5
+  %7 = or i32 %6, %4
+  %8 = and i32 %s, 31
+  %9 = lshr i32 %x, %8
+  %10 = sub i32 0, %s
+  %11 = and i32 %10, 31
+  %12 = shl i32 %x, %11
+  %13 = or i32 %9, %12
+  %14 = add i32 %3, %7
+  %15 = add i32 %14, %13
+  ret i32 %15
+}
+
+; unsigned bswap(unsigned x) {
+;   return x << 24 | (x & 0xff00) << 8 | (x >> 8 & 0xff00) | x >> 24;
+; }
+; STATS-NEXT: bswap (bswap): 1
+define i32 @bswap(i32 %x) {
+; CHECK-LABEL: define i32 @bswap(i32 %x) {
+; CHECK-NEXT:   %rev = call i32 @llvm.bswap.i32(i32 %x)
+; CHECK-NEXT:   ret i32 %rev
+  %1 = shl i32 %x, 24
+  %2 = and i32 %x, 65280
+  %3 = shl i32 %2, 8
+  %4 = or i32 %1, %3
+  %5 = lshr i32 %x, 8
+  %6 = and i32 %5, 65280
+  %7 = or i32 %4, %6
+  %8 = lshr i32 %x, 24
+  %9 = or i32 %7, %8
+  ret i32 %9
+}
+
+; The population count, and those of the trailing zeros and of the leading
+; zeros (once smeared into ones), which get recognized once the former is.
+;
+; int popcount(unsigned x) {
+;   x = x - ((x >> 1) & 0x55555555);
+;   x = (x & 0x33333333) + ((x >> 2) & 0x33333333);
+;   x = (x + (x >> 4)) & 0x0f0f0f0f;
+;   return (x * 0x01010101) >> 24;
+; }
+; int cttz(unsigned x) { return popcount((x & -x) - 1); }
+; int ctlz(unsigned x) {
+;   x |= x >> 1; x |= x >> 2; x |= x >> 4; x |= x >> 8; x |= x >> 16;
+;   return popcount(~x);
+; }
+; STATS-NEXT: popcount (popcount): 1
+define i32 @popcount(i32 %x) {
+; CHECK-LABEL: define i32 @popcount(i32 %x) {
+; CHECK-NEXT:   %1 = call i32 @llvm.ctpop.i32(i32 %x)
+; CHECK-NEXT:   ret i32 %1
+  %1 = lshr i32 %x, 1
+  %2 = and i32 %1, 1431655765
+  %3 = sub i32 %x, %2
+  %4 = and i32 %3, 858993459
+  %5 = lshr i32 %3, 2
+  %6 = and i32 %5, 858993459
+  %7 = add i32 %4, %6
+  %8 = lshr i32 %7, 4
+  %9 = add i32 %7, %8
+  %10 = and i32 %9, 252645135
+  %11 = mul i32 %10, 16843009
+  %12 = lshr i32 %11, 24
+  ret i32 %12
+}
+
+; STATS-NEXT: cttz (cttz): 1
+define i32 @cttz(i32 %x) {
+; CHECK-LABEL: define i32 @cttz(i32 %x) {
+; CHECK-NEXT:   %1 = call i32 @llvm.cttz.i32(i32 %x, i1 false)
+; CHECK-NEXT:   ret i32 %1
+  %1 = sub i32 0, %x
+  %2 = and i32 %x, %1
+  %3 = add i32 %2, -1
+  %4 = call i32 @llvm.ctpop.i32(i32 %3)
+  ret i32 %4
+}
+
+; STATS-NEXT: popcount (ctlz): 1
+; STATS-NEXT: ctlz (ctlz): 1
+define i8 @ctlz(i8 %x) {
+; CHECK-LABEL: define i8 @ctlz(i8 %x) {
+; CHECK-NEXT:   %1 = call i8 @llvm.ctlz.i8(i8 %x, i1 false)
+; CHECK-NEXT:   ret i8 %1
+  %1 = lshr i8 %x, 1
+  %2 = or i8 %x, %1
+  %3 = lshr i8 %2, 2
+  %4 = or i8 %2, %3
+  %5 = lshr i8 %4, 4
+  %6 = or i8 %4, %5
+  %7 = xor i8 %6, -1
+  %8 = lshr i8 %7, 1
+  %9 = and i8 %8, 85
+  %10 = sub i8 %7, %9
+  %11 = and i8 %10, 51
+  %12 = lshr i8 %10, 2
+  %13 = and i8 %12, 51
+  %14 = add i8 %11, %13
+  %15 = lshr i8 %14, 4
+  %16 = add i8 %14, %15
+  %17 = and i8 %16, 15
+  ret i8 %17
+}
+
+; int popcount_loop(unsigned x) {
+;   int c = 0;
+;   if (x)
+;     do { x &= x - 1; ++c; } while (x);
+;   return c;
+; }
+; STATS-NEXT: popcount-loop (popcount_loop): 1
+define i32 @popcount_loop(i32 %x) {
+; CHECK-LABEL: define i32 @popcount_loop(i32 %x) {
+; CHECK-NEXT:   %1 = icmp eq i32 %x, 0
+; CHECK-NEXT:   %2 = call i32 @llvm.ctpop.i32(i32 %x)
+; CHECK-NEXT:   %3 = call i32 @llvm.umax.i32(i32 %2, i32 1)
+; CHECK-NEXT:   br i1 %1, label %exit, label %loop
+; CHECK-EMPTY:
+; CHECK-NEXT: loop:                                             ; preds = %0
+; CHECK-NEXT:   br label %exit
+; CHECK-EMPTY:
+; CHECK-NEXT: exit:                                             ; preds = %loop, %0
+; CHECK-NEXT:   %r = phi i32 [ 0, %0 ], [ %3, %loop ]
+; CHECK-NEXT:   ret i32 %r
+  %1 = icmp eq i32 %x, 0
+  br i1 %1, label %exit, label %loop
+
+loop:
+  %2 = phi i32 [ %x, %0 ], [ %4, %loop ]
+  %c = phi i32 [ 0, %0 ], [ %c.next, %loop ]
+  %3 = add i32 %2, -1
+  %4 = and i32 %2, %3
+  %c.next = add nuw nsw i32 %c, 1
+  %5 = icmp eq i32 %4, 0
+  br i1 %5, label %exit, label %loop
+
+exit:
+  %r = phi i32 [ 0, %0 ], [ %c.next, %loop ]
+  ret i32 %r
+}
+
+; The number of significant bits, i.e., the width minus the leading zeros
+;
+; int bits(unsigned long x) {
+;   int n = 0;
+;   do { x >>= 1; ++n; } while (x != 0);
+;   return n;
+; }
+; STATS-NEXT: ctlz-loop (bits): 1
+define i32 @bits(i64 %x) {
+; CHECK-LABEL: define i32 @bits(i64 %x) {
+; CHECK-NEXT: loop:
+; CHECK-NEXT:   %0 = call i64 @llvm.ctlz.i64(i64 %x, i1 false)
+; CHECK-NEXT:   %1 = sub i64 64, %0
+; CHECK-NEXT:   %2 = call i64 @llvm.umax.i64(i64 %1, i64 1)
+; CHECK-NEXT:   %3 = trunc i64 %2 to i32
+; CHECK-NEXT:   br label %exit
+; CHECK-EMPTY:
+; CHECK-NEXT: exit:                                             ; preds = %loop
+; CHECK-NEXT:   ret i32 %3
+  br label %loop
+
+loop:
+  %1 = phi i64 [ %x, %0 ], [ %2, %loop ]
+  %n = phi i32 [ 0, %0 ], [ %n.next, %loop ]
+  %2 = lshr i64 %1, 1
+  %n.next = add i32 %n, 1
+  %3 = icmp ne i64 %2, 0
+  br i1 %3, label %loop, label %exit
+
+exit:
+  ret i32 %n.next
+}
+
+declare i32 @llvm.ctpop.i32(i32)
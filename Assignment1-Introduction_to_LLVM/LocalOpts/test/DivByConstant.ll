@@ -0,0 +1,59 @@
+; RUN: opt -S -load %dylibdir/libLocalOpts.so -strength-reduction \
+; RUN:     %s -o %basename_t 2>%basename_t.log
+; RUN: FileCheck --match-full-lines %s --input-file=%basename_t
+; RUN: FileCheck --match-full-lines %s --input-file=%basename_t.log \
+; RUN:     --check-prefix=STATS
+
+; STATS:      sdiv-pow2 (sdiv): 1
+; STATS-NEXT: sdiv-magic (sdiv): 2
+define i32 @sdiv(i32 %0) {
+; CHECK-LABEL: define i32 @sdiv(i32 %0) {
+; CHECK-NEXT:   %2 = sext i32 %0 to i64
+; CHECK-NEXT:   %3 = mul i64 %2, -1840700269
+; CHECK-NEXT:   %4 = lshr i64 %3, 32
+; CHECK-NEXT:   %5 = trunc i64 %4 to i32
+; CHECK-NEXT:   %6 = add i32 %5, %0
+; CHECK-NEXT:   %7 = ashr i32 %6, 2
+; CHECK-NEXT:   %8 = lshr i32 %7, 31
+; CHECK-NEXT:   %9 = add i32 %7, %8
+; CHECK-NEXT:   %10 = ashr i32 %9, 2
+; CHECK-NEXT:   %11 = lshr i32 %10, 29
+; CHECK-NEXT:   %12 = add i32 %9, %11
+; CHECK-NEXT:   %13 = ashr i32 %12, 3
+; CHECK-NEXT:   %14 = sub i32 0, %13
+; CHECK-NEXT:   %15 = ashr exact i32 %14, 2
+; CHECK-NEXT:   %16 = mul i32 %15, -1431655765
+; CHECK-NEXT:   ret i32 %16
+  %2 = sdiv i32 %0, 7
+  %3 = sdiv i32 %2, -8
+  %4 = sdiv exact i32 %3, 12
+  ret i32 %4
+}
+
+; STATS:      mul-decompose (udiv): 1
+; STATS-NEXT: udiv-magic (udiv): 1
+; STATS-NEXT: urem-const (udiv): 1
+define i32 @udiv(i32 %0) {
+; CHECK-LABEL: define i32 @udiv(i32 %0) {
+; CHECK-NEXT:   %2 = zext i32 %0 to i64
+; CHECK-NEXT:   %3 = mul i64 %2, 613566757
+; CHECK-NEXT:   %4 = lshr i64 %3, 32
+; CHECK-NEXT:   %5 = trunc i64 %4 to i32
+; CHECK-NEXT:   %6 = sub i32 %0, %5
+; CHECK-NEXT:   %7 = lshr i32 %6, 1
+; CHECK-NEXT:   %8 = add i32 %7, %5
+; CHECK-NEXT:   %9 = lshr i32 %8, 2
+; CHECK-NEXT:   %10 = zext i32 %9 to i64
+; CHECK-NEXT:   %11 = mul i64 %10, 3435973837
+; CHECK-NEXT:   %12 = lshr i64 %11, 32
+; CHECK-NEXT:   %13 = trunc i64 %12 to i32
+; CHECK-NEXT:   %14 = lshr i32 %13, 3
+; CHECK-NEXT:   %15 = shl i32 %14, 1
+; CHECK-NEXT:   %16 = shl i32 %14, 3
+; CHECK-NEXT:   %17 = add i32 %15, %16
+; CHECK-NEXT:   %18 = sub i32 %9, %17
+; CHECK-NEXT:   ret i32 %18
+  %2 = udiv i32 %0, 7
+  %3 = urem i32 %2, 10
+  ret i32 %3
+}
@@ -0,0 +1,88 @@
+; RUN: opt -S -load %dylibdir/libLocalOpts.so -fast-math-opt \
+; RUN:     %s -o %basename_t 2>%basename_t.log
+; RUN: FileCheck --match-full-lines %s --input-file=%basename_t
+; RUN: FileCheck --match-full-lines %s --input-file=%basename_t.log \
+; RUN:     --check-prefix=STATS
+
+; The identities that hold regardless of the fast-math flags
+; STATS:      fadd-zero (strict): 1
+; STATS-NEXT: fsub-zero (strict): 1
+; STATS-NEXT: fmul-one (strict): 1
+; STATS-NEXT: fdiv-one (strict): 1
+; STATS-NEXT: fdiv-reciprocal (strict): 1
+define double @strict(double %0) {
+; CHECK-LABEL: define double @strict(double %0) {
+; CHECK-NEXT:   %2 = fmul double %0, 5.000000e-01
+; CHECK-NEXT:   %3 = fadd double %2, 0.000000e+00
+; CHECK-NEXT:   %4 = fmul double %3, 0.000000e+00
+; CHECK-NEXT:   %5 = fdiv double %4, 3.000000e+00
+; CHECK-NEXT:   %6 = fmul double %5, %0
+; CHECK-NEXT:   %7 = fadd double %6, %0
+; CHECK-NEXT:   ret double %7
+  %2 = fadd double %0, -0.000000e+00
+  %3 = fsub double %2, 0.000000e+00
+  %4 = fmul double 1.000000e+00, %3
+  %5 = fdiv double %4, 1.000000e+00
+  %6 = fdiv double %5, 2.000000e+00
+  %7 = fadd double %6, 0.000000e+00
+  %8 = fmul double %7, 0.000000e+00
+  %9 = fdiv double %8, 3.000000e+00
+  %10 = fmul double %9, %0
+  %11 = fadd double %10, %0
+  ret double %11
+}
+
+; ... and the ones that need them
+; STATS-NEXT: fadd-zero (relaxed): 1
+; STATS-NEXT: fmul-zero (relaxed): 1
+; STATS-NEXT: fdiv-reciprocal (relaxed): 1
+define double @relaxed(double %0, double %1) {
+; CHECK-LABEL: define double @relaxed(double %0, double %1) {
+; CHECK-NEXT:   %3 = fadd double %0, 0.000000e+00
+; CHECK-NEXT:   %4 = fmul arcp double %3, 0x3FD5555555555555
+; CHECK-NEXT:   ret double %4
+  %3 = fadd nsz double %0, 0.000000e+00
+  %4 = fmul nnan nsz double %1, 0.000000e+00
+  %5 = fadd double %3, %4
+  %6 = fdiv arcp double %5, 3.000000e+00
+  ret double %6
+}
+
+; The multiplications get fused with the additions and subtractions that they
+; are the only operand of, if both allow contraction.
+; STATS-NEXT: fmuladd-contract (contract): 4
+define float @contract(float %a, float %b, float %c) {
+; CHECK-LABEL: define float @contract(float %a, float %b, float %c) {
+; CHECK-NEXT:   %1 = call contract float @llvm.fmuladd.f32(float %a, float %b, float %c)
+; CHECK-NEXT:   %2 = fneg contract float %c
+; CHECK-NEXT:   %3 = call contract float @llvm.fmuladd.f32(float %1, float %b, float %2)
+; CHECK-NEXT:   %4 = fneg contract float %a
+; CHECK-NEXT:   %5 = call contract float @llvm.fmuladd.f32(float %4, float %3, float %c)
+; CHECK-NEXT:   %6 = call contract float @llvm.fmuladd.f32(float %5, float %5, float %5)
+; CHECK-NEXT:   %7 = fmul float %6, %a
+; CHECK-NEXT:   %8 = fadd contract float %7, %c
+; CHECK-NEXT:   ret float %8
+  %1 = fmul contract float %a, %b
+  %2 = fadd contract float %c, %1
+  %3 = fmul contract float %2, %b
+  %4 = fsub contract float %3, %c
+  %5 = fmul contract float %a, %4
+  %6 = fsub contract float %c, %5
+  %7 = fmul contract float %6, %6
+  %8 = fadd contract float %7, %6
+  %9 = fmul float %8, %a
+  %10 = fadd contract float %9, %c
+  ret float %10
+}
+
+; Different powers of 2 in each lane
+; STATS-NEXT: fdiv-reciprocal (lanes): 1
+define <4 x float> @lanes(<4 x float> %0) {
+; CHECK-LABEL: define <4 x float> @lanes(<4 x float> %0) {
+; CHECK-NEXT:   %2 = fmul <4 x float> %0, <float 5.000000e-01, float 2.500000e-01, float 2.000000e+00, float -1.250000e-01>
+; CHECK-NEXT:   %3 = fdiv <4 x float> %2, <float 2.000000e+00, float 4.000000e+00, float 3.000000e+00, float -8.000000e+00>
+; CHECK-NEXT:   ret <4 x float> %3
+  %2 = fdiv <4 x float> %0, <float 2.0, float 4.0, float 0.5, float -8.0>
+  %3 = fdiv <4 x float> %2, <float 2.0, float 4.0, float 3.0, float -8.0>
+  ret <4 x float> %3
+}
@@ -0,0 +1,181 @@
+; RUN: opt -S -load %dylibdir/libLocalOpts.so -if-conversion \
+; RUN:     %s -o %basename_t 2>%basename_t.log
+; RUN: FileCheck --match-full-lines %s --input-file=%basename_t
+; RUN: FileCheck --match-full-lines %s --input-file=%basename_t.log \
+; RUN:     --check-prefix=STATS
+
+; int clamp(int x, int lo, int hi) {
+;   return x < lo ? lo : (x > hi ? hi : x);
+; }
+;
+; The inner triangle has to be converted first, which leaves the outer diamond
+; with single blocks as its arms.
+; STATS:      If-Converted Diamonds (clamp): 1
+; STATS-NEXT: If-Converted Triangles (clamp): 1
+define i32 @clamp(i32 %x, i32 %lo, i32 %hi) {
+; CHECK-LABEL: define i32 @clamp(i32 %x, i32 %lo, i32 %hi) {
+; CHECK-NEXT:   %1 = icmp slt i32 %x, %lo
+; CHECK-NEXT:   %2 = icmp sgt i32 %x, %hi
+; CHECK-NEXT:   %r = select i1 %2, i32 %hi, i32 %x
+; CHECK-NEXT:   %s = select i1 %1, i32 %lo, i32 %r
+; CHECK-NEXT:   ret i32 %s
+  %1 = icmp slt i32 %x, %lo
+  br i1 %1, label %4, label %2
+
+2:
+  %3 = icmp sgt i32 %x, %hi
+  br i1 %3, label %5, label %6
+
+4:
+  br label %7
+
+5:
+  br label %6
+
+6:
+  %r = phi i32 [ %hi, %5 ], [ %x, %2 ]
+  br label %7
+
+7:
+  %s = phi i32 [ %lo, %4 ], [ %r, %6 ]
+  ret i32 %s
+}
+
+; int absdiff(int a, int b) { return a > b ? a - b : b - a; }
+; STATS-NEXT: If-Converted Diamonds (absdiff): 1
+; STATS-NEXT: If-Converted Triangles (absdiff): 0
+define i32 @absdiff(i32 %a, i32 %b) {
+; CHECK-LABEL: define i32 @absdiff(i32 %a, i32 %b) {
+; CHECK-NEXT:   %1 = icmp sgt i32 %a, %b
+; CHECK-NEXT:   %2 = sub nsw i32 %a, %b
+; CHECK-NEXT:   %3 = sub nsw i32 %b, %a
+; CHECK-NEXT:   %4 = select i1 %1, i32 %2, i32 %3
+; CHECK-NEXT:   ret i32 %4
+  %1 = icmp sgt i32 %a, %b
+  br i1 %1, label %2, label %4
+
+2:
+  %3 = sub nsw i32 %a, %b
+  br label %6
+
+4:
+  %5 = sub nsw i32 %b, %a
+  br label %6
+
+6:
+  %7 = phi i32 [ %3, %2 ], [ %5, %4 ]
+  ret i32 %7
+}
+
+; The division may trap, and the load may not be dereferenceable, if they get
+; executed regardless of the condition.
+; STATS-NEXT: If-Converted Diamonds (unsafe): 0
+; STATS-NEXT: If-Converted Triangles (unsafe): 0
+define i32 @unsafe(i32 %a, i32 %b, i32* %p) {
+; CHECK-LABEL: define i32 @unsafe(i32 %a, i32 %b, i32* %p) {
+; CHECK-NEXT:   %1 = icmp ne i32 %b, 0
+; CHECK-NEXT:   br i1 %1, label %2, label %4
+; CHECK-EMPTY:
+; CHECK-NEXT: 2:                                                ; preds = %0
+; CHECK-NEXT:   %3 = sdiv i32 %a, %b
+; CHECK-NEXT:   br label %6
+; CHECK-EMPTY:
+; CHECK-NEXT: 4:                                                ; preds = %0
+; CHECK-NEXT:   %5 = load i32, i32* %p, align 4
+; CHECK-NEXT:   br label %6
+; CHECK-EMPTY:
+; CHECK-NEXT: 6:                                                ; preds = %4, %2
+; CHECK-NEXT:   %7 = phi i32 [ %3, %2 ], [ %5, %4 ]
+; CHECK-NEXT:   ret i32 %7
+  %1 = icmp ne i32 %b, 0
+  br i1 %1, label %2, label %4
+
+2:
+  %3 = sdiv i32 %a, %b
+  br label %6
+
+4:
+  %5 = load i32, i32* %p
+  br label %6
+
+6:
+  %7 = phi i32 [ %3, %2 ], [ %5, %4 ]
+  ret i32 %7
+}
+
+; A branch that is almost never taken is predicted well, and so is not worth
+; executing its arm every time.
+; STATS-NEXT: If-Converted Diamonds (biased): 0
+; STATS-NEXT: If-Converted Triangles (biased): 0
+define i32 @biased(i32 %a, i32 %b) {
+; CHECK-LABEL: define i32 @biased(i32 %a, i32 %b) {
+; CHECK-NEXT:   %1 = icmp eq i32 %a, 0
+; CHECK-NEXT:   br i1 %1, label %2, label %4, !prof !0
+; CHECK-EMPTY:
+; CHECK-NEXT: 2:                                                ; preds = %0
+; CHECK-NEXT:   %3 = mul i32 %b, %b
+; CHECK-NEXT:   br label %4
+; CHECK-EMPTY:
+; CHECK-NEXT: 4:                                                ; preds = %2, %0
+; CHECK-NEXT:   %5 = phi i32 [ %3, %2 ], [ %a, %0 ]
+; CHECK-NEXT:   ret i32 %5
+  %1 = icmp eq i32 %a, 0
+  br i1 %1, label %2, label %4, !prof !0
+
+2:
+  %3 = mul i32 %b, %b
+  br label %4
+
+4:
+  %5 = phi i32 [ %3, %2 ], [ %a, %0 ]
+  ret i32 %5
+}
+
+; Both arms are too long to be worth executing every time.
+; STATS-NEXT: If-Converted Diamonds (expensive): 0
+; STATS-NEXT: If-Converted Triangles (expensive): 0
+define i32 @expensive(i32 %a, i32 %b) {
+; CHECK-LABEL: define i32 @expensive(i32 %a, i32 %b) {
+; CHECK-NEXT:   %1 = icmp sgt i32 %a, %b
+; CHECK-NEXT:   br i1 %1, label %2, label %7
+; CHECK-EMPTY:
+; CHECK-NEXT: 2:                                                ; preds = %0
+; CHECK-NEXT:   %3 = mul i32 %a, %a
+; CHECK-NEXT:   %4 = mul i32 %3, %a
+; CHECK-NEXT:   %5 = mul i32 %4, %a
+; CHECK-NEXT:   %6 = mul i32 %5, %a
+; CHECK-NEXT:   br label %12
+; CHECK-EMPTY:
+; CHECK-NEXT: 7:                                                ; preds = %0
+; CHECK-NEXT:   %8 = mul i32 %b, %b
+; CHECK-NEXT:   %9 = mul i32 %8, %b
+; CHECK-NEXT:   %10 = mul i32 %9, %b
+; CHECK-NEXT:   %11 = mul i32 %10, %b
+; CHECK-NEXT:   br label %12
+; CHECK-EMPTY:
+; CHECK-NEXT: 12:                                               ; preds = %7, %2
+; CHECK-NEXT:   %13 = phi i32 [ %6, %2 ], [ %11, %7 ]
+; CHECK-NEXT:   ret i32 %13
+  %1 = icmp sgt i32 %a, %b
+  br i1 %1, label %2, label %7
+
+2:
+  %3 = mul i32 %a, %a
+  %4 = mul i32 %3, %a
+  %5 = mul i32 %4, %a
+  %6 = mul i32 %5, %a
+  br label %12
+
+7:
+  %8 = mul i32 %b, %b
+  %9 = mul i32 %8, %b
+  %10 = mul i32 %9, %b
+  %11 = mul i32 %10, %b
+  br label %12
+
+12:
+  %13 = phi i32 [ %6, %2 ], [ %11, %7 ]
+  ret i32 %13
+}
+
+!0 = !{!"branch_weights", i32 1, i32 1000}
@@ -0,0 +1,112 @@
+; The kernel sums its elements differently on either side of a threshold,
+; which a predictor guesses right for sorted elements, and wrong half of the
+; time for random ones. Both runs have to print the same sums before and
+; after the if-conversion. With 1000 runs instead of 10, on an x86-64 machine,
+; the random elements took 0.88s before and 0.20s after, and the sorted ones
+; 0.13s before and 0.19s after, as the kernel then always pays for both arms.
+; RUN: opt -load %dylibdir/libLocalOpts.so -if-conversion %s \
+; RUN:     -o %basename_t.bc 2>%basename_t.log
+; RUN: FileCheck --match-full-lines %s --input-file=%basename_t.log \
+; RUN:     --check-prefix=STATS
+; STATS:      If-Converted Diamonds (kernel): 1
+; STATS-NEXT: If-Converted Triangles (kernel): 0
+; STATS-NEXT: If-Converted Diamonds (run): 0
+; STATS-NEXT: If-Converted Triangles (run): 0
+; STATS-NEXT: If-Converted Diamonds (main): 0
+; STATS-NEXT: If-Converted Triangles (main): 0
+; RUN: llc %s -o %basename_t.before.s
+; RUN: clang %basename_t.before.s -o %basename_t.before.exe
+; RUN: ./%basename_t.before.exe | FileCheck --match-full-lines --check-prefix=CORRECTNESS %s
+; RUN: llc %basename_t.bc -o %basename_t.after.s
+; RUN: clang %basename_t.after.s -o %basename_t.after.exe
+; RUN: ./%basename_t.after.exe | FileCheck --match-full-lines --check-prefix=CORRECTNESS %s
+; CORRECTNESS: random: 93876320
+; CORRECTNESS-NEXT: sorted: 93716480
+
+@.random = private constant [12 x i8] c"random: %d\0A\00"
+@.sorted = private constant [12 x i8] c"sorted: %d\0A\00"
+@a = global [65536 x i32] zeroinitializer
+
+declare i32 @printf(i8*, ...)
+
+; int kernel(int *a, int n) {
+;   int s = 0;
+;   for (int i = 0; i < n; ++i)
+;     s += a[i] < 128 ? a[i] * 3 : a[i] >> 1;
+;   return s;
+; }
+define i32 @kernel(i32* %a, i32 %n) {
+entry:
+  br label %loop
+
+loop:
+  %i = phi i32 [ 0, %entry ], [ %i.next, %join ]
+  %s = phi i32 [ 0, %entry ], [ %s.next, %join ]
+  %p = getelementptr inbounds i32, i32* %a, i32 %i
+  %x = load i32, i32* %p
+  %small = icmp slt i32 %x, 128
+  br i1 %small, label %then, label %else
+
+then:
+  %tripled = mul nsw i32 %x, 3
+  br label %join
+
+else:
+  %halved = ashr i32 %x, 1
+  br label %join
+
+join:
+  %term = phi i32 [ %tripled, %then ], [ %halved, %else ]
+  %s.next = add nsw i32 %s, %term
+  %i.next = add nsw i32 %i, 1
+  %cond = icmp slt i32 %i.next, %n
+  br i1 %cond, label %loop, label %exit
+
+exit:
+  ret i32 %s.next
+}
+
+; Sum the kernel over 10 runs on the elements, which are either random
+; between 0 and 255, or sorted, i.e., each of those values 256 times in a row.
+define i32 @run(i1 %sorted) {
+entry:
+  %a = getelementptr [65536 x i32], [65536 x i32]* @a, i32 0, i32 0
+  br label %fill
+
+fill:
+  %i = phi i32 [ 0, %entry ], [ %i.next, %fill ]
+  %seed = phi i32 [ 12345, %entry ], [ %seed.next, %fill ]
+  %seed.mul = mul i32 %seed, 1103515245
+  %seed.next = add i32 %seed.mul, 12345
+  %seed.high = lshr i32 %seed.next, 16
+  %random = and i32 %seed.high, 255
+  %ordered = lshr i32 %i, 8
+  %x = select i1 %sorted, i32 %ordered, i32 %random
+  %p = getelementptr inbounds i32, i32* %a, i32 %i
+  store i32 %x, i32* %p
+  %i.next = add nsw i32 %i, 1
+  %fill.cond = icmp slt i32 %i.next, 65536
+  br i1 %fill.cond, label %fill, label %repeat
+
+repeat:
+  %j = phi i32 [ 0, %fill ], [ %j.next, %repeat ]
+  %sum = phi i32 [ 0, %fill ], [ %sum.next, %repeat ]
+  %k = call i32 @kernel(i32* %a, i32 65536)
+  %sum.next = add i32 %sum, %k
+  %j.next = add nsw i32 %j, 1
+  %repeat.cond = icmp slt i32 %j.next, 10
+  br i1 %repeat.cond, label %repeat, label %done
+
+done:
+  ret i32 %sum.next
+}
+
+define i32 @main() {
+  %random = call i32 @run(i1 false)
+  %random.fmt = getelementptr [12 x i8], [12 x i8]* @.random, i32 0, i32 0
+  call i32 (i8*, ...) @printf(i8* %random.fmt, i32 %random)
+  %sorted = call i32 @run(i1 true)
+  %sorted.fmt = getelementptr [12 x i8], [12 x i8]* @.sorted, i32 0, i32 0
+  call i32 (i8*, ...) @printf(i8* %sorted.fmt, i32 %sorted)
+  ret i32 0
+}
@@ -0,0 +1,60 @@
+; RUN: opt -S -load %dylibdir/libLocalOpts.so -strength-reduction \
+; RUN:     %s -o %basename_t 2>%basename_t.log
+; RUN: FileCheck --match-full-lines %s --input-file=%basename_t
+; RUN: FileCheck --match-full-lines %s --input-file=%basename_t.log \
+; RUN:     --check-prefix=STATS
+
+; STATS: Multiplication Cost Model: mul=3, vector-mul=10, shift=1, add=1, max-insts=4
+
+; STATS-NEXT: mul-decompose (mul10): 1
+define i32 @mul10(i32 %0) {
+; CHECK-LABEL: define i32 @mul10(i32 %0) {
+; CHECK-NEXT:   %2 = shl i32 %0, 1
+; CHECK-NEXT:   %3 = shl i32 %0, 3
+; CHECK-NEXT:   %4 = add i32 %2, %3
+; CHECK-NEXT:   ret i32 %4
+  %2 = mul nsw i32 %0, 10
+  ret i32 %2
+}
+
+; STATS-NEXT: mul-decompose (mul15): 1
+define i32 @mul15(i32 %0) {
+; CHECK-LABEL: define i32 @mul15(i32 %0) {
+; CHECK-NEXT:   %2 = shl i32 %0, 4
+; CHECK-NEXT:   %3 = sub i32 %2, %0
+; CHECK-NEXT:   ret i32 %3
+  %2 = mul i32 15, %0
+  ret i32 %2
+}
+
+; STATS-NEXT: mul-decompose (mul_neg7): 1
+define i32 @mul_neg7(i32 %0) {
+; CHECK-LABEL: define i32 @mul_neg7(i32 %0) {
+; CHECK-NEXT:   %2 = shl i32 %0, 3
+; CHECK-NEXT:   %3 = sub i32 %0, %2
+; CHECK-NEXT:   ret i32 %3
+  %2 = mul i32 %0, -7
+  ret i32 %2
+}
+
+; 45 = 64 - 16 - 4 + 1 takes 6 instructions.
+define i32 @mul45(i32 %0) {
+; CHECK-LABEL: define i32 @mul45(i32 %0) {
+; CHECK-NEXT:   %2 = mul i32 %0, 45
+; CHECK-NEXT:   ret i32 %2
+  %2 = mul i32 %0, 45
+  ret i32 %2
+}
+
+; The multiplication of i128 operands costs 4 times more than that of i64
+; ones, unlike the shifts and additions, which cost twice more.
+; STATS-NEXT: mul-decompose (mul_i128): 1
+define i128 @mul_i128(i128 %0) {
+; CHECK-LABEL: define i128 @mul_i128(i128 %0) {
+; CHECK-NEXT:   %2 = shl i128 %0, 2
+; CHECK-NEXT:   %3 = shl i128 %0, 65
+; CHECK-NEXT:   %4 = add i128 %2, %3
+; CHECK-NEXT:   ret i128 %4
+  %2 = mul i128 %0, 36893488147419103236
+  ret i128 %2
+}
@@ -0,0 +1,38 @@
+; RUN: opt -S -load %dylibdir/libLocalOpts.so -peephole \
+; RUN:     %s -o %basename_t 2>%basename_t.log
+; RUN: FileCheck --match-full-lines %s --input-file=%basename_t
+; RUN: FileCheck --match-full-lines %s --input-file=%basename_t.log \
+; RUN:     --check-prefix=STATS
+
+; The rewrites enable one another: Cancelling the subtractions exposes the
+; constant operands of the multiplications, which then become an identity and
+; a shift, and the multiplication by zero leaves the subtraction of zero.
+;
+; int bar(int a, int t) {
+;   int r0 = a * (t + (1 - t));
+;   int r1 = r0 * ((8 - t) + t);
+;   int r2 = r1 - r1 * 0;
+;   return r2 / 4;  // exact
+; }
+; STATS:      sub-zero (bar): 1
+; STATS-NEXT: mul-one (bar): 1
+; STATS-NEXT: mul-zero (bar): 1
+; STATS-NEXT: add-sub-cancel (bar): 2
+; STATS-NEXT: mul-pow2 (bar): 1
+; STATS-NEXT: sdiv-pow2 (bar): 1
+define i32 @bar(i32 %0, i32 %1) {
+; CHECK-LABEL: define i32 @bar(i32 %0, i32 %1) {
+; CHECK-NEXT:   %3 = shl i32 %0, 3
+; CHECK-NEXT:   %4 = ashr exact i32 %3, 2
+; CHECK-NEXT:   ret i32 %4
+  %3 = sub i32 1, %1
+  %4 = add i32 %1, %3
+  %5 = mul nsw i32 %0, %4
+  %6 = sub i32 8, %1
+  %7 = add i32 %6, %1
+  %8 = mul i32 %5, %7
+  %9 = mul i32 %8, 0
+  %10 = sub i32 %8, %9
+  %11 = sdiv exact i32 %10, 4
+  ret i32 %11
+}
@@ -0,0 +1,133 @@
+; RUN: opt -S -load %dylibdir/libLocalOpts.so -local-reassociate \
+; RUN:     %s -o %basename_t 2>%basename_t.log
+; RUN: FileCheck --match-full-lines %s --input-file=%basename_t
+; RUN: FileCheck --match-full-lines %s --input-file=%basename_t.log \
+; RUN:     --check-prefix=STATS
+
+; The constants of a chain get folded into one, wherever they appear in it.
+;
+; int chain(int x) { return (x + 3) + 5; }
+; int mix(int a, int b, int c) { return ((c + 3) - (a - b)) + 5; }
+; STATS:      Reassociated Trees (chain): 1
+; STATS-NEXT: Folded Constants (chain): 1
+; STATS-NEXT: Cancelled Pairs (chain): 0
+define i32 @chain(i32 %x) {
+; CHECK-LABEL: define i32 @chain(i32 %x) {
+; CHECK-NEXT:   %1 = add i32 %x, 8
+; CHECK-NEXT:   ret i32 %1
+  %1 = add i32 %x, 3
+  %2 = add i32 %1, 5
+  ret i32 %2
+}
+
+; STATS-NEXT: Reassociated Trees (mix): 1
+; STATS-NEXT: Folded Constants (mix): 1
+; STATS-NEXT: Cancelled Pairs (mix): 0
+define i32 @mix(i32 %a, i32 %b, i32 %c) {
+; CHECK-LABEL: define i32 @mix(i32 %a, i32 %b, i32 %c) {
+; CHECK-NEXT:   %1 = sub i32 %b, %a
+; CHECK-NEXT:   %2 = add i32 %1, %c
+; CHECK-NEXT:   %3 = add i32 %2, 8
+; CHECK-NEXT:   ret i32 %3
+  %1 = add i32 %c, 3
+  %2 = sub i32 %a, %b
+  %3 = sub i32 %1, %2
+  %4 = add i32 %3, 5
+  ret i32 %4
+}
+
+; The inverse pairs cancel out even if they are not next to each other.
+;
+; int cancel(int a, int b, int t) { return t + (a + (b - t)); }
+; STATS-NEXT: Reassociated Trees (cancel): 1
+; STATS-NEXT: Folded Constants (cancel): 0
+; STATS-NEXT: Cancelled Pairs (cancel): 1
+define i32 @cancel(i32 %a, i32 %b, i32 %t) {
+; CHECK-LABEL: define i32 @cancel(i32 %a, i32 %b, i32 %t) {
+; CHECK-NEXT:   %1 = add i32 %a, %b
+; CHECK-NEXT:   ret i32 %1
+  %1 = sub i32 %b, %t
+  %2 = add i32 %a, %1
+  %3 = add i32 %t, %2
+  ret i32 %3
+}
+
+; Both sums get rebuilt into the same canonical form, which makes them
+; available expressions of one another.
+;
+; int cse(int a, int b, int c) { return ((c + b) + a) * ((a + c) + b); }
+; STATS-NEXT: Reassociated Trees (cse): 2
+; STATS-NEXT: Folded Constants (cse): 0
+; STATS-NEXT: Cancelled Pairs (cse): 0
+define i32 @cse(i32 %a, i32 %b, i32 %c) {
+; CHECK-LABEL: define i32 @cse(i32 %a, i32 %b, i32 %c) {
+; CHECK-NEXT:   %1 = add i32 %a, %b
+; CHECK-NEXT:   %2 = add i32 %1, %c
+; CHECK-NEXT:   %3 = add i32 %a, %b
+; CHECK-NEXT:   %4 = add i32 %3, %c
+; CHECK-NEXT:   %5 = mul i32 %2, %4
+; CHECK-NEXT:   ret i32 %5
+  %1 = add i32 %c, %b
+  %2 = add i32 %1, %a
+  %3 = add i32 %a, %c
+  %4 = add i32 %3, %b
+  %5 = mul i32 %2, %4
+  ret i32 %5
+}
+
+; a ^ a cancels out, and so does ~b & b, which in turn leaves the disjunction
+; with a single operand.
+;
+; int bits(int a, int b) {
+;   int t = ((a ^ b) ^ 7) ^ a;
+;   return (t ^ 1) | ((~b & t) & b);
+; }
+; STATS-NEXT: Reassociated Trees (bits): 4
+; STATS-NEXT: Folded Constants (bits): 1
+; STATS-NEXT: Cancelled Pairs (bits): 2
+define i32 @bits(i32 %a, i32 %b) {
+; CHECK-LABEL: define i32 @bits(i32 %a, i32 %b) {
+; CHECK-NEXT:   %1 = xor i32 %b, 6
+; CHECK-NEXT:   ret i32 %1
+  %1 = xor i32 %a, %b
+  %2 = xor i32 %1, 7
+  %3 = xor i32 %2, %a
+  %4 = xor i32 %3, 1
+  %n = xor i32 %b, -1
+  %5 = and i32 %n, %3
+  %6 = and i32 %5, %b
+  %7 = or i32 %4, %6
+  ret i32 %7
+}
+
+; The coefficients of the constants keep their sign in integers wider than 64
+; bits, and in vectors.
+;
+; __int128 wide(__int128 x) { return (x - 5) + 1; }
+; STATS-NEXT: Reassociated Trees (wide): 1
+; STATS-NEXT: Folded Constants (wide): 1
+; STATS-NEXT: Cancelled Pairs (wide): 0
+define i128 @wide(i128 %x) {
+; CHECK-LABEL: define i128 @wide(i128 %x) {
+; CHECK-NEXT:   %1 = add i128 %x, -4
+; CHECK-NEXT:   ret i128 %1
+  %1 = sub i128 %x, 5
+  %2 = add i128 %1, 1
+  ret i128 %2
+}
+
+; typedef int v4si __attribute__((vector_size(16)));
+; v4si vector(v4si x, v4si y) { return ((x - 5) - y) + (v4si){1, 2, 3, 4} + y; }
+; STATS-NEXT: Reassociated Trees (vector): 1
+; STATS-NEXT: Folded Constants (vector): 1
+; STATS-NEXT: Cancelled Pairs (vector): 1
+define <4 x i32> @vector(<4 x i32> %x, <4 x i32> %y) {
+; CHECK-LABEL: define <4 x i32> @vector(<4 x i32> %x, <4 x i32> %y) {
+; CHECK-NEXT:   %1 = add <4 x i32> %x, <i32 -4, i32 -3, i32 -2, i32 -1>
+; CHECK-NEXT:   ret <4 x i32> %1
+  %1 = sub <4 x i32> %x, <i32 5, i32 5, i32 5, i32 5>
+  %2 = sub <4 x i32> %1, %y
+  %3 = add <4 x i32> %2, <i32 1, i32 2, i32 3, i32 4>
+  %4 = add <4 x i32> %3, %y
+  ret <4 x i32> %4
+}
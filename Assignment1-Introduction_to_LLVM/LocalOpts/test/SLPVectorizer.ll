@@ -0,0 +1,148 @@
+; RUN: opt -S -load %dylibdir/libLocalOpts.so -local-slp \
+; RUN:     %s -o %basename_t 2>%basename_t.log
+; RUN: FileCheck --match-full-lines %s --input-file=%basename_t
+; RUN: FileCheck --match-full-lines %s --input-file=%basename_t.log \
+; RUN:     --check-prefix=STATS
+
+; An unrolled 3-point stencil, whose loads overlap from one lane to the next
+;
+; void stencil(float *restrict a, float *restrict b, long i) {
+;   for (long j = i; j < i + 4; ++j)
+;     b[j] = (a[j-1] + a[j] + a[j+1]) * (1.0f / 3);
+; }
+; STATS:      Vectorized Trees (stencil): 1
+; STATS-NEXT: Vectorized Scalars (stencil): 28
+define void @stencil(float* noalias %a, float* noalias %b, i64 %i) {
+; CHECK-LABEL: define void @stencil(float* noalias %a, float* noalias %b, i64 %i) {
+; CHECK-NEXT:   %im1 = add nsw i64 %i, -1
+; CHECK-NEXT:   %ip1 = add nsw i64 %i, 1
+; CHECK-NEXT:   %pm1 = getelementptr inbounds float, float* %a, i64 %im1
+; CHECK-NEXT:   %p0 = getelementptr inbounds float, float* %a, i64 %i
+; CHECK-NEXT:   %p1 = getelementptr inbounds float, float* %a, i64 %ip1
+; CHECK-NEXT:   %q0 = getelementptr inbounds float, float* %b, i64 %i
+; CHECK-NEXT:   %1 = bitcast float* %pm1 to <4 x float>*
+; CHECK-NEXT:   %2 = load <4 x float>, <4 x float>* %1, align 4
+; CHECK-NEXT:   %3 = bitcast float* %p0 to <4 x float>*
+; CHECK-NEXT:   %4 = load <4 x float>, <4 x float>* %3, align 4
+; CHECK-NEXT:   %5 = fadd fast <4 x float> %2, %4
+; CHECK-NEXT:   %6 = bitcast float* %p1 to <4 x float>*
+; CHECK-NEXT:   %7 = load <4 x float>, <4 x float>* %6, align 4
+; CHECK-NEXT:   %8 = fadd fast <4 x float> %5, %7
+; CHECK-NEXT:   %9 = fmul fast <4 x float> %8, <float 0x3FD5555560000000, float 0x3FD5555560000000, float 0x3FD5555560000000, float 0x3FD5555560000000>
+; CHECK-NEXT:   %10 = bitcast float* %q0 to <4 x float>*
+; CHECK-NEXT:   store <4 x float> %9, <4 x float>* %10, align 4
+; CHECK-NEXT:   ret void
+  %im1 = add nsw i64 %i, -1
+  %ip1 = add nsw i64 %i, 1
+  %ip2 = add nsw i64 %i, 2
+  %ip3 = add nsw i64 %i, 3
+  %ip4 = add nsw i64 %i, 4
+  %pm1 = getelementptr inbounds float, float* %a, i64 %im1
+  %p0 = getelementptr inbounds float, float* %a, i64 %i
+  %p1 = getelementptr inbounds float, float* %a, i64 %ip1
+  %p2 = getelementptr inbounds float, float* %a, i64 %ip2
+  %p3 = getelementptr inbounds float, float* %a, i64 %ip3
+  %p4 = getelementptr inbounds float, float* %a, i64 %ip4
+  %q0 = getelementptr inbounds float, float* %b, i64 %i
+  %q1 = getelementptr inbounds float, float* %b, i64 %ip1
+  %q2 = getelementptr inbounds float, float* %b, i64 %ip2
+  %q3 = getelementptr inbounds float, float* %b, i64 %ip3
+  %l0a = load float, float* %pm1
+  %l0b = load float, float* %p0
+  %l0c = load float, float* %p1
+  %s0a = fadd fast float %l0a, %l0b
+  %s0 = fadd fast float %s0a, %l0c
+  %m0 = fmul fast float %s0, 0x3FD5555560000000
+  store float %m0, float* %q0
+  %l1a = load float, float* %p0
+  %l1b = load float, float* %p1
+  %l1c = load float, float* %p2
+  %s1a = fadd fast float %l1a, %l1b
+  %s1 = fadd fast float %s1a, %l1c
+  %m1 = fmul fast float %s1, 0x3FD5555560000000
+  store float %m1, float* %q1
+  %l2a = load float, float* %p1
+  %l2b = load float, float* %p2
+  %l2c = load float, float* %p3
+  %s2a = fadd fast float %l2a, %l2b
+  %s2 = fadd fast float %s2a, %l2c
+  %m2 = fmul fast float %s2, 0x3FD5555560000000
+  store float %m2, float* %q2
+  %l3a = load float, float* %p2
+  %l3b = load float, float* %p3
+  %l3c = load float, float* %p4
+  %s3a = fadd fast float %l3a, %l3b
+  %s3 = fadd fast float %s3a, %l3c
+  %m3 = fmul fast float %s3, 0x3FD5555560000000
+  store float %m3, float* %q3
+  ret void
+}
+
+; The same, in place: Each lane reads what the previous one has written.
+; STATS-NEXT: Vectorized Trees (inplace): 0
+; STATS-NEXT: Vectorized Scalars (inplace): 0
+define void @inplace(i32* %a) {
+; CHECK-LABEL: define void @inplace(i32* %a) {
+; CHECK-NEXT:   %p1 = getelementptr inbounds i32, i32* %a, i64 1
+; CHECK-NEXT:   %p2 = getelementptr inbounds i32, i32* %a, i64 2
+; CHECK-NEXT:   %l0 = load i32, i32* %a, align 4
+; CHECK-NEXT:   %l1 = load i32, i32* %p1, align 4
+; CHECK-NEXT:   %s0 = add i32 %l0, %l1
+; CHECK-NEXT:   store i32 %s0, i32* %p1, align 4
+; CHECK-NEXT:   %l2 = load i32, i32* %p1, align 4
+; CHECK-NEXT:   %l3 = load i32, i32* %p2, align 4
+; CHECK-NEXT:   %s1 = add i32 %l2, %l3
+; CHECK-NEXT:   store i32 %s1, i32* %p2, align 4
+; CHECK-NEXT:   ret void
+  %p1 = getelementptr inbounds i32, i32* %a, i64 1
+  %p2 = getelementptr inbounds i32, i32* %a, i64 2
+  %l0 = load i32, i32* %a
+  %l1 = load i32, i32* %p1
+  %s0 = add i32 %l0, %l1
+  store i32 %s0, i32* %p1
+  %l2 = load i32, i32* %p1
+  %l3 = load i32, i32* %p2
+  %s1 = add i32 %l2, %l3
+  store i32 %s1, i32* %p2
+  ret void
+}
+
+; Only worth it if few lanes have to be gathered from scalars one by one
+;
+; void gather(int *a, int x, int y) {
+;   a[0] += x; a[1] += y;
+;   a[2] = x * 3; a[3] = y * 5;
+; }
+; STATS-NEXT: Vectorized Trees (gather): 1
+; STATS-NEXT: Vectorized Scalars (gather): 6
+define void @gather(i32* %a, i32 %x, i32 %y) {
+; CHECK-LABEL: define void @gather(i32* %a, i32 %x, i32 %y) {
+; CHECK-NEXT:   %p2 = getelementptr inbounds i32, i32* %a, i64 2
+; CHECK-NEXT:   %p3 = getelementptr inbounds i32, i32* %a, i64 3
+; CHECK-NEXT:   %1 = bitcast i32* %a to <2 x i32>*
+; CHECK-NEXT:   %2 = load <2 x i32>, <2 x i32>* %1, align 4
+; CHECK-NEXT:   %3 = insertelement <2 x i32> undef, i32 %x, i64 0
+; CHECK-NEXT:   %4 = insertelement <2 x i32> %3, i32 %y, i64 1
+; CHECK-NEXT:   %5 = add <2 x i32> %2, %4
+; CHECK-NEXT:   %6 = bitcast i32* %a to <2 x i32>*
+; CHECK-NEXT:   store <2 x i32> %5, <2 x i32>* %6, align 4
+; CHECK-NEXT:   %s2 = mul i32 %x, 3
+; CHECK-NEXT:   store i32 %s2, i32* %p2, align 4
+; CHECK-NEXT:   %s3 = mul i32 %y, 5
+; CHECK-NEXT:   store i32 %s3, i32* %p3, align 4
+; CHECK-NEXT:   ret void
+  %p1 = getelementptr inbounds i32, i32* %a, i64 1
+  %p2 = getelementptr inbounds i32, i32* %a, i64 2
+  %p3 = getelementptr inbounds i32, i32* %a, i64 3
+  %l0 = load i32, i32* %a
+  %s0 = add i32 %l0, %x
+  store i32 %s0, i32* %a
+  %l1 = load i32, i32* %p1
+  %s1 = add i32 %l1, %y
+  store i32 %s1, i32* %p1
+  %s2 = mul i32 %x, 3
+  store i32 %s2, i32* %p2
+  %s3 = mul i32 %y, 5
+  store i32 %s3, i32* %p3
+  ret void
+}
@@ -0,0 +1,73 @@
+; RUN: opt -S -load %dylibdir/libLocalOpts.so -peephole \
+; RUN:     %s -o %basename_t 2>%basename_t.log
+; RUN: FileCheck --match-full-lines %s --input-file=%basename_t
+; RUN: FileCheck --match-full-lines %s --input-file=%basename_t.log \
+; RUN:     --check-prefix=STATS
+
+; STATS: Multiplication Cost Model: mul=3, vector-mul=10, shift=1, add=1, max-insts=4
+
+; Splat vector constants, the same as scalar ones
+; STATS-NEXT: add-zero (splat): 1
+; STATS-NEXT: mul-one (splat): 1
+; STATS-NEXT: mul-decompose (splat): 1
+; STATS-NEXT: sdiv-pow2 (splat): 1
+; STATS-NEXT: sdiv-magic (splat): 1
+define <4 x i32> @splat(<4 x i32> %0) {
+; CHECK-LABEL: define <4 x i32> @splat(<4 x i32> %0) {
+; CHECK-NEXT:   %2 = shl <4 x i32> %0, <i32 3, i32 3, i32 3, i32 3>
+; CHECK-NEXT:   %3 = add <4 x i32> %0, %2
+; CHECK-NEXT:   %4 = ashr exact <4 x i32> %3, <i32 2, i32 2, i32 2, i32 2>
+; CHECK-NEXT:   %5 = sext <4 x i32> %4 to <4 x i64>
+; CHECK-NEXT:   %6 = mul <4 x i64> %5, <i64 -1840700269, i64 -1840700269, i64 -1840700269, i64 -1840700269>
+; CHECK-NEXT:   %7 = lshr <4 x i64> %6, <i64 32, i64 32, i64 32, i64 32>
+; CHECK-NEXT:   %8 = trunc <4 x i64> %7 to <4 x i32>
+; CHECK-NEXT:   %9 = add <4 x i32> %8, %4
+; CHECK-NEXT:   %10 = ashr <4 x i32> %9, <i32 2, i32 2, i32 2, i32 2>
+; CHECK-NEXT:   %11 = lshr <4 x i32> %10, <i32 31, i32 31, i32 31, i32 31>
+; CHECK-NEXT:   %12 = add <4 x i32> %10, %11
+; CHECK-NEXT:   ret <4 x i32> %12
+  %2 = add <4 x i32> %0, zeroinitializer
+  %3 = mul <4 x i32> %2, <i32 1, i32 1, i32 1, i32 1>
+  %4 = mul <4 x i32> %3, <i32 9, i32 9, i32 9, i32 9>
+  %5 = sdiv exact <4 x i32> %4, <i32 4, i32 4, i32 4, i32 4>
+  %6 = sdiv <4 x i32> %5, <i32 7, i32 7, i32 7, i32 7>
+  ret <4 x i32> %6
+}
+
+; Different powers of 2 in each lane
+; STATS-NEXT: mul-pow2 (lanes): 1
+; STATS-NEXT: sdiv-pow2 (lanes): 1
+; STATS-NEXT: udiv-pow2 (lanes): 1
+; STATS-NEXT: urem-pow2 (lanes): 1
+define <4 x i32> @lanes(<4 x i32> %0) {
+; CHECK-LABEL: define <4 x i32> @lanes(<4 x i32> %0) {
+; CHECK-NEXT:   %2 = shl <4 x i32> %0, <i32 0, i32 1, i32 2, i32 3>
+; CHECK-NEXT:   %3 = ashr <4 x i32> %2, <i32 31, i32 31, i32 31, i32 31>
+; CHECK-NEXT:   %4 = lshr <4 x i32> %3, <i32 31, i32 30, i32 29, i32 28>
+; CHECK-NEXT:   %5 = add <4 x i32> %2, %4
+; CHECK-NEXT:   %6 = ashr <4 x i32> %5, <i32 1, i32 2, i32 3, i32 4>
+; CHECK-NEXT:   %7 = lshr <4 x i32> %6, <i32 4, i32 3, i32 2, i32 1>
+; CHECK-NEXT:   %8 = and <4 x i32> %7, <i32 0, i32 1, i32 3, i32 7>
+; CHECK-NEXT:   ret <4 x i32> %8
+  %2 = mul <4 x i32> %0, <i32 1, i32 2, i32 4, i32 8>
+  %3 = sdiv <4 x i32> %2, <i32 2, i32 4, i32 8, i32 16>
+  %4 = udiv <4 x i32> %3, <i32 16, i32 8, i32 4, i32 2>
+  %5 = urem <4 x i32> %4, <i32 1, i32 2, i32 4, i32 8>
+  ret <4 x i32> %5
+}
+
+; Constants beyond 64 bits
+; STATS-NEXT: mul-pow2 (wide): 1
+; STATS-NEXT: sdiv-pow2 (wide): 1
+define i128 @wide(i128 %0) {
+; CHECK-LABEL: define i128 @wide(i128 %0) {
+; CHECK-NEXT:   %2 = shl i128 %0, 70
+; CHECK-NEXT:   %3 = ashr i128 %2, 99
+; CHECK-NEXT:   %4 = lshr i128 %3, 28
+; CHECK-NEXT:   %5 = add i128 %2, %4
+; CHECK-NEXT:   %6 = ashr i128 %5, 100
+; CHECK-NEXT:   ret i128 %6
+  %2 = mul i128 %0, 1180591620717411303424
+  %3 = sdiv i128 %2, 1267650600228229401496703205376
+  ret i128 %3
+}
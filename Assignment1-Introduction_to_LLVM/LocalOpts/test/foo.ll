@@ -18,7 +18,29 @@
 ; }
 define i32 @foo(i32 %0) {
 ; CHECK-LABEL: define i32 @foo(i32 %0) {
-; @todo(cscd70) Please complete the CHECK directives.
+; CHECK-NEXT:   %2 = shl i32 %0, 4
+; CHECK-NEXT:   %3 = mul nsw i32 %2, %0
+; CHECK-NEXT:   %4 = sdiv i32 %3, %0
+; CHECK-NEXT:   %5 = sext i32 %3 to i64
+; CHECK-NEXT:   %6 = mul i64 %5, 1717986919
+; CHECK-NEXT:   %7 = lshr i64 %6, 32
+; CHECK-NEXT:   %8 = trunc i64 %7 to i32
+; CHECK-NEXT:   %9 = ashr i32 %8, 2
+; CHECK-NEXT:   %10 = lshr i32 %9, 31
+; CHECK-NEXT:   %11 = add i32 %9, %10
+; CHECK-NEXT:   %12 = mul nsw i32 54, %4
+; CHECK-NEXT:   %13 = ashr i32 %11, 6
+; CHECK-NEXT:   %14 = lshr i32 %13, 25
+; CHECK-NEXT:   %15 = add i32 %11, %14
+; CHECK-NEXT:   %16 = ashr i32 %15, 7
+; CHECK-NEXT:   %17 = sext i32 %12 to i64
+; CHECK-NEXT:   %18 = mul i64 %17, 1272582903
+; CHECK-NEXT:   %19 = lshr i64 %18, 32
+; CHECK-NEXT:   %20 = trunc i64 %19 to i32
+; CHECK-NEXT:   %21 = ashr i32 %20, 4
+; CHECK-NEXT:   %22 = lshr i32 %21, 31
+; CHECK-NEXT:   %23 = add i32 %21, %22
+; CHECK-NEXT:   ret i32 %23
   %2 = add nsw i32 %0, 0
   %3 = mul nsw i32 %2, 16
   %4 = mul nsw i32 %3, %2
@@ -1,16 +1,25 @@
 #pragma once // NOLINT(llvm-header-guard)
 
+#include <cstdint>
+#include <cstring>
+#include <string>
 #include <type_traits>
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
+#include <llvm/Analysis/CFG.h>
+#include <llvm/Analysis/LoopInfo.h>
 #include <llvm/IR/BasicBlock.h>
 #include <llvm/IR/CFG.h>
+#include <llvm/IR/Dominators.h>
 #include <llvm/IR/Function.h>
 #include <llvm/IR/InstIterator.h>
 #include <llvm/IR/Instruction.h>
 #include <llvm/Support/raw_ostream.h>
 
+#include "ResultCache.h"
+
 using namespace llvm;
 
 namespace dfa {
@@ -21,6 +30,10 @@ class MeetOp;
 /// Analysis Direction, used as Template Parameter
 enum class Direction { kForward, kBackward };
 
+/// Phase of the fixpoint iteration. The ascending phase applies widening at the
+/// widening points, the (bounded) descending phase applies narrowing.
+enum class IterationPhase { kAscending, kDescending };
+
 template <Direction TDirection> //
 struct FrameworkTypeSupport {};
 
@@ -80,6 +93,29 @@ protected:
   std::vector<TDomainElem> Domain;
   // Instruction-Domain Value Mapping
   std::unordered_map<const Instruction *, DomainVal_t> InstDomainValMap;
+  // Number of visits to a widening point before the widening operator is
+  // applied. Delaying the widening keeps short loops precise.
+  unsigned WideningDelay = 2;
+  // Upper bound on the number of iterations of the descending phase.
+  unsigned MaxNarrowingIters = 2;
+  // Whether to dump the CFG traversal and the final instruction-domain value
+  // mapping. Analyses that run on large functions as part of a transformation
+  // should turn this off.
+  bool Verbose = true;
+
+private:
+  // Widening Points (Loop Heads) and their last Extrapolated Boundary Values
+  std::unordered_set<const BasicBlock *> WideningPoints;
+  std::unordered_map<const BasicBlock *, DomainVal_t> WideningPointValMap;
+  std::unordered_map<const BasicBlock *, unsigned> WideningPointVisitCnt;
+  // Whether the widening operator has ever changed a value. If not, the
+  // ascending phase has reached the least fixpoint and narrowing is void.
+  bool HasWidened = false;
+  // Result cache and the values at the entry of each basic block (in the
+  // direction of the analysis) as of the last CFG traversal, which are what is
+  // cached.
+  const ResultCache *Cache = nullptr;
+  std::unordered_map<const BasicBlock *, DomainVal_t> BBEntryValMap;
   /*****************************************************************************
    * Auxiliary Print Subroutines
    *****************************************************************************/
@@ -102,6 +138,27 @@ private:
     errs() << "}";
   }
 
+  /**
+   * @brief Print the domain value. Bit-vector values are printed as the masked
+   *        domain, all other lattices as a list of (element: value) pairs.
+   */
+  template <typename T = TDomainElemRepr>
+  std::enable_if_t<std::is_same<T, bool>::value>
+  printDomainVal(const DomainVal_t &Val) const {
+    printDomainWithMask(Val);
+  }
+  template <typename T = TDomainElemRepr>
+  std::enable_if_t<!std::is_same<T, bool>::value>
+  printDomainVal(const DomainVal_t &Val) const {
+    errs() << "{";
+    assert(Val.size() == Domain.size() &&
+           "The size of the value must be equal to the size of domain.");
+    for (size_t Idx = 0; Idx < Domain.size(); ++Idx) {
+      errs() << Domain[Idx] << ": " << Val[Idx] << ", ";
+    }
+    errs() << "}";
+  }
+
   /**
    * @brief Fetch the DomainMap for the Instr, and print out at the
    * value at the Instr point in the Forward pass.
@@ -114,12 +171,12 @@ private:
     if (&Inst == &(InstParent->front())) {
       errs() << "\t";
       errs() << "\n\n**[First Inst of BB] -- [Getting Predecessors Mask]**\n\n";
-      printDomainWithMask(getBoundaryVal(*InstParent));
+      printDomainVal(getBoundaryVal(*InstParent));
       errs() << "\n";
     } // if (&Inst == &(*InstParent->begin()))
     outs() << Inst << "\n";
     errs() << "\t";
-    printDomainWithMask(InstDomainValMap.at(&Inst));
+    printDomainVal(InstDomainValMap.at(&Inst));
     errs() << "\n";
   }
 
@@ -130,7 +187,7 @@ private:
   printInstDomainValMap(const Instruction &Inst) const {
     const BasicBlock *const InstParent = Inst.getParent();
     errs() << "\n";
-    printDomainWithMask(InstDomainValMap.at(&Inst));
+    printDomainVal(InstDomainValMap.at(&Inst));
     errs() << "\n";
     outs() << Inst << "\n";
     //printDomainWithMask(InstDomainValMap.at(&Inst));
@@ -138,7 +195,7 @@ private:
     if (&Inst == &(InstParent->back())) {
       errs() << "**[Last Inst of BB] -- [Getting Successors: Mask]**";
       errs() << "\n";
-      printDomainWithMask(getBoundaryVal(*InstParent));
+      printDomainVal(getBoundaryVal(*InstParent));
       errs() << "\n\n";
     } // if (&Inst == &(*InstParent->end()))
   }
@@ -200,10 +257,14 @@ private:
 
     return operands;
   }
+
+protected:
   /**
    * @brief Boundary Condition
    */
-  DomainVal_t bc() const { return DomainVal_t(Domain.size()); }
+  virtual DomainVal_t bc() const { return DomainVal_t(Domain.size()); }
+
+private:
   /**
    * @brief Apply the meet operator to the operands.
    */
@@ -283,19 +344,109 @@ private:
     return make_range(BB.rbegin(), BB.rend());
   }
 
+  /*****************************************************************************
+   * Widening Points
+   *****************************************************************************/
+  /**
+   * @brief Widening points of a forward pass are the loop headers, as every
+   *        cycle of a natural loop goes through its header.
+   */
+  METHOD_ENABLE_IF_DIRECTION(Direction::kForward, void)
+  addWideningPoints(const Loop &L) {
+    WideningPoints.insert(L.getHeader());
+  }
+  /**
+   * @brief Widening points of a backward pass are the loop latches, which are
+   *        where the values flowing backward along the back edges meet.
+   */
+  METHOD_ENABLE_IF_DIRECTION(Direction::kBackward, void)
+  addWideningPoints(const Loop &L) {
+    SmallVector<BasicBlock *, 4> Latches;
+    L.getLoopLatches(Latches);
+    WideningPoints.insert(Latches.begin(), Latches.end());
+  }
+  METHOD_ENABLE_IF_DIRECTION(Direction::kForward, void)
+  addWideningPoints(const std::pair<const BasicBlock *, const BasicBlock *>
+                        &BackEdge) {
+    WideningPoints.insert(BackEdge.second);
+  }
+  METHOD_ENABLE_IF_DIRECTION(Direction::kBackward, void)
+  addWideningPoints(const std::pair<const BasicBlock *, const BasicBlock *>
+                        &BackEdge) {
+    WideningPoints.insert(BackEdge.first);
+  }
+
+  /**
+   * @brief Select the widening points using the loop-nesting structure of
+   *        @c F .
+   *
+   * Irreducible cycles are not recognized as natural loops, hence the
+   * endpoints of the DFS back edges are added as well so that every cycle of
+   * the CFG is guaranteed to be cut by at least one widening point.
+   */
+  void initializeWideningPoints(const Function &F) {
+    WideningPoints.clear();
+    WideningPointValMap.clear();
+    WideningPointVisitCnt.clear();
+    HasWidened = false;
+
+    // The analyses themselves never modify the function.
+    DominatorTree DT(const_cast<Function &>(F));
+    LoopInfo LI(DT);
+    for (const Loop *const L : LI.getLoopsInPreorder()) {
+      addWideningPoints(*L);
+    }
+    SmallVector<std::pair<const BasicBlock *, const BasicBlock *>, 8> BackEdges;
+    FindFunctionBackedges(F, BackEdges);
+    for (const auto &BackEdge : BackEdges) {
+      if (LI.isLoopHeader(BackEdge.second)) {
+        continue;
+      }
+      addWideningPoints(BackEdge);
+    }
+  }
+
+  /**
+   * @brief Apply the widening (ascending phase) or the narrowing (descending
+   *        phase) operator to the boundary value @c IN of the widening point
+   *        @c BB .
+   */
+  DomainVal_t extrapolate(const BasicBlock &BB, const DomainVal_t &IN,
+                          const IterationPhase Phase) {
+    auto PrevIt = WideningPointValMap.find(&BB);
+    if (PrevIt == WideningPointValMap.end()) {
+      WideningPointValMap.emplace(&BB, IN);
+      return IN;
+    }
+    TMeetOp MeetOp;
+    DomainVal_t Extrapolated = IN;
+    if (Phase == IterationPhase::kAscending) {
+      if (++WideningPointVisitCnt[&BB] > WideningDelay) {
+        Extrapolated = MeetOp.widen(PrevIt->second, IN);
+        HasWidened = HasWidened || Extrapolated != IN;
+      }
+    } else {
+      Extrapolated = MeetOp.narrow(PrevIt->second, IN);
+    }
+    PrevIt->second = Extrapolated;
+    return Extrapolated;
+  }
+
   /**
    * @brief  Traverse through the CFG and update instruction-domain value
    *         mapping.
    * @return true if changes are made to the mapping, false otherwise
    *
    */
-  bool traverseCFG(const Function &F) {
+  bool traverseCFG(const Function &F, const IterationPhase Phase) {
     bool isChanged = false;
-    // clang-format off
-    errs() << "**************************************************" << "\n"
-           << "* Traverse CFG" << "\n"
-           << "**************************************************" << "\n";
-    // clang-format on
+    if (Verbose) {
+      // clang-format off
+      errs() << "**************************************************" << "\n"
+             << "* Traverse CFG" << "\n"
+             << "**************************************************" << "\n";
+      // clang-format on
+    }
     for (const llvm::BasicBlock &BB : getBBTraversalOrder(F)) {
       /*
        * Initial
@@ -303,44 +454,153 @@ private:
        * or exit block. Get meet(meetOperands())
        * Case 2: Entry or Exit block, get bc().
        */
-      errs() << "BB:" << BB << "\n";
+      if (Verbose) {
+        errs() << "BB:" << BB << "\n";
+      }
       DomainVal_t IN = getBoundaryVal(BB);
+      if (WideningPoints.count(&BB)) {
+        IN = extrapolate(BB, IN, Phase);
+      }
+      if (Cache) {
+        BBEntryValMap[&BB] = IN;
+      }
       for (const llvm::Instruction &I : getInstTraversalOrder(BB)) {
-        errs() << "IN\n[";
-        for (auto in : IN) {
-          errs() << in << ' ';
+        if (Verbose) {
+          errs() << "IN\n[";
+          for (auto in : IN) {
+            errs() << in << ' ';
+          }
+          errs() << "]\n";
+          errs() << I << "\n";
         }
-        errs() << "]\n";
-        errs() << I << "\n";
-
-        DomainVal_t OUT = InstDomainValMap.at(&I);
-        
-        errs() << "OUT Before Transfer\n[";
-        for (auto out : OUT) {
-          errs() << out << ' ';
+
+        DomainVal_t &OUT = InstDomainValMap.at(&I);
+
+        if (Verbose) {
+          errs() << "OUT Before Transfer\n[";
+          for (auto out : OUT) {
+            errs() << out << ' ';
+          }
+          errs() << "]\n";
         }
-        errs() << "]\n";
-        
+
+        // The output is updated in place in the InstDomainValMap for the next
+        // iteration.
         isChanged = isChanged | transferFunc(I, IN, OUT);
-        // If output changed, we need to update the InstDomainValMap for next
-        // iter.
-        errs() << "OUT After Transfer\n[";
-        for (auto out : OUT) {
-          errs() << out << ' ';
+        if (Verbose) {
+          errs() << "OUT After Transfer\n[";
+          for (auto out : OUT) {
+            errs() << out << ' ';
+          }
+          errs() << "]\n";
         }
-        errs() << "]\n";
-        InstDomainValMap.at(&I) = OUT;
         /*
          * Case 3: Middle of the block, hence predeccesor (Forward) or successor
          * (Backward) acts as input for next Inst.
          */
         IN = OUT;
       }
-      errs() << "\n\n\n";
+      if (Verbose) {
+        errs() << "\n\n\n";
+      }
     }
 
     return isChanged;
   }
+  /*****************************************************************************
+   * Result Cache
+   *****************************************************************************/
+  static constexpr uint32_t kCacheMagic = 0x43414644; // "DFAC"
+  static constexpr uint32_t kCacheVersion = 1;
+  struct CacheEntryHeader {
+    uint32_t Magic, Version, DomainSize, NumBBs;
+  };
+
+  /**
+   * @brief Serialize the entry value of every basic block, in the order of
+   *        the function, as fixed-size rows of packed bits.
+   */
+  template <typename T = TDomainElemRepr>
+  std::enable_if_t<std::is_same<T, bool>::value, std::string>
+  serializeResult(const Function &F) const {
+    const size_t NumWords = (Domain.size() + 63) / 64;
+    const CacheEntryHeader Header = {kCacheMagic, kCacheVersion,
+                                     static_cast<uint32_t>(Domain.size()),
+                                     static_cast<uint32_t>(F.size())};
+    std::string Data(reinterpret_cast<const char *>(&Header), sizeof(Header));
+    std::vector<uint64_t> Row(NumWords);
+    for (const BasicBlock &BB : F) {
+      const DomainVal_t &Val = BBEntryValMap.at(&BB);
+      std::fill(Row.begin(), Row.end(), 0);
+      for (size_t Idx = 0; Idx < Val.size(); ++Idx) {
+        if (Val[Idx]) {
+          Row[Idx / 64] |= uint64_t(1) << (Idx % 64);
+        }
+      }
+      Data.append(reinterpret_cast<const char *>(Row.data()),
+                  NumWords * sizeof(uint64_t));
+    }
+    return Data;
+  }
+  template <typename T = TDomainElemRepr>
+  std::enable_if_t<!std::is_same<T, bool>::value, std::string>
+  serializeResult(const Function &F) const {
+    return "";
+  }
+
+  /**
+   * @brief Recover the instruction-domain value mapping from the cached entry
+   *        values of the basic blocks, which takes a single application of the
+   *        transfer function per instruction instead of solving to fixpoint.
+   * @return false if @c Entry does not match the function and domain
+   */
+  template <typename T = TDomainElemRepr>
+  std::enable_if_t<std::is_same<T, bool>::value, bool>
+  deserializeResult(const Function &F, StringRef Entry) {
+    const size_t NumWords = (Domain.size() + 63) / 64;
+    CacheEntryHeader Header;
+    if (Entry.size() < sizeof(Header)) {
+      return false;
+    }
+    std::memcpy(&Header, Entry.data(), sizeof(Header));
+    if (Header.Magic != kCacheMagic || Header.Version != kCacheVersion ||
+        Header.DomainSize != Domain.size() || Header.NumBBs != F.size() ||
+        Entry.size() !=
+            sizeof(Header) + F.size() * NumWords * sizeof(uint64_t)) {
+      return false;
+    }
+    const char *RowPtr = Entry.data() + sizeof(Header);
+    std::vector<uint64_t> Row(NumWords);
+    for (const BasicBlock &BB : F) {
+      std::memcpy(Row.data(), RowPtr, NumWords * sizeof(uint64_t));
+      RowPtr += NumWords * sizeof(uint64_t);
+      DomainVal_t IN(Domain.size());
+      for (size_t Idx = 0; Idx < IN.size(); ++Idx) {
+        IN[Idx] = (Row[Idx / 64] >> (Idx % 64)) & 1;
+      }
+      for (const Instruction &I : getInstTraversalOrder(BB)) {
+        DomainVal_t &OUT = InstDomainValMap.at(&I);
+        transferFunc(I, IN, OUT);
+        IN = OUT;
+      }
+    }
+    return true;
+  }
+  template <typename T = TDomainElemRepr>
+  std::enable_if_t<!std::is_same<T, bool>::value, bool>
+  deserializeResult(const Function &F, StringRef Entry) {
+    return false;
+  }
+
+protected:
+  /**
+   * @brief Identity of the analysis in the result cache. The results are
+   *        cached only for the bit-vector analyses that return a non-empty
+   *        identity, which must change whenever the analysis does.
+   */
+  virtual StringRef getCacheID() const { return ""; }
+
+private:
   /*****************************************************************************
    * Domain Initialization
    *****************************************************************************/
@@ -362,23 +622,56 @@ protected:
 
   bool runOnFunction(const Function &F) {
     // initialize the domain
-    // clang-format off
-    errs() << "**************************************************" << "\n"
-           << "* Intializing Domain" << "\n"
-           << "**************************************************" << "\n";
-    // clang-format on
+    if (Verbose) {
+      // clang-format off
+      errs() << "**************************************************" << "\n"
+             << "* Intializing Domain" << "\n"
+             << "**************************************************" << "\n";
+      // clang-format on
+    }
     initializeDomain(F);
-    errs() << "Domain Size:" << Domain.size() << "\n";
+    if (Verbose) {
+      errs() << "Domain Size:" << Domain.size() << "\n";
+    }
     // apply the initial conditions
     TMeetOp MeetOp;
     for (const auto &Inst : instructions(F)) {
       InstDomainValMap.emplace(&Inst, MeetOp.top(Domain.size()));
     }
+    // On a hit in the result cache, the fixpoint iteration is skipped.
+    std::string CacheKey;
+    Cache = std::is_same<TDomainElemRepr, bool>::value && !getCacheID().empty()
+                ? ResultCache::get()
+                : nullptr;
+    if (Cache) {
+      CacheKey = Cache->getKey(getCacheID(), F);
+      std::unique_ptr<MemoryBuffer> Entry = Cache->lookup(CacheKey);
+      if (Entry && deserializeResult(F, Entry->getBuffer())) {
+        if (Verbose) {
+          printInstDomainValMap(F);
+        }
+        return false;
+      }
+    }
+    initializeWideningPoints(F);
     // keep traversing until no changes have been made to the
     // instruction-domain value mapping
-    while (traverseCFG(F)) {
+    while (traverseCFG(F, IterationPhase::kAscending)) {
+    }
+    // The widened fixpoint is sound but possibly imprecise, hence refine it
+    // with a bounded number of descending iterations.
+    for (unsigned Iter = 0;
+         HasWidened && Iter < MaxNarrowingIters &&
+         traverseCFG(F, IterationPhase::kDescending);
+         ++Iter) {
+    }
+    if (Cache) {
+      Cache->insert(CacheKey, serializeResult(F));
+      BBEntryValMap.clear();
+    }
+    if (Verbose) {
+      printInstDomainValMap(F);
     }
-    printInstDomainValMap(F);
     return false;
   }
 };
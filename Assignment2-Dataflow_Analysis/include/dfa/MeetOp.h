@@ -14,6 +14,28 @@ public:
   virtual DomainVal_t operator()(const DomainVal_t &LHS,
                                  const DomainVal_t &RHS) const = 0;
   virtual DomainVal_t top(const size_t DomainSize) const = 0;
+  /**
+   * @brief Widening operator, applied at the widening points (loop heads) of
+   *        the CFG to cut ascending chains short in infinite-height lattices.
+   *
+   * @param Prev  Value at the widening point from the previous iteration
+   * @param Curr  Value at the widening point from the current iteration
+   *
+   * The default simply takes the current value, which is sufficient for the
+   * finite-height bit-vector lattices.
+   */
+  virtual DomainVal_t widen(const DomainVal_t &Prev,
+                            const DomainVal_t &Curr) const {
+    return Curr;
+  }
+  /**
+   * @brief Narrowing operator, applied at the widening points during the
+   *        descending phase to recover the precision lost to widening.
+   */
+  virtual DomainVal_t narrow(const DomainVal_t &Prev,
+                             const DomainVal_t &Curr) const {
+    return Curr;
+  }
 };
 
 /**
@@ -0,0 +1,52 @@
+#pragma once // NOLINT(llvm-header-guard)
+
+#include <memory>
+#include <string>
+
+#include <llvm/ADT/StringRef.h>
+#include <llvm/IR/Function.h>
+#include <llvm/Support/MemoryBuffer.h>
+
+using namespace llvm;
+
+namespace dfa {
+
+/**
+ * @brief Persistent on-disk cache of the dataflow results.
+ *
+ * Every entry is a file of its own in the cache directory (given by
+ * `-dfa-cache-dir`), named after the analysis and the SHA-1 hash of the
+ * function's IR, so that unchanged functions hit across runs of the compiler.
+ * Entries are written to a temporary file that is then renamed into place,
+ * and they are memory-mapped when looked up.
+ */
+class ResultCache {
+private:
+  const std::string Dir;
+
+  explicit ResultCache(std::string Dir) : Dir(std::move(Dir)) {}
+
+public:
+  /**
+   * @brief Return the cache, or nullptr if caching has not been enabled.
+   */
+  static const ResultCache *get();
+
+  /**
+   * @brief Return the key of the result of the analysis @c AnalysisID on the
+   *        function @c F .
+   */
+  std::string getKey(StringRef AnalysisID, const Function &F) const;
+  /**
+   * @brief Map the entry @c Key into memory.
+   * @return the entry, or nullptr on a miss
+   */
+  std::unique_ptr<MemoryBuffer> lookup(StringRef Key) const;
+  /**
+   * @brief Store @c Data as the entry @c Key . The cache is best-effort, hence
+   *        failing to write the entry is not an error.
+   */
+  void insert(StringRef Key, StringRef Data) const;
+};
+
+} // namespace dfa
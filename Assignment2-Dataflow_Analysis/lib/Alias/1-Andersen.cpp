@@ -0,0 +1,167 @@
+#include "1-Andersen.h"
+
+/*******************************************************************************
+ * Constraint Solving
+ ******************************************************************************/
+unsigned AndersenImpl::unite(unsigned A, unsigned B) {
+  if (Ranks[A] < Ranks[B]) {
+    std::swap(A, B);
+  } else if (Ranks[A] == Ranks[B]) {
+    ++Ranks[A];
+  }
+  Reps[B] = A;
+  ++NumCollapsedNodes;
+
+  Node &RepNode = Nodes[A], &Collapsed = Nodes[B];
+  RepNode.PointsTo |= Collapsed.PointsTo;
+  // Only what has been propagated on behalf of both nodes is known to have
+  // reached all of the merged successors.
+  RepNode.PrevPointsTo &= Collapsed.PrevPointsTo;
+  RepNode.PrevComplexPointsTo &= Collapsed.PrevComplexPointsTo;
+  RepNode.CopyTo |= Collapsed.CopyTo;
+  RepNode.LoadTo.insert(RepNode.LoadTo.end(), Collapsed.LoadTo.begin(),
+                        Collapsed.LoadTo.end());
+  RepNode.StoreFrom.insert(RepNode.StoreFrom.end(), Collapsed.StoreFrom.begin(),
+                           Collapsed.StoreFrom.end());
+  Collapsed = Node();
+  return A;
+}
+
+std::vector<unsigned> AndersenImpl::collapseCycles() {
+  // Tarjan's algorithm, made iterative as the constraint graphs of large
+  // modules have very long copy chains.
+  const unsigned NumNodes = Nodes.size();
+  std::vector<unsigned> Index(NumNodes, 0), LowLink(NumNodes, 0);
+  std::vector<bool> OnStack(NumNodes, false);
+  std::vector<unsigned> SCCStack;
+  std::vector<std::pair<unsigned, PointsTo_t::iterator>> DFSStack;
+  std::vector<std::vector<unsigned>> SCCs;
+  unsigned NextIndex = 1;
+
+  for (unsigned Root = 0; Root < NumNodes; ++Root) {
+    if (find(Root) != Root || Index[Root]) {
+      continue;
+    }
+    Index[Root] = LowLink[Root] = NextIndex++;
+    SCCStack.push_back(Root);
+    OnStack[Root] = true;
+    DFSStack.emplace_back(Root, Nodes[Root].CopyTo.begin());
+
+    while (!DFSStack.empty()) {
+      const unsigned N = DFSStack.back().first;
+      PointsTo_t::iterator &SuccIt = DFSStack.back().second;
+      if (SuccIt != Nodes[N].CopyTo.end()) {
+        const unsigned Succ = find(*SuccIt);
+        ++SuccIt;
+        if (!Index[Succ]) {
+          Index[Succ] = LowLink[Succ] = NextIndex++;
+          SCCStack.push_back(Succ);
+          OnStack[Succ] = true;
+          DFSStack.emplace_back(Succ, Nodes[Succ].CopyTo.begin());
+        } else if (OnStack[Succ]) {
+          LowLink[N] = std::min(LowLink[N], Index[Succ]);
+        }
+        continue;
+      }
+      DFSStack.pop_back();
+      if (!DFSStack.empty()) {
+        const unsigned Parent = DFSStack.back().first;
+        LowLink[Parent] = std::min(LowLink[Parent], LowLink[N]);
+      }
+      if (LowLink[N] != Index[N]) {
+        continue;
+      }
+      SCCs.emplace_back();
+      unsigned Member;
+      do {
+        Member = SCCStack.back();
+        SCCStack.pop_back();
+        OnStack[Member] = false;
+        SCCs.back().push_back(Member);
+      } while (Member != N);
+    }
+  }
+
+  // Tarjan's algorithm emits the components in reverse topological order.
+  std::vector<unsigned> TopoOrder;
+  TopoOrder.reserve(SCCs.size());
+  for (auto SCCIt = SCCs.rbegin(); SCCIt != SCCs.rend(); ++SCCIt) {
+    unsigned Rep = SCCIt->front();
+    for (auto MemberIt = std::next(SCCIt->begin()); MemberIt != SCCIt->end();
+         ++MemberIt) {
+      Rep = unite(Rep, *MemberIt);
+    }
+    TopoOrder.push_back(Rep);
+  }
+  return TopoOrder;
+}
+
+void AndersenImpl::propagate(const std::vector<unsigned> &TopoOrder) {
+  for (const unsigned N : TopoOrder) {
+    Node &Src = Nodes[N];
+    PointsTo_t Delta = Src.PointsTo;
+    Delta.intersectWithComplement(Src.PrevPointsTo);
+    if (Delta.empty()) {
+      continue;
+    }
+    Src.PrevPointsTo = Src.PointsTo;
+    for (const unsigned Succ : Src.CopyTo) {
+      const unsigned Dst = find(Succ);
+      if (Dst != N) {
+        Nodes[Dst].PointsTo |= Delta;
+      }
+    }
+  }
+}
+
+bool AndersenImpl::resolveComplexConstraints() {
+  bool HasNewEdges = false;
+  auto addEdge = [&](const unsigned Src, const unsigned Dst) {
+    if (Src == Dst || !Nodes[Src].CopyTo.test_and_set(Dst)) {
+      return;
+    }
+    Nodes[Dst].PointsTo |= Nodes[Src].PointsTo;
+    HasNewEdges = true;
+  };
+
+  for (unsigned N = 0; N < Nodes.size(); ++N) {
+    if (find(N) != N ||
+        (Nodes[N].LoadTo.empty() && Nodes[N].StoreFrom.empty())) {
+      continue;
+    }
+    PointsTo_t Delta = Nodes[N].PointsTo;
+    Delta.intersectWithComplement(Nodes[N].PrevComplexPointsTo);
+    if (Delta.empty()) {
+      continue;
+    }
+    Nodes[N].PrevComplexPointsTo = Nodes[N].PointsTo;
+    for (const unsigned Obj : Delta) {
+      const unsigned ObjNode = find(ObjectNodes[Obj]);
+      for (const unsigned Dst : Nodes[N].LoadTo) {
+        addEdge(ObjNode, find(Dst));
+      }
+      for (const unsigned Src : Nodes[N].StoreFrom) {
+        addEdge(find(Src), ObjNode);
+      }
+    }
+  }
+  return HasNewEdges;
+}
+
+void AndersenImpl::solve() {
+  bool HasNewEdges = true;
+  while (HasNewEdges) {
+    ++NumWaves;
+    propagate(collapseCycles());
+    HasNewEdges = resolveComplexConstraints();
+  }
+
+  errs() << "Nodes: " << Nodes.size() << "\n"
+         << "Constraints: " << NumConstraints << "\n"
+         << "Collapsed Nodes: " << NumCollapsedNodes << "\n"
+         << "Waves: " << NumWaves << "\n";
+}
+
+char AndersenWrapperPass::ID = 0;
+static RegisterPass<AndersenWrapperPass>
+    X("andersen", "Andersen Points-To Analysis", false, true);
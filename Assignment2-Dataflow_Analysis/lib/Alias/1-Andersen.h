@@ -0,0 +1,152 @@
+#pragma once // NOLINT(llvm-header-guard)
+
+/**
+ * @file Andersen's Points-To Analysis
+ */
+#include <llvm/Pass.h>
+
+#include <memory>
+#include <vector>
+
+#include "PointerAnalysis.h"
+
+class AndersenWrapperPass;
+
+/**
+ * @brief Inclusion-based (Andersen) points-to analysis over the whole module.
+ *
+ * The analysis is field-insensitive, and its abstract locations are the
+ * memory objects themselves. The objects are numbered apart from the nodes, so
+ * that the bit-vectors of the points-to sets stay densely packed. The
+ * constraints are solved with wave propagation (Pereira and Berlin): Each wave
+ * collapses the cycles of the copy edges, propagates the points-to sets in
+ * topological order, and then resolves the load and store constraints into
+ * new copy edges. Only the difference since the last visit of a node is
+ * propagated.
+ */
+class AndersenImpl final : public PointerAnalysis {
+private:
+  struct Node {
+    PointsTo_t PointsTo;
+    // points-to set that has already been propagated along the copy edges and
+    // through the load and store constraints, respectively
+    PointsTo_t PrevPointsTo, PrevComplexPointsTo;
+    // copy edges, i.e., pts(m) ⊇ pts(n) ∀m ∈ CopyTo
+    PointsTo_t CopyTo;
+    // load constraints pts(m) ⊇ pts(*n) ∀m ∈ LoadTo and store constraints
+    // pts(*n) ⊇ pts(m) ∀m ∈ StoreFrom
+    std::vector<unsigned> LoadTo, StoreFrom;
+  };
+
+  std::vector<Node> Nodes;
+  // union-find forest of the collapsed nodes
+  mutable std::vector<unsigned> Reps;
+  std::vector<unsigned> Ranks;
+
+  unsigned NumConstraints = 0, NumCollapsedNodes = 0, NumWaves = 0;
+
+  virtual unsigned createNode() override {
+    Nodes.emplace_back();
+    Reps.push_back(Reps.size());
+    Ranks.push_back(0);
+    return Nodes.size() - 1;
+  }
+  virtual void addAddrOf(const unsigned Dst, const unsigned Obj) override {
+    Nodes[Dst].PointsTo.set(Obj);
+    ++NumConstraints;
+  }
+  virtual void addCopy(const unsigned Dst, const unsigned Src) override {
+    Nodes[Src].CopyTo.set(Dst);
+    ++NumConstraints;
+  }
+  virtual void addLoad(const unsigned Dst, const unsigned Src) override {
+    Nodes[Src].LoadTo.push_back(Dst);
+    ++NumConstraints;
+  }
+  virtual void addStore(const unsigned Dst, const unsigned Src) override {
+    Nodes[Dst].StoreFrom.push_back(Src);
+    ++NumConstraints;
+  }
+
+  /*****************************************************************************
+   * Constraint Solving
+   ****************************************************************************/
+  unsigned find(unsigned N) const {
+    unsigned Root = N;
+    while (Reps[Root] != Root) {
+      Root = Reps[Root];
+    }
+    while (Reps[N] != Root) {
+      unsigned Next = Reps[N];
+      Reps[N] = Root;
+      N = Next;
+    }
+    return Root;
+  }
+  /**
+   * @brief Collapse the nodes @c A and @c B into one.
+   * @return the representative of the collapsed node
+   */
+  unsigned unite(unsigned A, unsigned B);
+  /**
+   * @brief Collapse every strongly connected component of the copy edges.
+   * @return the representative nodes in topological order
+   */
+  std::vector<unsigned> collapseCycles();
+  /**
+   * @brief Propagate the differences of the points-to sets along the copy
+   *        edges in the topological order @c TopoOrder .
+   */
+  void propagate(const std::vector<unsigned> &TopoOrder);
+  /**
+   * @brief Resolve the load and store constraints of the new pointees into
+   *        copy edges.
+   * @return true if new copy edges have been added, false otherwise
+   */
+  bool resolveComplexConstraints();
+  virtual void solve() override;
+
+  /**
+   * @brief Pointers to the unknown object may point to any escaped object.
+   */
+  virtual PointsTo_t getLocations(const unsigned N) const override {
+    PointsTo_t PointsTo = Nodes[find(N)].PointsTo;
+    if (PointsTo.test(UnknownObject)) {
+      PointsTo |= Nodes[find(UnknownNode)].PointsTo;
+    }
+    return PointsTo;
+  }
+  virtual unsigned getLocation(const unsigned Obj) const override {
+    return Obj;
+  }
+
+private:
+  friend class AndersenWrapperPass;
+};
+
+class AndersenWrapperPass : public ModulePass {
+private:
+  std::unique_ptr<AndersenImpl> Andersen;
+
+public:
+  static char ID;
+
+  AndersenWrapperPass() : ModulePass(ID) {}
+
+  virtual void getAnalysisUsage(AnalysisUsage &AU) const override {
+    AU.addRequired<TargetLibraryInfoWrapperPass>();
+    AU.setPreservesAll();
+  }
+
+  bool runOnModule(Module &M) override {
+    Andersen = std::make_unique<AndersenImpl>();
+    return Andersen->runOnModule(M, [this](Function &F) -> const auto & {
+      return getAnalysis<TargetLibraryInfoWrapperPass>().getTLI(F);
+    });
+  }
+  virtual void print(raw_ostream &Outs, const Module *M) const override {
+    Andersen->print(Outs, *M);
+  }
+
+  const AliasQuery &getAliasQuery() const { return *Andersen; }
+};
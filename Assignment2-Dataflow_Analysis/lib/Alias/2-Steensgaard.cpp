@@ -0,0 +1,51 @@
+#include "2-Steensgaard.h"
+
+constexpr unsigned SteensgaardImpl::NoPointee;
+
+void SteensgaardImpl::unify(unsigned A, unsigned B) {
+  // Unifying two classes unifies their pointees as well, which is done
+  // iteratively as the chains of pointees may get long.
+  SmallVector<std::pair<unsigned, unsigned>, 8> Worklist;
+  Worklist.emplace_back(A, B);
+  while (!Worklist.empty()) {
+    A = find(Worklist.back().first);
+    B = find(Worklist.back().second);
+    Worklist.pop_back();
+    if (A == B) {
+      continue;
+    }
+    if (Ranks[A] < Ranks[B]) {
+      std::swap(A, B);
+    } else if (Ranks[A] == Ranks[B]) {
+      ++Ranks[A];
+    }
+    Reps[B] = A;
+    ++NumUnifications;
+
+    if (Pointees[A] == NoPointee) {
+      Pointees[A] = Pointees[B];
+    } else if (Pointees[B] != NoPointee) {
+      Worklist.emplace_back(Pointees[A], Pointees[B]);
+    }
+  }
+}
+
+unsigned SteensgaardImpl::getPointee(unsigned N) {
+  N = find(N);
+  if (Pointees[N] == NoPointee) {
+    const unsigned Pointee = createNode();
+    Pointees[N] = Pointee;
+    return Pointee;
+  }
+  return find(Pointees[N]);
+}
+
+void SteensgaardImpl::solve() {
+  errs() << "Nodes: " << Reps.size() << "\n"
+         << "Constraints: " << NumConstraints << "\n"
+         << "Unifications: " << NumUnifications << "\n";
+}
+
+char SteensgaardWrapperPass::ID = 0;
+static RegisterPass<SteensgaardWrapperPass>
+    X("steensgaard", "Steensgaard Points-To Analysis", false, true);
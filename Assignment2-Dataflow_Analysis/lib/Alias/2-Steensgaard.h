@@ -0,0 +1,136 @@
+#pragma once // NOLINT(llvm-header-guard)
+
+/**
+ * @file Steensgaard's Points-To Analysis
+ */
+#include <llvm/ADT/SmallVector.h>
+#include <llvm/Pass.h>
+
+#include <memory>
+#include <vector>
+
+#include "PointerAnalysis.h"
+
+class SteensgaardWrapperPass;
+
+/**
+ * @brief Unification-based (Steensgaard) points-to analysis over the whole
+ *        module.
+ *
+ * Every node belongs to an equivalence class, and every class points to at
+ * most one other class. Rather than adding edges, each constraint unifies the
+ * classes on both of its sides, which is done on the fly with union-find
+ * (path compression and union by rank) in almost linear time. The abstract
+ * locations are hence the classes of the objects' content nodes, and two
+ * pointers may alias iff they point to the same class.
+ */
+class SteensgaardImpl final : public PointerAnalysis {
+private:
+  static constexpr unsigned NoPointee = ~0U;
+
+  mutable std::vector<unsigned> Reps;
+  std::vector<unsigned> Ranks, Pointees;
+
+  unsigned NumConstraints = 0, NumUnifications = 0;
+
+  virtual unsigned createNode() override {
+    Reps.push_back(Reps.size());
+    Ranks.push_back(0);
+    Pointees.push_back(NoPointee);
+    return Reps.size() - 1;
+  }
+  unsigned find(unsigned N) const {
+    unsigned Root = N;
+    while (Reps[Root] != Root) {
+      Root = Reps[Root];
+    }
+    while (Reps[N] != Root) {
+      unsigned Next = Reps[N];
+      Reps[N] = Root;
+      N = Next;
+    }
+    return Root;
+  }
+  /**
+   * @brief Unify the classes of @c A and @c B , and recursively the classes
+   *        that they point to.
+   */
+  void unify(unsigned A, unsigned B);
+  /**
+   * @brief Return the class that @c N points to, which is created if @c N
+   *        does not point to anything yet.
+   */
+  unsigned getPointee(unsigned N);
+
+  virtual void addAddrOf(const unsigned Dst, const unsigned Obj) override {
+    unify(getPointee(Dst), ObjectNodes[Obj]);
+    ++NumConstraints;
+  }
+  // The constraints that involve the null pointer add nothing to any
+  // points-to set, whereas unifying with it would merge all the pointers that
+  // may be null into one class.
+  virtual void addCopy(const unsigned Dst, const unsigned Src) override {
+    if (Src != NullNode) {
+      unify(getPointee(Dst), getPointee(Src));
+    }
+    ++NumConstraints;
+  }
+  virtual void addLoad(const unsigned Dst, const unsigned Src) override {
+    if (Src != NullNode) {
+      unify(getPointee(Dst), getPointee(getPointee(Src)));
+    }
+    ++NumConstraints;
+  }
+  virtual void addStore(const unsigned Dst, const unsigned Src) override {
+    if (Dst != NullNode && Src != NullNode) {
+      unify(getPointee(getPointee(Dst)), getPointee(Src));
+    }
+    ++NumConstraints;
+  }
+  /**
+   * @brief The constraints have been solved as they were added.
+   */
+  virtual void solve() override;
+
+  virtual PointsTo_t getLocations(const unsigned N) const override {
+    PointsTo_t Locations;
+    const unsigned Pointee = Pointees[find(N)];
+    if (Pointee != NoPointee) {
+      Locations.set(find(Pointee));
+    }
+    return Locations;
+  }
+  virtual unsigned getLocation(const unsigned Obj) const override {
+    return find(ObjectNodes[Obj]);
+  }
+
+private:
+  friend class SteensgaardWrapperPass;
+};
+
+class SteensgaardWrapperPass : public ModulePass {
+private:
+  std::unique_ptr<SteensgaardImpl> Steensgaard;
+
+public:
+  static char ID;
+
+  SteensgaardWrapperPass() : ModulePass(ID) {}
+
+  virtual void getAnalysisUsage(AnalysisUsage &AU) const override {
+    AU.addRequired<TargetLibraryInfoWrapperPass>();
+    AU.setPreservesAll();
+  }
+
+  bool runOnModule(Module &M) override {
+    Steensgaard = std::make_unique<SteensgaardImpl>();
+    return Steensgaard->runOnModule(M, [this](Function &F) -> const auto & {
+      return getAnalysis<TargetLibraryInfoWrapperPass>().getTLI(F);
+    });
+  }
+  virtual void print(raw_ostream &Outs, const Module *M) const override {
+    Steensgaard->print(Outs, *M);
+  }
+
+  const AliasQuery &getAliasQuery() const { return *Steensgaard; }
+};
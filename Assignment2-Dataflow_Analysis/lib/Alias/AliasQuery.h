@@ -0,0 +1,45 @@
+#pragma once // NOLINT(llvm-header-guard)
+
+/**
+ * @file Alias Query Interface
+ */
+#include <llvm/Analysis/AliasAnalysis.h>
+#include <llvm/IR/InstrTypes.h>
+#include <llvm/IR/Value.h>
+
+using namespace llvm;
+
+/**
+ * @brief The alias queries that the pointer analyses answer for the dataflow
+ *        passes.
+ *
+ * Memory objects are the allocas, the global values and the heap allocation
+ * sites. Code outside of the module is modeled as one unknown object that can
+ * reach every escaped object.
+ */
+class AliasQuery {
+public:
+  virtual ~AliasQuery() {}
+
+  /**
+   * @brief Whether the pointers @c P and @c Q may point to the same memory
+   *        object.
+   */
+  virtual bool mayAlias(const Value &P, const Value &Q) const = 0;
+  /**
+   * @brief Whether the pointer @c P may point to the memory object @c Obj .
+   */
+  virtual bool mayPointTo(const Value &P, const Value &Obj) const = 0;
+  /**
+   * @brief Whether the memory object @c Obj may be accessed by code that the
+   *        analysis cannot see, e.g., because its address is passed to an
+   *        external function or stored to an escaped object.
+   */
+  virtual bool isEscaped(const Value &Obj) const = 0;
+  /**
+   * @brief Whether @c Call may modify and/or reference the memory that the
+   *        pointer @c P points to.
+   */
+  virtual ModRefInfo getModRefInfo(const CallBase &Call,
+                                   const Value &P) const = 0;
+};
@@ -0,0 +1,450 @@
+#include "PointerAnalysis.h"
+
+#include <llvm/ADT/SCCIterator.h>
+#include <llvm/Analysis/CallGraph.h>
+#include <llvm/Analysis/MemoryBuiltins.h>
+#include <llvm/IR/InstIterator.h>
+#include <llvm/IR/IntrinsicInst.h>
+
+/**
+ * @brief Whether a value of type @c Ty may carry a pointer.
+ */
+static bool mayContainPointer(const Type *const Ty) {
+  if (Ty->isPointerTy()) {
+    return true;
+  }
+  if (const VectorType *const VecTy = dyn_cast<VectorType>(Ty)) {
+    return mayContainPointer(VecTy->getElementType());
+  }
+  if (const ArrayType *const ArrTy = dyn_cast<ArrayType>(Ty)) {
+    return mayContainPointer(ArrTy->getElementType());
+  }
+  if (const StructType *const StructTy = dyn_cast<StructType>(Ty)) {
+    return any_of(StructTy->elements(), mayContainPointer);
+  }
+  return false;
+}
+
+/*******************************************************************************
+ * Constraint Collection
+ ******************************************************************************/
+unsigned PointerAnalysis::getValueNode(const Value &V) {
+  if (isa<ConstantPointerNull>(V) || isa<UndefValue>(V)) {
+    return NullNode;
+  }
+  auto NodeIt = ValueNodeMap.find(&V);
+  if (NodeIt != ValueNodeMap.end()) {
+    return NodeIt->second;
+  }
+  const unsigned N = ValueNodeMap[&V] = createNode();
+  if (const Constant *const C = dyn_cast<Constant>(&V)) {
+    addConstantPointees(N, *C);
+  }
+  return N;
+}
+
+void PointerAnalysis::addConstantPointees(const unsigned Dst,
+                                          const Constant &C) {
+  if (const GlobalAlias *const GA = dyn_cast<GlobalAlias>(&C)) {
+    addConstantPointees(Dst, *GA->getAliasee());
+    return;
+  }
+  if (isa<GlobalValue>(C)) {
+    addAddrOf(Dst, getObject(C));
+    return;
+  }
+  if (isa<BlockAddress>(C)) {
+    return;
+  }
+  if (const ConstantExpr *const CE = dyn_cast<ConstantExpr>(&C)) {
+    if (CE->getOpcode() == Instruction::IntToPtr) {
+      addCopy(Dst, UnknownNode);
+      return;
+    }
+  }
+  for (const Use &Operand : C.operands()) {
+    addConstantPointees(Dst, *cast<Constant>(Operand.get()));
+  }
+}
+
+void PointerAnalysis::addEscape(const Value &V) {
+  if (V.getType()->isPointerTy()) {
+    addCopy(UnknownNode, getValueNode(V));
+  } else if (isa<Constant>(V) && mayContainPointer(V.getType())) {
+    addConstantPointees(UnknownNode, cast<Constant>(V));
+  }
+}
+
+void PointerAnalysis::collectConstraints(const Module &M) {
+  // The null pointer is reserved before any constraint, as the analyses may
+  // create nodes while adding them.
+  Objects.push_back(nullptr);
+  ObjectNodes.push_back(createNode());
+  createNode();
+  // Code outside of the module can reach the whole content of the escaped
+  // objects and store the escaped objects anywhere in them.
+  addAddrOf(UnknownNode, UnknownObject);
+  addLoad(UnknownNode, UnknownNode);
+  addStore(UnknownNode, UnknownNode);
+
+  for (const GlobalVariable &GV : M.globals()) {
+    const unsigned Obj = getObject(GV);
+    if (GV.hasInitializer()) {
+      addConstantPointees(ObjectNodes[Obj], *GV.getInitializer());
+    }
+    if (!GV.hasLocalLinkage()) {
+      addAddrOf(UnknownNode, Obj);
+    }
+  }
+  for (const Function &F : M) {
+    const unsigned Obj = getObject(F);
+    if (F.hasLocalLinkage() && !F.hasAddressTaken()) {
+      continue;
+    }
+    // Externally visible and address-taken functions may be called from
+    // anywhere, with any argument.
+    addAddrOf(UnknownNode, Obj);
+    for (const Argument &Arg : F.args()) {
+      if (Arg.getType()->isPointerTy()) {
+        addCopy(getValueNode(Arg), UnknownNode);
+      }
+    }
+    if (F.getReturnType()->isPointerTy()) {
+      addCopy(UnknownNode, getRetNode(F));
+    }
+  }
+}
+
+void PointerAnalysis::collectConstraints(const CallBase &Call,
+                                      const TargetLibraryInfo &TLI) {
+  if (isa<DbgInfoIntrinsic>(Call) || Call.isLifetimeStartOrEnd() ||
+      isa<MemSetInst>(Call)) {
+    return;
+  }
+  if (isFreeCall(&Call, &TLI)) {
+    FreeCalls.insert(&Call);
+    return;
+  }
+  if (const MemTransferInst *const MTI = dyn_cast<MemTransferInst>(&Call)) {
+    const unsigned Content = createNode();
+    addLoad(Content, getValueNode(*MTI->getRawSource()));
+    addStore(getValueNode(*MTI->getRawDest()), Content);
+    return;
+  }
+  if (isMallocOrCallocLikeFn(&Call, &TLI)) {
+    AllocCalls.insert(&Call);
+    addAddrOf(getValueNode(Call), getObject(Call));
+    return;
+  }
+  const Function *const Callee = Call.getCalledFunction();
+  if (Callee && !Callee->isDeclaration()) {
+    for (unsigned ArgIdx = 0; ArgIdx < Call.arg_size(); ++ArgIdx) {
+      const Value &Actual = *Call.getArgOperand(ArgIdx);
+      if (ArgIdx < Callee->arg_size() &&
+          Callee->getArg(ArgIdx)->getType()->isPointerTy()) {
+        addCopy(getValueNode(*Callee->getArg(ArgIdx)), getValueNode(Actual));
+      } else {
+        // variadic arguments, and the non-pointer formal parameters, e.g., an
+        // aggregate holding pointers, through which the pointees escape
+        addEscape(Actual);
+      }
+    }
+    if (Call.getType()->isPointerTy()) {
+      addCopy(getValueNode(Call), getRetNode(*Callee));
+    }
+    return;
+  }
+  // External and indirect calls
+  for (const Use &Arg : Call.args()) {
+    addEscape(*Arg.get());
+  }
+  if (Call.getType()->isPointerTy()) {
+    addCopy(getValueNode(Call), UnknownNode);
+  }
+}
+
+void PointerAnalysis::collectConstraints(const Instruction &Inst,
+                                      const TargetLibraryInfo &TLI) {
+  const bool IsPointer = Inst.getType()->isPointerTy();
+
+  switch (Inst.getOpcode()) {
+  case Instruction::Alloca:
+    addAddrOf(getValueNode(Inst), getObject(Inst));
+    return;
+  case Instruction::Load:
+    if (IsPointer) {
+      addLoad(getValueNode(Inst), getValueNode(*Inst.getOperand(0)));
+    } else if (mayContainPointer(Inst.getType())) {
+      addLoad(UnknownNode, getValueNode(*Inst.getOperand(0)));
+    }
+    return;
+  case Instruction::Store: {
+    const Value &Val = *Inst.getOperand(0);
+    if (Val.getType()->isPointerTy()) {
+      addStore(getValueNode(*Inst.getOperand(1)), getValueNode(Val));
+    } else if (mayContainPointer(Val.getType())) {
+      addStore(getValueNode(*Inst.getOperand(1)), UnknownNode);
+      addEscape(Val);
+    }
+    return;
+  }
+  case Instruction::GetElementPtr:
+  case Instruction::BitCast:
+  case Instruction::AddrSpaceCast:
+  case Instruction::Freeze:
+    if (IsPointer) {
+      addCopy(getValueNode(Inst), getValueNode(*Inst.getOperand(0)));
+      return;
+    }
+    break;
+  case Instruction::PHI:
+    if (IsPointer) {
+      for (const Value *const Incoming :
+           cast<PHINode>(Inst).incoming_values()) {
+        addCopy(getValueNode(Inst), getValueNode(*Incoming));
+      }
+      return;
+    }
+    break;
+  case Instruction::Select:
+    if (IsPointer) {
+      addCopy(getValueNode(Inst), getValueNode(*Inst.getOperand(1)));
+      addCopy(getValueNode(Inst), getValueNode(*Inst.getOperand(2)));
+      return;
+    }
+    break;
+  case Instruction::ICmp:
+    return;
+  case Instruction::Ret:
+    if (Inst.getNumOperands() != 0 &&
+        Inst.getOperand(0)->getType()->isPointerTy()) {
+      addCopy(getRetNode(*Inst.getFunction()),
+              getValueNode(*Inst.getOperand(0)));
+      return;
+    }
+    break;
+  case Instruction::Call:
+  case Instruction::Invoke:
+  case Instruction::CallBr:
+    collectConstraints(cast<CallBase>(Inst), TLI);
+    return;
+  default:
+    break;
+  }
+  // Everything else (integer-pointer casts, aggregates, vectors, atomics, ...)
+  // exposes its pointer operands and yields unknown pointers.
+  for (const Use &Operand : Inst.operands()) {
+    if (!isa<BasicBlock>(Operand.get())) {
+      addEscape(*Operand.get());
+    }
+  }
+  if (IsPointer) {
+    addCopy(getValueNode(Inst), UnknownNode);
+  }
+}
+
+/*******************************************************************************
+ * Mod/Ref Summaries
+ ******************************************************************************/
+void PointerAnalysis::summarizeCall(const CallBase &Call,
+                                    ModRefSummary &Summary) const {
+  if (isa<DbgInfoIntrinsic>(Call) || Call.isLifetimeStartOrEnd() ||
+      Call.doesNotAccessMemory() || AllocCalls.count(&Call)) {
+    return;
+  }
+  if (const MemTransferInst *const MTI = dyn_cast<MemTransferInst>(&Call)) {
+    Summary.Ref |= getPointsTo(*MTI->getRawSource());
+    Summary.Mod |= getPointsTo(*MTI->getRawDest());
+    return;
+  }
+  if (const MemSetInst *const MSI = dyn_cast<MemSetInst>(&Call)) {
+    Summary.Mod |= getPointsTo(*MSI->getRawDest());
+    return;
+  }
+  if (FreeCalls.count(&Call)) {
+    Summary.Mod |= getPointsTo(*Call.getArgOperand(0));
+    return;
+  }
+  const Function *const Callee = Call.getCalledFunction();
+  if (Callee && !Callee->isDeclaration()) {
+    auto SummaryIt = ModRefSummaries.find(Callee);
+    if (SummaryIt != ModRefSummaries.end()) {
+      Summary.Mod |= SummaryIt->second.Mod;
+      Summary.Ref |= SummaryIt->second.Ref;
+    }
+    return;
+  }
+  // External and indirect calls access whatever their pointer arguments point
+  // to, and every escaped object unless they only access argument memory.
+  PointsTo_t Accessed;
+  for (const Use &Arg : Call.args()) {
+    if (Arg->getType()->isPointerTy()) {
+      Accessed |= getPointsTo(*Arg.get());
+    }
+  }
+  if (!Call.onlyAccessesArgMemory()) {
+    Accessed |= getLocations(UnknownNode);
+  }
+  Summary.Ref |= Accessed;
+  if (!Call.onlyReadsMemory()) {
+    Summary.Mod |= Accessed;
+  }
+}
+
+void PointerAnalysis::summarizeFunctions(Module &M) {
+  CallGraph CG(M);
+  for (auto SCCIt = scc_begin(&CG); !SCCIt.isAtEnd(); ++SCCIt) {
+    // Recursive functions are summarized until their summaries stabilize.
+    bool isChanged = true;
+    while (isChanged) {
+      isChanged = false;
+      for (const CallGraphNode *const Node : *SCCIt) {
+        const Function *const F = Node->getFunction();
+        if (!F || F->isDeclaration()) {
+          continue;
+        }
+        ModRefSummary Summary;
+        for (const Instruction &Inst : instructions(*F)) {
+          if (const LoadInst *const Load = dyn_cast<LoadInst>(&Inst)) {
+            Summary.Ref |= getPointsTo(*Load->getPointerOperand());
+          } else if (const StoreInst *const Store =
+                         dyn_cast<StoreInst>(&Inst)) {
+            Summary.Mod |= getPointsTo(*Store->getPointerOperand());
+          } else if (const CallBase *const Call = dyn_cast<CallBase>(&Inst)) {
+            summarizeCall(*Call, Summary);
+          } else if (Inst.mayReadOrWriteMemory()) {
+            // atomics and va_arg
+            for (const Use &Operand : Inst.operands()) {
+              if (Operand->getType()->isPointerTy()) {
+                Summary.Ref |= getPointsTo(*Operand.get());
+                Summary.Mod |= getPointsTo(*Operand.get());
+              }
+            }
+          }
+        }
+        ModRefSummary &PrevSummary = ModRefSummaries[F];
+        if (Summary.Mod != PrevSummary.Mod || Summary.Ref != PrevSummary.Ref) {
+          PrevSummary = std::move(Summary);
+          isChanged = SCCIt.hasCycle();
+        }
+      }
+    }
+  }
+}
+
+bool PointerAnalysis::runOnModule(
+    Module &M, function_ref<const TargetLibraryInfo &(Function &)> GetTLI) {
+  collectConstraints(M);
+  for (Function &F : M) {
+    if (F.isDeclaration()) {
+      continue;
+    }
+    const TargetLibraryInfo &TLI = GetTLI(F);
+    for (const BasicBlock &BB : F) {
+      for (const Instruction &Inst : BB) {
+        collectConstraints(Inst, TLI);
+      }
+    }
+  }
+  solve();
+  summarizeFunctions(M);
+  return false;
+}
+
+/*******************************************************************************
+ * Queries
+ ******************************************************************************/
+PointerAnalysis::PointsTo_t
+PointerAnalysis::getPointsTo(const Value &P) const {
+  if (isa<ConstantPointerNull>(P) || isa<UndefValue>(P)) {
+    return PointsTo_t();
+  }
+  auto NodeIt = ValueNodeMap.find(&P);
+  return getLocations(NodeIt == ValueNodeMap.end() ? UnknownNode
+                                                   : NodeIt->second);
+}
+
+ModRefInfo PointerAnalysis::getModRefInfo(const CallBase &Call,
+                                          const Value &P) const {
+  ModRefSummary Summary;
+  summarizeCall(Call, Summary);
+  const PointsTo_t PointsTo = getPointsTo(P);
+  ModRefInfo MRI = ModRefInfo::NoModRef;
+  if (Summary.Mod.intersects(PointsTo)) {
+    MRI = setMod(MRI);
+  }
+  if (Summary.Ref.intersects(PointsTo)) {
+    MRI = setRef(MRI);
+  }
+  return MRI;
+}
+
+void PointerAnalysis::printPointsTo(raw_ostream &Outs,
+                                    const PointsTo_t &Locations,
+                                    const bool PrintUnknown) const {
+  Outs << "{";
+  bool IsFirst = true;
+  for (unsigned Obj = PrintUnknown ? 0 : 1; Obj < Objects.size(); ++Obj) {
+    if (!Locations.test(getLocation(Obj))) {
+      continue;
+    }
+    Outs << (IsFirst ? " " : ", ");
+    IsFirst = false;
+    if (Obj == UnknownObject) {
+      Outs << "<unknown>";
+    } else {
+      Objects[Obj]->printAsOperand(Outs, false);
+    }
+  }
+  Outs << " }";
+}
+
+void PointerAnalysis::print(raw_ostream &Outs, const Module &M) const {
+  auto printValue = [&](const Value &V) {
+    auto NodeIt = ValueNodeMap.find(&V);
+    if (NodeIt == ValueNodeMap.end()) {
+      return;
+    }
+    Outs << "  ";
+    V.printAsOperand(Outs, false);
+    Outs << " -> ";
+    printPointsTo(Outs, getLocations(NodeIt->second));
+    Outs << "\n";
+  };
+  auto printModRef = [&](const CallBase &Call) {
+    ModRefSummary Summary;
+    summarizeCall(Call, Summary);
+    if (Summary.Mod.empty() && Summary.Ref.empty()) {
+      return;
+    }
+    Outs << "  call ";
+    if (const Function *const Callee = Call.getCalledFunction()) {
+      Callee->printAsOperand(Outs, false);
+    } else {
+      Outs << "<indirect>";
+    }
+    Outs << ": Mod ";
+    printPointsTo(Outs, Summary.Mod);
+    Outs << " Ref ";
+    printPointsTo(Outs, Summary.Ref);
+    Outs << "\n";
+  };
+  for (const Function &F : M) {
+    if (F.isDeclaration()) {
+      continue;
+    }
+    Outs << "Function: " << F.getName() << "\n";
+    for (const Argument &Arg : F.args()) {
+      printValue(Arg);
+    }
+    for (const Instruction &Inst : instructions(F)) {
+      printValue(Inst);
+      if (const CallBase *const Call = dyn_cast<CallBase>(&Inst)) {
+        printModRef(*Call);
+      }
+    }
+  }
+  Outs << "Escaped: ";
+  printPointsTo(Outs, getLocations(UnknownNode), false);
+  Outs << "\n";
+}
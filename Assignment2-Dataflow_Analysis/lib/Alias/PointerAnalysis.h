@@ -0,0 +1,159 @@
+#pragma once // NOLINT(llvm-header-guard)
+
+/**
+ * @file Pointer Analysis
+ */
+#include <llvm/ADT/DenseMap.h>
+#include <llvm/ADT/DenseSet.h>
+#include <llvm/ADT/STLExtras.h>
+#include <llvm/ADT/SparseBitVector.h>
+#include <llvm/Analysis/TargetLibraryInfo.h>
+#include <llvm/IR/Constants.h>
+#include <llvm/IR/InstrTypes.h>
+#include <llvm/IR/Instructions.h>
+#include <llvm/IR/Module.h>
+
+#include <vector>
+
+#include "AliasQuery.h"
+
+/**
+ * @brief Common base of the points-to analyses.
+ *
+ * Walks the module to generate the points-to constraints over the nodes of a
+ * constraint graph: Every pointer-typed value as well as every memory object
+ * (whose node stands for the object's content) is a node. The constraints
+ *
+ *   - p ⊇ {o}  (address-of),  - p ⊇ q  (copy),
+ *   - p ⊇ *q   (load),        - *p ⊇ q (store)
+ *
+ * are solved by the concrete analyses, which map every node to a set of
+ * abstract locations. The queries are then answered in terms of those
+ * locations, and so are the mod/ref summaries of the calls.
+ */
+class PointerAnalysis : public AliasQuery {
+protected:
+  using PointsTo_t = SparseBitVector<>;
+
+  // The unknown object, whose content is every escaped object.
+  static constexpr unsigned UnknownObject = 0, UnknownNode = 0;
+  // The node of the null pointer, whose points-to set is always empty.
+  static constexpr unsigned NullNode = 1;
+
+  // the memory objects (nullptr for the unknown one) and their content nodes
+  std::vector<const Value *> Objects;
+  std::vector<unsigned> ObjectNodes;
+
+  virtual unsigned createNode() = 0;
+  virtual void addAddrOf(const unsigned Dst, const unsigned Obj) = 0;
+  virtual void addCopy(const unsigned Dst, const unsigned Src) = 0;
+  virtual void addLoad(const unsigned Dst, const unsigned Src) = 0;
+  virtual void addStore(const unsigned Dst, const unsigned Src) = 0;
+  virtual void solve() = 0;
+  /**
+   * @brief Return the abstract locations that the node @c N may point to.
+   */
+  virtual PointsTo_t getLocations(const unsigned N) const = 0;
+  /**
+   * @brief Return the abstract location of the memory object @c Obj .
+   */
+  virtual unsigned getLocation(const unsigned Obj) const = 0;
+
+private:
+  DenseMap<const Value *, unsigned> ValueNodeMap, ObjectIdxMap;
+  DenseMap<const Function *, unsigned> RetNodeMap;
+
+  unsigned getValueNode(const Value &V);
+  unsigned getObject(const Value &Obj) {
+    auto IdxIt = ObjectIdxMap.find(&Obj);
+    if (IdxIt != ObjectIdxMap.end()) {
+      return IdxIt->second;
+    }
+    Objects.push_back(&Obj);
+    ObjectNodes.push_back(createNode());
+    return ObjectIdxMap[&Obj] = Objects.size() - 1;
+  }
+  unsigned getRetNode(const Function &F) {
+    auto NodeIt = RetNodeMap.find(&F);
+    if (NodeIt != RetNodeMap.end()) {
+      return NodeIt->second;
+    }
+    return RetNodeMap[&F] = createNode();
+  }
+
+  /*****************************************************************************
+   * Constraint Collection
+   ****************************************************************************/
+  /**
+   * @brief Add the memory objects that the constant @c C refers to (and the
+   *        unknown object for integer-to-pointer casts) to the points-to set
+   *        of @c Dst .
+   */
+  void addConstantPointees(const unsigned Dst, const Constant &C);
+  /**
+   * @brief Let code outside of the module access everything that @c V may
+   *        point to.
+   */
+  void addEscape(const Value &V);
+
+  void collectConstraints(const Module &M);
+  void collectConstraints(const CallBase &Call, const TargetLibraryInfo &TLI);
+  void collectConstraints(const Instruction &Inst,
+                          const TargetLibraryInfo &TLI);
+
+  /*****************************************************************************
+   * Mod/Ref Summaries
+   ****************************************************************************/
+  struct ModRefSummary {
+    PointsTo_t Mod, Ref;
+  };
+  DenseMap<const Function *, ModRefSummary> ModRefSummaries;
+  // library calls recognized during the constraint collection
+  DenseSet<const CallBase *> AllocCalls, FreeCalls;
+
+  /**
+   * @brief Add the locations that @c Call may modify and reference to
+   *        @c Summary .
+   */
+  void summarizeCall(const CallBase &Call, ModRefSummary &Summary) const;
+  /**
+   * @brief Summarize the locations that each function (including its callees)
+   *        may modify and reference, bottom-up over the call graph.
+   */
+  void summarizeFunctions(Module &M);
+
+  /**
+   * @brief Return the abstract locations that @c P may point to.
+   */
+  PointsTo_t getPointsTo(const Value &P) const;
+  /**
+   * @brief Print the memory objects at the abstract locations @c Locations .
+   */
+  void printPointsTo(raw_ostream &Outs, const PointsTo_t &Locations,
+                     const bool PrintUnknown = true) const;
+
+public:
+  bool runOnModule(Module &M,
+                   function_ref<const TargetLibraryInfo &(Function &)> GetTLI);
+  void print(raw_ostream &Outs, const Module &M) const;
+
+  virtual bool mayAlias(const Value &P, const Value &Q) const override {
+    return getPointsTo(P).intersects(getPointsTo(Q));
+  }
+  virtual bool mayPointTo(const Value &P, const Value &Obj) const override {
+    auto IdxIt = ObjectIdxMap.find(&Obj);
+    if (IdxIt == ObjectIdxMap.end()) {
+      return true;
+    }
+    return getPointsTo(P).test(getLocation(IdxIt->second));
+  }
+  virtual bool isEscaped(const Value &Obj) const override {
+    auto IdxIt = ObjectIdxMap.find(&Obj);
+    if (IdxIt == ObjectIdxMap.end()) {
+      return true;
+    }
+    return getLocations(UnknownNode).test(getLocation(IdxIt->second));
+  }
+  virtual ModRefInfo getModRefInfo(const CallBase &Call,
+                                   const Value &P) const override;
+};
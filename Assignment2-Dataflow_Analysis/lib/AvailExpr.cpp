@@ -24,77 +24,51 @@ using AvailExprFrameworkBase =
 
 class AvailExpr final : public AvailExprFrameworkBase, public FunctionPass {
 private:
+  ExpressionTable Table;
+
   virtual void initializeDomainFromInst(const Instruction &Inst) override {
-    if (const BinaryOperator *const BinaryOp =
-            dyn_cast<BinaryOperator>(&Inst)) {
-      /**
-       * Add Expression to the domain
-       * std::vector<TDomainElem> Domain
-       * TDomainElem is Expression
-       */
-      Expression Expr = Expression(*BinaryOp);
-// If Expr not already in the Domain, add it
+    /**
+     * Add Expression to the domain
+     * std::vector<TDomainElem> Domain
+     * TDomainElem is Expression, whose index in the domain is its ID in the
+     * expression table.
+     */
+    Optional<unsigned> ID = Table.insert(Inst);
+    if (!ID) {
+      return;
+    }
 #ifdef DEBUG_AVAIL_EXPR
-      errs() << "Domain Inst:" << Inst << "\n";
-      errs() << "\t\tExpression:"
-             << "\n";
-      errs() << "\t\t  Opcode:" << Expr.Opcode << "\n";
-      errs() << "\t\t  LHS:" << *Expr.LHS << "\n";
-      errs() << "\t\t  RHS:" << *Expr.RHS << "\n";
+    errs() << "Domain Inst:" << Inst << "\n";
+    errs() << "\t\tExpression " << *ID << ":" << Table[*ID] << "\n";
 #endif
-      if (std::find(Domain.begin(), Domain.end(), Expr) == Domain.end()) {
-        Domain.emplace_back(Expr);
-      }
+    // If Expr not already in the Domain, add it
+    if (*ID == Domain.size()) {
+      Domain.push_back(Table[*ID]);
     }
   }
   virtual bool transferFunc(const Instruction &Inst, const DomainVal_t &IBV,
                             DomainVal_t &OBV) override {
-
-    int Idx = 0;
     DomainVal_t TEMP_OBV = IBV;
 
     /*
      * Step 1: Generate
      *
      * Set the newly defined Instr in output.
-     * Add only if its a BinaryInstr
+     * Add only if its an Expression
      *
      * x = x + 1 -> Generate, then kill X
      */
-    if (const BinaryOperator *const BinaryOp =
-            dyn_cast<BinaryOperator>(&Inst)) {
-      Expression Expr = Expression(*BinaryOp);
-      auto it = std::find(Domain.begin(), Domain.end(), Expr);
-      if (it != Domain.end()) {
-        int index = it - Domain.begin();
-        TEMP_OBV.at(index) = true;
-      }
+    if (Optional<unsigned> ID = Table.lookup(Inst)) {
+      TEMP_OBV.at(*ID) = true;
     }
     /*
      * Step 2: Kill
      *
-     * For all Expressions in Domain, whose Expr.LHS or Expr.RHS
-     * equals current Inst, then Expr is killed or no more valid,
-     * because Inst is re-defined.
+     * For all Expressions in Domain that use the current Inst as an operand,
+     * Expr is killed or no more valid, because Inst is re-defined.
      */
-    for (Expression Expr : Domain) {
-      bool redefined = false;
-      // LHS
-      if (auto *InstLHS = dyn_cast<Instruction>(Expr.LHS)) {
-        if (InstLHS == &Inst) {
-          redefined = true;
-        }
-      }
-      // RHS
-      if (auto *InstRHS = dyn_cast<Instruction>(Expr.RHS)) {
-        if (InstRHS == &Inst) {
-          redefined = true;
-        }
-      }
-      if (redefined) {
-        TEMP_OBV.at(Idx) = false;
-      }
-      Idx++;
+    for (const unsigned UserID : Table.getUsers(Inst)) {
+      TEMP_OBV.at(UserID) = false;
     }
 
     // Did Output BitVector change?
@@ -103,6 +77,7 @@ private:
     OBV = TEMP_OBV;
     return isChanged;
   }
+  virtual StringRef getCacheID() const override { return "avail-expr"; }
 
 public:
   static char ID;
@@ -113,6 +88,9 @@ public:
     AU.setPreservesAll();
   }
   bool runOnFunction(Function &F) override {
+    Table = ExpressionTable();
+    Domain.clear();
+    InstDomainValMap.clear();
     return AvailExprFrameworkBase::runOnFunction(F);
   }
 };
@@ -0,0 +1,141 @@
+#include "1-MemLiveness.h"
+
+#include <llvm/Analysis/ValueTracking.h>
+#include <llvm/IR/GlobalVariable.h>
+#include <llvm/IR/Module.h>
+
+Optional<unsigned> MemLivenessImpl::getObjectIdx(const Value &P) const {
+  auto IdxIt = DomainIdxMap.find(getUnderlyingObject(&P));
+  if (IdxIt == DomainIdxMap.end()) {
+    return None;
+  }
+  return IdxIt->second;
+}
+
+Optional<unsigned>
+MemLivenessImpl::getKilledObjectIdx(const StoreInst &Store) const {
+  if (!Store.isSimple()) {
+    return None;
+  }
+  const Value *const Obj = Store.getPointerOperand()->stripPointerCasts();
+  auto IdxIt = DomainIdxMap.find(Obj);
+  if (IdxIt == DomainIdxMap.end()) {
+    return None;
+  }
+  const DataLayout &DL = Store.getModule()->getDataLayout();
+  Type *const ObjTy = isa<AllocaInst>(Obj)
+                          ? cast<AllocaInst>(Obj)->getAllocatedType()
+                          : cast<GlobalVariable>(Obj)->getValueType();
+  if (DL.getTypeStoreSize(Store.getValueOperand()->getType()) <
+      DL.getTypeStoreSize(ObjTy)) {
+    return None;
+  }
+  return IdxIt->second;
+}
+
+void MemLivenessImpl::collectPointees(
+    const Value &P, SmallVectorImpl<unsigned> &GenObjectIdxs) const {
+  // A pointer derived from an object cannot point anywhere else.
+  if (Optional<unsigned> ObjectIdx = getObjectIdx(P)) {
+    GenObjectIdxs.push_back(*ObjectIdx);
+    return;
+  }
+  for (unsigned Idx = 0; Idx < Domain.size(); ++Idx) {
+    if (AQ.mayPointTo(P, *Domain[Idx].V)) {
+      GenObjectIdxs.push_back(Idx);
+    }
+  }
+}
+
+void MemLivenessImpl::collectGenObjectIdxs(
+    const Instruction &Inst, SmallVectorImpl<unsigned> &GenObjectIdxs) const {
+  if (!Inst.mayReadFromMemory()) {
+    return;
+  }
+  if (const LoadInst *const Load = dyn_cast<LoadInst>(&Inst)) {
+    collectPointees(*Load->getPointerOperand(), GenObjectIdxs);
+  } else if (const AtomicRMWInst *const RMW = dyn_cast<AtomicRMWInst>(&Inst)) {
+    collectPointees(*RMW->getPointerOperand(), GenObjectIdxs);
+  } else if (const AtomicCmpXchgInst *const CmpXchg =
+                 dyn_cast<AtomicCmpXchgInst>(&Inst)) {
+    collectPointees(*CmpXchg->getPointerOperand(), GenObjectIdxs);
+  } else if (const CallBase *const Call = dyn_cast<CallBase>(&Inst)) {
+    // The callers may read the global variables after an exception.
+    const bool MayThrow = Call->mayThrow();
+    for (unsigned Idx = 0; Idx < Domain.size(); ++Idx) {
+      if ((MayThrow && isa<GlobalVariable>(Domain[Idx].V)) ||
+          isRefSet(AQ.getModRefInfo(*Call, *Domain[Idx].V))) {
+        GenObjectIdxs.push_back(Idx);
+      }
+    }
+  } else {
+    for (unsigned Idx = 0; Idx < Domain.size(); ++Idx) {
+      GenObjectIdxs.push_back(Idx);
+    }
+  }
+}
+
+void MemLivenessImpl::initializeDomainFromInst(const Instruction &Inst) {
+  // Only the objects that are stored to are of interest.
+  const StoreInst *const Store = dyn_cast<StoreInst>(&Inst);
+  if (!Store) {
+    return;
+  }
+  const Value *const Obj = getUnderlyingObject(Store->getPointerOperand());
+  const GlobalVariable *const GV = dyn_cast<GlobalVariable>(Obj);
+  if (!isa<AllocaInst>(Obj) && (!GV || GV->isConstant())) {
+    return;
+  }
+  if (DomainIdxMap.try_emplace(Obj, Domain.size()).second) {
+    Domain.emplace_back(Obj);
+  }
+}
+
+bool MemLivenessImpl::transferFunc(const Instruction &Inst,
+                                   const DomainVal_t &IV, DomainVal_t &OV) {
+  DomainVal_t TEMP_OV = IV;
+
+  /*
+   * A store that overwrites a whole object kills it, and everything that may
+   * read an object generates it.
+   */
+  if (const StoreInst *const Store = dyn_cast<StoreInst>(&Inst)) {
+    if (Optional<unsigned> ObjectIdx = getKilledObjectIdx(*Store)) {
+      TEMP_OV[*ObjectIdx] = false;
+    }
+  } else {
+    auto GenIt = GenMap.find(&Inst);
+    if (GenIt == GenMap.end()) {
+      GenIt = GenMap.try_emplace(&Inst).first;
+      collectGenObjectIdxs(Inst, GenIt->second);
+    }
+    for (const unsigned ObjectIdx : GenIt->second) {
+      TEMP_OV[ObjectIdx] = true;
+    }
+  }
+
+  bool isChanged = TEMP_OV != OV;
+  OV = TEMP_OV;
+  return isChanged;
+}
+
+MemLivenessImpl::DomainVal_t MemLivenessImpl::bc() const {
+  DomainVal_t BC(Domain.size());
+  for (unsigned Idx = 0; Idx < Domain.size(); ++Idx) {
+    BC[Idx] = isa<GlobalVariable>(Domain[Idx].V);
+  }
+  return BC;
+}
+
+bool MemLivenessImpl::isDeadStore(const StoreInst &Store) const {
+  if (!Store.isSimple()) {
+    return false;
+  }
+  Optional<unsigned> ObjectIdx = getObjectIdx(*Store.getPointerOperand());
+  if (!ObjectIdx) {
+    return false;
+  }
+  // The liveness right after the store is the one before the next
+  // instruction, as the store cannot be the terminator.
+  return !InstDomainValMap.at(Store.getNextNode())[*ObjectIdx];
+}
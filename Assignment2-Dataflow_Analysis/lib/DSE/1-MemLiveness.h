@@ -0,0 +1,76 @@
+#pragma once // NOLINT(llvm-header-guard)
+
+/**
+ * @file Memory Liveness Dataflow Analysis
+ */
+#include <llvm/ADT/DenseMap.h>
+#include <llvm/ADT/SmallVector.h>
+#include <llvm/IR/Instructions.h>
+
+#include <dfa/Framework.h>
+#include <dfa/MeetOp.h>
+
+#include "../Alias/AliasQuery.h"
+#include "../Variable.h"
+
+using namespace dfa;
+
+using MemLivenessFrameworkBase =
+    Framework<Variable, bool, Direction::kBackward, Union>;
+
+/**
+ * @brief Liveness of the memory objects, i.e., the stack slots and the global
+ *        variables that the function stores to.
+ *
+ * An object is live at a program point if its current content may be read
+ * before it gets overwritten as a whole. Loads and calls generate the objects
+ * that they may read according to the alias queries. As the objects are not
+ * split into fields, only the stores that overwrite an object entirely kill
+ * it. Global variables are live on exit from the function, and on the
+ * exceptional exits of the calls that may throw.
+ */
+class MemLivenessImpl : public MemLivenessFrameworkBase {
+private:
+  const AliasQuery &AQ;
+  // Object-Domain Index Mapping
+  DenseMap<const Value *, unsigned> DomainIdxMap;
+  // Instruction-Generated Objects Mapping, filled as the instructions are
+  // visited for the first time
+  DenseMap<const Instruction *, SmallVector<unsigned, 4>> GenMap;
+
+  /**
+   * @brief Return the domain index of the object that @c P points into, or
+   *        None if @c P is not known to point into a single object of the
+   *        domain.
+   */
+  Optional<unsigned> getObjectIdx(const Value &P) const;
+  /**
+   * @brief Return the domain index of the object that @c Store overwrites as
+   *        a whole, or None if it is not such a store.
+   */
+  Optional<unsigned> getKilledObjectIdx(const StoreInst &Store) const;
+  /**
+   * @brief Collect the domain indices of the objects that @c Inst may read.
+   */
+  void collectGenObjectIdxs(const Instruction &Inst,
+                            SmallVectorImpl<unsigned> &GenObjectIdxs) const;
+  void collectPointees(const Value &P,
+                       SmallVectorImpl<unsigned> &GenObjectIdxs) const;
+
+  virtual void initializeDomainFromInst(const Instruction &Inst) override;
+  virtual bool transferFunc(const Instruction &Inst, const DomainVal_t &IV,
+                            DomainVal_t &OV) override;
+  virtual DomainVal_t bc() const override;
+
+public:
+  explicit MemLivenessImpl(const AliasQuery &AQ) : AQ(AQ) { Verbose = false; }
+
+  bool runOnFunction(const Function &F) {
+    return MemLivenessFrameworkBase::runOnFunction(F);
+  }
+  /**
+   * @brief Whether the value stored by @c Store can never be read, i.e., the
+   *        object that it stores into is dead right after it.
+   */
+  bool isDeadStore(const StoreInst &Store) const;
+};
@@ -0,0 +1,85 @@
+/**
+ * @file Dead Store Elimination
+ */
+#include <llvm/IR/InstIterator.h>
+#include <llvm/Pass.h>
+#include <llvm/Transforms/Utils/Local.h>
+
+#include "../Alias/1-Andersen.h"
+#include "1-MemLiveness.h"
+
+namespace {
+
+/**
+ * @brief Delete the stores whose values can never be read, across the basic
+ *        blocks, as given by the liveness of the memory objects.
+ *
+ * Deleting a store may leave the computation of its value, and in particular
+ * the loads therein, dead. Those are deleted as well, which may in turn make
+ * more stores dead, hence the liveness is solved again until no more stores
+ * are deleted. The alias queries stay valid throughout, as deleting
+ * instructions can only make the points-to sets smaller.
+ *
+ * This is a module pass because the legacy pass manager does not let function
+ * passes depend on the (module-level) points-to analysis.
+ */
+class DeadStoreElim final : public ModulePass {
+private:
+  /**
+   * @brief Delete the dead stores of @c F .
+   * @return the number of deleted stores
+   */
+  static unsigned eliminateDeadStores(Function &F, const AliasQuery &AQ) {
+    unsigned NumDeadStores = 0;
+    while (true) {
+      MemLivenessImpl MemLiveness(AQ);
+      MemLiveness.runOnFunction(F);
+      SmallVector<StoreInst *, 16> DeadStores;
+      for (Instruction &Inst : instructions(F)) {
+        StoreInst *const Store = dyn_cast<StoreInst>(&Inst);
+        if (Store && MemLiveness.isDeadStore(*Store)) {
+          DeadStores.push_back(Store);
+        }
+      }
+      if (DeadStores.empty()) {
+        return NumDeadStores;
+      }
+      for (StoreInst *const Store : DeadStores) {
+        Value *const Val = Store->getValueOperand();
+        Store->eraseFromParent();
+        RecursivelyDeleteTriviallyDeadInstructions(Val);
+      }
+      NumDeadStores += DeadStores.size();
+    }
+  }
+
+public:
+  static char ID;
+
+  DeadStoreElim() : ModulePass(ID) {}
+
+  virtual void getAnalysisUsage(AnalysisUsage &AU) const override {
+    AU.addRequired<AndersenWrapperPass>();
+    AU.setPreservesCFG();
+  }
+
+  virtual bool runOnModule(Module &M) override {
+    const AliasQuery &AQ = getAnalysis<AndersenWrapperPass>().getAliasQuery();
+    bool Changed = false;
+    for (Function &F : M) {
+      if (F.isDeclaration()) {
+        continue;
+      }
+      const unsigned NumDeadStores = eliminateDeadStores(F, AQ);
+      errs() << "Dead Stores (" << F.getName() << "): " << NumDeadStores
+             << "\n";
+      Changed |= NumDeadStores != 0;
+    }
+    return Changed;
+  }
+};
+
+char DeadStoreElim::ID = 0;
+RegisterPass<DeadStoreElim> X("dead-store-elim", "Dead Store Elimination");
+
+} // anonymous namespace
@@ -1,68 +1,222 @@
 #pragma once // NOLINT(llvm-header-guard)
 
+#include <llvm/ADT/ArrayRef.h>
+#include <llvm/ADT/DenseMap.h>
+#include <llvm/ADT/Hashing.h>
+#include <llvm/ADT/Optional.h>
+#include <llvm/ADT/SmallVector.h>
+#include <llvm/IR/Constant.h>
+#include <llvm/IR/InstrTypes.h>
 #include <llvm/IR/Instruction.h>
 #include <llvm/IR/Instructions.h>
+#include <llvm/IR/Type.h>
 #include <llvm/IR/Value.h>
 #include <llvm/Support/raw_ostream.h>
 
+#include <algorithm>
+#include <utility>
+#include <vector>
+
 using namespace llvm;
 
 /**
- * @brief A wrapper for binary expressions.
+ * @brief A wrapper for the side-effect-free expressions, i.e., the unary and
+ *        binary operators, compares, casts, GEPs and selects.
+ *
+ * Expressions are compared structurally, hence they should be created through
+ * an @c ExpressionTable so that equivalent instructions (e.g., `a + b` and
+ * `b + a`, or `a < b` and `b > a`) have the same canonical form.
  */
 struct Expression {
-  const unsigned Opcode;
-  const Value *const LHS = nullptr, *const RHS = nullptr;
-  Expression(const BinaryOperator &BinaryOp)
-      : Opcode(BinaryOp.getOpcode()), LHS(BinaryOp.getOperand(0)),
-        RHS(BinaryOp.getOperand(1)) {}
+  unsigned Opcode;
+  // predicate of the compares, BAD_ICMP_PREDICATE otherwise
+  CmpInst::Predicate Predicate = CmpInst::BAD_ICMP_PREDICATE;
+  // result type, which tells apart, e.g., `zext i8 to i32` and `zext i8 to i64`
+  Type *Ty = nullptr;
+  SmallVector<const Value *, 3> Operands;
+
+  explicit Expression(const unsigned Opcode) : Opcode(Opcode) {}
 
   bool operator==(const Expression &Expr) const {
-    if (Expr.Opcode == Opcode && Expr.LHS == LHS && Expr.RHS == RHS) {
-      return true;
-    }
+    return Opcode == Expr.Opcode && Predicate == Expr.Predicate &&
+           Ty == Expr.Ty && Operands == Expr.Operands;
+  }
+};
 
-    /*
-     * Commutation Instruction like add (8), fadd(9), mul(12) and fmul(13),
-     * where lhs + rhs == rhs + lhs
-     * https://llvm.org/doxygen/group__LLVMCCoreTypes.html
-     */
-    if (Expr.Opcode == Opcode) {
-      switch (Opcode) {
-      case Instruction::Add:
-      case Instruction::FAdd:
-      case Instruction::Mul:
-      case Instruction::FMul:
-      case Instruction::And:
-      case Instruction::Or:
-      case Instruction::Xor: {
-        // Commutative
-        if (Expr.LHS == RHS && Expr.RHS == LHS) {
-          return true;
-        }
-        break;
-      }
-      default:
-        break;
-      }
-      /*
-      if (Opcode == 8 || Opcode == 9 || Opcode == 12 || Opcode == 13) {
-        if (Expr.LHS == RHS && Expr.RHS == LHS) {
-          return true;
-        }
-      }
-      */
-    }
+inline hash_code hash_value(const Expression &Expr) {
+  return hash_combine(
+      Expr.Opcode, Expr.Predicate, Expr.Ty,
+      hash_combine_range(Expr.Operands.begin(), Expr.Operands.end()));
+}
+
+namespace llvm {
 
-    return false;
+template <> struct DenseMapInfo<Expression> {
+  static Expression getEmptyKey() { return Expression(~0U); }
+  static Expression getTombstoneKey() { return Expression(~1U); }
+  static unsigned getHashValue(const Expression &Expr) {
+    return hash_value(Expr);
+  }
+  static bool isEqual(const Expression &LHS, const Expression &RHS) {
+    return LHS == RHS;
   }
 };
 
+} // namespace llvm
+
 inline raw_ostream &operator<<(raw_ostream &Outs, const Expression &Expr) {
   Outs << "[" << Instruction::getOpcodeName(Expr.Opcode) << " ";
-  Expr.LHS->printAsOperand(Outs, false);
-  Outs << ", ";
-  Expr.RHS->printAsOperand(Outs, false);
+  if (Expr.Predicate != CmpInst::BAD_ICMP_PREDICATE) {
+    Outs << CmpInst::getPredicateName(Expr.Predicate) << " ";
+  }
+  for (size_t Idx = 0; Idx < Expr.Operands.size(); ++Idx) {
+    if (Idx != 0) {
+      Outs << ", ";
+    }
+    Expr.Operands[Idx]->printAsOperand(Outs, false);
+  }
+  if (Instruction::isCast(Expr.Opcode)) {
+    Outs << " to " << *Expr.Ty;
+  }
   Outs << "]";
   return Outs;
 }
+
+/**
+ * @brief Hash-consed table of the expressions of a function.
+ *
+ * Every distinct expression is interned to a small integer ID, which is
+ * assigned in the order of insertion. The expression analyses use the IDs as
+ * their domain indices, and the analyses that build on another one share its
+ * table. The operands of the commutative operators and of the compares
+ * (whose predicate is swapped accordingly) are put in a canonical order,
+ * where constants come last and the values are otherwise ordered by the first
+ * time that the table sees them. Operands are hash-consed as well, i.e.,
+ * replaced by the leader of their own expression, so that, e.g., two GEPs
+ * over two separate but identical index computations are the same expression.
+ */
+class ExpressionTable {
+private:
+  std::vector<Expression> Expressions;
+  // the first instruction that computes each expression
+  std::vector<const Instruction *> Leaders;
+  DenseMap<Expression, unsigned> ExpressionIDs;
+  // Instruction-Expression ID Mapping
+  DenseMap<const Instruction *, unsigned> InstIDs;
+  // Value-Expression IDs Mapping, from each value to the expressions that use
+  // it as an operand
+  DenseMap<const Value *, SmallVector<unsigned, 2>> UserIDs;
+  // ranks of the operands, used to order them canonically
+  DenseMap<const Value *, unsigned> ValueRanks;
+
+  bool isOrdered(const Value *const LHS, const Value *const RHS) {
+    if (isa<Constant>(LHS) != isa<Constant>(RHS)) {
+      return isa<Constant>(RHS);
+    }
+    const unsigned LHSRank =
+        ValueRanks.try_emplace(LHS, ValueRanks.size()).first->second;
+    const unsigned RHSRank =
+        ValueRanks.try_emplace(RHS, ValueRanks.size()).first->second;
+    return LHSRank <= RHSRank;
+  }
+
+  /**
+   * @brief Return the canonical expression computed by @c Inst , or None if
+   *        @c Inst is not an expression.
+   */
+  Optional<Expression> canonicalize(const Instruction &Inst) {
+    if (!isa<UnaryOperator>(Inst) && !isa<BinaryOperator>(Inst) &&
+        !isa<CmpInst>(Inst) && !isa<CastInst>(Inst) &&
+        !isa<GetElementPtrInst>(Inst) && !isa<SelectInst>(Inst)) {
+      return None;
+    }
+    Expression Expr(Inst.getOpcode());
+    Expr.Ty = Inst.getType();
+    // Operands that compute the same expression hold the same value, hence
+    // they are replaced by the leader of that expression.
+    for (const Value *const Operand : Inst.operands()) {
+      const Instruction *const OperandInst = dyn_cast<Instruction>(Operand);
+      auto InstIt = OperandInst ? InstIDs.find(OperandInst) : InstIDs.end();
+      Expr.Operands.push_back(
+          InstIt != InstIDs.end() ? Leaders[InstIt->second] : Operand);
+    }
+    if (const CmpInst *const Cmp = dyn_cast<CmpInst>(&Inst)) {
+      Expr.Predicate = Cmp->getPredicate();
+      if (!isOrdered(Expr.Operands[0], Expr.Operands[1])) {
+        std::swap(Expr.Operands[0], Expr.Operands[1]);
+        Expr.Predicate = CmpInst::getSwappedPredicate(Expr.Predicate);
+      }
+    } else if (Inst.isCommutative() &&
+               !isOrdered(Expr.Operands[0], Expr.Operands[1])) {
+      std::swap(Expr.Operands[0], Expr.Operands[1]);
+    }
+    return Expr;
+  }
+
+public:
+  /**
+   * @brief Intern the expression computed by @c Inst .
+   * @return the ID of the expression, or None if @c Inst is not an expression
+   */
+  Optional<unsigned> insert(const Instruction &Inst) {
+    auto InstIt = InstIDs.find(&Inst);
+    if (InstIt != InstIDs.end()) {
+      return InstIt->second;
+    }
+    Optional<Expression> Expr = canonicalize(Inst);
+    if (!Expr) {
+      return None;
+    }
+    auto Inserted = ExpressionIDs.try_emplace(*Expr, Expressions.size());
+    const unsigned ID = Inserted.first->second;
+    if (Inserted.second) {
+      Expressions.push_back(std::move(*Expr));
+      Leaders.push_back(&Inst);
+    }
+    // The expression is killed by the redefinition of any operand of any
+    // instruction that computes it, whether or not that is the leader.
+    for (const Value *const Operand : Inst.operands()) {
+      if (isa<Constant>(Operand)) {
+        continue;
+      }
+      SmallVector<unsigned, 2> &Users = UserIDs[Operand];
+      if (std::find(Users.begin(), Users.end(), ID) == Users.end()) {
+        Users.push_back(ID);
+      }
+    }
+    InstIDs.try_emplace(&Inst, ID);
+    return ID;
+  }
+  /**
+   * @brief Return the ID of the expression computed by @c Inst , or None if
+   *        @c Inst has not been inserted.
+   */
+  Optional<unsigned> lookup(const Instruction &Inst) const {
+    auto InstIt = InstIDs.find(&Inst);
+    if (InstIt == InstIDs.end()) {
+      return None;
+    }
+    return InstIt->second;
+  }
+  /**
+   * @brief Return the IDs of the expressions that use @c V as an operand,
+   *        i.e., the expressions that are killed when @c V is redefined.
+   */
+  ArrayRef<unsigned> getUsers(const Value &V) const {
+    auto UsersIt = UserIDs.find(&V);
+    if (UsersIt == UserIDs.end()) {
+      return None;
+    }
+    return UsersIt->second;
+  }
+
+  /**
+   * @brief Return the first instruction that computes the expression @c ID .
+   */
+  const Instruction *getLeader(const unsigned ID) const { return Leaders[ID]; }
+  const Expression &operator[](const unsigned ID) const {
+    return Expressions[ID];
+  }
+  const std::vector<Expression> &getExpressions() const { return Expressions; }
+  unsigned size() const { return Expressions.size(); }
+};
@@ -0,0 +1,130 @@
+#pragma once // NOLINT(llvm-header-guard)
+
+#include <llvm/ADT/Optional.h>
+#include <llvm/IR/ConstantRange.h>
+#include <llvm/Support/raw_ostream.h>
+
+#include <dfa/MeetOp.h>
+
+using namespace llvm;
+
+/**
+ * @brief A wrapper for integer intervals.
+ *
+ * The interval is stored as a (possibly wrapped) @c ConstantRange so that both
+ * its signed and its unsigned bounds can be queried. An interval without any
+ * range is the bottom element, i.e., the value has not been reached yet.
+ */
+struct Interval {
+  Optional<ConstantRange> Range;
+
+  Interval() = default;
+  Interval(const ConstantRange &CR) : Range(CR) {}
+
+  bool isBottom() const { return !Range.hasValue(); }
+
+  bool operator==(const Interval &Other) const {
+    if (isBottom() || Other.isBottom()) {
+      return isBottom() == Other.isBottom();
+    }
+    return *Range == *Other.Range;
+  }
+  bool operator!=(const Interval &Other) const { return !(*this == Other); }
+};
+
+inline raw_ostream &operator<<(raw_ostream &Outs, const Interval &Itv) {
+  if (Itv.isBottom()) {
+    Outs << "bottom";
+  } else {
+    Itv.Range->print(Outs);
+  }
+  return Outs;
+}
+
+/**
+ * @brief Interval Hull Meet Operator
+ *
+ * The smallest interval that covers both LHS and RHS.
+ *
+ * "top" value is bottom (unreached) for every element. As the lattice has
+ * infinite height for practical purposes, widening pushes a bound that keeps
+ * growing straight to the signed extreme, and narrowing pulls it back.
+ */
+class IntervalHull final : public dfa::MeetOp<Interval> {
+private:
+  static Interval hull(const Interval &LHS, const Interval &RHS) {
+    if (LHS.isBottom()) {
+      return RHS;
+    }
+    if (RHS.isBottom()) {
+      return LHS;
+    }
+    return LHS.Range->unionWith(*RHS.Range, ConstantRange::Signed);
+  }
+
+  static Interval fromSignedBounds(const APInt &Lower, const APInt &Upper) {
+    if (Lower.isMinSignedValue() && Upper.isMaxSignedValue()) {
+      return ConstantRange::getFull(Lower.getBitWidth());
+    }
+    return ConstantRange::getNonEmpty(Lower, Upper + 1);
+  }
+
+public:
+  virtual DomainVal_t operator()(const DomainVal_t &LHS,
+                                 const DomainVal_t &RHS) const override {
+    assert(LHS.size() == RHS.size() &&
+           "Size of domain values for merge has to be the same");
+    DomainVal_t Result(LHS.size());
+    for (size_t Idx = 0; Idx < LHS.size(); ++Idx) {
+      Result[Idx] = hull(LHS[Idx], RHS[Idx]);
+    }
+    return Result;
+  }
+
+  virtual DomainVal_t top(const size_t DomainSize) const override {
+    return DomainVal_t(DomainSize);
+  }
+
+  virtual DomainVal_t widen(const DomainVal_t &Prev,
+                            const DomainVal_t &Curr) const override {
+    DomainVal_t Result(Prev.size());
+    for (size_t Idx = 0; Idx < Prev.size(); ++Idx) {
+      if (Prev[Idx].isBottom() || Curr[Idx].isBottom()) {
+        Result[Idx] = hull(Prev[Idx], Curr[Idx]);
+        continue;
+      }
+      const ConstantRange &P = *Prev[Idx].Range, &C = *Curr[Idx].Range;
+      APInt Lower = P.getSignedMin(), Upper = P.getSignedMax();
+      if (C.getSignedMin().slt(Lower)) {
+        Lower = APInt::getSignedMinValue(Lower.getBitWidth());
+      }
+      if (C.getSignedMax().sgt(Upper)) {
+        Upper = APInt::getSignedMaxValue(Upper.getBitWidth());
+      }
+      Result[Idx] = fromSignedBounds(Lower, Upper);
+    }
+    return Result;
+  }
+
+  virtual DomainVal_t narrow(const DomainVal_t &Prev,
+                             const DomainVal_t &Curr) const override {
+    DomainVal_t Result(Prev.size());
+    for (size_t Idx = 0; Idx < Prev.size(); ++Idx) {
+      if (Prev[Idx].isBottom() || Curr[Idx].isBottom()) {
+        Result[Idx] = Curr[Idx];
+        continue;
+      }
+      const ConstantRange &P = *Prev[Idx].Range, &C = *Curr[Idx].Range;
+      // Only the bounds that have been widened to infinity are refined.
+      APInt Lower = P.getSignedMin(), Upper = P.getSignedMax();
+      if (Lower.isMinSignedValue()) {
+        Lower = C.getSignedMin();
+      }
+      if (Upper.isMaxSignedValue()) {
+        Upper = C.getSignedMax();
+      }
+      Result[Idx] = Lower.sgt(Upper) ? Curr[Idx] : fromSignedBounds(Lower, Upper);
+    }
+    return Result;
+  }
+};
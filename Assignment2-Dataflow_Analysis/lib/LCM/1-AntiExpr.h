@@ -25,69 +25,42 @@ using AntiExprFrameworkBase =
 
 class AntiExprImpl : public AntiExprFrameworkBase {
 private:
+  ExpressionTable Table;
+
   virtual void initializeDomainFromInst(const Instruction &Inst) override {
-    if (const BinaryOperator *const BinaryOp =
-            dyn_cast<BinaryOperator>(&Inst)) {
-      Expression Expr = Expression(*BinaryOp);
+    Optional<unsigned> ID = Table.insert(Inst);
+    if (!ID) {
+      return;
+    }
 
 #ifdef DEBUG_ANTI_EXPR
-      errs() << "Domain Inst:" << Inst << "\n";
-      errs() << "\t\tExpression:"
-             << "\n";
-      errs() << "\t\t  Opcode:" << Expr.Opcode << "\n";
-      errs() << "\t\t  LHS:" << *Expr.LHS << "\n";
-      errs() << "\t\t  RHS:" << *Expr.RHS << "\n";
+    errs() << "Domain Inst:" << Inst << "\n";
+    errs() << "\t\tExpression " << *ID << ":" << Table[*ID] << "\n";
 #endif // DEBUG
 
-      if (std::find(Domain.begin(), Domain.end(), Expr) == Domain.end()) {
-        Domain.emplace_back(Expr);
-      }
+    if (*ID == Domain.size()) {
+      Domain.push_back(Table[*ID]);
     }
   }
   virtual bool transferFunc(const Instruction &Inst, const DomainVal_t &IV,
                             DomainVal_t &OV) override {
 
-    int Idx = 0;
     DomainVal_t TEMP_OV = IV;
     /*
      * Step 1: Generate the Anticipated Expression.
      *
      */
-    if (const BinaryOperator *const BinaryOp =
-            dyn_cast<BinaryOperator>(&Inst)) {
-      Expression Expr = Expression(*BinaryOp);
-      auto it = std::find(Domain.begin(), Domain.end(), Expr);
-
-      if (it != Domain.end()) {
-        int index = it - Domain.begin();
-        TEMP_OV.at(index) = true;
-      }
+    if (Optional<unsigned> ID = Table.lookup(Inst)) {
+      TEMP_OV.at(*ID) = true;
     }
 
     /*
-     * Step 2: Kill the expression who LHS or RHS equal Inst,
+     * Step 2: Kill the expressions that use Inst as an operand,
      * because its redefined
      *
      */
-    for (Expression Expr : Domain) {
-      bool redefined = false;
-      if (auto *InstLHS = dyn_cast<Instruction>(Expr.LHS)) {
-        if (InstLHS == &Inst) {
-          redefined = true;
-        }
-      }
-
-      if (auto *InstRHS = dyn_cast<Instruction>(Expr.RHS)) {
-        if (InstRHS == &Inst) {
-          redefined = true;
-        }
-      }
-
-      if (redefined) {
-        TEMP_OV.at(Idx) = false;
-      }
-
-      Idx++;
+    for (const unsigned UserID : Table.getUsers(Inst)) {
+      TEMP_OV.at(UserID) = false;
     }
 
     bool isChanged = TEMP_OV != OV;
@@ -96,6 +69,7 @@ private:
 
     return isChanged;
   }
+  virtual StringRef getCacheID() const override { return "anti-expr"; }
 
 private:
   friend class AntiExprWrapperPass;
@@ -119,10 +93,15 @@ public:
     errs() << "* Anticipated Expression *"
            << "\n";
 
+    AntiExpr = AntiExprImpl();
     return AntiExpr.runOnFunction(F);
   }
 
-  std::vector<Expression> getDomain() const { return AntiExpr.Domain; }
+  /**
+   * Obtain the expression table of @c AntiExprImpl , whose IDs are the domain
+   * indices of all the LCM analyses.
+   */
+  const ExpressionTable &getExpressionTable() const { return AntiExpr.Table; }
   std::unordered_map<const Instruction *, std::vector<bool>>
   getInstDomainValMap() const {
     return AntiExpr.InstDomainValMap;
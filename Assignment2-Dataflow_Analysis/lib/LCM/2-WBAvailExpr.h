@@ -18,6 +18,8 @@ using WBAvailExprFrameworkBase =
 
 class WBAvailExprImpl : public WBAvailExprFrameworkBase {
 private:
+  // Expression Table shared with the Anticipated Expression
+  const ExpressionTable *Table = nullptr;
   std::unordered_map<const Instruction *, DomainVal_t> AntiExprInstDomainValMap;
   // Basic Block - Boundary Value Mapping
   std::unordered_map<const BasicBlock *, std::vector<bool>>
@@ -26,11 +28,11 @@ private:
 private:
   WBAvailExprImpl() = default;
 
-  void initialize(std::vector<Expression> AntiExprDomain,
+  void initialize(const ExpressionTable &AntiExprTable,
                   std::unordered_map<const Instruction *, DomainVal_t>
                       AntiExprInstDomainValMap) {
-    std::copy(AntiExprDomain.begin(), AntiExprDomain.end(),
-              std::back_inserter(this->Domain));
+    this->Table = &AntiExprTable;
+    this->Domain = AntiExprTable.getExpressions();
     this->AntiExprInstDomainValMap = AntiExprInstDomainValMap;
   }
 
@@ -46,19 +48,9 @@ private:
      * method. Just adding debug information.
      */
 #ifdef DEBUG_WB_EXPR
-    if (const BinaryOperator *const BinaryOp =
-            dyn_cast<BinaryOperator>(&Inst)) {
-      Expression Expr = Expression(*BinaryOp);
-      auto it = std::find(Domain.begin(), Domain.end(), Expr);
-
-      if (it != Domain.end()) {
-        errs() << "Domain Inst:" << Inst << "\n";
-        errs() << "\t\tExpression:"
-               << "\n";
-        errs() << "\t\t  Opcode:" << Expr.Opcode << "\n";
-        errs() << "\t\t  LHS:" << *Expr.LHS << "\n";
-        errs() << "\t\t  RHS:" << *Expr.RHS << "\n";
-      }
+    if (Optional<unsigned> ID = Table->lookup(Inst)) {
+      errs() << "Domain Inst:" << Inst << "\n";
+      errs() << "\t\tExpression " << *ID << ":" << Domain[*ID] << "\n";
     }
 #endif
   }
@@ -69,17 +61,11 @@ private:
      * Step 1: Generate
      *
      * Set the newly defined Instr in output.
-     * Add only if its a BinaryInstr
+     * Add only if its an Expression
      */
     DomainVal_t TEMP_OV = IV;
-    if (const BinaryOperator *const BinaryOp =
-            dyn_cast<BinaryOperator>(&Inst)) {
-      Expression Expr = Expression(*BinaryOp);
-      auto it = std::find(Domain.begin(), Domain.end(), Expr);
-      if (it != Domain.end()) {
-        int index = it - Domain.begin();
-        TEMP_OV.at(index) = true;
-      }
+    if (Optional<unsigned> ID = Table->lookup(Inst)) {
+      TEMP_OV.at(*ID) = true;
     }
 
     /*
@@ -89,7 +75,7 @@ private:
      * it also available
      *
      */
-    DomainVal_t AntiExprIN = AntiExprInstDomainValMap.at(&Inst);
+    const DomainVal_t &AntiExprIN = AntiExprInstDomainValMap.at(&Inst);
     assert(
         AntiExprIN.size() == TEMP_OV.size() &&
         "Anticipated IN Inst Vector should equal Will Be Availble OUT Vector");
@@ -101,29 +87,11 @@ private:
     /*
      * Step 3: Kill
      *
-     * For all Expressions in Domain, whose Expr.LHS or Expr.RHS
-     * equals current Inst, then Expr is killed or no more valid,
-     * because Inst is re-defined.
+     * For all Expressions in Domain that use the current Inst as an
+     * operand, Expr is killed or no more valid, because Inst is re-defined.
      */
-    int Idx = 0;
-    for (Expression Expr : Domain) {
-      bool redefined = false;
-      // LHS
-      if (auto *InstLHS = dyn_cast<Instruction>(Expr.LHS)) {
-        if (InstLHS == &Inst) {
-          redefined = true;
-        }
-      }
-      // RHS
-      if (auto *InstRHS = dyn_cast<Instruction>(Expr.RHS)) {
-        if (InstRHS == &Inst) {
-          redefined = true;
-        }
-      }
-      if (redefined) {
-        TEMP_OV.at(Idx) = false;
-      }
-      Idx++;
+    for (const unsigned UserID : Table->getUsers(Inst)) {
+      TEMP_OV.at(UserID) = false;
     }
 
     bool isChanged = TEMP_OV != OV;
@@ -131,6 +99,7 @@ private:
 
     return isChanged;
   }
+  virtual StringRef getCacheID() const override { return "wb-avail-expr"; }
 
 private:
   friend class WBAvailExprWrapperPass;
@@ -157,11 +126,12 @@ public:
     // Get the results from AntiExprWrapperPass
     AntiExprWrapperPass &AntiExpr = getAnalysis<AntiExprWrapperPass>();
 
-    // Access the domain and instruction-domain value map from
+    // Access the expression table and instruction-domain value map from
     // Anticipated Expression
-    std::vector<Expression> AntiExprDomain = AntiExpr.getDomain();
     auto AntiExprInstDomainValMap = AntiExpr.getInstDomainValMap();
-    WBAvailExpr.initialize(AntiExprDomain, AntiExprInstDomainValMap);
+    WBAvailExpr = WBAvailExprImpl();
+    WBAvailExpr.initialize(AntiExpr.getExpressionTable(),
+                           AntiExprInstDomainValMap);
 
     bool isModified = WBAvailExpr.runOnFunction(F);
 
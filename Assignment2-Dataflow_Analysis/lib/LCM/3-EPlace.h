@@ -12,6 +12,9 @@ using EPlaceFrameworkBase =
 class EPlaceImpl : public EPlaceFrameworkBase {
 
 private:
+  // Expression Table shared with the Anticipated Expression
+  const ExpressionTable *Table = nullptr;
+
   // Anticipated Expression OUT
   std::unordered_map<const Instruction *, DomainVal_t> AntiExprInstDomainValMap;
 
@@ -22,14 +25,14 @@ private:
 private:
   EPlaceImpl() = default;
 
-  void initialize(std::vector<Expression> AntiExprDomain,
+  void initialize(const ExpressionTable &AntiExprTable,
                   std::unordered_map<const Instruction *, DomainVal_t>
                       AntiExprInstDomainValMap,
                   std::unordered_map<const BasicBlock *, std::vector<bool>>
                       WBAvailExprBoundaryVals) {
 
-    std::copy(AntiExprDomain.begin(), AntiExprDomain.end(),
-              std::back_inserter(this->Domain));
+    this->Table = &AntiExprTable;
+    this->Domain = AntiExprTable.getExpressions();
     this->AntiExprInstDomainValMap = AntiExprInstDomainValMap;
     this->WBAvailExprBoundaryVals = WBAvailExprBoundaryVals;
   }
@@ -41,19 +44,9 @@ private:
      * Domain Variables.
      */
 #ifdef DEBUG_EPLACE
-    if (const BinaryOperator *const BinaryOp =
-            dyn_cast<BinaryOperator>(&Inst)) {
-      Expression Expr = Expression(*BinaryOp);
-      auto it = std::find(Domain.begin(), Domain.end(), Expr);
-
-      if (it != Domain.end()) {
-        errs() << "Domain Inst:" << Inst << "\n";
-        errs() << "\t\tExpression:"
-               << "\n";
-        errs() << "\t\t  Opcode:" << Expr.Opcode << "\n";
-        errs() << "\t\t  LHS:" << *Expr.LHS << "\n";
-        errs() << "\t\t  RHS:" << *Expr.RHS << "\n";
-      }
+    if (Optional<unsigned> ID = Table->lookup(Inst)) {
+      errs() << "Domain Inst:" << Inst << "\n";
+      errs() << "\t\tExpression " << *ID << ":" << Domain[*ID] << "\n";
     }
 #endif
   }
@@ -89,12 +82,12 @@ public:
     AntiExprWrapperPass &AntiExpr = getAnalysis<AntiExprWrapperPass>();
     WBAvailExprWrapperPass &WBAvailExpr = getAnalysis<WBAvailExprWrapperPass>();
 
-    std::vector<Expression> Domain = AntiExpr.getDomain();
     auto AntiExprInstDomainValMap = AntiExpr.getInstDomainValMap();
     auto WBAvailExprInstDomainValMap = WBAvailExpr.getInstDomainValMap();
     auto WBAvailExprBoundaryVals = WBAvailExpr.getBoundaryVals();
 
-    EPlace.initialize(Domain, AntiExprInstDomainValMap,
+    EPlace = EPlaceImpl();
+    EPlace.initialize(AntiExpr.getExpressionTable(), AntiExprInstDomainValMap,
                       WBAvailExprBoundaryVals);
 
     return EPlace.runOnFunction(F);
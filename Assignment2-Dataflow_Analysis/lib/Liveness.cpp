@@ -88,6 +88,7 @@ private:
     OBV = TEMP_OBV;
     return isChanged;
   }
+  virtual StringRef getCacheID() const override { return "liveness"; }
 
 public:
   static char ID;
@@ -0,0 +1,184 @@
+#include "1-ValueRange.h"
+
+bool ValueRangeImpl::refineOnEdge(const BasicBlock &Pred, const BasicBlock &BB,
+                                  DomainVal_t &Val) const {
+  const BranchInst *const Br = dyn_cast<BranchInst>(Pred.getTerminator());
+  if (!Br || !Br->isConditional() ||
+      Br->getSuccessor(0) == Br->getSuccessor(1)) {
+    return true;
+  }
+  const bool IsTrueEdge = Br->getSuccessor(0) == &BB;
+
+  // The condition might already be known, in which case one edge is dead.
+  Interval Cond = lookup(Br->getCondition(), Val);
+  if (!Cond.isBottom()) {
+    if (const APInt *const CondVal = Cond.Range->getSingleElement()) {
+      if (CondVal->getBoolValue() != IsTrueEdge) {
+        return false;
+      }
+    }
+  }
+
+  const ICmpInst *const Cmp = dyn_cast<ICmpInst>(Br->getCondition());
+  if (!Cmp || !Cmp->getOperand(0)->getType()->isIntegerTy()) {
+    return true;
+  }
+  const CmpInst::Predicate EdgePred =
+      IsTrueEdge ? Cmp->getPredicate() : Cmp->getInversePredicate();
+  const Value *const LHS = Cmp->getOperand(0), *const RHS = Cmp->getOperand(1);
+  const Interval LHSItv = lookup(LHS, Val), RHSItv = lookup(RHS, Val);
+  if (LHSItv.isBottom() || RHSItv.isBottom()) {
+    return true;
+  }
+
+  /*
+   * Intersect the interval of @c V with the region that satisfies
+   * "V CmpPred Other". An empty intersection means the edge is infeasible.
+   */
+  auto Restrict = [&](const Value *const V, const CmpInst::Predicate CmpPred,
+                      const ConstantRange &Other) -> bool {
+    auto IdxIt = DomainIdxMap.find(V);
+    if (IdxIt == DomainIdxMap.end() || Val[IdxIt->second].isBottom()) {
+      return true;
+    }
+    Interval &Itv = Val[IdxIt->second];
+    ConstantRange Restricted = Itv.Range->intersectWith(
+        ConstantRange::makeAllowedICmpRegion(CmpPred, Other),
+        ConstantRange::Signed);
+    if (Restricted.isEmptySet()) {
+      return false;
+    }
+    Itv = Restricted;
+    return true;
+  };
+  return Restrict(LHS, EdgePred, *RHSItv.Range) &&
+         Restrict(RHS, CmpInst::getSwappedPredicate(EdgePred), *LHSItv.Range);
+}
+
+void ValueRangeImpl::evaluatePHIsOnEdge(const BasicBlock &Pred,
+                                        const BasicBlock &BB,
+                                        DomainVal_t &Val) const {
+  // φ-nodes are evaluated in parallel, hence the updates are buffered.
+  SmallVector<std::pair<unsigned, Interval>, 8> Updates;
+  for (const PHINode &PHI : BB.phis()) {
+    auto IdxIt = DomainIdxMap.find(&PHI);
+    if (IdxIt == DomainIdxMap.end()) {
+      continue;
+    }
+    Updates.emplace_back(IdxIt->second,
+                         lookup(PHI.getIncomingValueForBlock(&Pred), Val));
+  }
+  for (const auto &Update : Updates) {
+    Val[Update.first] = Update.second;
+  }
+}
+
+ValueRangeImpl::DomainVal_t
+ValueRangeImpl::getBoundaryVal(const BasicBlock &BB) const {
+  if (pred_empty(&BB)) {
+    return bc();
+  }
+  IntervalHull MeetOp;
+  DomainVal_t Merge = MeetOp.top(Domain.size());
+  for (const BasicBlock *const Pred : predecessors(&BB)) {
+    DomainVal_t EdgeVal = InstDomainValMap.at(&Pred->back());
+    if (!refineOnEdge(*Pred, BB, EdgeVal)) {
+      continue;
+    }
+    evaluatePHIsOnEdge(*Pred, BB, EdgeVal);
+    Merge = MeetOp(Merge, EdgeVal);
+  }
+  return Merge;
+}
+
+Interval ValueRangeImpl::evaluate(const Instruction &Inst,
+                                  const DomainVal_t &Val) const {
+  const unsigned BitWidth = Inst.getType()->getIntegerBitWidth();
+
+  if (isa<PHINode>(Inst)) {
+    // already evaluated on the incoming edges
+    return lookup(&Inst, Val);
+  }
+  SmallVector<ConstantRange, 3> Operands;
+  for (const Use &Operand : Inst.operands()) {
+    if (!Operand->getType()->isIntegerTy()) {
+      continue;
+    }
+    Interval Itv = lookup(Operand.get(), Val);
+    if (Itv.isBottom()) {
+      // The operand has not been reached yet, and neither has Inst.
+      return Interval();
+    }
+    Operands.push_back(*Itv.Range);
+  }
+
+  if (const BinaryOperator *const BinaryOp = dyn_cast<BinaryOperator>(&Inst)) {
+    const Instruction::BinaryOps Opcode = BinaryOp->getOpcode();
+    unsigned NoWrapKind = 0;
+    if (isa<OverflowingBinaryOperator>(BinaryOp)) {
+      NoWrapKind |= BinaryOp->hasNoSignedWrap()
+                        ? OverflowingBinaryOperator::NoSignedWrap
+                        : 0;
+      NoWrapKind |= BinaryOp->hasNoUnsignedWrap()
+                        ? OverflowingBinaryOperator::NoUnsignedWrap
+                        : 0;
+    }
+    if (NoWrapKind && (Opcode == Instruction::Add ||
+                       Opcode == Instruction::Sub ||
+                       Opcode == Instruction::Mul)) {
+      return Operands[0].overflowingBinaryOp(Opcode, Operands[1], NoWrapKind);
+    }
+    return Operands[0].binaryOp(Opcode, Operands[1]);
+  }
+  if (const CastInst *const Cast = dyn_cast<CastInst>(&Inst)) {
+    if (Operands.size() == 1) {
+      return Operands[0].castOp(Cast->getOpcode(), BitWidth);
+    }
+  }
+  if (const ICmpInst *const Cmp = dyn_cast<ICmpInst>(&Inst)) {
+    if (Operands.size() == 2) {
+      if (Operands[0].icmp(Cmp->getPredicate(), Operands[1])) {
+        return ConstantRange(APInt(1, 1));
+      }
+      if (Operands[0].icmp(Cmp->getInversePredicate(), Operands[1])) {
+        return ConstantRange(APInt(1, 0));
+      }
+    }
+  }
+  if (const ExtractValueInst *const Extract = dyn_cast<ExtractValueInst>(&Inst)) {
+    // The arithmetic result of an overflow check wraps around on overflow.
+    const WithOverflowInst *const WO =
+        dyn_cast<WithOverflowInst>(Extract->getAggregateOperand());
+    if (WO && Extract->getNumIndices() == 1 && *Extract->idx_begin() == 0) {
+      Interval LHS = lookup(WO->getLHS(), Val), RHS = lookup(WO->getRHS(), Val);
+      if (LHS.isBottom() || RHS.isBottom()) {
+        return Interval();
+      }
+      return LHS.Range->binaryOp(WO->getBinaryOp(), *RHS.Range);
+    }
+  }
+  if (isa<SelectInst>(Inst) && Operands.size() == 3) {
+    if (const APInt *const Cond = Operands[0].getSingleElement()) {
+      return Cond->getBoolValue() ? Operands[1] : Operands[2];
+    }
+    return Operands[1].unionWith(Operands[2], ConstantRange::Signed);
+  }
+  return ConstantRange::getFull(BitWidth);
+}
+
+bool ValueRangeImpl::transferFunc(const Instruction &Inst,
+                                  const DomainVal_t &IV, DomainVal_t &OV) {
+  DomainVal_t TEMP_OV = IV;
+
+  auto IdxIt = DomainIdxMap.find(&Inst);
+  if (IdxIt != DomainIdxMap.end()) {
+    TEMP_OV[IdxIt->second] = evaluate(Inst, IV);
+  }
+
+  bool isChanged = TEMP_OV != OV;
+  OV = TEMP_OV;
+  return isChanged;
+}
+
+char ValueRangeWrapperPass::ID = 0;
+static RegisterPass<ValueRangeWrapperPass> X("value-range", "Value Range");
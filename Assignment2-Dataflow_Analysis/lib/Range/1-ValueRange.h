@@ -0,0 +1,155 @@
+#pragma once // NOLINT(llvm-header-guard)
+
+/**
+ * @file Value Range Dataflow Analysis
+ */
+#include <llvm/ADT/DenseMap.h>
+#include <llvm/IR/Constants.h>
+#include <llvm/IR/InstrTypes.h>
+#include <llvm/IR/Instructions.h>
+#include <llvm/IR/IntrinsicInst.h>
+#include <llvm/IR/Operator.h>
+#include <llvm/Pass.h>
+
+#include <memory>
+
+#include <dfa/Framework.h>
+#include <dfa/MeetOp.h>
+
+#include "../Interval.h"
+#include "../Variable.h"
+
+using namespace dfa;
+
+class ValueRangeWrapperPass;
+
+using ValueRangeFrameworkBase =
+    Framework<Variable, Interval, Direction::kForward, IntervalHull>;
+
+/**
+ * @brief Integer value range analysis.
+ *
+ * Tracks, ∀ integer-typed instruction and argument, the interval of values it
+ * may hold at each program point. Intervals are refined along the edges of
+ * conditional branches, and φ-nodes are evaluated on the incoming edges so
+ * that they are subject to widening at the loop headers.
+ */
+class ValueRangeImpl : public ValueRangeFrameworkBase {
+private:
+  // Variable-Domain Index Mapping
+  DenseMap<const Value *, unsigned> DomainIdxMap;
+
+  void addToDomain(const Value *const V) {
+    if (!V->getType()->isIntegerTy() || DomainIdxMap.count(V)) {
+      return;
+    }
+    DomainIdxMap[V] = Domain.size();
+    Domain.emplace_back(V);
+  }
+
+  virtual void initializeDomainFromInst(const Instruction &Inst) override {
+    for (const Use &Operand : Inst.operands()) {
+      if (isa<Argument>(Operand.get())) {
+        addToDomain(Operand.get());
+      }
+    }
+    addToDomain(&Inst);
+  }
+
+  /**
+   * @brief Boundary Condition: Arguments may hold any value, everything else
+   *        has not been defined yet.
+   */
+  virtual DomainVal_t bc() const override {
+    DomainVal_t BC(Domain.size());
+    for (size_t Idx = 0; Idx < Domain.size(); ++Idx) {
+      if (isa<Argument>(Domain[Idx].V)) {
+        BC[Idx] = ConstantRange::getFull(
+            Domain[Idx].V->getType()->getIntegerBitWidth());
+      }
+    }
+    return BC;
+  }
+
+  /**
+   * @brief Restrict the values in @c Val to those that can flow along the
+   *        edge @c Pred → @c BB .
+   * @return false if the edge can never be taken, true otherwise
+   */
+  bool refineOnEdge(const BasicBlock &Pred, const BasicBlock &BB,
+                    DomainVal_t &Val) const;
+  /**
+   * @brief Evaluate the φ-nodes of @c BB on the edge @c Pred → @c BB .
+   */
+  void evaluatePHIsOnEdge(const BasicBlock &Pred, const BasicBlock &BB,
+                          DomainVal_t &Val) const;
+
+  virtual DomainVal_t getBoundaryVal(const BasicBlock &BB) const override;
+
+  /**
+   * @brief Evaluate the interval of @c Inst given its operands' intervals.
+   */
+  Interval evaluate(const Instruction &Inst, const DomainVal_t &Val) const;
+
+  virtual bool transferFunc(const Instruction &Inst, const DomainVal_t &IV,
+                            DomainVal_t &OV) override;
+
+  /**
+   * @brief Return the interval of @c V given the domain value @c Val .
+   */
+  Interval lookup(const Value *const V, const DomainVal_t &Val) const {
+    if (const ConstantInt *const CI = dyn_cast<ConstantInt>(V)) {
+      return ConstantRange(CI->getValue());
+    }
+    auto IdxIt = DomainIdxMap.find(V);
+    if (IdxIt != DomainIdxMap.end()) {
+      return Val[IdxIt->second];
+    }
+    return ConstantRange::getFull(V->getType()->getIntegerBitWidth());
+  }
+
+public:
+  /**
+   * @brief Return the interval of @c V right before @c At is executed.
+   */
+  Interval getRangeAt(const Value &V, const Instruction &At) const {
+    if (!V.getType()->isIntegerTy()) {
+      return Interval();
+    }
+    const Instruction *const Prev = At.getPrevNode();
+    return lookup(&V, Prev ? InstDomainValMap.at(Prev)
+                           : getBoundaryVal(*At.getParent()));
+  }
+
+private:
+  friend class ValueRangeWrapperPass;
+};
+
+class ValueRangeWrapperPass : public FunctionPass {
+private:
+  std::unique_ptr<ValueRangeImpl> ValueRange;
+
+public:
+  static char ID;
+
+  ValueRangeWrapperPass() : FunctionPass(ID) {}
+
+  virtual void getAnalysisUsage(AnalysisUsage &AU) const override {
+    AU.setPreservesAll();
+  }
+
+  bool runOnFunction(Function &F) override {
+    errs() << "* Value Range *"
+           << "\n";
+    ValueRange = std::make_unique<ValueRangeImpl>();
+    return ValueRange->runOnFunction(F);
+  }
+
+  /**
+   * @brief Return the interval of @c V right before @c At is executed. A
+   *        bottom interval means that @c At is unreachable.
+   */
+  Interval getRangeAt(const Value &V, const Instruction &At) const {
+    return ValueRange->getRangeAt(V, At);
+  }
+};
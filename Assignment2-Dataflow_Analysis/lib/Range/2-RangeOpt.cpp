@@ -0,0 +1,218 @@
+/**
+ * @file Range-based Optimizations
+ */
+#include <llvm/IR/IRBuilder.h>
+#include <llvm/IR/IntrinsicInst.h>
+#include <llvm/Transforms/Utils/Local.h>
+
+#include "1-ValueRange.h"
+
+namespace {
+
+/**
+ * @brief Use the results of the value range analysis to
+ *
+ *        1. fold comparisons that are always true or false, and with them the
+ *           branches (e.g., redundant bounds checks in loops) they guard,
+ *        2. lower signed division and remainder by a power of two to shifts
+ *           and masks when the dividend is proven non-negative, and
+ *        3. drop overflow checks (@c llvm.*.with.overflow ) that can never
+ *           fire.
+ */
+class RangeOpt final : public FunctionPass {
+private:
+  unsigned NumFoldedCmps = 0, NumFoldedBranches = 0, NumNarrowedDivs = 0,
+           NumOverflowChecks = 0;
+
+  /**
+   * @brief Whether the comparison @c Cmp is known to be always true (1) or
+   *        always false (0) at its program point.
+   */
+  static Optional<bool> evaluateCmp(const ICmpInst &Cmp,
+                                    const ValueRangeWrapperPass &VR) {
+    Interval LHS = VR.getRangeAt(*Cmp.getOperand(0), Cmp),
+             RHS = VR.getRangeAt(*Cmp.getOperand(1), Cmp);
+    if (LHS.isBottom() || RHS.isBottom()) {
+      return None;
+    }
+    if (LHS.Range->icmp(Cmp.getPredicate(), *RHS.Range)) {
+      return true;
+    }
+    if (LHS.Range->icmp(Cmp.getInversePredicate(), *RHS.Range)) {
+      return false;
+    }
+    return None;
+  }
+
+  /**
+   * @brief Whether @c BinaryOp is a signed division or remainder by a power of
+   *        two whose dividend is non-negative.
+   */
+  static bool isNarrowableDiv(const BinaryOperator &BinaryOp,
+                              const ValueRangeWrapperPass &VR) {
+    if (BinaryOp.getOpcode() != Instruction::SDiv &&
+        BinaryOp.getOpcode() != Instruction::SRem) {
+      return false;
+    }
+    const ConstantInt *const Divisor =
+        dyn_cast<ConstantInt>(BinaryOp.getOperand(1));
+    if (!Divisor || !Divisor->getValue().isPowerOf2() ||
+        Divisor->isNegative()) {
+      return false;
+    }
+    Interval Dividend = VR.getRangeAt(*BinaryOp.getOperand(0), BinaryOp);
+    return !Dividend.isBottom() &&
+           Dividend.Range->getSignedMin().isNonNegative();
+  }
+
+  /**
+   * @brief Whether the arithmetic checked by @c WO never overflows.
+   */
+  static bool neverOverflows(const WithOverflowInst &WO,
+                             const ValueRangeWrapperPass &VR) {
+    Interval LHS = VR.getRangeAt(*WO.getLHS(), WO),
+             RHS = VR.getRangeAt(*WO.getRHS(), WO);
+    if (LHS.isBottom() || RHS.isBottom()) {
+      return false;
+    }
+    const ConstantRange &L = *LHS.Range, &R = *RHS.Range;
+    const unsigned BitWidth = L.getBitWidth();
+    switch (WO.getBinaryOp()) {
+    case Instruction::Add:
+      return (WO.isSigned() ? L.signedAddMayOverflow(R)
+                            : L.unsignedAddMayOverflow(R)) ==
+             ConstantRange::OverflowResult::NeverOverflows;
+    case Instruction::Sub:
+      return (WO.isSigned() ? L.signedSubMayOverflow(R)
+                            : L.unsignedSubMayOverflow(R)) ==
+             ConstantRange::OverflowResult::NeverOverflows;
+    case Instruction::Mul: {
+      if (!WO.isSigned()) {
+        return L.unsignedMulMayOverflow(R) ==
+               ConstantRange::OverflowResult::NeverOverflows;
+      }
+      // Evaluate the product in twice the width and check that it fits.
+      ConstantRange Product = L.signExtend(2 * BitWidth)
+                                  .multiply(R.signExtend(2 * BitWidth));
+      return ConstantRange::getFull(BitWidth)
+          .signExtend(2 * BitWidth)
+          .contains(Product);
+    }
+    default:
+      return false;
+    }
+  }
+
+  void narrowDiv(BinaryOperator &BinaryOp) {
+    const APInt &Divisor = cast<ConstantInt>(BinaryOp.getOperand(1))->getValue();
+    IRBuilder<> Builder(&BinaryOp);
+    Value *Narrowed =
+        BinaryOp.getOpcode() == Instruction::SDiv
+            ? Builder.CreateLShr(BinaryOp.getOperand(0), Divisor.logBase2())
+            : Builder.CreateAnd(BinaryOp.getOperand(0), Divisor - 1);
+    Narrowed->takeName(&BinaryOp);
+    BinaryOp.replaceAllUsesWith(Narrowed);
+    BinaryOp.eraseFromParent();
+    ++NumNarrowedDivs;
+  }
+
+  void removeOverflowCheck(WithOverflowInst &WO) {
+    SmallVector<ExtractValueInst *, 2> Extracts;
+    for (User *const U : WO.users()) {
+      ExtractValueInst *const Extract = dyn_cast<ExtractValueInst>(U);
+      if (!Extract || Extract->getNumIndices() != 1) {
+        return;
+      }
+      Extracts.push_back(Extract);
+    }
+    IRBuilder<> Builder(&WO);
+    Value *const Result =
+        Builder.CreateBinOp(WO.getBinaryOp(), WO.getLHS(), WO.getRHS());
+    Result->takeName(&WO);
+    if (BinaryOperator *const BinaryOp = dyn_cast<BinaryOperator>(Result)) {
+      if (WO.isSigned()) {
+        BinaryOp->setHasNoSignedWrap();
+      } else {
+        BinaryOp->setHasNoUnsignedWrap();
+      }
+    }
+    for (ExtractValueInst *const Extract : Extracts) {
+      Extract->replaceAllUsesWith(*Extract->idx_begin() == 0
+                                      ? Result
+                                      : Builder.getFalse());
+      Extract->eraseFromParent();
+    }
+    WO.eraseFromParent();
+    ++NumOverflowChecks;
+  }
+
+public:
+  static char ID;
+
+  RangeOpt() : FunctionPass(ID) {}
+
+  virtual void getAnalysisUsage(AnalysisUsage &AU) const override {
+    AU.addRequired<ValueRangeWrapperPass>();
+  }
+
+  virtual bool runOnFunction(Function &F) override {
+    const ValueRangeWrapperPass &VR = getAnalysis<ValueRangeWrapperPass>();
+    NumFoldedCmps = NumFoldedBranches = NumNarrowedDivs = NumOverflowChecks = 0;
+
+    // The analysis results are keyed by the instructions of F, hence all the
+    // queries are made before any instruction is touched.
+    std::vector<std::pair<ICmpInst *, bool>> FoldableCmps;
+    std::vector<BinaryOperator *> NarrowableDivs;
+    std::vector<WithOverflowInst *> RedundantOverflowChecks;
+    for (Instruction &I : instructions(F)) {
+      if (ICmpInst *const Cmp = dyn_cast<ICmpInst>(&I)) {
+        if (Optional<bool> Outcome = evaluateCmp(*Cmp, VR)) {
+          FoldableCmps.emplace_back(Cmp, *Outcome);
+        }
+      } else if (BinaryOperator *const BinaryOp =
+                     dyn_cast<BinaryOperator>(&I)) {
+        if (isNarrowableDiv(*BinaryOp, VR)) {
+          NarrowableDivs.push_back(BinaryOp);
+        }
+      } else if (WithOverflowInst *const WO = dyn_cast<WithOverflowInst>(&I)) {
+        if (neverOverflows(*WO, VR)) {
+          RedundantOverflowChecks.push_back(WO);
+        }
+      }
+    }
+
+    for (auto &CmpOutcomePair : FoldableCmps) {
+      ICmpInst *const Cmp = CmpOutcomePair.first;
+      Cmp->replaceAllUsesWith(
+          ConstantInt::getBool(Cmp->getType(), CmpOutcomePair.second));
+      Cmp->eraseFromParent();
+      ++NumFoldedCmps;
+    }
+    for (BinaryOperator *const BinaryOp : NarrowableDivs) {
+      narrowDiv(*BinaryOp);
+    }
+    for (WithOverflowInst *const WO : RedundantOverflowChecks) {
+      removeOverflowCheck(*WO);
+    }
+    // Remove the branches that have become unconditional.
+    for (BasicBlock &BB : F) {
+      if (ConstantFoldTerminator(&BB, /*DeleteDeadConditions=*/true)) {
+        ++NumFoldedBranches;
+      }
+    }
+    bool Changed = NumFoldedCmps || NumNarrowedDivs || NumOverflowChecks ||
+                   NumFoldedBranches;
+    Changed |= removeUnreachableBlocks(F);
+
+    errs() << "Folded Comparisons: " << NumFoldedCmps << "\n"
+           << "Folded Branches: " << NumFoldedBranches << "\n"
+           << "Narrowed Divisions: " << NumNarrowedDivs << "\n"
+           << "Removed Overflow Checks: " << NumOverflowChecks << "\n";
+    return Changed;
+  }
+};
+
+char RangeOpt::ID = 0;
+RegisterPass<RangeOpt> X("range-opt", "Range-based Optimizations");
+
+} // anonymous namespace
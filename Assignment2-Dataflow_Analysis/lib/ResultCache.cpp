@@ -0,0 +1,77 @@
+/**
+ * @file Persistent Cache of the Dataflow Results
+ */
+#include <llvm/ADT/StringExtras.h>
+#include <llvm/Support/CommandLine.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/Path.h>
+#include <llvm/Support/raw_ostream.h>
+#include <llvm/Support/raw_sha1_ostream.h>
+
+#include <dfa/ResultCache.h>
+
+using namespace dfa;
+using namespace llvm;
+
+static cl::opt<std::string>
+    CacheDir("dfa-cache-dir",
+             cl::desc("Directory of the persistent cache of the dataflow "
+                      "results (disabled if empty)"),
+             cl::value_desc("directory"), cl::init(""));
+
+const ResultCache *ResultCache::get() {
+  if (CacheDir.empty()) {
+    return nullptr;
+  }
+  static const ResultCache Cache(CacheDir);
+  return &Cache;
+}
+
+std::string ResultCache::getKey(StringRef AnalysisID,
+                                const Function &F) const {
+  raw_sha1_ostream Hasher;
+  F.print(Hasher);
+  SmallString<128> Path(Dir);
+  sys::path::append(Path, AnalysisID + "-" + toHex(Hasher.sha1(), true));
+  return std::string(Path.str());
+}
+
+std::unique_ptr<MemoryBuffer> ResultCache::lookup(StringRef Key) const {
+  Expected<sys::fs::file_t> FD = sys::fs::openNativeFileForRead(Key);
+  if (!FD) {
+    consumeError(FD.takeError());
+    return nullptr;
+  }
+  std::unique_ptr<MemoryBuffer> Entry;
+  sys::fs::file_status Status;
+  if (!sys::fs::status(*FD, Status)) {
+    ErrorOr<std::unique_ptr<MemoryBuffer>> Buffer = MemoryBuffer::getOpenFile(
+        *FD, Key, Status.getSize(), /*RequiresNullTerminator=*/false);
+    if (Buffer) {
+      Entry = std::move(*Buffer);
+    }
+  }
+  sys::fs::closeFile(*FD);
+  return Entry;
+}
+
+void ResultCache::insert(StringRef Key, StringRef Data) const {
+  if (sys::fs::create_directories(Dir)) {
+    return;
+  }
+  int FD;
+  SmallString<128> TempPath;
+  if (sys::fs::createUniqueFile(Key + "-%%%%%%.tmp", FD, TempPath)) {
+    return;
+  }
+  {
+    raw_fd_ostream Outs(FD, /*shouldClose=*/true);
+    Outs << Data;
+    Outs.close();
+    if (!Outs.has_error() && !sys::fs::rename(TempPath, Key)) {
+      return;
+    }
+    Outs.clear_error();
+  }
+  sys::fs::remove(TempPath);
+}
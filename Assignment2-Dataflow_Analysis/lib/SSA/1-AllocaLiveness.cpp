@@ -0,0 +1,53 @@
+#include "1-AllocaLiveness.h"
+
+#include <llvm/IR/CFG.h>
+
+void AllocaLivenessImpl::computeLiveInBlocks(const AllocaInst &AI) {
+  /*
+   * A store kills the slot and a load generates it. As the slot is
+   * promotable, these are its only two kinds of users, and the blocks that
+   * store to it end the walk unless they load from it first.
+   */
+  SmallPtrSet<const BasicBlock *, 32> DefBlocks, UseBlocks;
+  for (const User *const U : AI.users()) {
+    if (isa<StoreInst>(U)) {
+      DefBlocks.insert(cast<Instruction>(U)->getParent());
+    } else {
+      UseBlocks.insert(cast<Instruction>(U)->getParent());
+    }
+  }
+  SmallVector<const BasicBlock *, 32> Worklist;
+  for (const BasicBlock *const BB : UseBlocks) {
+    if (!DefBlocks.count(BB) || isUpwardExposed(AI, *BB)) {
+      Worklist.push_back(BB);
+    }
+  }
+
+  SmallPtrSet<const BasicBlock *, 32> &LiveInBlocks = LiveInBlocksMap[&AI];
+  while (!Worklist.empty()) {
+    const BasicBlock *const BB = Worklist.pop_back_val();
+    if (!LiveInBlocks.insert(BB).second) {
+      continue;
+    }
+    for (const BasicBlock *const Pred : predecessors(BB)) {
+      if (!DefBlocks.count(Pred) && !LiveInBlocks.count(Pred)) {
+        Worklist.push_back(Pred);
+      }
+    }
+  }
+}
+
+void AllocaLivenessImpl::runOnFunction(const Function &F) {
+  // The static allocas are all in the entry block.
+  for (const Instruction &Inst : F.getEntryBlock()) {
+    const AllocaInst *const AI = dyn_cast<AllocaInst>(&Inst);
+    if (AI && isPromotableAlloca(*AI)) {
+      Allocas.push_back(AI);
+      computeLiveInBlocks(*AI);
+    }
+  }
+}
+
+char AllocaLivenessWrapperPass::ID = 0;
+static RegisterPass<AllocaLivenessWrapperPass> X("alloca-liveness",
+                                                 "Alloca Liveness");
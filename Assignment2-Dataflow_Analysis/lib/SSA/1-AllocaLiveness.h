@@ -0,0 +1,121 @@
+#pragma once // NOLINT(llvm-header-guard)
+
+/**
+ * @file Alloca Liveness Analysis
+ */
+#include <llvm/ADT/DenseMap.h>
+#include <llvm/ADT/SmallPtrSet.h>
+#include <llvm/IR/Instructions.h>
+#include <llvm/Pass.h>
+
+#include <memory>
+#include <vector>
+
+using namespace llvm;
+
+/**
+ * @brief Whether the stack slot @c AI can be promoted to SSA values, i.e., it
+ *        is a static scalar whose address is only ever used to load from and
+ *        store to it.
+ */
+inline bool isPromotableAlloca(const AllocaInst &AI) {
+  if (!AI.isStaticAlloca() || AI.isArrayAllocation()) {
+    return false;
+  }
+  for (const User *const U : AI.users()) {
+    if (const LoadInst *const Load = dyn_cast<LoadInst>(U)) {
+      if (Load->isVolatile() || Load->getType() != AI.getAllocatedType()) {
+        return false;
+      }
+    } else if (const StoreInst *const Store = dyn_cast<StoreInst>(U)) {
+      if (Store->isVolatile() || Store->getValueOperand() == &AI ||
+          Store->getValueOperand()->getType() != AI.getAllocatedType()) {
+        return false;
+      }
+    } else {
+      return false;
+    }
+  }
+  return true;
+}
+
+/**
+ * @brief Liveness of the promotable stack slots.
+ *
+ * A stack slot is live at a program point if its current content may be
+ * loaded before it gets overwritten, i.e., loads generate and stores kill.
+ * Rather than solving this for all the slots at once over every block, the
+ * live-in blocks of each slot are found by walking backwards from the blocks
+ * that load it before storing to it, up to those that store to it, so that the
+ * cost is linear in the blocks that the slot is live in.
+ */
+class AllocaLivenessImpl {
+private:
+  std::vector<const AllocaInst *> Allocas;
+  // Alloca-Live-In Blocks Mapping
+  DenseMap<const AllocaInst *, SmallPtrSet<const BasicBlock *, 32>>
+      LiveInBlocksMap;
+
+  /**
+   * @brief Return whether @c BB loads from @c AI before storing to it.
+   */
+  static bool isUpwardExposed(const AllocaInst &AI, const BasicBlock &BB) {
+    for (const Instruction &Inst : BB) {
+      if (const LoadInst *const Load = dyn_cast<LoadInst>(&Inst)) {
+        if (Load->getPointerOperand() == &AI) {
+          return true;
+        }
+      } else if (const StoreInst *const Store = dyn_cast<StoreInst>(&Inst)) {
+        if (Store->getPointerOperand() == &AI) {
+          return false;
+        }
+      }
+    }
+    return false;
+  }
+  void computeLiveInBlocks(const AllocaInst &AI);
+
+public:
+  void runOnFunction(const Function &F);
+
+  /**
+   * @brief Return the promotable stack slots of the function.
+   */
+  const std::vector<const AllocaInst *> &getAllocas() const {
+    return Allocas;
+  }
+  /**
+   * @brief Whether the stack slot @c AI is live on entry to @c BB .
+   */
+  bool isLiveIn(const AllocaInst &AI, const BasicBlock &BB) const {
+    auto LiveInIt = LiveInBlocksMap.find(&AI);
+    return LiveInIt != LiveInBlocksMap.end() && LiveInIt->second.count(&BB);
+  }
+};
+
+class AllocaLivenessWrapperPass : public FunctionPass {
+private:
+  std::unique_ptr<AllocaLivenessImpl> AllocaLiveness;
+
+public:
+  static char ID;
+
+  AllocaLivenessWrapperPass() : FunctionPass(ID) {}
+
+  virtual void getAnalysisUsage(AnalysisUsage &AU) const override {
+    AU.setPreservesAll();
+  }
+
+  bool runOnFunction(Function &F) override {
+    AllocaLiveness = std::make_unique<AllocaLivenessImpl>();
+    AllocaLiveness->runOnFunction(F);
+    return false;
+  }
+
+  const std::vector<const AllocaInst *> &getAllocas() const {
+    return AllocaLiveness->getAllocas();
+  }
+  bool isLiveIn(const AllocaInst &AI, const BasicBlock &BB) const {
+    return AllocaLiveness->isLiveIn(AI, BB);
+  }
+};
@@ -0,0 +1,245 @@
+/**
+ * @file SSA Construction
+ */
+#include <llvm/ADT/DenseMap.h>
+#include <llvm/ADT/SmallPtrSet.h>
+#include <llvm/IR/Constants.h>
+#include <llvm/IR/Dominators.h>
+
+#include "1-AllocaLiveness.h"
+
+namespace {
+
+/**
+ * @brief Promote the stack slots to SSA values (Cytron et al.).
+ *
+ * φ-nodes are placed on the iterated dominance frontiers of the blocks that
+ * store to a slot, and only where the slot is live (pruned SSA). The loads and
+ * stores are then renamed by a walk over the dominator tree.
+ */
+class SSAConstruct final : public FunctionPass {
+private:
+  using DomFrontiers_t =
+      DenseMap<const BasicBlock *, SmallPtrSet<BasicBlock *, 4>>;
+
+  unsigned NumPromotedAllocas = 0, NumInsertedPHIs = 0;
+
+  /**
+   * @brief Compute the dominance frontier of every block (Cooper, Harvey and
+   *        Kennedy): A join block belongs to the frontier of every block on
+   *        the dominator tree path from each of its predecessors up to (but
+   *        excluding) its immediate dominator.
+   */
+  static DomFrontiers_t computeDomFrontiers(Function &F,
+                                            const DominatorTree &DT) {
+    DomFrontiers_t DomFrontiers;
+    for (BasicBlock &BB : F) {
+      if (!DT.isReachableFromEntry(&BB) || !BB.hasNPredecessorsOrMore(2)) {
+        continue;
+      }
+      const BasicBlock *const IDom = DT.getNode(&BB)->getIDom()->getBlock();
+      for (BasicBlock *const Pred : predecessors(&BB)) {
+        if (!DT.isReachableFromEntry(Pred)) {
+          continue;
+        }
+        for (BasicBlock *Runner = Pred; Runner != IDom;
+             Runner = DT.getNode(Runner)->getIDom()->getBlock()) {
+          DomFrontiers[Runner].insert(&BB);
+        }
+      }
+    }
+    return DomFrontiers;
+  }
+
+  /**
+   * @brief Place the φ-nodes for @c AI on the iterated dominance frontier of
+   *        its definitions, pruned by its liveness.
+   */
+  void placePHIs(AllocaInst &AI, const unsigned AllocaIdx,
+                 const DomFrontiers_t &DomFrontiers,
+                 const AllocaLivenessWrapperPass &Liveness,
+                 DenseMap<PHINode *, unsigned> &PHIAllocaMap) {
+    SmallPtrSet<BasicBlock *, 32> DefBlocks, HasPHI;
+    for (User *const U : AI.users()) {
+      if (StoreInst *const Store = dyn_cast<StoreInst>(U)) {
+        DefBlocks.insert(Store->getParent());
+      }
+    }
+    SmallVector<BasicBlock *, 32> Worklist(DefBlocks.begin(), DefBlocks.end());
+    while (!Worklist.empty()) {
+      BasicBlock *const X = Worklist.pop_back_val();
+      auto DFIt = DomFrontiers.find(X);
+      if (DFIt == DomFrontiers.end()) {
+        continue;
+      }
+      for (BasicBlock *const Y : DFIt->second) {
+        // A slot that is dead on entry needs no φ-node, and without the
+        // φ-node Y does not become a new definition either.
+        if (!Liveness.isLiveIn(AI, *Y) || !HasPHI.insert(Y).second) {
+          continue;
+        }
+        PHINode *const PHI =
+            PHINode::Create(AI.getAllocatedType(), pred_size(Y), AI.getName(),
+                            &Y->front());
+        PHIAllocaMap[PHI] = AllocaIdx;
+        ++NumInsertedPHIs;
+        if (DefBlocks.insert(Y).second) {
+          Worklist.push_back(Y);
+        }
+      }
+    }
+  }
+
+  /**
+   * @brief Rename the loads and stores of the promoted slots in a preorder
+   *        walk over the dominator tree, keeping one stack of reaching
+   *        definitions per slot.
+   */
+  void rename(const DominatorTree &DT, const std::vector<AllocaInst *> &Allocas,
+              const DenseMap<AllocaInst *, unsigned> &AllocaIdxMap,
+              const DenseMap<PHINode *, unsigned> &PHIAllocaMap) {
+    std::vector<std::vector<Value *>> DefStacks(Allocas.size());
+    auto getReachingDef = [&](const unsigned AllocaIdx) -> Value * {
+      if (DefStacks[AllocaIdx].empty()) {
+        return UndefValue::get(Allocas[AllocaIdx]->getAllocatedType());
+      }
+      return DefStacks[AllocaIdx].back();
+    };
+    // Slots pushed in the blocks on the current path, so that they can be
+    // popped when leaving the subtree. The walk is iterative as dominator
+    // trees of large functions get very deep.
+    std::vector<unsigned> PushedAllocas;
+    std::vector<std::pair<const DomTreeNode *, size_t>> Worklist;
+    Worklist.emplace_back(DT.getRootNode(), 0);
+    while (!Worklist.empty()) {
+      const DomTreeNode *const Node = Worklist.back().first;
+      const size_t NumPushed = Worklist.back().second;
+      Worklist.pop_back();
+      if (!Node) {
+        while (PushedAllocas.size() > NumPushed) {
+          DefStacks[PushedAllocas.back()].pop_back();
+          PushedAllocas.pop_back();
+        }
+        continue;
+      }
+      // exit marker of the subtree
+      Worklist.emplace_back(nullptr, PushedAllocas.size());
+
+      BasicBlock *const BB = Node->getBlock();
+      for (auto InstIt = BB->begin(); InstIt != BB->end();) {
+        Instruction &Inst = *(InstIt++);
+        if (PHINode *const PHI = dyn_cast<PHINode>(&Inst)) {
+          auto IdxIt = PHIAllocaMap.find(PHI);
+          if (IdxIt != PHIAllocaMap.end()) {
+            DefStacks[IdxIt->second].push_back(PHI);
+            PushedAllocas.push_back(IdxIt->second);
+          }
+        } else if (LoadInst *const Load = dyn_cast<LoadInst>(&Inst)) {
+          auto IdxIt = AllocaIdxMap.find(
+              dyn_cast<AllocaInst>(Load->getPointerOperand()));
+          if (IdxIt != AllocaIdxMap.end()) {
+            Load->replaceAllUsesWith(getReachingDef(IdxIt->second));
+            Load->eraseFromParent();
+          }
+        } else if (StoreInst *const Store = dyn_cast<StoreInst>(&Inst)) {
+          auto IdxIt = AllocaIdxMap.find(
+              dyn_cast<AllocaInst>(Store->getPointerOperand()));
+          if (IdxIt != AllocaIdxMap.end()) {
+            DefStacks[IdxIt->second].push_back(Store->getValueOperand());
+            PushedAllocas.push_back(IdxIt->second);
+            Store->eraseFromParent();
+          }
+        }
+      }
+      // One incoming value per edge, hence successors are not uniqued.
+      for (BasicBlock *const Succ : successors(BB)) {
+        for (PHINode &PHI : Succ->phis()) {
+          auto IdxIt = PHIAllocaMap.find(&PHI);
+          if (IdxIt != PHIAllocaMap.end()) {
+            PHI.addIncoming(getReachingDef(IdxIt->second), BB);
+          }
+        }
+      }
+      for (const DomTreeNode *const Child : Node->children()) {
+        Worklist.emplace_back(Child, 0);
+      }
+    }
+  }
+
+  /**
+   * @brief Clean up what is left in the unreachable blocks, which the
+   *        dominator tree walk does not visit.
+   */
+  static void cleanupUnreachable(const DominatorTree &DT,
+                                 const std::vector<AllocaInst *> &Allocas,
+                                 const DenseMap<PHINode *, unsigned> &PHIs) {
+    for (AllocaInst *const AI : Allocas) {
+      for (auto UserIt = AI->user_begin(); UserIt != AI->user_end();) {
+        Instruction *const Inst = cast<Instruction>(*(UserIt++));
+        if (LoadInst *const Load = dyn_cast<LoadInst>(Inst)) {
+          Load->replaceAllUsesWith(UndefValue::get(Load->getType()));
+        }
+        Inst->eraseFromParent();
+      }
+    }
+    for (const auto &PHIAllocaPair : PHIs) {
+      PHINode *const PHI = PHIAllocaPair.first;
+      for (BasicBlock *const Pred : predecessors(PHI->getParent())) {
+        if (!DT.isReachableFromEntry(Pred)) {
+          PHI->addIncoming(UndefValue::get(PHI->getType()), Pred);
+        }
+      }
+    }
+  }
+
+public:
+  static char ID;
+
+  SSAConstruct() : FunctionPass(ID) {}
+
+  virtual void getAnalysisUsage(AnalysisUsage &AU) const override {
+    AU.addRequired<DominatorTreeWrapperPass>();
+    AU.addRequired<AllocaLivenessWrapperPass>();
+    AU.setPreservesCFG();
+  }
+
+  virtual bool runOnFunction(Function &F) override {
+    const DominatorTree &DT =
+        getAnalysis<DominatorTreeWrapperPass>().getDomTree();
+    const AllocaLivenessWrapperPass &Liveness =
+        getAnalysis<AllocaLivenessWrapperPass>();
+    NumPromotedAllocas = NumInsertedPHIs = 0;
+
+    std::vector<AllocaInst *> Allocas;
+    DenseMap<AllocaInst *, unsigned> AllocaIdxMap;
+    for (const AllocaInst *const AI : Liveness.getAllocas()) {
+      AllocaIdxMap[const_cast<AllocaInst *>(AI)] = Allocas.size();
+      Allocas.push_back(const_cast<AllocaInst *>(AI));
+    }
+    if (Allocas.empty()) {
+      return false;
+    }
+
+    DomFrontiers_t DomFrontiers = computeDomFrontiers(F, DT);
+    DenseMap<PHINode *, unsigned> PHIAllocaMap;
+    for (unsigned AllocaIdx = 0; AllocaIdx < Allocas.size(); ++AllocaIdx) {
+      placePHIs(*Allocas[AllocaIdx], AllocaIdx, DomFrontiers, Liveness,
+                PHIAllocaMap);
+    }
+    rename(DT, Allocas, AllocaIdxMap, PHIAllocaMap);
+    cleanupUnreachable(DT, Allocas, PHIAllocaMap);
+    for (AllocaInst *const AI : Allocas) {
+      AI->eraseFromParent();
+      ++NumPromotedAllocas;
+    }
+
+    errs() << "Promoted Allocas: " << NumPromotedAllocas << "\n"
+           << "Inserted PHIs: " << NumInsertedPHIs << "\n";
+    return true;
+  }
+};
+
+char SSAConstruct::ID = 0;
+RegisterPass<SSAConstruct> X("ssa-construct", "SSA Construction");
+
+} // anonymous namespace
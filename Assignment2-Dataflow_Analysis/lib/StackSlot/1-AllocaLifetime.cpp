@@ -0,0 +1,161 @@
+#include "1-AllocaLifetime.h"
+
+#include <llvm/Analysis/CaptureTracking.h>
+#include <llvm/ADT/SmallPtrSet.h>
+#include <llvm/IR/InstIterator.h>
+
+AllocaAccesses::AllocaAccesses(const Function &F) {
+  const DataLayout &DL = F.getParent()->getDataLayout();
+  for (const Instruction &Inst : F.getEntryBlock()) {
+    const AllocaInst *const AI = dyn_cast<AllocaInst>(&Inst);
+    if (!AI || !AI->isStaticAlloca() ||
+        PointerMayBeCaptured(AI, /*ReturnCaptures=*/true,
+                             /*StoreCaptures=*/true)) {
+      continue;
+    }
+    const unsigned AllocaIdx = AllocaIdxMap[AI] = Allocas.size();
+    Allocas.push_back(AI);
+
+    // Visit the pointers derived from the slot, and record their users as
+    // accesses.
+    SmallVector<const Value *, 8> Worklist = {AI};
+    SmallPtrSet<const Value *, 8> Visited = {AI};
+    while (!Worklist.empty()) {
+      const Value *const Ptr = Worklist.pop_back_val();
+      for (const User *const U : Ptr->users()) {
+        const Instruction *const UserInst = cast<Instruction>(U);
+        if (isa<GetElementPtrInst>(UserInst) || isa<BitCastInst>(UserInst) ||
+            isa<AddrSpaceCastInst>(UserInst) || isa<PHINode>(UserInst) ||
+            isa<SelectInst>(UserInst)) {
+          if (Visited.insert(UserInst).second) {
+            Worklist.push_back(UserInst);
+          }
+          continue;
+        }
+        SmallVector<unsigned, 2> &AccessedAllocas = AccessMap[UserInst];
+        if (AccessedAllocas.empty() || AccessedAllocas.back() != AllocaIdx) {
+          AccessedAllocas.push_back(AllocaIdx);
+        }
+        const StoreInst *const Store = dyn_cast<StoreInst>(UserInst);
+        if (Store && Store->getPointerOperand()->stripPointerCasts() == AI &&
+            DL.getTypeStoreSize(Store->getValueOperand()->getType()) >=
+                getAllocaSize(*AI)) {
+          OverwriteMap[Store] = AllocaIdx;
+        }
+      }
+    }
+  }
+}
+
+SlotLivenessImpl::SlotLivenessImpl(const AllocaAccesses &Accesses)
+    : Accesses(Accesses) {
+  Verbose = false;
+  for (const AllocaInst *const AI : Accesses.Allocas) {
+    Domain.emplace_back(AI);
+  }
+}
+
+bool SlotLivenessImpl::transferFunc(const Instruction &Inst,
+                                    const DomainVal_t &IV, DomainVal_t &OV) {
+  DomainVal_t TEMP_OV = IV;
+
+  auto OverwriteIt = Accesses.OverwriteMap.find(&Inst);
+  if (OverwriteIt != Accesses.OverwriteMap.end()) {
+    TEMP_OV[OverwriteIt->second] = false;
+  } else {
+    auto AccessIt = Accesses.AccessMap.find(&Inst);
+    if (AccessIt != Accesses.AccessMap.end()) {
+      for (const unsigned AllocaIdx : AccessIt->second) {
+        TEMP_OV[AllocaIdx] = true;
+      }
+    }
+  }
+
+  bool isChanged = TEMP_OV != OV;
+  OV = TEMP_OV;
+  return isChanged;
+}
+
+SlotAccessedImpl::SlotAccessedImpl(const AllocaAccesses &Accesses)
+    : Accesses(Accesses) {
+  Verbose = false;
+  for (const AllocaInst *const AI : Accesses.Allocas) {
+    Domain.emplace_back(AI);
+  }
+}
+
+bool SlotAccessedImpl::transferFunc(const Instruction &Inst,
+                                    const DomainVal_t &IV, DomainVal_t &OV) {
+  DomainVal_t TEMP_OV = IV;
+
+  auto AccessIt = Accesses.AccessMap.find(&Inst);
+  if (AccessIt != Accesses.AccessMap.end()) {
+    for (const unsigned AllocaIdx : AccessIt->second) {
+      TEMP_OV[AllocaIdx] = true;
+    }
+  }
+
+  bool isChanged = TEMP_OV != OV;
+  OV = TEMP_OV;
+  return isChanged;
+}
+
+bool AllocaLifetimeWrapperPass::runOnFunction(Function &F) {
+  Accesses = std::make_unique<AllocaAccesses>(F);
+  const unsigned NumAllocas = Accesses->Allocas.size();
+  InterferenceGraph.assign(NumAllocas, BitVector(NumAllocas));
+  if (NumAllocas == 0) {
+    return false;
+  }
+  SlotLivenessImpl SlotLiveness(*Accesses);
+  SlotLiveness.runOnFunction(F);
+  SlotAccessedImpl SlotAccessed(*Accesses);
+  SlotAccessed.runOnFunction(F);
+
+  // As the accesses themselves count as uses, the slots that have been
+  // accessed once an instruction has executed cover the ones that have been
+  // accessed before it, and only the former need to be tracked.
+  BitVector InUse(NumAllocas);
+  for (const Instruction &Inst : instructions(F)) {
+    const std::vector<bool> &Live = SlotLiveness.getLiveSlots(Inst),
+                            &Accessed = SlotAccessed.getAccessedSlots(Inst);
+    InUse.reset();
+    for (unsigned AllocaIdx = 0; AllocaIdx < NumAllocas; ++AllocaIdx) {
+      if (Live[AllocaIdx] && Accessed[AllocaIdx]) {
+        InUse.set(AllocaIdx);
+      }
+    }
+    auto AccessIt = Accesses->AccessMap.find(&Inst);
+    if (AccessIt != Accesses->AccessMap.end()) {
+      for (const unsigned AllocaIdx : AccessIt->second) {
+        InUse.set(AllocaIdx);
+      }
+    }
+    for (const unsigned AllocaIdx : InUse.set_bits()) {
+      InterferenceGraph[AllocaIdx] |= InUse;
+    }
+  }
+  return false;
+}
+
+void AllocaLifetimeWrapperPass::print(raw_ostream &Outs,
+                                      const Module *M) const {
+  for (unsigned A = 0; A < getAllocas().size(); ++A) {
+    getAllocas()[A]->printAsOperand(Outs, false);
+    Outs << ": {";
+    bool IsFirst = true;
+    for (const unsigned B : InterferenceGraph[A].set_bits()) {
+      if (B == A) {
+        continue;
+      }
+      Outs << (IsFirst ? " " : ", ");
+      IsFirst = false;
+      getAllocas()[B]->printAsOperand(Outs, false);
+    }
+    Outs << (IsFirst ? "}" : " }") << "\n";
+  }
+}
+
+char AllocaLifetimeWrapperPass::ID = 0;
+static RegisterPass<AllocaLifetimeWrapperPass>
+    X("alloca-lifetime", "Alloca Lifetime", false, true);
@@ -0,0 +1,147 @@
+#pragma once // NOLINT(llvm-header-guard)
+
+/**
+ * @file Alloca Lifetime Dataflow Analyses
+ */
+#include <llvm/ADT/BitVector.h>
+#include <llvm/ADT/DenseMap.h>
+#include <llvm/ADT/SmallVector.h>
+#include <llvm/IR/Constants.h>
+#include <llvm/IR/Instructions.h>
+#include <llvm/IR/Module.h>
+#include <llvm/Pass.h>
+
+#include <memory>
+#include <vector>
+
+#include <dfa/Framework.h>
+#include <dfa/MeetOp.h>
+
+#include "../Variable.h"
+
+using namespace dfa;
+
+/**
+ * @brief Return the size of the static alloca @c AI in bytes.
+ */
+inline uint64_t getAllocaSize(const AllocaInst &AI) {
+  const DataLayout &DL = AI.getModule()->getDataLayout();
+  return DL.getTypeAllocSize(AI.getAllocatedType()) *
+         cast<ConstantInt>(AI.getArraySize())->getZExtValue();
+}
+
+/**
+ * @brief The accesses to the stack slots whose lifetimes can be analyzed,
+ *        i.e., the static allocas whose addresses are never captured.
+ *
+ * An instruction accesses a slot if it uses the slot's address or a pointer
+ * derived from it (through GEPs, casts, φ-nodes and selects).
+ */
+struct AllocaAccesses {
+  std::vector<const AllocaInst *> Allocas;
+  DenseMap<const AllocaInst *, unsigned> AllocaIdxMap;
+  // Instruction-Accessed Slots Mapping
+  DenseMap<const Instruction *, SmallVector<unsigned, 2>> AccessMap;
+  // Instruction-Overwritten Slot Mapping, of the stores that overwrite a slot
+  // as a whole
+  DenseMap<const Instruction *, unsigned> OverwriteMap;
+
+  explicit AllocaAccesses(const Function &F);
+};
+
+using AllocaLivenessFrameworkBase =
+    Framework<Variable, bool, Direction::kBackward, Union>;
+using AllocaAccessedFrameworkBase =
+    Framework<Variable, bool, Direction::kForward, Union>;
+
+/**
+ * @brief Liveness of the contents of the stack slots: Every access but a
+ *        store that overwrites the whole slot generates, such stores kill.
+ */
+class SlotLivenessImpl : public AllocaLivenessFrameworkBase {
+private:
+  const AllocaAccesses &Accesses;
+
+  virtual void initializeDomainFromInst(const Instruction &Inst) override {}
+  virtual bool transferFunc(const Instruction &Inst, const DomainVal_t &IV,
+                            DomainVal_t &OV) override;
+
+public:
+  explicit SlotLivenessImpl(const AllocaAccesses &Accesses);
+
+  bool runOnFunction(const Function &F) {
+    return AllocaLivenessFrameworkBase::runOnFunction(F);
+  }
+  /**
+   * @brief Return the slots that are live right before @c Inst .
+   */
+  const DomainVal_t &getLiveSlots(const Instruction &Inst) const {
+    return InstDomainValMap.at(&Inst);
+  }
+};
+
+/**
+ * @brief Whether the stack slots may have been accessed, i.e., whether their
+ *        lifetimes may have begun.
+ */
+class SlotAccessedImpl : public AllocaAccessedFrameworkBase {
+private:
+  const AllocaAccesses &Accesses;
+
+  virtual void initializeDomainFromInst(const Instruction &Inst) override {}
+  virtual bool transferFunc(const Instruction &Inst, const DomainVal_t &IV,
+                            DomainVal_t &OV) override;
+
+public:
+  explicit SlotAccessedImpl(const AllocaAccesses &Accesses);
+
+  bool runOnFunction(const Function &F) {
+    return AllocaAccessedFrameworkBase::runOnFunction(F);
+  }
+  /**
+   * @brief Return the slots that may have been accessed once @c Inst has
+   *        executed.
+   */
+  const DomainVal_t &getAccessedSlots(const Instruction &Inst) const {
+    return InstDomainValMap.at(&Inst);
+  }
+};
+
+/**
+ * @brief Lifetimes of the stack slots and their interference graph.
+ *
+ * A slot is in use at an instruction if the instruction accesses it, or if
+ * the slot has been accessed before and its content is live. Two slots
+ * interfere if they are ever in use at the same instruction, as otherwise
+ * they can share the same memory.
+ */
+class AllocaLifetimeWrapperPass : public FunctionPass {
+private:
+  std::unique_ptr<AllocaAccesses> Accesses;
+  std::vector<BitVector> InterferenceGraph;
+
+public:
+  static char ID;
+
+  AllocaLifetimeWrapperPass() : FunctionPass(ID) {}
+
+  virtual void getAnalysisUsage(AnalysisUsage &AU) const override {
+    AU.setPreservesAll();
+  }
+
+  bool runOnFunction(Function &F) override;
+  virtual void print(raw_ostream &Outs, const Module *M) const override;
+
+  /**
+   * @brief Return the stack slots whose lifetimes are known.
+   */
+  const std::vector<const AllocaInst *> &getAllocas() const {
+    return Accesses->Allocas;
+  }
+  /**
+   * @brief Whether the @c A -th and the @c B -th slots interfere.
+   */
+  bool interfere(const unsigned A, const unsigned B) const {
+    return InterferenceGraph[A].test(B);
+  }
+};
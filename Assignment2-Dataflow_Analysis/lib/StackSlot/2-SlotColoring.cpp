@@ -0,0 +1,117 @@
+/**
+ * @file Stack Slot Coloring
+ */
+#include <llvm/IR/IRBuilder.h>
+#include <llvm/Support/Alignment.h>
+
+#include <algorithm>
+
+#include "1-AllocaLifetime.h"
+
+namespace {
+
+/**
+ * @brief Let the stack slots whose lifetimes never overlap share memory.
+ *
+ * The slots are colored greedily on their interference graph, the largest
+ * ones first, so that every shared slot is as large as its first member. The
+ * first member then takes the place of the others, with its alignment raised
+ * to the largest one among them.
+ */
+class SlotColoring final : public FunctionPass {
+private:
+  struct Slot {
+    AllocaInst *Leader;
+    SmallVector<unsigned, 4> Members;
+    uint64_t Size;
+    Align Alignment;
+  };
+
+  /**
+   * @brief Return the size of the stack frame of @c F , i.e., the sum of the
+   *        sizes of its static allocas, each padded to its alignment.
+   */
+  static uint64_t getFrameSize(const Function &F) {
+    uint64_t FrameSize = 0;
+    for (const Instruction &Inst : F.getEntryBlock()) {
+      const AllocaInst *const AI = dyn_cast<AllocaInst>(&Inst);
+      if (AI && AI->isStaticAlloca()) {
+        FrameSize = alignTo(FrameSize, AI->getAlign()) + getAllocaSize(*AI);
+      }
+    }
+    return FrameSize;
+  }
+
+public:
+  static char ID;
+
+  SlotColoring() : FunctionPass(ID) {}
+
+  virtual void getAnalysisUsage(AnalysisUsage &AU) const override {
+    AU.addRequired<AllocaLifetimeWrapperPass>();
+    AU.setPreservesCFG();
+  }
+
+  virtual bool runOnFunction(Function &F) override {
+    const AllocaLifetimeWrapperPass &Lifetime =
+        getAnalysis<AllocaLifetimeWrapperPass>();
+    const std::vector<const AllocaInst *> &Allocas = Lifetime.getAllocas();
+    const uint64_t FrameSizeBefore = getFrameSize(F);
+
+    std::vector<unsigned> Order(Allocas.size());
+    std::vector<uint64_t> Sizes(Allocas.size());
+    for (unsigned AllocaIdx = 0; AllocaIdx < Allocas.size(); ++AllocaIdx) {
+      Order[AllocaIdx] = AllocaIdx;
+      Sizes[AllocaIdx] = getAllocaSize(*Allocas[AllocaIdx]);
+    }
+    std::stable_sort(Order.begin(), Order.end(),
+                     [&Sizes](const unsigned A, const unsigned B) {
+                       return Sizes[A] > Sizes[B];
+                     });
+
+    std::vector<Slot> Slots;
+    for (const unsigned AllocaIdx : Order) {
+      AllocaInst *const AI = const_cast<AllocaInst *>(Allocas[AllocaIdx]);
+      auto SlotIt = find_if(Slots, [&](const Slot &S) {
+        return none_of(S.Members, [&](const unsigned Member) {
+          return Lifetime.interfere(AllocaIdx, Member);
+        });
+      });
+      if (SlotIt == Slots.end()) {
+        Slots.push_back({AI, {}, Sizes[AllocaIdx], AI->getAlign()});
+        SlotIt = std::prev(Slots.end());
+      }
+      SlotIt->Members.push_back(AllocaIdx);
+      SlotIt->Alignment = std::max(SlotIt->Alignment, AI->getAlign());
+    }
+
+    bool Changed = false;
+    for (Slot &S : Slots) {
+      S.Leader->setAlignment(S.Alignment);
+      for (const unsigned Member : drop_begin(S.Members, 1)) {
+        AllocaInst *const AI = const_cast<AllocaInst *>(Allocas[Member]);
+        // The leader has to dominate all the uses of its members.
+        if (AI->comesBefore(S.Leader)) {
+          S.Leader->moveBefore(AI);
+        }
+        IRBuilder<> Builder(AI);
+        Value *const Replacement =
+            Builder.CreateBitCast(S.Leader, AI->getType(), AI->getName());
+        AI->replaceAllUsesWith(Replacement);
+        AI->eraseFromParent();
+        Changed = true;
+      }
+    }
+
+    errs() << "Stack Slots (" << F.getName() << "): " << Allocas.size()
+           << " -> " << Slots.size() << "\n"
+           << "Frame Size (" << F.getName() << "): " << FrameSizeBefore
+           << " -> " << getFrameSize(F) << " bytes\n";
+    return Changed;
+  }
+};
+
+char SlotColoring::ID = 0;
+RegisterPass<SlotColoring> X("slot-coloring", "Stack Slot Coloring");
+
+} // anonymous namespace
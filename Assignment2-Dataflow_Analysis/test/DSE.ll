@@ -0,0 +1,105 @@
+; RUN: opt -S -load %dylibdir/libDFA.so -dead-store-elim \
+; RUN:     %s -o %basename_t 2>%basename_t.log
+; RUN: FileCheck --match-full-lines %s --input-file=%basename_t
+; RUN: FileCheck --match-full-lines %s --input-file=%basename_t.log \
+; RUN:     --check-prefix=STATS
+
+; int g;
+; void use(int *p);
+; int ext(void);
+;
+; int foo(int a, int c) {
+;   int x, t, u, w;
+;   x = 1;      // dead: overwritten on both paths
+;   t = a;      // dead once `u = t` is deleted
+;   u = t;      // dead: u is never read
+;   w = 0;      // live: read by use() through the escaped address of w
+;   g = a;      // dead: overwritten before it may be read
+;   if (c)
+;     x = a;
+;   else
+;     x = c;
+;   g = x;      // live: use() may read g
+;   use(&w);
+;   x = ext();  // dead: x is not read again
+;   return g;
+; }
+; STATS: Dead Stores (foo): 5
+@g = dso_local global i32 0, align 4
+
+define dso_local i32 @foo(i32 %0, i32 %1) {
+; CHECK-LABEL: define dso_local i32 @foo(i32 %0, i32 %1) {
+; CHECK-NEXT:    %3 = alloca i32, align 4
+; CHECK-NEXT:    %4 = alloca i32, align 4
+; CHECK-NEXT:    %5 = alloca i32, align 4
+; CHECK-NEXT:    %6 = alloca i32, align 4
+; CHECK-NEXT:    %7 = alloca i32, align 4
+; CHECK-NEXT:    %8 = alloca i32, align 4
+; CHECK-NEXT:    store i32 %0, i32* %3, align 4
+; CHECK-NEXT:    store i32 %1, i32* %4, align 4
+; CHECK-NEXT:    store i32 0, i32* %8, align 4
+; CHECK-NEXT:    %9 = load i32, i32* %4, align 4
+; CHECK-NEXT:    %10 = icmp ne i32 %9, 0
+; CHECK-NEXT:    br i1 %10, label %11, label %13
+; CHECK-EMPTY:
+; CHECK-NEXT:  11:                                               ; preds = %2
+; CHECK-NEXT:    %12 = load i32, i32* %3, align 4
+; CHECK-NEXT:    store i32 %12, i32* %5, align 4
+; CHECK-NEXT:    br label %15
+; CHECK-EMPTY:
+; CHECK-NEXT:  13:                                               ; preds = %2
+; CHECK-NEXT:    %14 = load i32, i32* %4, align 4
+; CHECK-NEXT:    store i32 %14, i32* %5, align 4
+; CHECK-NEXT:    br label %15
+; CHECK-EMPTY:
+; CHECK-NEXT:  15:                                               ; preds = %13, %11
+; CHECK-NEXT:    %16 = load i32, i32* %5, align 4
+; CHECK-NEXT:    store i32 %16, i32* @g, align 4
+; CHECK-NEXT:    call void @use(i32* %8)
+; CHECK-NEXT:    %17 = call i32 @ext()
+; CHECK-NEXT:    %18 = load i32, i32* @g, align 4
+; CHECK-NEXT:    ret i32 %18
+; CHECK-NEXT:  }
+  %3 = alloca i32, align 4
+  %4 = alloca i32, align 4
+  %5 = alloca i32, align 4
+  %6 = alloca i32, align 4
+  %7 = alloca i32, align 4
+  %8 = alloca i32, align 4
+  store i32 %0, i32* %3, align 4
+  store i32 %1, i32* %4, align 4
+  store i32 1, i32* %5, align 4
+  %9 = load i32, i32* %3, align 4
+  store i32 %9, i32* %6, align 4
+  %10 = load i32, i32* %6, align 4
+  store i32 %10, i32* %7, align 4
+  store i32 0, i32* %8, align 4
+  %11 = load i32, i32* %3, align 4
+  store i32 %11, i32* @g, align 4
+  %12 = load i32, i32* %4, align 4
+  %13 = icmp ne i32 %12, 0
+  br i1 %13, label %14, label %16
+
+14:                                               ; preds = %2
+  %15 = load i32, i32* %3, align 4
+  store i32 %15, i32* %5, align 4
+  br label %18
+
+16:                                               ; preds = %2
+  %17 = load i32, i32* %4, align 4
+  store i32 %17, i32* %5, align 4
+  br label %18
+
+18:                                               ; preds = %16, %14
+  %19 = load i32, i32* %5, align 4
+  store i32 %19, i32* @g, align 4
+  call void @use(i32* %8)
+  %20 = call i32 @ext()
+  store i32 %20, i32* %5, align 4
+  %21 = load i32, i32* @g, align 4
+  ret i32 %21
+}
+
+declare dso_local void @use(i32*)
+
+declare dso_local i32 @ext()
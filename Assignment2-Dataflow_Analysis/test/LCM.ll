@@ -26,6 +26,13 @@
 ;   return e;
 ; }
 ; ANTIEXPR-LABEL: * Anticipated Expression *
+; ANTIEXPR:       Expression 0:[icmp sgt %0, 5]
+; ANTIEXPR:       Expression 1:[add %1, %2]
+; ANTIEXPR:       Expression 2:[icmp slt %.0, 5]
+; ANTIEXPR:       Expression 3:[add %.0, 1]
+; ANTIEXPR:       Expression 4:[add %2, %11]
+; ANTIEXPR:       Expression 5:[add %2, %.1]
+; ANTIEXPR-NEXT:  Domain Size:6
 
 ; WBAVAILEXPR-LABEL: * Will-Be-Available Expression *
 
@@ -61,3 +68,32 @@ define i32 @foo(i32 %0, i32 %1, i32 %2) {
   %15 = add nsw i32 %.1, %2
   ret i32 %15
 }
+
+; Compares with swapped operands, identical casts and GEPs over identical
+; indices are the same expressions.
+; ANTIEXPR-LABEL: * Anticipated Expression *
+; ANTIEXPR:       Domain Inst:  %4 = icmp slt i32 %1, %2
+; ANTIEXPR-NEXT:  Expression 0:[icmp slt %1, %2]
+; ANTIEXPR-NEXT:  Domain Inst:  %5 = icmp sgt i32 %2, %1
+; ANTIEXPR-NEXT:  Expression 0:[icmp slt %1, %2]
+; ANTIEXPR-NEXT:  Domain Inst:  %6 = sext i32 %1 to i64
+; ANTIEXPR-NEXT:  Expression 1:[sext %1 to i64]
+; ANTIEXPR-NEXT:  Domain Inst:  %7 = getelementptr inbounds i32, i32* %0, i64 %6
+; ANTIEXPR-NEXT:  Expression 2:[getelementptr %0, %6]
+; ANTIEXPR-NEXT:  Domain Inst:  %8 = sext i32 %1 to i64
+; ANTIEXPR-NEXT:  Expression 1:[sext %1 to i64]
+; ANTIEXPR-NEXT:  Domain Inst:  %9 = getelementptr inbounds i32, i32* %0, i64 %8
+; ANTIEXPR-NEXT:  Expression 2:[getelementptr %0, %6]
+; ANTIEXPR-NEXT:  Domain Inst:  %10 = select i1 %5, i32* %7, i32* %9
+; ANTIEXPR-NEXT:  Expression 3:[select %4, %7, %7]
+; ANTIEXPR-NEXT:  Domain Size:4
+define i32* @bar(i32* %0, i32 %1, i32 %2) {
+  %4 = icmp slt i32 %1, %2
+  %5 = icmp sgt i32 %2, %1
+  %6 = sext i32 %1 to i64
+  %7 = getelementptr inbounds i32, i32* %0, i64 %6
+  %8 = sext i32 %1 to i64
+  %9 = getelementptr inbounds i32, i32* %0, i64 %8
+  %10 = select i1 %5, i32* %7, i32* %9
+  ret i32* %10
+}
@@ -0,0 +1,152 @@
+; RUN: opt -load %dylibdir/libDFA.so -andersen -analyze \
+; RUN:     %s -o %basename_t.andersen 2>%basename_t.andersen.log
+; RUN: FileCheck --match-full-lines %s --input-file=%basename_t.andersen \
+; RUN:     --check-prefix=ANDERSEN
+; RUN: FileCheck --match-full-lines %s \
+; RUN:     --input-file=%basename_t.andersen.log --check-prefix=ANDERSEN-STATS
+; RUN: opt -load %dylibdir/libDFA.so -steensgaard -analyze \
+; RUN:     %s -o %basename_t.steensgaard 2>%basename_t.steensgaard.log
+; RUN: FileCheck --match-full-lines %s --input-file=%basename_t.steensgaard \
+; RUN:     --check-prefix=STEENSGAARD
+; RUN: FileCheck --match-full-lines %s \
+; RUN:     --input-file=%basename_t.steensgaard.log \
+; RUN:     --check-prefix=STEENSGAARD-STATS
+
+; static int *swap(int **p, int **q) {
+;   int *t = *p;
+;   *p = *q;
+;   *q = t;
+;   return t;
+; }
+;
+; int g;
+;
+; int foo() {
+;   int a, b, c;
+;   int *pa = &a, *pb = &b;
+;   int *r = swap(&pa, &pb);
+;   int *h = malloc(4);
+;   int *e = &c;
+;   bar(&e);
+;   return *r + *h + g;
+; }
+; ANDERSEN-STATS:      Nodes: 40
+; ANDERSEN-STATS-NEXT: Constraints: 40
+; ANDERSEN-STATS-NEXT: Collapsed Nodes: 10
+; ANDERSEN-STATS-NEXT: Waves: 3
+; ANDERSEN-LABEL: Function: swap
+; ANDERSEN-NEXT:    %p -> { %pa }
+; ANDERSEN-NEXT:    %q -> { %pb }
+; ANDERSEN-NEXT:    %t -> { %a, %b }
+; ANDERSEN-NEXT:    %u -> { %a, %b }
+; ANDERSEN-NEXT:  Function: foo
+; ANDERSEN-NEXT:    %a -> { %a }
+; ANDERSEN-NEXT:    %b -> { %b }
+; ANDERSEN-NEXT:    %c -> { %c }
+; ANDERSEN-NEXT:    %pa -> { %pa }
+; ANDERSEN-NEXT:    %pb -> { %pb }
+; ANDERSEN-NEXT:    %e -> { %e }
+; ANDERSEN-NEXT:    %r -> { %a, %b }
+; ANDERSEN-NEXT:    call @swap: Mod { %pa, %pb } Ref { %pa, %pb }
+; ANDERSEN-NEXT:    %call -> { %call }
+; ANDERSEN-NEXT:    %h -> { %call }
+; ANDERSEN-NEXT:    call @bar: Mod { <unknown>, @g, @foo, @nulls, @malloc, @bar, %c, %e } Ref { <unknown>, @g, @foo, @nulls, @malloc, @bar, %c, %e }
+; ANDERSEN-NEXT:  Function: nulls
+; ANDERSEN-NEXT:    %a -> { %a }
+; ANDERSEN-NEXT:    %b -> { %b }
+; ANDERSEN-NEXT:    %pp -> { %pp }
+; ANDERSEN-NEXT:    %p -> { %a }
+; ANDERSEN-NEXT:    %q -> { %b }
+; ANDERSEN-NEXT:    %r -> { %b }
+; ANDERSEN-NEXT:  Escaped: { @g, @foo, @nulls, @malloc, @bar, %c, %e }
+; STEENSGAARD-STATS:      Nodes: 69
+; STEENSGAARD-STATS-NEXT: Constraints: 40
+; STEENSGAARD-STATS-NEXT: Unifications: 37
+; STEENSGAARD-LABEL: Function: swap
+; STEENSGAARD-NEXT:    %p -> { %pa }
+; STEENSGAARD-NEXT:    %q -> { %pb }
+; STEENSGAARD-NEXT:    %t -> { %a, %b }
+; STEENSGAARD-NEXT:    %u -> { %a, %b }
+; STEENSGAARD-NEXT:  Function: foo
+; STEENSGAARD-NEXT:    %a -> { %a, %b }
+; STEENSGAARD-NEXT:    %b -> { %a, %b }
+; STEENSGAARD-NEXT:    %c -> { <unknown>, @g, @foo, @nulls, @malloc, @bar, %c, %e }
+; STEENSGAARD-NEXT:    %pa -> { %pa }
+; STEENSGAARD-NEXT:    %pb -> { %pb }
+; STEENSGAARD-NEXT:    %e -> { <unknown>, @g, @foo, @nulls, @malloc, @bar, %c, %e }
+; STEENSGAARD-NEXT:    %r -> { %a, %b }
+; STEENSGAARD-NEXT:    call @swap: Mod { %pa, %pb } Ref { %pa, %pb }
+; STEENSGAARD-NEXT:    %call -> { %call }
+; STEENSGAARD-NEXT:    %h -> { %call }
+; STEENSGAARD-NEXT:    call @bar: Mod { <unknown>, @g, @foo, @nulls, @malloc, @bar, %c, %e } Ref { <unknown>, @g, @foo, @nulls, @malloc, @bar, %c, %e }
+; STEENSGAARD-NEXT:  Function: nulls
+; STEENSGAARD-NEXT:    %a -> { %a }
+; STEENSGAARD-NEXT:    %b -> { %b }
+; STEENSGAARD-NEXT:    %pp -> { %pp }
+; STEENSGAARD-NEXT:    %p -> { %a }
+; STEENSGAARD-NEXT:    %q -> { %b }
+; STEENSGAARD-NEXT:    %r -> { %b }
+; STEENSGAARD-NEXT:  Escaped: { @g, @foo, @nulls, @malloc, @bar, %c, %e }
+@g = global i32 0, align 4
+
+define internal i32* @swap(i32** %p, i32** %q) {
+entry:
+  %t = load i32*, i32** %p, align 8
+  %u = load i32*, i32** %q, align 8
+  store i32* %u, i32** %p, align 8
+  store i32* %t, i32** %q, align 8
+  ret i32* %t
+}
+
+define i32 @foo() {
+entry:
+  %a = alloca i32, align 4
+  %b = alloca i32, align 4
+  %c = alloca i32, align 4
+  %pa = alloca i32*, align 8
+  %pb = alloca i32*, align 8
+  %e = alloca i32*, align 8
+  store i32* %a, i32** %pa, align 8
+  store i32* %b, i32** %pb, align 8
+  %r = call i32* @swap(i32** %pa, i32** %pb)
+  %call = call noalias i8* @malloc(i64 4)
+  %h = bitcast i8* %call to i32*
+  store i32* %c, i32** %e, align 8
+  call void @bar(i32** %e)
+  %0 = load i32, i32* %r, align 4
+  %1 = load i32, i32* %h, align 4
+  %2 = load i32, i32* @g, align 4
+  %3 = add nsw i32 %0, %1
+  %4 = add nsw i32 %3, %2
+  ret i32 %4
+}
+
+; The null pointer points to nothing, so that it neither merges the pointers
+; that may be null nor makes their pointees escape.
+define i32 @nulls(i1 %c) {
+entry:
+  %a = alloca i32, align 4
+  %b = alloca i32, align 4
+  %pp = alloca i32*, align 8
+  %p = select i1 %c, i32* %a, i32* null
+  store i32* null, i32** %pp, align 8
+  store i32* %b, i32** %pp, align 8
+  br i1 %c, label %then, label %join
+
+then:
+  br label %join
+
+join:
+  %q = phi i32* [ %b, %then ], [ null, %entry ]
+  %r = load i32*, i32** %pp, align 8
+  %0 = load i32, i32* %p, align 4
+  %1 = load i32, i32* %q, align 4
+  %2 = load i32, i32* %r, align 4
+  %3 = add nsw i32 %0, %1
+  %4 = add nsw i32 %3, %2
+  ret i32 %4
+}
+
+declare noalias i8* @malloc(i64)
+
+declare void @bar(i32**)
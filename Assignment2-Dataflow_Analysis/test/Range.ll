@@ -0,0 +1,117 @@
+; RUN: opt -S -load %dylibdir/libDFA.so -range-opt \
+; RUN:     %s -o %basename_t 2>%basename_t.log
+; RUN: FileCheck --match-full-lines %s --input-file=%basename_t
+; RUN: FileCheck --match-full-lines %s --input-file=%basename_t.log \
+; RUN:     --check-prefix=STATS
+
+; int sum(int *a) {
+;   int s = 0;
+;   for (int i = 0; i < 100;) {
+;     if (i >= 100) {
+;       abort();
+;     }
+;     s += a[i / 4] + a[i % 4];
+;     if (__builtin_sadd_overflow(i, 1, &i)) {
+;       abort();
+;     }
+;   }
+;   return s;
+; }
+;
+; int div(int x) {
+;   return x / 4;
+; }
+; STATS:      Folded Comparisons: 1
+; STATS-NEXT: Folded Branches: 2
+; STATS-NEXT: Narrowed Divisions: 2
+; STATS-NEXT: Removed Overflow Checks: 1
+; STATS:      Folded Comparisons: 0
+; STATS-NEXT: Folded Branches: 0
+; STATS-NEXT: Narrowed Divisions: 0
+; STATS-NEXT: Removed Overflow Checks: 0
+define i32 @sum(i32* %a) {
+; CHECK-LABEL: define i32 @sum(i32* %a) {
+; CHECK-NEXT:  entry:
+; CHECK-NEXT:    br label %header
+; CHECK-EMPTY:
+; CHECK-NEXT:  header:                                           ; preds = %latch, %entry
+; CHECK-NEXT:    %s = phi i32 [ 0, %entry ], [ %s.next, %latch ]
+; CHECK-NEXT:    %i = phi i32 [ 0, %entry ], [ %inc, %latch ]
+; CHECK-NEXT:    %cond = icmp slt i32 %i, 100
+; CHECK-NEXT:    br i1 %cond, label %check, label %exit
+; CHECK-EMPTY:
+; CHECK-NEXT:  check:                                            ; preds = %header
+; CHECK-NEXT:    br label %body
+; CHECK-EMPTY:
+; CHECK-NEXT:  body:                                             ; preds = %check
+; CHECK-NEXT:    %div = lshr i32 %i, 2
+; CHECK-NEXT:    %div.ext = sext i32 %div to i64
+; CHECK-NEXT:    %p = getelementptr inbounds i32, i32* %a, i64 %div.ext
+; CHECK-NEXT:    %v = load i32, i32* %p, align 4
+; CHECK-NEXT:    %rem = and i32 %i, 3
+; CHECK-NEXT:    %rem.ext = sext i32 %rem to i64
+; CHECK-NEXT:    %q = getelementptr inbounds i32, i32* %a, i64 %rem.ext
+; CHECK-NEXT:    %w = load i32, i32* %q, align 4
+; CHECK-NEXT:    %vw = add nsw i32 %v, %w
+; CHECK-NEXT:    %s.next = add nsw i32 %s, %vw
+; CHECK-NEXT:    %inc = add nsw i32 %i, 1
+; CHECK-NEXT:    br label %latch
+; CHECK-EMPTY:
+; CHECK-NEXT:  latch:                                            ; preds = %body
+; CHECK-NEXT:    br label %header
+; CHECK-EMPTY:
+; CHECK-NEXT:  exit:                                             ; preds = %header
+; CHECK-NEXT:    ret i32 %s
+; CHECK-NEXT:  }
+entry:
+  br label %header
+
+header:
+  %s = phi i32 [ 0, %entry ], [ %s.next, %latch ]
+  %i = phi i32 [ 0, %entry ], [ %i.next, %latch ]
+  %cond = icmp slt i32 %i, 100
+  br i1 %cond, label %check, label %exit
+
+check:
+  %oob = icmp sge i32 %i, 100
+  br i1 %oob, label %trap, label %body
+
+body:
+  %div = sdiv i32 %i, 4
+  %div.ext = sext i32 %div to i64
+  %p = getelementptr inbounds i32, i32* %a, i64 %div.ext
+  %v = load i32, i32* %p, align 4
+  %rem = srem i32 %i, 4
+  %rem.ext = sext i32 %rem to i64
+  %q = getelementptr inbounds i32, i32* %a, i64 %rem.ext
+  %w = load i32, i32* %q, align 4
+  %vw = add nsw i32 %v, %w
+  %s.next = add nsw i32 %s, %vw
+  %inc = call { i32, i1 } @llvm.sadd.with.overflow.i32(i32 %i, i32 1)
+  %ovf = extractvalue { i32, i1 } %inc, 1
+  br i1 %ovf, label %trap, label %latch
+
+latch:
+  %i.next = extractvalue { i32, i1 } %inc, 0
+  br label %header
+
+trap:
+  call void @abort()
+  unreachable
+
+exit:
+  ret i32 %s
+}
+
+define i32 @div(i32 %x) {
+; CHECK-LABEL: define i32 @div(i32 %x) {
+; CHECK-NEXT:    %1 = sdiv i32 %x, 4
+; CHECK-NEXT:    ret i32 %1
+; CHECK-NEXT:  }
+  %1 = sdiv i32 %x, 4
+  ret i32 %1
+}
+
+declare { i32, i1 } @llvm.sadd.with.overflow.i32(i32, i32)
+
+declare void @abort()
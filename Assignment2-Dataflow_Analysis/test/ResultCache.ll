@@ -0,0 +1,80 @@
+; The cold run solves the liveness to fixpoint and stores the result, which
+; the warm run recovers without traversing the CFG, with the same mapping.
+; RUN: rm -rf %t.cache
+; RUN: opt -load %dylibdir/libDFA.so -liveness -dfa-cache-dir=%t.cache \
+; RUN:     -disable-output %s > %basename_t.cold.out 2> %basename_t.cold.log
+; RUN: FileCheck --match-full-lines %s --input-file=%basename_t.cold.log \
+; RUN:     --check-prefix=SOLVED
+; RUN: sed -n '/Instruction-Domain Value Mapping/,$p' %basename_t.cold.log \
+; RUN:     > %basename_t.cold.map
+; RUN: cp %t.cache/liveness-* %t.entry
+; RUN: opt -load %dylibdir/libDFA.so -liveness -dfa-cache-dir=%t.cache \
+; RUN:     -disable-output %s > %basename_t.warm.out 2> %basename_t.warm.log
+; RUN: FileCheck --match-full-lines %s --input-file=%basename_t.warm.log \
+; RUN:     --check-prefix=CACHED
+; RUN: sed -n '/Instruction-Domain Value Mapping/,$p' %basename_t.warm.log \
+; RUN:     > %basename_t.warm.map
+; RUN: diff %basename_t.cold.out %basename_t.warm.out
+; RUN: diff %basename_t.cold.map %basename_t.warm.map
+; SOLVED: * Traverse CFG
+; SOLVED: * Instruction-Domain Value Mapping
+; CACHED-NOT: * Traverse CFG
+; CACHED: * Instruction-Domain Value Mapping
+
+; An entry of another version of the cache is not trusted, but recomputed and
+; replaced.
+; RUN: printf '\377\377\377\377' > %t.version
+; RUN: find %t.cache -name 'liveness-*' -exec dd if=%t.version of={} bs=1 \
+; RUN:     seek=4 conv=notrunc status=none ';'
+; RUN: not cmp -s %t.entry %t.cache/liveness-*
+; RUN: opt -load %dylibdir/libDFA.so -liveness -dfa-cache-dir=%t.cache \
+; RUN:     -disable-output %s > %basename_t.version.out \
+; RUN:     2> %basename_t.version.log
+; RUN: FileCheck --match-full-lines %s --input-file=%basename_t.version.log \
+; RUN:     --check-prefix=SOLVED
+; RUN: sed -n '/Instruction-Domain Value Mapping/,$p' \
+; RUN:     %basename_t.version.log > %basename_t.version.map
+; RUN: diff %basename_t.cold.out %basename_t.version.out
+; RUN: diff %basename_t.cold.map %basename_t.version.map
+; RUN: cmp %t.entry %t.cache/liveness-*
+
+; Neither is a truncated entry.
+; RUN: find %t.cache -name 'liveness-*' -exec truncate -s 20 {} ';'
+; RUN: opt -load %dylibdir/libDFA.so -liveness -dfa-cache-dir=%t.cache \
+; RUN:     -disable-output %s > %basename_t.truncated.out \
+; RUN:     2> %basename_t.truncated.log
+; RUN: FileCheck --match-full-lines %s --input-file=%basename_t.truncated.log \
+; RUN:     --check-prefix=SOLVED
+; RUN: sed -n '/Instruction-Domain Value Mapping/,$p' \
+; RUN:     %basename_t.truncated.log > %basename_t.truncated.map
+; RUN: diff %basename_t.cold.out %basename_t.truncated.out
+; RUN: diff %basename_t.cold.map %basename_t.truncated.map
+; RUN: cmp %t.entry %t.cache/liveness-*
+
+; int sum(int a, int b) {
+;   int res = 1;
+;   for (int i = a; i < b; i++) {
+;     res += i;
+;   }
+;   return res;
+; }
+define i32 @sum(i32 %0, i32 %1) {
+  br label %3
+
+3:                                                ; preds = %7, %2
+  %.01 = phi i32 [ 1, %2 ], [ %6, %7 ]
+  %.0 = phi i32 [ %0, %2 ], [ %8, %7 ]
+  %4 = icmp slt i32 %.0, %1
+  br i1 %4, label %5, label %9
+
+5:                                                ; preds = %3
+  %6 = add nsw i32 %.01, %.0
+  br label %7
+
+7:                                                ; preds = %5
+  %8 = add nsw i32 %.0, 1
+  br label %3
+
+9:                                                ; preds = %3
+  ret i32 %.01
+}
@@ -0,0 +1,100 @@
+; RUN: opt -S -load %dylibdir/libDFA.so -ssa-construct \
+; RUN:     %s -o %basename_t 2>%basename_t.log
+; RUN: FileCheck --match-full-lines %s --input-file=%basename_t
+; RUN: FileCheck --match-full-lines %s --input-file=%basename_t.log \
+; RUN:     --check-prefix=STATS
+
+; int foo(int a, int b) {
+;   int x, y, t;
+;   if (a > b) {
+;     x = a;
+;     t = 1;
+;   } else {
+;     x = b;
+;     t = 2;
+;   }
+;   y = 0;
+;   while (x > 0) {
+;     y = y + x;
+;     x = x - 1;
+;   }
+;   return y;
+; }
+; STATS:      Promoted Allocas: 5
+; STATS-NEXT: Inserted PHIs: 3
+define i32 @foo(i32 %0, i32 %1) {
+; CHECK-LABEL: define i32 @foo(i32 %0, i32 %1) {
+; CHECK-NEXT:    %3 = icmp sgt i32 %0, %1
+; CHECK-NEXT:    br i1 %3, label %4, label %5
+; CHECK-EMPTY:
+; CHECK-NEXT:  4:                                                ; preds = %2
+; CHECK-NEXT:    br label %6
+; CHECK-EMPTY:
+; CHECK-NEXT:  5:                                                ; preds = %2
+; CHECK-NEXT:    br label %6
+; CHECK-EMPTY:
+; CHECK-NEXT:  6:                                                ; preds = %5, %4
+; CHECK-NEXT:    %7 = phi i32 [ %1, %5 ], [ %0, %4 ]
+; CHECK-NEXT:    br label %8
+; CHECK-EMPTY:
+; CHECK-NEXT:  8:                                                ; preds = %12, %6
+; CHECK-NEXT:    %9 = phi i32 [ 0, %6 ], [ %13, %12 ]
+; CHECK-NEXT:    %10 = phi i32 [ %7, %6 ], [ %14, %12 ]
+; CHECK-NEXT:    %11 = icmp sgt i32 %10, 0
+; CHECK-NEXT:    br i1 %11, label %12, label %15
+; CHECK-EMPTY:
+; CHECK-NEXT:  12:                                               ; preds = %8
+; CHECK-NEXT:    %13 = add nsw i32 %9, %10
+; CHECK-NEXT:    %14 = sub nsw i32 %10, 1
+; CHECK-NEXT:    br label %8
+; CHECK-EMPTY:
+; CHECK-NEXT:  15:                                               ; preds = %8
+; CHECK-NEXT:    ret i32 %9
+; CHECK-NEXT:  }
+  %3 = alloca i32, align 4
+  %4 = alloca i32, align 4
+  %5 = alloca i32, align 4
+  %6 = alloca i32, align 4
+  %7 = alloca i32, align 4
+  store i32 %0, i32* %3, align 4
+  store i32 %1, i32* %4, align 4
+  %8 = load i32, i32* %3, align 4
+  %9 = load i32, i32* %4, align 4
+  %10 = icmp sgt i32 %8, %9
+  br i1 %10, label %11, label %13
+
+11:                                               ; preds = %2
+  %12 = load i32, i32* %3, align 4
+  store i32 %12, i32* %5, align 4
+  store i32 1, i32* %7, align 4
+  br label %15
+
+13:                                               ; preds = %2
+  %14 = load i32, i32* %4, align 4
+  store i32 %14, i32* %5, align 4
+  store i32 2, i32* %7, align 4
+  br label %15
+
+15:                                               ; preds = %13, %11
+  store i32 0, i32* %6, align 4
+  br label %16
+
+16:                                               ; preds = %19, %15
+  %17 = load i32, i32* %5, align 4
+  %18 = icmp sgt i32 %17, 0
+  br i1 %18, label %19, label %25
+
+19:                                               ; preds = %16
+  %20 = load i32, i32* %6, align 4
+  %21 = load i32, i32* %5, align 4
+  %22 = add nsw i32 %20, %21
+  store i32 %22, i32* %6, align 4
+  %23 = load i32, i32* %5, align 4
+  %24 = sub nsw i32 %23, 1
+  store i32 %24, i32* %5, align 4
+  br label %16
+
+25:                                               ; preds = %16
+  %26 = load i32, i32* %6, align 4
+  ret i32 %26
+}
@@ -0,0 +1,68 @@
+; RUN: opt -S -load %dylibdir/libDFA.so -slot-coloring \
+; RUN:     %s -o %basename_t 2>%basename_t.log
+; RUN: FileCheck --match-full-lines %s --input-file=%basename_t
+; RUN: FileCheck --match-full-lines %s --input-file=%basename_t.log \
+; RUN:     --check-prefix=STATS
+
+; void use(int *p);
+;
+; long foo(int c) {
+;   int a[4], x;
+;   int y;
+;   long d;
+;   int e;
+;   a[0] = c;     // a and x are only used here, ...
+;   x = c;
+;   int t = a[0] + x;
+;   y = t;        // ... so y can take the place of x and d the one of a.
+;   d = t;
+;   long r = y + d;
+;   use(&e);      // e escapes and keeps its own slot.
+;   return r;
+; }
+; STATS: Stack Slots (foo): 4 -> 2
+; STATS-NEXT: Frame Size (foo): 36 -> 24 bytes
+declare dso_local void @use(i32*)
+
+define dso_local i64 @foo(i32 %0) {
+; CHECK-LABEL: define dso_local i64 @foo(i32 %0) {
+  %2 = alloca [4 x i32], align 16
+  %3 = alloca i32, align 4
+  %4 = alloca i32, align 4
+  %5 = alloca i64, align 8
+  %6 = alloca i32, align 4
+; CHECK-NEXT:   %2 = alloca [4 x i32], align 16
+; CHECK-NEXT:   %3 = alloca i32, align 4
+; CHECK-NEXT:   %4 = bitcast [4 x i32]* %2 to i64*
+; CHECK-NEXT:   %5 = alloca i32, align 4
+  %7 = getelementptr inbounds [4 x i32], [4 x i32]* %2, i64 0, i64 0
+  store i32 %0, i32* %7, align 16
+  store i32 %0, i32* %3, align 4
+  %8 = load i32, i32* %7, align 16
+  %9 = load i32, i32* %3, align 4
+  %10 = add nsw i32 %8, %9
+  store i32 %10, i32* %4, align 4
+  %11 = sext i32 %10 to i64
+  store i64 %11, i64* %5, align 8
+  %12 = load i32, i32* %4, align 4
+  %13 = sext i32 %12 to i64
+  %14 = load i64, i64* %5, align 8
+  %15 = add nsw i64 %13, %14
+  call void @use(i32* %6)
+  ret i64 %15
+; CHECK-NEXT:   %6 = getelementptr inbounds [4 x i32], [4 x i32]* %2, i64 0, i64 0
+; CHECK-NEXT:   store i32 %0, i32* %6, align 16
+; CHECK-NEXT:   store i32 %0, i32* %3, align 4
+; CHECK-NEXT:   %7 = load i32, i32* %6, align 16
+; CHECK-NEXT:   %8 = load i32, i32* %3, align 4
+; CHECK-NEXT:   %9 = add nsw i32 %7, %8
+; CHECK-NEXT:   store i32 %9, i32* %3, align 4
+; CHECK-NEXT:   %10 = sext i32 %9 to i64
+; CHECK-NEXT:   store i64 %10, i64* %4, align 8
+; CHECK-NEXT:   %11 = load i32, i32* %3, align 4
+; CHECK-NEXT:   %12 = sext i32 %11 to i64
+; CHECK-NEXT:   %13 = load i64, i64* %4, align 8
+; CHECK-NEXT:   %14 = add nsw i64 %12, %13
+; CHECK-NEXT:   call void @use(i32* %5)
+; CHECK-NEXT:   ret i64 %14
+}
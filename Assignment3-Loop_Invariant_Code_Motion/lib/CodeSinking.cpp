@@ -0,0 +1,197 @@
+/**
+ * @file Code Sinking
+ */
+#include <llvm/ADT/DepthFirstIterator.h>
+#include <llvm/ADT/DenseMap.h>
+#include <llvm/Analysis/BlockFrequencyInfo.h>
+#include <llvm/Analysis/LoopPass.h>
+#include <llvm/IR/Dominators.h>
+#include <llvm/Transforms/Utils.h>
+
+using namespace llvm;
+
+namespace {
+
+/**
+ * @brief Sink the instructions of the loops whose results are only used on
+ *        some of the paths through them, either
+ *
+ *     - into the exit blocks, if they are only used after the loop, in which
+ *       case they only get computed for the last iteration, or
+ *     - into the block of the loop that dominates all their uses,
+ *
+ * provided that the destination executes less often than where they are.
+ */
+class CodeSinking final : public LoopPass {
+private:
+  const DominatorTree *DT;
+  const LoopInfo *LI;
+  const BlockFrequencyInfo *BFI;
+  unsigned NumSunkToExits, NumSunkToBlocks;
+
+  /**
+   * @brief Whether @c Inst computes its value from nothing but its operands,
+   *        and may thus be computed anywhere that they are available.
+   */
+  static bool isSinkCandidate(const Instruction &Inst) {
+    return !isa<PHINode>(Inst) && !isa<AllocaInst>(Inst) &&
+           !Inst.isTerminator() && !Inst.isEHPad() &&
+           !Inst.mayReadOrWriteMemory() && !Inst.mayHaveSideEffects();
+  }
+  /**
+   * @brief Return a PHI node of @c ExitBlock , which has a single
+   *        predecessor in the loop, for the value of @c Inst when the loop is
+   *        left, as the loop closed SSA form requires for its uses after it.
+   */
+  static Value *getExitValue(Instruction &Inst, BasicBlock &ExitBlock) {
+    for (PHINode &Phi : ExitBlock.phis()) {
+      if (Phi.getNumIncomingValues() == 1 &&
+          Phi.getIncomingValue(0) == &Inst) {
+        return &Phi;
+      }
+    }
+    PHINode *const Phi = PHINode::Create(Inst.getType(), 1,
+                                         Inst.getName() + ".lcssa",
+                                         &ExitBlock.front());
+    Phi->addIncoming(&Inst, ExitBlock.getSinglePredecessor());
+    return Phi;
+  }
+
+  /**
+   * @brief Sink @c Inst into the exit blocks of @c L if it is only used
+   *        after the loop, and computed in every iteration that leaves it.
+   * @return whether it has been sunk
+   */
+  bool sinkToExits(Instruction &Inst, const Loop &L) {
+    BasicBlock *const BB = Inst.getParent();
+    // In the loop closed SSA form, the uses after the loop are PHI nodes of
+    // the exit blocks.
+    SmallVector<PHINode *, 4> Phis;
+    SmallVector<BasicBlock *, 4> ExitBlocks;
+    BlockFrequency ExitFreq;
+    for (User *const U : Inst.users()) {
+      PHINode *const Phi = dyn_cast<PHINode>(U);
+      if (!Phi || L.contains(Phi->getParent())) {
+        return false;
+      }
+      BasicBlock *const ExitBlock = Phi->getParent();
+      const BasicBlock *const Exiting = ExitBlock->getSinglePredecessor();
+      if (!Exiting || !DT->dominates(BB, Exiting)) {
+        return false;
+      }
+      Phis.push_back(Phi);
+      if (!is_contained(ExitBlocks, ExitBlock)) {
+        ExitBlocks.push_back(ExitBlock);
+        ExitFreq += BFI->getBlockFreq(ExitBlock);
+      }
+    }
+    if (Phis.empty() || ExitFreq >= BFI->getBlockFreq(BB)) {
+      return false;
+    }
+
+    const std::string Name = Inst.getName().str();
+    Inst.setName("");
+    DenseMap<const BasicBlock *, Instruction *> Clones;
+    for (BasicBlock *const ExitBlock : ExitBlocks) {
+      Instruction *const Clone = Inst.clone();
+      Clone->setName(Name);
+      Clone->insertBefore(&*ExitBlock->getFirstInsertionPt());
+      for (Use &Op : Clone->operands()) {
+        Instruction *const OpInst = dyn_cast<Instruction>(Op.get());
+        if (OpInst && L.contains(OpInst)) {
+          Op.set(getExitValue(*OpInst, *ExitBlock));
+        }
+      }
+      Clones[ExitBlock] = Clone;
+    }
+    for (PHINode *const Phi : Phis) {
+      Phi->replaceAllUsesWith(Clones[Phi->getParent()]);
+      Phi->eraseFromParent();
+    }
+    Inst.eraseFromParent();
+    ++NumSunkToExits;
+    return true;
+  }
+  /**
+   * @brief Sink @c Inst into the block of @c L that dominates all its uses,
+   *        if it executes less often than the block of @c Inst .
+   * @return whether it has been sunk
+   */
+  bool sinkToBlock(Instruction &Inst, const Loop &L) {
+    BasicBlock *const BB = Inst.getParent();
+    BasicBlock *Dest = nullptr;
+    for (const Use &U : Inst.uses()) {
+      const Instruction *const User = cast<Instruction>(U.getUser());
+      // The uses in PHI nodes are at the end of the incoming blocks.
+      BasicBlock *const UseBB =
+          isa<PHINode>(User) ? cast<PHINode>(User)->getIncomingBlock(U)
+                             : const_cast<BasicBlock *>(User->getParent());
+      Dest = Dest ? DT->findNearestCommonDominator(Dest, UseBB) : UseBB;
+    }
+    if (!Dest || Dest == BB || LI->getLoopFor(Dest) != &L ||
+        BFI->getBlockFreq(Dest) >= BFI->getBlockFreq(BB)) {
+      return false;
+    }
+    Inst.moveBefore(&*Dest->getFirstInsertionPt());
+    ++NumSunkToBlocks;
+    return true;
+  }
+
+public:
+  static char ID;
+
+  CodeSinking() : LoopPass(ID) {}
+
+  virtual void getAnalysisUsage(AnalysisUsage &AU) const override {
+    AU.addRequired<DominatorTreeWrapperPass>();
+    AU.addRequired<LoopInfoWrapperPass>();
+    AU.addRequired<BlockFrequencyInfoWrapperPass>();
+    AU.addRequiredID(LoopSimplifyID);
+    AU.addRequiredID(LCSSAID);
+    AU.addPreservedID(LCSSAID);
+    AU.setPreservesCFG();
+  }
+
+  virtual bool runOnLoop(Loop *L, LPPassManager &LPM) override {
+    DT = &getAnalysis<DominatorTreeWrapperPass>().getDomTree();
+    LI = &getAnalysis<LoopInfoWrapperPass>().getLoopInfo();
+    BFI = &getAnalysis<BlockFrequencyInfoWrapperPass>().getBFI();
+    NumSunkToExits = NumSunkToBlocks = 0;
+
+    // Visit the users before the instructions that they use, i.e., the
+    // blocks in reverse dominator tree order and each from the bottom up,
+    // so that sinking an instruction may let its operands follow it. The
+    // instructions of the inner loops have been sunk out of them already.
+    SmallVector<BasicBlock *, 16> Blocks;
+    for (const DomTreeNode *const Node :
+         depth_first(DT->getNode(L->getHeader()))) {
+      if (LI->getLoopFor(Node->getBlock()) == L) {
+        Blocks.push_back(Node->getBlock());
+      }
+    }
+    bool Changed = false;
+    for (BasicBlock *const BB : reverse(Blocks)) {
+      for (Instruction &Inst : make_early_inc_range(reverse(*BB))) {
+        if (isSinkCandidate(Inst)) {
+          Changed |= sinkToExits(Inst, *L) || sinkToBlock(Inst, *L);
+        }
+      }
+    }
+    if (Changed) {
+      const std::string Name =
+          (L->getHeader()->getParent()->getName() + ", " +
+           L->getHeader()->getName())
+              .str();
+      errs() << "Instructions Sunk to Exits (" << Name
+             << "): " << NumSunkToExits << "\n"
+             << "Instructions Sunk to Colder Blocks (" << Name
+             << "): " << NumSunkToBlocks << "\n";
+    }
+    return Changed;
+  }
+};
+
+char CodeSinking::ID = 0;
+RegisterPass<CodeSinking> X("code-sinking", "Code Sinking");
+
+} // anonymous namespace
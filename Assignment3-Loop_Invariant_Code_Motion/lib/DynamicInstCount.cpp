@@ -0,0 +1,91 @@
+/**
+ * @file Dynamic Instruction Count
+ */
+#include <llvm/IR/IRBuilder.h>
+#include <llvm/IR/IntrinsicInst.h>
+#include <llvm/IR/Module.h>
+#include <llvm/Pass.h>
+
+using namespace llvm;
+
+namespace {
+
+/**
+ * @brief Instrument the module to count the instructions, and among them the
+ *        conditional branches and switches, that it executes, and to print
+ *        the counts when @c main returns, e.g.,
+ *
+ *            Dynamic Instructions: 42
+ *            Dynamic Branches: 7
+ *
+ *        The counts cover the instructions of the module as they were before
+ *        the instrumentation, except for the PHI nodes and the debug
+ *        intrinsics, which do not execute as such.
+ */
+class DynamicInstCount final : public ModulePass {
+public:
+  static char ID;
+
+  DynamicInstCount() : ModulePass(ID) {}
+
+  virtual bool runOnModule(Module &M) override {
+    Function *const Main = M.getFunction("main");
+    if (!Main || Main->isDeclaration()) {
+      return false;
+    }
+    LLVMContext &Ctx = M.getContext();
+    IntegerType *const Int64Ty = Type::getInt64Ty(Ctx);
+    auto CreateCounter = [&](const Twine &Name) {
+      return new GlobalVariable(M, Int64Ty, /*isConstant=*/false,
+                                GlobalValue::InternalLinkage,
+                                ConstantInt::get(Int64Ty, 0), Name);
+    };
+    GlobalVariable *const InstCounter = CreateCounter("dynamic.inst.count");
+    GlobalVariable *const BranchCounter =
+        CreateCounter("dynamic.branch.count");
+
+    for (Function &F : M) {
+      for (BasicBlock &BB : F) {
+        const uint64_t NumInsts = count_if(BB, [](const Instruction &Inst) {
+          return !isa<PHINode>(Inst) && !isa<DbgInfoIntrinsic>(Inst);
+        });
+        const BranchInst *const Br = dyn_cast<BranchInst>(BB.getTerminator());
+        const bool IsBranch = (Br && Br->isConditional()) ||
+                              isa<SwitchInst>(BB.getTerminator());
+        IRBuilder<> Builder(&*BB.getFirstInsertionPt());
+        for (GlobalVariable *const Counter : {InstCounter, BranchCounter}) {
+          const uint64_t Count = Counter == InstCounter ? NumInsts : IsBranch;
+          if (Count) {
+            Builder.CreateStore(
+                Builder.CreateAdd(Builder.CreateLoad(Int64Ty, Counter),
+                                  ConstantInt::get(Int64Ty, Count)),
+                Counter);
+          }
+        }
+      }
+    }
+
+    FunctionCallee Printf = M.getOrInsertFunction(
+        "printf", FunctionType::get(Type::getInt32Ty(Ctx),
+                                    {Type::getInt8PtrTy(Ctx)},
+                                    /*isVarArg=*/true));
+    for (BasicBlock &BB : *Main) {
+      if (ReturnInst *const Ret = dyn_cast<ReturnInst>(BB.getTerminator())) {
+        IRBuilder<> Builder(Ret);
+        Builder.CreateCall(
+            Printf,
+            {Builder.CreateGlobalStringPtr("Dynamic Instructions: %lld\n"
+                                           "Dynamic Branches: %lld\n"),
+             Builder.CreateLoad(Int64Ty, InstCounter),
+             Builder.CreateLoad(Int64Ty, BranchCounter)});
+      }
+    }
+    return true;
+  }
+};
+
+char DynamicInstCount::ID = 0;
+RegisterPass<DynamicInstCount> X("dynamic-inst-count",
+                                 "Dynamic Instruction Count Instrumentation");
+
+} // anonymous namespace
@@ -1,30 +1,537 @@
 /**
  * @file Loop Invariant Code Motion
  */
+#include <llvm/ADT/DepthFirstIterator.h>
+#include <llvm/ADT/MapVector.h>
+#include <llvm/Analysis/AliasAnalysis.h>
+#include <llvm/Analysis/BlockFrequencyInfo.h>
+#include <llvm/Analysis/Loads.h>
 #include <llvm/Analysis/LoopPass.h>
+#include <llvm/Analysis/TargetTransformInfo.h>
 #include <llvm/Analysis/ValueTracking.h>
+#include <llvm/IR/Dominators.h>
+#include <llvm/Support/CommandLine.h>
+#include <llvm/Support/InstructionCost.h>
+#include <llvm/Transforms/Utils.h>
+#include <llvm/Transforms/Utils/SSAUpdater.h>
+
+#include <algorithm>
 
 using namespace llvm;
 
+static cl::opt<bool> PromoteScalars(
+    "licm-promote-scalars", cl::init(false),
+    cl::desc("Promote the loop-invariant memory locations to registers"));
+static cl::opt<unsigned> RegisterBudget(
+    "licm-register-budget", cl::init(0),
+    cl::desc("Number of registers of each class that the loops may keep "
+             "live, or 0 for that of the target"));
+
 namespace {
 
+/**
+ * @brief Rewrite the loads and stores of a promoted memory location into SSA
+ *        values, and store the value back in the exit blocks if the loop
+ *        writes to it.
+ */
+class LoopPromoter final : public LoadAndStorePromoter {
+private:
+  Value *const Ptr;
+  const SmallVectorImpl<BasicBlock *> &ExitBlocks;
+  const Align Alignment;
+  const bool IsWritten;
+
+public:
+  LoopPromoter(ArrayRef<const Instruction *> Insts, SSAUpdater &SSA,
+               Value *const Ptr,
+               const SmallVectorImpl<BasicBlock *> &ExitBlocks,
+               const Align Alignment, const bool IsWritten)
+      : LoadAndStorePromoter(Insts, SSA), Ptr(Ptr), ExitBlocks(ExitBlocks),
+        Alignment(Alignment), IsWritten(IsWritten) {}
+
+  virtual void doExtraRewritesBeforeFinalDeletion() override {
+    if (!IsWritten) {
+      return;
+    }
+    for (BasicBlock *const ExitBlock : ExitBlocks) {
+      new StoreInst(SSA.GetValueInMiddleOfBlock(ExitBlock), Ptr,
+                    /*isVolatile=*/false, Alignment,
+                    &*ExitBlock->getFirstInsertionPt());
+    }
+  }
+};
+
 class LoopInvariantCodeMotion final : public LoopPass {
+private:
+  const DominatorTree *DT;
+  AAResults *AA;
+  const TargetTransformInfo *TTI;
+  const BlockFrequencyInfo *BFI;
+  /// Whether anything in the loop may stop the execution halfway through an
+  /// iteration, e.g., a call to exit
+  bool MayStop;
+
+  /**
+   * @brief Whether @c Inst computes its value from nothing but its operands,
+   *        i.e., it is loop-invariant if all of them are.
+   */
+  static bool isInvariantCandidate(const Instruction &Inst) {
+    return !isa<PHINode>(Inst) && !isa<AllocaInst>(Inst) &&
+           !Inst.isTerminator() && !Inst.isEHPad() &&
+           !Inst.mayReadOrWriteMemory() && !Inst.mayHaveSideEffects();
+  }
+  /**
+   * @brief Return the type of the value that @c Access loads or stores.
+   */
+  static Type *getAccessType(const Instruction *const Access) {
+    return isa<LoadInst>(Access)
+               ? Access->getType()
+               : cast<StoreInst>(Access)->getValueOperand()->getType();
+  }
+  /**
+   * @brief Whether @c BB executes whenever the loop @c L is entered and left
+   *        through one of its exits, i.e., it dominates all of them.
+   */
+  bool dominatesAllExits(const BasicBlock &BB, const Loop &L) const {
+    SmallVector<BasicBlock *, 4> ExitBlocks;
+    L.getExitBlocks(ExitBlocks);
+    return !ExitBlocks.empty() &&
+           all_of(ExitBlocks, [&](const BasicBlock *const ExitBlock) {
+             return DT->dominates(&BB, ExitBlock);
+           });
+  }
+  /**
+   * @brief Whether @c BB executes whenever the loop @c L is entered.
+   */
+  bool isGuaranteedToExecute(const BasicBlock &BB, const Loop &L) const {
+    return !MayStop && dominatesAllExits(BB, L);
+  }
+
+  /**
+   * @brief Return the register class that holds @c V .
+   */
+  unsigned getRegisterClass(const Value &V) const {
+    return TTI->getRegisterClassForType(V.getType()->isVectorTy(),
+                                        V.getType());
+  }
+  /**
+   * @brief Estimate the register pressure of @c L , i.e., the maximum number
+   *        of values of each register class that are live at the same point,
+   *        were the instructions in @c Hoisted moved into the preheader.
+   *
+   * The values defined outside the loop (including the hoisted ones) are
+   * live throughout it if they are used in it or after it, whereas those
+   * defined in the loop follow from a liveness analysis over its blocks.
+   */
+  SmallDenseMap<unsigned, unsigned>
+  estimatePressure(const Loop &L,
+                   const SmallPtrSetImpl<const Instruction *> &Hoisted) const {
+    auto IsLocal = [&](const Value *const V) {
+      const Instruction *const Inst = dyn_cast<Instruction>(V);
+      return Inst && !Inst->getType()->isVoidTy() && L.contains(Inst) &&
+             !Hoisted.count(Inst);
+    };
+    auto IsOutside = [&](const Value *const V) {
+      const Instruction *const Inst = dyn_cast<Instruction>(V);
+      return (isa<Argument>(V) || (Inst && !L.contains(Inst)) ||
+              Hoisted.count(Inst)) &&
+             !V->getType()->isVoidTy();
+    };
+
+    SmallDenseMap<unsigned, unsigned> Pressure;
+    // the values that live throughout the loop
+    SmallPtrSet<const Value *, 16> LiveThrough;
+    for (const BasicBlock *const BB : L.blocks()) {
+      for (const Instruction &Inst : *BB) {
+        if (Hoisted.count(&Inst)) {
+          continue;
+        }
+        for (const Use &U : Inst.operands()) {
+          const PHINode *const Phi = dyn_cast<PHINode>(&Inst);
+          if (IsOutside(U.get()) &&
+              (!Phi || L.contains(Phi->getIncomingBlock(U)))) {
+            LiveThrough.insert(U.get());
+          }
+        }
+      }
+    }
+    for (const Instruction *const Inst : Hoisted) {
+      if (any_of(Inst->users(), [&](const User *const U) {
+            const Instruction *const UserInst = cast<Instruction>(U);
+            return !Hoisted.count(UserInst) &&
+                   DT->dominates(L.getHeader(), UserInst->getParent());
+          })) {
+        LiveThrough.insert(Inst);
+      }
+    }
+    for (const Value *const V : LiveThrough) {
+      ++Pressure[getRegisterClass(*V)];
+    }
+
+    // the values that are defined in the loop, which are live out of the
+    // exiting blocks that they dominate if they are used after the loop
+    SmallVector<const Instruction *, 4> UsedAfter;
+    for (const BasicBlock *const BB : L.blocks()) {
+      for (const Instruction &Inst : *BB) {
+        if (IsLocal(&Inst) && any_of(Inst.users(), [&](const User *const U) {
+              return !L.contains(cast<Instruction>(U));
+            })) {
+          UsedAfter.push_back(&Inst);
+        }
+      }
+    }
+    DenseMap<const BasicBlock *, SmallPtrSet<const Value *, 16>> LiveIns;
+    SmallDenseMap<unsigned, unsigned> LocalPressure;
+    bool IsLiveInChanged;
+    do {
+      IsLiveInChanged = false;
+      for (const BasicBlock *const BB : reverse(L.getBlocks())) {
+        SmallPtrSet<const Value *, 16> Live;
+        for (const BasicBlock *const Succ : successors(BB)) {
+          if (!L.contains(Succ)) {
+            continue;
+          }
+          const SmallPtrSetImpl<const Value *> &SuccLiveIn = LiveIns[Succ];
+          Live.insert(SuccLiveIn.begin(), SuccLiveIn.end());
+          for (const PHINode &Phi : Succ->phis()) {
+            const Value *const Incoming = Phi.getIncomingValueForBlock(BB);
+            if (IsLocal(Incoming)) {
+              Live.insert(Incoming);
+            }
+          }
+        }
+        if (L.isLoopExiting(BB)) {
+          for (const Instruction *const Inst : UsedAfter) {
+            if (DT->dominates(Inst->getParent(), BB)) {
+              Live.insert(Inst);
+            }
+          }
+        }
+        SmallDenseMap<unsigned, unsigned> Counts;
+        for (const Value *const V : Live) {
+          ++Counts[getRegisterClass(*V)];
+        }
+        auto UpdateMax = [&]() {
+          for (const std::pair<unsigned, unsigned> &CP : Counts) {
+            LocalPressure[CP.first] =
+                std::max(LocalPressure[CP.first], CP.second);
+          }
+        };
+        UpdateMax();
+        for (const Instruction &Inst : reverse(*BB)) {
+          if (Live.erase(&Inst)) {
+            --Counts[getRegisterClass(Inst)];
+          }
+          // The operands of the PHI nodes are live out of the incoming blocks
+          // instead.
+          if (isa<PHINode>(Inst)) {
+            continue;
+          }
+          for (const Value *const Op : Inst.operands()) {
+            if (IsLocal(Op) && Live.insert(Op).second) {
+              ++Counts[getRegisterClass(*Op)];
+            }
+          }
+          UpdateMax();
+        }
+        SmallPtrSetImpl<const Value *> &LiveIn = LiveIns[BB];
+        if (LiveIn.size() != Live.size()) {
+          LiveIn.insert(Live.begin(), Live.end());
+          IsLiveInChanged = true;
+        }
+      }
+    } while (IsLiveInChanged);
+    for (const std::pair<unsigned, unsigned> &CP : LocalPressure) {
+      Pressure[CP.first] += CP.second;
+    }
+    return Pressure;
+  }
+
+  /**
+   * @brief Hoist the loop-invariant instructions of @c L into @c Preheader .
+   */
+  bool hoistInvariants(Loop &L, BasicBlock &Preheader) {
+    // 1. Mark the loop-invariant instructions, i.e., those whose operands are
+    //    all constants, defined outside the loop, or loop-invariant, until
+    //    nothing changes.
+    SmallPtrSet<const Instruction *, 16> Invariants;
+    bool IsMarkChanged;
+    do {
+      IsMarkChanged = false;
+      for (const BasicBlock *const BB : L.blocks()) {
+        for (const Instruction &Inst : *BB) {
+          if (Invariants.count(&Inst) || !isInvariantCandidate(Inst)) {
+            continue;
+          }
+          if (all_of(Inst.operands(), [&](const Value *const Op) {
+                const Instruction *const OpInst = dyn_cast<Instruction>(Op);
+                return L.isLoopInvariant(Op) ||
+                       (OpInst && Invariants.count(OpInst));
+              })) {
+            Invariants.insert(&Inst);
+            IsMarkChanged = true;
+          }
+        }
+      }
+    } while (IsMarkChanged);
+
+    // 2. Collect the invariants that may be hoisted, i.e., those that cannot
+    //    trap or would have executed anyway, and whose operands are defined
+    //    outside the loop or may be hoisted too, in the preorder of the
+    //    dominator tree, so that the definitions come before their uses.
+    SmallVector<Instruction *, 16> Candidates;
+    SmallPtrSet<const Instruction *, 16> IsCandidate;
+    for (DomTreeNode *const Node : depth_first(DT->getNode(L.getHeader()))) {
+      BasicBlock *const BB = Node->getBlock();
+      if (!L.contains(BB)) {
+        continue;
+      }
+      const bool IsGuaranteedToExecute = isGuaranteedToExecute(*BB, L);
+      for (Instruction &Inst : *BB) {
+        if (!Invariants.count(&Inst) ||
+            !(IsGuaranteedToExecute || isSafeToSpeculativelyExecute(&Inst)) ||
+            !all_of(Inst.operands(), [&](const Value *const Op) {
+              const Instruction *const OpInst = dyn_cast<Instruction>(Op);
+              return L.isLoopInvariant(Op) ||
+                     (OpInst && IsCandidate.count(OpInst));
+            })) {
+          continue;
+        }
+        Candidates.push_back(&Inst);
+        IsCandidate.insert(&Inst);
+      }
+    }
+
+    // 3. Rank the candidates by the number of executions that hoisting them
+    //    saves, weighted by their latencies, and hoist them together with
+    //    the candidates that they depend on, as long as the register pressure
+    //    stays within the budget of the target or does not grow. Those left
+    //    in the loop are cheap to recompute on every iteration compared to
+    //    spilling.
+    const double PreheaderFreq = BFI->getBlockFreq(&Preheader).getFrequency();
+    DenseMap<const Instruction *, double> Benefits;
+    for (const Instruction *const Candidate : Candidates) {
+      const InstructionCost Latency =
+          TTI->getInstructionCost(Candidate, TargetTransformInfo::TCK_Latency);
+      Benefits[Candidate] =
+          L.getLoopDepth() *
+          (BFI->getBlockFreq(Candidate->getParent()).getFrequency() /
+           std::max(PreheaderFreq, 1.0)) *
+          (Latency.isValid() ? *Latency.getValue() : 1);
+    }
+    SmallVector<Instruction *, 16> Ranked(Candidates.begin(), Candidates.end());
+    std::stable_sort(Ranked.begin(), Ranked.end(),
+                     [&](const Instruction *const LHS,
+                         const Instruction *const RHS) {
+                       return Benefits[LHS] > Benefits[RHS];
+                     });
+    SmallPtrSet<const Instruction *, 16> Hoisted;
+    SmallDenseMap<unsigned, unsigned> Pressure = estimatePressure(L, Hoisted);
+    for (Instruction *const Candidate : Ranked) {
+      if (Hoisted.count(Candidate)) {
+        continue;
+      }
+      SmallPtrSet<const Instruction *, 16> NewHoisted = Hoisted;
+      SmallVector<const Instruction *, 4> Worklist = {Candidate};
+      while (!Worklist.empty()) {
+        const Instruction *const Inst = Worklist.pop_back_val();
+        if (!NewHoisted.insert(Inst).second) {
+          continue;
+        }
+        for (const Value *const Op : Inst->operands()) {
+          const Instruction *const OpInst = dyn_cast<Instruction>(Op);
+          if (OpInst && IsCandidate.count(OpInst)) {
+            Worklist.push_back(OpInst);
+          }
+        }
+      }
+      SmallDenseMap<unsigned, unsigned> NewPressure =
+          estimatePressure(L, NewHoisted);
+      if (all_of(NewPressure, [&](const std::pair<unsigned, unsigned> &CP) {
+            const unsigned Budget = RegisterBudget
+                                        ? RegisterBudget
+                                        : TTI->getNumberOfRegisters(CP.first);
+            return CP.second <= std::max(Pressure.lookup(CP.first), Budget);
+          })) {
+        Hoisted = std::move(NewHoisted);
+        Pressure = std::move(NewPressure);
+      }
+    }
+
+    // 4. Hoist the selected candidates into the preheader.
+    for (Instruction *const Candidate : Candidates) {
+      if (!Hoisted.count(Candidate)) {
+        continue;
+      }
+      if (!isGuaranteedToExecute(*Candidate->getParent(), L)) {
+        // The metadata may only hold on the paths that reach the block.
+        Candidate->dropUnknownNonDebugMetadata();
+      }
+      Candidate->moveBefore(Preheader.getTerminator());
+    }
+    return !Hoisted.empty();
+  }
+
+  /**
+   * @brief Promote the memory locations that @c L accesses through
+   *        loop-invariant pointers to SSA values, i.e.,
+   *
+   *            Preheader:                  Preheader:
+   *                                          %p.promoted = load %p
+   *            Loop:                       Loop:
+   *              %x = load %p       →        %x = phi [%p.promoted, ...]
+   *              %y = add %x, 1                %y = add %x, 1
+   *              store %y, %p
+   *            Exit:                       Exit:
+   *                                          store %y, %p
+   *
+   *        if no other access in the loop may alias the location, the load in
+   *        the preheader cannot trap, and the stores in the exit blocks do
+   *        not introduce writes on the paths that did not write before.
+   */
+  bool promoteScalars(Loop &L, BasicBlock &Preheader) {
+    // The exit blocks must be dedicated to the loop for the stores in them to
+    // only execute after it.
+    SmallVector<BasicBlock *, 4> ExitBlocks;
+    L.getExitBlocks(ExitBlocks);
+    if (ExitBlocks.empty() || !L.hasDedicatedExits() ||
+        any_of(ExitBlocks, [](const BasicBlock *const ExitBlock) {
+          return ExitBlock->isEHPad();
+        })) {
+      return false;
+    }
+
+    // Group the loads and stores by their pointers, and collect the other
+    // instructions that access memory.
+    MapVector<Value *, SmallVector<Instruction *, 4>> AccessesByPtr;
+    SmallVector<Instruction *, 8> OtherAccesses;
+    for (BasicBlock *const BB : L.blocks()) {
+      for (Instruction &Inst : *BB) {
+        if (!Inst.mayReadOrWriteMemory()) {
+          continue;
+        }
+        Value *const Ptr = getLoadStorePointerOperand(&Inst);
+        if (Ptr && L.isLoopInvariant(Ptr)) {
+          AccessesByPtr[Ptr].push_back(&Inst);
+        } else {
+          OtherAccesses.push_back(&Inst);
+        }
+      }
+    }
+
+    const DataLayout &DL = Preheader.getModule()->getDataLayout();
+    bool Changed = false;
+    for (auto &PtrAccessesPair : AccessesByPtr) {
+      Value *const Ptr = PtrAccessesPair.first;
+      SmallVectorImpl<Instruction *> &Accesses = PtrAccessesPair.second;
+      Type *const Ty = getAccessType(Accesses.front());
+      const MemoryLocation Loc = MemoryLocation::get(Accesses.front());
+
+      bool IsPromotable = true, IsWritten = false, IsDereferenceable = false;
+      Align Alignment = getLoadStoreAlignment(Accesses.front());
+      for (Instruction *const Access : Accesses) {
+        const bool IsSimple = isa<LoadInst>(Access)
+                                  ? cast<LoadInst>(Access)->isSimple()
+                                  : cast<StoreInst>(Access)->isSimple();
+        if (!IsSimple || getAccessType(Access) != Ty) {
+          IsPromotable = false;
+          break;
+        }
+        const bool IsGuaranteedToExecute =
+            isGuaranteedToExecute(*Access->getParent(), L);
+        // The stores in the exit blocks could race with the other threads
+        // unless the loop is guaranteed to write to the location anyway.
+        if (isa<StoreInst>(Access)) {
+          if (!IsGuaranteedToExecute) {
+            IsPromotable = false;
+            break;
+          }
+          IsWritten = true;
+        }
+        IsDereferenceable |= IsGuaranteedToExecute;
+        Alignment = std::min(Alignment, getLoadStoreAlignment(Access));
+      }
+      if (!IsPromotable ||
+          (!IsDereferenceable &&
+           !isSafeToLoadUnconditionally(Ptr, Ty, Alignment, DL,
+                                        Preheader.getTerminator(), DT))) {
+        continue;
+      }
+      // Any other access in the loop that may alias the location, including
+      // those through the other loop-invariant pointers, prevents the
+      // promotion.
+      auto MayAlias = [&](const Instruction *const Inst) {
+        return isModOrRefSet(AA->getModRefInfo(Inst, Loc));
+      };
+      if (any_of(OtherAccesses, MayAlias) ||
+          any_of(AccessesByPtr, [&](const auto &OtherPtrAccessesPair) {
+            return OtherPtrAccessesPair.first != Ptr &&
+                   any_of(OtherPtrAccessesPair.second, MayAlias);
+          })) {
+        continue;
+      }
+
+      SmallVector<PHINode *, 4> NewPHIs;
+      SSAUpdater SSA(&NewPHIs);
+      LoopPromoter Promoter(
+          ArrayRef<const Instruction *>(Accesses.begin(), Accesses.end()),
+          SSA, Ptr, ExitBlocks, Alignment, IsWritten);
+      LoadInst *const PreheaderLoad =
+          new LoadInst(Ty, Ptr, Ptr->getName() + ".promoted",
+                       /*isVolatile=*/false, Alignment,
+                       Preheader.getTerminator());
+      SSA.AddAvailableValue(&Preheader, PreheaderLoad);
+      Promoter.run(Accesses);
+      // The promoted accesses have been deleted, hence they no longer need
+      // to be checked against the other locations.
+      Accesses.clear();
+      Changed = true;
+    }
+    return Changed;
+  }
+
 public:
   static char ID;
 
   LoopInvariantCodeMotion() : LoopPass(ID) {}
 
   virtual void getAnalysisUsage(AnalysisUsage &AU) const override {
-    /**
-     * @todo(cscd70) Request the dominator tree and the loop simplify pass.
-     */
+    AU.addRequired<DominatorTreeWrapperPass>();
+    AU.addRequired<AAResultsWrapperPass>();
+    AU.addRequired<BlockFrequencyInfoWrapperPass>();
+    AU.addRequired<TargetTransformInfoWrapperPass>();
+    AU.addRequiredID(LoopSimplifyID);
     AU.setPreservesCFG();
   }
 
-  /**
-   * @todo(cscd70) Please finish the implementation of this method.
-   */
-  virtual bool runOnLoop(Loop *L, LPPassManager &LPM) override { return false; }
+  virtual bool runOnLoop(Loop *L, LPPassManager &LPM) override {
+    // The loop simplify pass guarantees a preheader unless the loop is
+    // entered through an indirect branch.
+    BasicBlock *const Preheader = L->getLoopPreheader();
+    if (!Preheader) {
+      return false;
+    }
+    DT = &getAnalysis<DominatorTreeWrapperPass>().getDomTree();
+    AA = &getAnalysis<AAResultsWrapperPass>().getAAResults();
+    BFI = &getAnalysis<BlockFrequencyInfoWrapperPass>().getBFI();
+    TTI = &getAnalysis<TargetTransformInfoWrapperPass>().getTTI(
+        *L->getHeader()->getParent());
+    MayStop = any_of(L->blocks(), [](const BasicBlock *const BB) {
+      return any_of(*BB, [](const Instruction &Inst) {
+        return !isGuaranteedToTransferExecutionToSuccessor(&Inst);
+      });
+    });
+
+    // As the loop pass manager visits the inner loops first, the invariants
+    // hoisted into the preheader of an inner loop get hoisted further out of
+    // the enclosing loops. The promotion comes after the hoisting, as the
+    // hoisting makes more pointers loop-invariant.
+    bool Changed = hoistInvariants(*L, *Preheader);
+    if (PromoteScalars) {
+      Changed |= promoteScalars(*L, *Preheader);
+    }
+    return Changed;
+  }
 };
 
 char LoopInvariantCodeMotion::ID = 0;
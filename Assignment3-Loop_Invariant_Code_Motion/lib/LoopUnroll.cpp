@@ -0,0 +1,403 @@
+/**
+ * @file Loop Unrolling
+ */
+#include <llvm/Analysis/LoopPass.h>
+#include <llvm/Analysis/ScalarEvolution.h>
+#include <llvm/IR/Dominators.h>
+#include <llvm/IR/IRBuilder.h>
+#include <llvm/IR/IntrinsicInst.h>
+#include <llvm/Support/CommandLine.h>
+#include <llvm/Transforms/Utils.h>
+#include <llvm/Transforms/Utils/BasicBlockUtils.h>
+#include <llvm/Transforms/Utils/Cloning.h>
+#include <llvm/Transforms/Utils/Local.h>
+#include <llvm/Transforms/Utils/LoopUtils.h>
+#include <llvm/Transforms/Utils/ScalarEvolutionExpander.h>
+
+using namespace llvm;
+
+static cl::opt<unsigned> UnrollThreshold(
+    "unrolling-threshold", cl::init(200),
+    cl::desc("Number of instructions that the body of an unrolled loop may "
+             "have"));
+static cl::opt<unsigned>
+    MaxUnrollCount("unrolling-max-count", cl::init(8),
+                   cl::desc("Largest factor by which to partially unroll"));
+static cl::opt<unsigned> MinSavings(
+    "unrolling-min-savings", cl::init(10),
+    cl::desc("Percentage of the instructions executed by a loop that partial "
+             "unrolling must save"));
+
+namespace {
+
+/// Number of loop control instructions that every iteration of a partially
+/// unrolled loop executes, i.e., the increment and the compare of the
+/// iteration counter, and the branch
+constexpr unsigned RuntimeOverhead = 3;
+
+/**
+ * @brief Unroll the innermost loops that leave through their latch only,
+ *        either fully if their trip count is a small constant, or partially
+ *        by a power of two otherwise:
+ *
+ *     PH:  ...                        PH:  %iters = %tc / U
+ *     L:   <body>                          br %iters == 0, R, L
+ *          br %c, L, Exit      →      L:   <body> ... <body>  ; U times
+ *                                          br ++%niter < %iters, L, L.exit
+ *                                     L.exit:
+ *                                          br %tc % U == 0, Exit, R
+ *                                     R:   <body>             ; the remainder
+ *                                          br %c, R, Exit
+ *
+ * Partial unrolling trades the size of the body for the loop control
+ * instructions of U - 1 out of U iterations, and only pays off if the body is
+ * small enough for them to matter. This pass is meant to run before the loop
+ * invariant code motion and the peephole optimizations, which benefit from
+ * the larger bodies.
+ */
+class LoopUnrolling final : public LoopPass {
+private:
+  LoopInfo *LI;
+  DominatorTree *DT;
+  ScalarEvolution *SE;
+
+  /**
+   * @brief Return the number of instructions of @c L , except for the PHI
+   *        nodes, which the unrolling mostly removes.
+   */
+  static unsigned getSize(const Loop &L) {
+    unsigned Size = 0;
+    for (const BasicBlock *const BB : L.blocks()) {
+      Size += count_if(*BB, [](const Instruction &Inst) {
+        return !isa<PHINode>(Inst) && !isa<DbgInfoIntrinsic>(Inst);
+      });
+    }
+    return Size;
+  }
+  /**
+   * @brief Return the number of instructions of @c L that only decide
+   *        whether to run another iteration, i.e., the branch of the latch,
+   *        and the compare that it is on if nothing else uses it.
+   */
+  static unsigned getControlOverhead(const Loop &L) {
+    const BranchInst *const Br =
+        cast<BranchInst>(L.getLoopLatch()->getTerminator());
+    const Instruction *const Cmp = dyn_cast<Instruction>(Br->getCondition());
+    return Cmp && Cmp->hasOneUse() && L.contains(Cmp) ? 2 : 1;
+  }
+  /**
+   * @brief Whether @c L can be unrolled, i.e., it is an innermost loop in
+   *        simplified form that is only left from its latch, and it may be
+   *        duplicated.
+   */
+  static bool isUnrollable(const Loop &L) {
+    const BasicBlock *const Latch = L.getLoopLatch();
+    if (!L.isInnermost() || !L.getLoopPreheader() || !Latch ||
+        L.getExitingBlock() != Latch || !L.getExitBlock() ||
+        !L.hasDedicatedExits() ||
+        getBooleanLoopAttribute(&L, "llvm.loop.unroll.disable")) {
+      return false;
+    }
+    const BranchInst *const Br = dyn_cast<BranchInst>(Latch->getTerminator());
+    if (!Br || !Br->isConditional()) {
+      return false;
+    }
+    return all_of(L.blocks(), [](const BasicBlock *const BB) {
+      return all_of(*BB, [](const Instruction &Inst) {
+        const CallBase *const Call = dyn_cast<CallBase>(&Inst);
+        return !Call || (!Call->cannotDuplicate() && !Call->isConvergent());
+      });
+    });
+  }
+  /**
+   * @brief Return the largest power of two by which to partially unroll
+   *        @c L , whose trip count is @c TripCount if it is a constant, or 0
+   *        if it does not pay off.
+   */
+  static unsigned getPartialUnrollCount(const Loop &L,
+                                        const unsigned TripCount) {
+    const unsigned Size = getSize(L), Overhead = getControlOverhead(L);
+    for (unsigned Count = PowerOf2Floor(MaxUnrollCount); Count >= 2;
+         Count /= 2) {
+      if (Size * Count > UnrollThreshold ||
+          (TripCount && Count > TripCount)) {
+        continue;
+      }
+      // The instructions saved per iteration of the original loop
+      const double Savings =
+          Overhead - static_cast<double>(RuntimeOverhead) / Count;
+      return Savings * 100 >= MinSavings * Size ? Count : 0;
+    }
+    return 0;
+  }
+
+  /**
+   * @brief Unroll @c L in place, i.e., chain @c Count copies of its body, of
+   *        which all but the last go straight on to the next.
+   * @return the latch of the last copy, which still branches back to the
+   *         header of the first, and to the exit block, whose PHI nodes it
+   *         is the incoming block for
+   */
+  BasicBlock *unrollBody(Loop &L, const unsigned Count) {
+    BasicBlock *const Header = L.getHeader();
+    BasicBlock *const Latch = L.getLoopLatch();
+    Function &F = *Header->getParent();
+    const std::vector<BasicBlock *> Blocks = L.getBlocks();
+    SmallVector<PHINode *, 4> Phis;
+    for (PHINode &Phi : Header->phis()) {
+      Phis.push_back(&Phi);
+    }
+
+    // The values of the instructions of the loop in the last copy so far
+    ValueToValueMapTy LastValues;
+    auto GetLastValue = [&](Value *const V) {
+      Value *const LastValue = LastValues.lookup(V);
+      return LastValue ? LastValue : V;
+    };
+    SmallVector<BasicBlock *, 8> Headers = {Header}, Latches = {Latch};
+    for (unsigned I = 1; I != Count; ++I) {
+      ValueToValueMapTy VMap;
+      SmallVector<BasicBlock *, 16> NewBlocks;
+      for (BasicBlock *const BB : Blocks) {
+        BasicBlock *const NewBB = CloneBasicBlock(BB, VMap, "." + Twine(I), &F);
+        VMap[BB] = NewBB;
+        L.addBasicBlockToLoop(NewBB, *LI);
+        NewBlocks.push_back(NewBB);
+      }
+      // Each copy starts from the values at the end of the previous one.
+      for (PHINode *const Phi : Phis) {
+        cast<PHINode>(VMap[Phi])->eraseFromParent();
+        VMap[Phi] = GetLastValue(Phi->getIncomingValueForBlock(Latch));
+      }
+      remapInstructionsInBlocks(NewBlocks, VMap);
+      for (BasicBlock *const BB : Blocks) {
+        for (Instruction &Inst : *BB) {
+          LastValues[&Inst] = VMap[&Inst];
+        }
+      }
+
+      Headers.push_back(cast<BasicBlock>(VMap[Header]));
+      Latches.push_back(cast<BasicBlock>(VMap[Latch]));
+      Latches.back()->getTerminator()->replaceSuccessorWith(Headers.back(),
+                                                            Header);
+    }
+
+    // The latches of the copies go on to the next, once all of them have
+    // been cloned from the original body.
+    SmallVector<WeakTrackingVH, 8> DeadConds;
+    for (unsigned I = 0; I + 1 != Count; ++I) {
+      BranchInst *const Br = cast<BranchInst>(Latches[I]->getTerminator());
+      DeadConds.push_back(Br->getCondition());
+      ReplaceInstWithInst(Br, BranchInst::Create(Headers[I + 1]));
+    }
+    BasicBlock *const LastLatch = Latches.back();
+
+    for (PHINode *const Phi : Phis) {
+      const int Index = Phi->getBasicBlockIndex(Latch);
+      Phi->setIncomingValue(Index, GetLastValue(Phi->getIncomingValue(Index)));
+      Phi->setIncomingBlock(Index, LastLatch);
+    }
+    for (PHINode &Phi : L.getExitBlock()->phis()) {
+      const int Index = Phi.getBasicBlockIndex(Latch);
+      Phi.setIncomingValue(Index, GetLastValue(Phi.getIncomingValue(Index)));
+      Phi.setIncomingBlock(Index, LastLatch);
+    }
+    for (WeakTrackingVH &Cond : DeadConds) {
+      if (Cond) {
+        RecursivelyDeleteTriviallyDeadInstructions(Cond);
+      }
+    }
+    return LastLatch;
+  }
+  /**
+   * @brief Unroll @c L , which runs @c TripCount iterations, fully.
+   */
+  void unrollFully(Loop &L, const unsigned TripCount, LPPassManager &LPM) {
+    BasicBlock *const Preheader = L.getLoopPreheader();
+    BasicBlock *const Header = L.getHeader();
+    BasicBlock *const ExitBlock = L.getExitBlock();
+    Function &F = *Header->getParent();
+
+    BasicBlock *const LastLatch = unrollBody(L, TripCount);
+    Value *const Cond =
+        cast<BranchInst>(LastLatch->getTerminator())->getCondition();
+    ReplaceInstWithInst(LastLatch->getTerminator(),
+                        BranchInst::Create(ExitBlock));
+    RecursivelyDeleteTriviallyDeadInstructions(Cond);
+    for (PHINode &Phi : make_early_inc_range(Header->phis())) {
+      Phi.replaceAllUsesWith(Phi.getIncomingValueForBlock(Preheader));
+      Phi.eraseFromParent();
+    }
+    LPM.markLoopAsDeleted(L);
+    LI->erase(&L);
+    DT->recalculate(F);
+  }
+  /**
+   * @brief Unroll @c L , which runs @c TripCount iterations, partially by
+   *        @c Count , which is a power of two, and run the remaining
+   *        iterations in a copy of @c L .
+   */
+  void unrollWithRemainder(Loop &L, const unsigned Count,
+                           Value *const TripCount, LPPassManager &LPM) {
+    BasicBlock *const Preheader = L.getLoopPreheader();
+    BasicBlock *const Header = L.getHeader();
+    BasicBlock *const Latch = L.getLoopLatch();
+    BasicBlock *const ExitBlock = L.getExitBlock();
+    Function &F = *Header->getParent();
+    LLVMContext &Ctx = F.getContext();
+    Type *const Ty = TripCount->getType();
+
+    IRBuilder<> Builder(Preheader->getTerminator());
+    Value *const NumIters =
+        Builder.CreateLShr(TripCount, Log2_32(Count), "unroll.iters");
+    Value *const NumRemaining =
+        Builder.CreateAnd(TripCount, Count - 1, "unroll.remaining");
+    BasicBlock *const UnrolledPreheader =
+        SplitBlock(Preheader, Preheader->getTerminator(), DT, LI);
+
+    // The remainder loop is a copy of the loop as it was.
+    ValueToValueMapTy VMap;
+    SmallVector<BasicBlock *, 16> RemainderBlocks;
+    Loop *const Remainder =
+        cloneLoopWithPreheader(UnrolledPreheader, Preheader, &L, VMap, ".rem",
+                               LI, DT, RemainderBlocks);
+    remapInstructionsInBlocks(RemainderBlocks, VMap);
+    BasicBlock *const RemainderPreheader = Remainder->getLoopPreheader();
+    for (PHINode &Phi : ExitBlock->phis()) {
+      Value *const V = Phi.getIncomingValueForBlock(Latch);
+      Value *const RemainderV = VMap.lookup(V);
+      Phi.addIncoming(RemainderV ? RemainderV : V,
+                      cast<BasicBlock>(VMap[Latch]));
+    }
+
+    // The unrolled loop counts its iterations, and leaves through a new exit
+    // block.
+    BasicBlock *const LastLatch = unrollBody(L, Count);
+    BasicBlock *const UnrolledExit =
+        BasicBlock::Create(Ctx, "unroll.exit", &F, RemainderPreheader);
+    if (Loop *const ParentLoop = L.getParentLoop()) {
+      ParentLoop->addBasicBlockToLoop(UnrolledExit, *LI);
+    }
+    PHINode *const NumDone =
+        PHINode::Create(Ty, 2, "unroll.niter", &Header->front());
+    Builder.SetInsertPoint(LastLatch->getTerminator());
+    Value *const NextNumDone = Builder.CreateAdd(
+        NumDone, ConstantInt::get(Ty, 1), "unroll.niter.next");
+    NumDone->addIncoming(ConstantInt::get(Ty, 0), UnrolledPreheader);
+    NumDone->addIncoming(NextNumDone, LastLatch);
+    BranchInst *const OldBr = cast<BranchInst>(LastLatch->getTerminator());
+    BranchInst *const NewBr = Builder.CreateCondBr(
+        Builder.CreateICmpULT(NextNumDone, NumIters, "unroll.more"), Header,
+        UnrolledExit);
+    NewBr->setMetadata(LLVMContext::MD_loop,
+                       OldBr->getMetadata(LLVMContext::MD_loop));
+    Value *const OldCond = OldBr->getCondition();
+    OldBr->eraseFromParent();
+    RecursivelyDeleteTriviallyDeadInstructions(OldCond);
+    for (PHINode &Phi : ExitBlock->phis()) {
+      Phi.setIncomingBlock(Phi.getBasicBlockIndex(LastLatch), UnrolledExit);
+    }
+
+    // The remainder loop runs at least once, hence only if there are
+    // iterations left, and starts from where the unrolled loop stops, if it
+    // runs at all.
+    Builder.SetInsertPoint(UnrolledExit);
+    Builder.CreateCondBr(Builder.CreateICmpEQ(NumRemaining,
+                                              ConstantInt::get(Ty, 0),
+                                              "unroll.done"),
+                         ExitBlock, RemainderPreheader);
+    Builder.SetInsertPoint(Preheader->getTerminator());
+    ReplaceInstWithInst(
+        Preheader->getTerminator(),
+        BranchInst::Create(
+            RemainderPreheader, UnrolledPreheader,
+            Builder.CreateICmpEQ(NumIters, ConstantInt::get(Ty, 0),
+                                 "unroll.skip")));
+    for (PHINode &Phi : Header->phis()) {
+      if (&Phi == NumDone) {
+        continue;
+      }
+      PHINode *const RemainderPhi = cast<PHINode>(VMap[&Phi]);
+      const int Index = RemainderPhi->getBasicBlockIndex(RemainderPreheader);
+      PHINode *const Start =
+          PHINode::Create(Phi.getType(), 2, Phi.getName() + ".start",
+                          &RemainderPreheader->front());
+      Start->addIncoming(RemainderPhi->getIncomingValue(Index), Preheader);
+      Start->addIncoming(Phi.getIncomingValueForBlock(LastLatch),
+                         UnrolledExit);
+      RemainderPhi->setIncomingValue(Index, Start);
+    }
+
+    DT->recalculate(F);
+    formDedicatedExitBlocks(Remainder, DT, LI, /*MSSAU=*/nullptr,
+                            /*PreserveLCSSA=*/true);
+    formLCSSARecursively(L, *DT, LI, SE);
+    L.setLoopAlreadyUnrolled();
+    Remainder->setLoopAlreadyUnrolled();
+    LPM.addLoop(*Remainder);
+  }
+
+public:
+  static char ID;
+
+  LoopUnrolling() : LoopPass(ID) {}
+
+  virtual void getAnalysisUsage(AnalysisUsage &AU) const override {
+    AU.addRequired<DominatorTreeWrapperPass>();
+    AU.addPreserved<DominatorTreeWrapperPass>();
+    AU.addRequired<LoopInfoWrapperPass>();
+    AU.addPreserved<LoopInfoWrapperPass>();
+    AU.addRequired<ScalarEvolutionWrapperPass>();
+    AU.addPreserved<ScalarEvolutionWrapperPass>();
+    AU.addRequiredID(LoopSimplifyID);
+    AU.addPreservedID(LoopSimplifyID);
+    AU.addRequiredID(LCSSAID);
+    AU.addPreservedID(LCSSAID);
+  }
+
+  virtual bool runOnLoop(Loop *L, LPPassManager &LPM) override {
+    if (!isUnrollable(*L)) {
+      return false;
+    }
+    LI = &getAnalysis<LoopInfoWrapperPass>().getLoopInfo();
+    DT = &getAnalysis<DominatorTreeWrapperPass>().getDomTree();
+    SE = &getAnalysis<ScalarEvolutionWrapperPass>().getSE();
+    const std::string Name = (L->getHeader()->getParent()->getName() + ", " +
+                              L->getHeader()->getName())
+                                 .str();
+
+    const unsigned TripCount = SE->getSmallConstantTripCount(L);
+    if (TripCount && getSize(*L) * TripCount <= UnrollThreshold) {
+      SE->forgetLoop(L);
+      unrollFully(*L, TripCount, LPM);
+      errs() << "Full Unroll Count (" << Name << "): " << TripCount << "\n";
+      return true;
+    }
+    const unsigned Count = getPartialUnrollCount(*L, TripCount);
+    const SCEV *const BackedgeTakenCount = SE->getBackedgeTakenCount(L);
+    if (!Count || isa<SCEVCouldNotCompute>(BackedgeTakenCount)) {
+      return false;
+    }
+    // The trip count may wrap around to 0, in which case the remainder loop
+    // runs all the iterations.
+    const SCEV *const TripCountSCEV = SE->getAddExpr(
+        BackedgeTakenCount, SE->getOne(BackedgeTakenCount->getType()));
+    if (!isSafeToExpand(TripCountSCEV, *SE)) {
+      return false;
+    }
+    SCEVExpander Expander(*SE, L->getHeader()->getModule()->getDataLayout(),
+                          "unroll");
+    Value *const TripCountV = Expander.expandCodeFor(
+        TripCountSCEV, TripCountSCEV->getType(),
+        L->getLoopPreheader()->getTerminator());
+    SE->forgetLoop(L);
+    unrollWithRemainder(*L, Count, TripCountV, LPM);
+    errs() << "Runtime Unroll Count (" << Name << "): " << Count << "\n";
+    return true;
+  }
+};
+
+char LoopUnrolling::ID = 0;
+RegisterPass<LoopUnrolling> X("loop-unrolling", "Loop Unrolling");
+
+} // anonymous namespace
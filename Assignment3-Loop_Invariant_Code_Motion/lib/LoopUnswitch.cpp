@@ -0,0 +1,303 @@
+/**
+ * @file Loop Unswitching
+ */
+#include <llvm/ADT/DenseMap.h>
+#include <llvm/ADT/SmallPtrSet.h>
+#include <llvm/Analysis/LoopPass.h>
+#include <llvm/Analysis/ValueTracking.h>
+#include <llvm/IR/Dominators.h>
+#include <llvm/IR/IRBuilder.h>
+#include <llvm/IR/IntrinsicInst.h>
+#include <llvm/Support/CommandLine.h>
+#include <llvm/Transforms/Utils.h>
+#include <llvm/Transforms/Utils/BasicBlockUtils.h>
+#include <llvm/Transforms/Utils/Cloning.h>
+#include <llvm/Transforms/Utils/LoopUtils.h>
+
+using namespace llvm;
+
+static cl::opt<unsigned> SizeBudget(
+    "unswitching-size-budget", cl::init(200),
+    cl::desc("Number of instructions by which the unswitching may grow each "
+             "function"));
+
+namespace {
+
+/**
+ * @brief Move the loop-invariant conditions of the branches and switches in
+ *        front of the loop, by cloning the loop for each outcome:
+ *
+ *     PH:   br L                         PH:   br %c, L, L.us
+ *     L:    ...                          L:    ...; br true, T, F
+ *           br %c, T, F           →      ...
+ *     ...                                L.us: ...; br false, T.us, F.us
+ *                                        ...
+ *
+ * and, for a switch, with one version per case that does not go to the
+ * default destination. The branches on constants are left for the CFG
+ * simplification to fold, along with the blocks that they make dead.
+ */
+class LoopUnswitching final : public LoopPass {
+private:
+  LoopInfo *LI;
+  DominatorTree *DT;
+  /// Number of instructions added to each function so far
+  DenseMap<const Function *, unsigned> Growths;
+
+  /**
+   * @brief Return the number of instructions of @c L .
+   */
+  static unsigned getSize(const Loop &L) {
+    unsigned Size = 0;
+    for (const BasicBlock *const BB : L.blocks()) {
+      Size += count_if(*BB, [](const Instruction &Inst) {
+        return !isa<DbgInfoIntrinsic>(Inst);
+      });
+    }
+    return Size;
+  }
+  /**
+   * @brief Return the blocks of @c L that may execute, i.e., that are
+   *        reachable from its header without going through an edge that a
+   *        branch on a constant never takes.
+   */
+  static SmallPtrSet<const BasicBlock *, 16> getLiveBlocks(const Loop &L) {
+    SmallPtrSet<const BasicBlock *, 16> LiveBlocks;
+    SmallVector<const BasicBlock *, 16> WorkList = {L.getHeader()};
+    LiveBlocks.insert(L.getHeader());
+    while (!WorkList.empty()) {
+      const Instruction *const Term = WorkList.pop_back_val()->getTerminator();
+      SmallVector<const BasicBlock *, 4> Succs(successors(Term));
+      const BranchInst *const Br = dyn_cast<BranchInst>(Term);
+      const SwitchInst *const Switch = dyn_cast<SwitchInst>(Term);
+      if (Br && Br->isConditional()) {
+        if (const ConstantInt *const C =
+                dyn_cast<ConstantInt>(Br->getCondition())) {
+          Succs = {Br->getSuccessor(C->isZero())};
+        }
+      } else if (Switch) {
+        if (ConstantInt *const C =
+                dyn_cast<ConstantInt>(Switch->getCondition())) {
+          Succs = {Switch->findCaseValue(C)->getCaseSuccessor()};
+        }
+      }
+      for (const BasicBlock *const Succ : Succs) {
+        if (L.contains(Succ) && LiveBlocks.insert(Succ).second) {
+          WorkList.push_back(Succ);
+        }
+      }
+    }
+    return LiveBlocks;
+  }
+  /**
+   * @brief Return the outcomes of @c Term , i.e., its distinct successors
+   *        along with a condition that leads to each of them, or none if it
+   *        is neither a conditional branch nor a switch.
+   */
+  static SmallVector<std::pair<BasicBlock *, ConstantInt *>, 4>
+  getOutcomes(Instruction &Term) {
+    SmallVector<std::pair<BasicBlock *, ConstantInt *>, 4> Outcomes;
+    if (BranchInst *const Br = dyn_cast<BranchInst>(&Term)) {
+      if (Br->isConditional() && Br->getSuccessor(0) != Br->getSuccessor(1)) {
+        LLVMContext &Ctx = Br->getContext();
+        Outcomes.emplace_back(Br->getSuccessor(0), ConstantInt::getTrue(Ctx));
+        Outcomes.emplace_back(Br->getSuccessor(1),
+                              ConstantInt::getFalse(Ctx));
+      }
+    } else if (SwitchInst *const Switch = dyn_cast<SwitchInst>(&Term)) {
+      SmallPtrSet<const BasicBlock *, 4> Succs;
+      for (const SwitchInst::CaseHandle &Case : Switch->cases()) {
+        if (Succs.insert(Case.getCaseSuccessor()).second) {
+          Outcomes.emplace_back(Case.getCaseSuccessor(), Case.getCaseValue());
+        }
+      }
+      // Unless a case goes to the default destination, find a value that
+      // none of them matches, if there is one.
+      // The bound is an APInt, as the condition may be wider than 64 bits.
+      IntegerType *const Ty =
+          cast<IntegerType>(Switch->getCondition()->getType());
+      const APInt MaxValue = APInt::getMaxValue(Ty->getBitWidth());
+      for (uint64_t V = 0; !Succs.count(Switch->getDefaultDest()) &&
+                           V <= Switch->getNumCases() && MaxValue.uge(V);
+           ++V) {
+        ConstantInt *const C = ConstantInt::get(Ty, V);
+        if (Switch->findCaseValue(C) == Switch->case_default()) {
+          Succs.insert(Switch->getDefaultDest());
+          Outcomes.emplace_back(Switch->getDefaultDest(), C);
+        }
+      }
+    }
+    return Outcomes;
+  }
+
+  /**
+   * @brief Return a branch or a switch of @c L (rather than of one of its
+   *        inner loops) with several outcomes and a loop-invariant condition,
+   *        after hoisting the condition into the preheader if need be, or
+   *        nullptr if there is none.
+   * @param Changed set if a condition has been hoisted
+   */
+  Instruction *findCandidate(Loop &L, bool &Changed) const {
+    const SmallPtrSet<const BasicBlock *, 16> LiveBlocks = getLiveBlocks(L);
+    for (BasicBlock *const BB : L.blocks()) {
+      if (!LiveBlocks.count(BB) || LI->getLoopFor(BB) != &L) {
+        continue;
+      }
+      Instruction *const Term = BB->getTerminator();
+      if (getOutcomes(*Term).size() < 2) {
+        continue;
+      }
+      // The condition is the first operand of both.
+      Value *const Cond = Term->getOperand(0);
+      if (!isa<Constant>(Cond) && L.makeLoopInvariant(Cond, Changed)) {
+        return Term;
+      }
+    }
+    return nullptr;
+  }
+  /**
+   * @brief Unswitch @c Term out of @c L , which is kept for its first
+   *        outcome, and cloned for each of the others.
+   */
+  void unswitch(Loop &L, Instruction &Term, LPPassManager &LPM) {
+    Function &F = *L.getHeader()->getParent();
+    SwitchInst *const Switch = dyn_cast<SwitchInst>(&Term);
+    Value *const Cond = Term.getOperand(0);
+    const SmallVector<std::pair<BasicBlock *, ConstantInt *>, 4> Outcomes =
+        getOutcomes(Term);
+
+    // The test goes into the current preheader, and the loop is entered
+    // through a new one, which gets cloned along with the loop.
+    BasicBlock *const TestBB = L.getLoopPreheader();
+    SmallVector<BasicBlock *, 4> Preheaders = {
+        SplitBlock(TestBB, TestBB->getTerminator(), DT, LI)};
+    SmallVector<Loop *, 4> Versions = {&L};
+    SmallVector<BasicBlock *, 4> ExitBlocks;
+    L.getUniqueExitBlocks(ExitBlocks);
+    for (unsigned I = 1; I != Outcomes.size(); ++I) {
+      ValueToValueMapTy VMap;
+      SmallVector<BasicBlock *, 16> ClonedBlocks;
+      Loop *const ClonedLoop = cloneLoopWithPreheader(
+          Preheaders.front(), TestBB, &L, VMap, ".us", LI, DT, ClonedBlocks);
+      remapInstructionsInBlocks(ClonedBlocks, VMap);
+      Preheaders.push_back(ClonedLoop->getLoopPreheader());
+      Versions.push_back(ClonedLoop);
+
+      // All the versions leave through the same exit blocks, in which the
+      // loop closed SSA form has a PHI node for every value used after the
+      // loop.
+      for (BasicBlock *const ExitBlock : ExitBlocks) {
+        for (PHINode &Phi : ExitBlock->phis()) {
+          for (unsigned J = 0, E = Phi.getNumIncomingValues(); J != E; ++J) {
+            BasicBlock *const Pred = Phi.getIncomingBlock(J);
+            if (!L.contains(Pred)) {
+              continue;
+            }
+            Value *const V = Phi.getIncomingValue(J);
+            Value *const ClonedV = VMap.lookup(V);
+            Phi.addIncoming(ClonedV ? ClonedV : V,
+                            cast<BasicBlock>(VMap[Pred]));
+          }
+        }
+      }
+      cast<Instruction>(VMap[&Term])->setOperand(0, Outcomes[I].second);
+    }
+    Term.setOperand(0, Outcomes.front().second);
+
+    // The test now executes even if the loop would not have reached the
+    // branch or the switch, in which case it must not be on poison.
+    IRBuilder<> Builder(TestBB->getTerminator());
+    Value *Test = Cond;
+    if (!isGuaranteedNotToBeUndefOrPoison(Cond)) {
+      Test = Builder.CreateFreeze(Cond, Cond->getName() + ".fr");
+    }
+    if (!Switch) {
+      Builder.CreateCondBr(Test, Preheaders[0], Preheaders[1]);
+    } else {
+      // The cases that go to the same block go to the same version, and
+      // the default destination, if no version is for it, cannot be reached.
+      auto GetPreheader = [&](const BasicBlock *const Succ) {
+        for (unsigned I = 0; I != Outcomes.size(); ++I) {
+          if (Outcomes[I].first == Succ) {
+            return Preheaders[I];
+          }
+        }
+        return Preheaders.front();
+      };
+      SwitchInst *const TestSwitch =
+          Builder.CreateSwitch(Test, GetPreheader(Switch->getDefaultDest()),
+                               Switch->getNumCases());
+      for (const SwitchInst::CaseHandle &Case : Switch->cases()) {
+        TestSwitch->addCase(Case.getCaseValue(),
+                            GetPreheader(Case.getCaseSuccessor()));
+      }
+    }
+    TestBB->getTerminator()->eraseFromParent();
+
+    // The exit blocks are no longer dominated by the loop, and no longer
+    // dedicated to it.
+    DT->recalculate(F);
+    for (Loop *const Version : Versions) {
+      formDedicatedExitBlocks(Version, DT, LI, /*MSSAU=*/nullptr,
+                              /*PreserveLCSSA=*/true);
+      if (Version != &L) {
+        LPM.addLoop(*Version);
+      }
+    }
+  }
+
+public:
+  static char ID;
+
+  LoopUnswitching() : LoopPass(ID) {}
+
+  virtual void getAnalysisUsage(AnalysisUsage &AU) const override {
+    AU.addRequired<DominatorTreeWrapperPass>();
+    AU.addPreserved<DominatorTreeWrapperPass>();
+    AU.addRequired<LoopInfoWrapperPass>();
+    AU.addPreserved<LoopInfoWrapperPass>();
+    AU.addRequiredID(LoopSimplifyID);
+    AU.addPreservedID(LoopSimplifyID);
+    AU.addRequiredID(LCSSAID);
+    AU.addPreservedID(LCSSAID);
+  }
+
+  virtual bool runOnLoop(Loop *L, LPPassManager &LPM) override {
+    if (!L->getLoopPreheader() || !L->hasDedicatedExits()) {
+      return false;
+    }
+    LI = &getAnalysis<LoopInfoWrapperPass>().getLoopInfo();
+    DT = &getAnalysis<DominatorTreeWrapperPass>().getDomTree();
+    const Function &F = *L->getHeader()->getParent();
+    unsigned &Growth = Growths[&F];
+
+    // Each unswitching turns a condition of all the versions into a
+    // constant, and the loop pass manager visits the clones afterwards.
+    bool Changed = false;
+    unsigned NumUnswitched = 0, LoopGrowth = 0;
+    while (Instruction *const Term = findCandidate(*L, Changed)) {
+      const unsigned Size = getSize(*L) * (getOutcomes(*Term).size() - 1);
+      if (Growth + Size > SizeBudget) {
+        break;
+      }
+      unswitch(*L, *Term, LPM);
+      Growth += Size;
+      LoopGrowth += Size;
+      ++NumUnswitched;
+      Changed = true;
+    }
+    if (NumUnswitched) {
+      const std::string Name =
+          (F.getName() + ", " + L->getHeader()->getName()).str();
+      errs() << "Unswitched Conditions (" << Name << "): " << NumUnswitched
+             << "\n"
+             << "Code Size Growth (" << Name << "): " << LoopGrowth << "\n";
+    }
+    return Changed;
+  }
+};
+
+char LoopUnswitching::ID = 0;
+RegisterPass<LoopUnswitching> X("loop-unswitching", "Loop Unswitching");
+
+} // anonymous namespace
@@ -0,0 +1,630 @@
+/**
+ * @file Loop Vectorization
+ */
+#include <llvm/ADT/DenseMap.h>
+#include <llvm/Analysis/AliasAnalysis.h>
+#include <llvm/Analysis/LoopPass.h>
+#include <llvm/Analysis/ScalarEvolution.h>
+#include <llvm/Analysis/ScalarEvolutionExpressions.h>
+#include <llvm/Analysis/TargetTransformInfo.h>
+#include <llvm/IR/Dominators.h>
+#include <llvm/IR/IRBuilder.h>
+#include <llvm/IR/IntrinsicInst.h>
+#include <llvm/Support/CommandLine.h>
+#include <llvm/Transforms/Utils.h>
+#include <llvm/Transforms/Utils/BasicBlockUtils.h>
+#include <llvm/Transforms/Utils/LoopUtils.h>
+#include <llvm/Transforms/Utils/ScalarEvolutionExpander.h>
+
+using namespace llvm;
+
+static cl::opt<unsigned> VectorWidth(
+    "vectorization-width", cl::init(0),
+    cl::desc("Number of bits of the vectors that the loops are widened to, "
+             "or 0 for that of the target"));
+static cl::opt<unsigned> MaxRuntimeChecks(
+    "vectorization-max-runtime-checks", cl::init(8),
+    cl::desc("Number of pointer overlap checks that a vectorized loop may "
+             "need before it runs"));
+
+namespace {
+
+/**
+ * @brief Vectorize the innermost loops that consist of a single block, i.e.,
+ *        run VF iterations at once with vector instructions for as long as
+ *        at least VF of them are left, and the rest with the original loop:
+ *
+ *     PH:  ...                    PH:  br %tc < VF || <overlap>, SPH, VPH
+ *     L:   <body>                 VPH: ...
+ *          br %c, L, Exit    →    VL:  <body on VF lanes>
+ *                                      br %index + VF != %tc & -VF, VL, M
+ *                                 M:   br %tc == %tc & -VF, Exit, SPH
+ *                                 SPH: ...
+ *                                 L:   <body>             ; the epilogue
+ *                                      br %c, L, Exit
+ *
+ * The loads and the stores must access consecutive elements from one
+ * iteration to the next, and the values used after the loop must be the
+ * results of reductions. If alias analysis cannot tell apart the memory that
+ * two of the accesses touch, and neither can their constant distance, the
+ * vectorized loop only runs if their address ranges do not overlap.
+ */
+class LoopVectorization final : public LoopPass {
+private:
+  LoopInfo *LI;
+  DominatorTree *DT;
+  ScalarEvolution *SE;
+  AAResults *AA;
+  const TargetTransformInfo *TTI;
+  /// The number of iterations that the vectorized loop runs at once
+  unsigned VF;
+  /// The number of iterations of the loop, which wraps around to 0 if the
+  /// backedge taken count is the largest value of its type
+  const SCEV *TripCount;
+  /// The recurrences of the induction variables, and of the addresses of the
+  /// loads and stores
+  DenseMap<const Value *, const SCEVAddRecExpr *> Recurrences;
+  /// The PHI nodes of the header that accumulate a reduction
+  SmallVector<PHINode *, 4> Reductions;
+  /// The loads and stores, in program order
+  SmallVector<Instruction *, 8> Accesses;
+  /// The instructions that compute the values of the vectorized loop, rather
+  /// than its addresses or its control flow
+  SmallPtrSet<const Instruction *, 16> Widened;
+  /// The pairs of loads and stores whose address ranges must not overlap
+  SmallVector<std::pair<Instruction *, Instruction *>, 8> OverlapChecks;
+
+  /**
+   * @brief Return the affine recurrence of @c L that @c V evaluates to, or
+   *        null if it is not one.
+   */
+  const SCEVAddRecExpr *getAffineRecurrence(Value &V, const Loop &L) const {
+    if (!SE->isSCEVable(V.getType())) {
+      return nullptr;
+    }
+    const SCEVAddRecExpr *const AR =
+        dyn_cast<SCEVAddRecExpr>(SE->getSCEV(&V));
+    return AR && AR->getLoop() == &L && AR->isAffine() ? AR : nullptr;
+  }
+  /**
+   * @brief Return the value of the affine recurrence @c AR at the iteration
+   *        @c Iteration , which is taken as unsigned.
+   */
+  const SCEV *evaluateAt(const SCEVAddRecExpr &AR,
+                         const SCEV *const Iteration) const {
+    const SCEV *const Step = AR.getStepRecurrence(*SE);
+    return SE->getAddExpr(
+        AR.getStart(),
+        SE->getMulExpr(SE->getTruncateOrZeroExtend(Iteration, Step->getType()),
+                       Step));
+  }
+  /**
+   * @brief Whether vectors of @c Ty may be loaded and stored, i.e., its
+   *        values take up exactly their size in memory.
+   */
+  static bool isElementType(Type *const Ty, const DataLayout &DL) {
+    return (Ty->isIntegerTy() || Ty->isFloatingPointTy()) &&
+           DL.getTypeSizeInBits(Ty) == DL.getTypeAllocSizeInBits(Ty);
+  }
+  static Type *getAccessType(const Instruction &Access) {
+    return isa<StoreInst>(Access)
+               ? cast<StoreInst>(Access).getValueOperand()->getType()
+               : Access.getType();
+  }
+  /**
+   * @brief Whether @c Phi , whose loop consists of a single block, is only
+   *        used by an associative and commutative operation, whose result
+   *        is in turn only used by @c Phi and after the loop.
+   */
+  static bool isReduction(const PHINode &Phi, const Loop &L) {
+    const Instruction *const Op =
+        dyn_cast<Instruction>(Phi.getIncomingValueForBlock(L.getLoopLatch()));
+    if (!Op || !L.contains(Op) || !isa<BinaryOperator>(Op) ||
+        !Op->isAssociative() || !Op->isCommutative() || !Phi.hasOneUse() ||
+        Phi.user_back() != Op) {
+      return false;
+    }
+    return all_of(Op->users(), [&](const User *const U) {
+      return U == &Phi || !L.contains(cast<Instruction>(U));
+    });
+  }
+  bool isReductionResult(const Value &V, const Loop &L) const {
+    return any_of(Reductions, [&](const PHINode *const Phi) {
+      return Phi->getIncomingValueForBlock(L.getLoopLatch()) == &V;
+    });
+  }
+  /**
+   * @brief Whether @c Inst has a counterpart that computes its values for VF
+   *        iterations at once.
+   */
+  bool isWidenable(const Instruction &Inst) const {
+    if (isa<LoadInst>(Inst) || isa<StoreInst>(Inst)) {
+      // The accesses have been checked to be consecutive.
+      return true;
+    }
+    Type *const Ty = Inst.getType();
+    if (!Ty->isIntegerTy() && !Ty->isFloatingPointTy()) {
+      return false;
+    }
+    if (const PHINode *const Phi = dyn_cast<PHINode>(&Inst)) {
+      // The lanes of an induction variable are steps apart.
+      return is_contained(Reductions, Phi) ||
+             (Ty->isIntegerTy() &&
+              isa<SCEVConstant>(Recurrences.lookup(Phi)->getStepRecurrence(
+                  *SE)));
+    }
+    if (const CastInst *const Cast = dyn_cast<CastInst>(&Inst)) {
+      Type *const SrcTy = Cast->getSrcTy();
+      return SrcTy->isIntegerTy() || SrcTy->isFloatingPointTy();
+    }
+    return isa<BinaryOperator>(Inst) || isa<CmpInst>(Inst) ||
+           isa<SelectInst>(Inst);
+  }
+
+  /**
+   * @brief Collect the induction variables, the reductions and the accesses
+   *        of @c L , and the instructions to widen.
+   * @return whether @c L can be vectorized, regardless of its dependences
+   */
+  bool analyzeLoop(const Loop &L) {
+    BasicBlock *const BB = L.getHeader();
+    const DataLayout &DL = BB->getModule()->getDataLayout();
+    for (PHINode &Phi : BB->phis()) {
+      if (isReduction(Phi, L)) {
+        Reductions.push_back(&Phi);
+      } else if (const SCEVAddRecExpr *const AR =
+                     getAffineRecurrence(Phi, L)) {
+        Recurrences[&Phi] = AR;
+      } else {
+        return false;
+      }
+    }
+
+    SmallVector<Instruction *, 16> Worklist;
+    for (Instruction &Inst : *BB) {
+      if (isa<DbgInfoIntrinsic>(Inst)) {
+        continue;
+      }
+      if (isa<LoadInst>(Inst) || isa<StoreInst>(Inst)) {
+        const SCEVAddRecExpr *const AR =
+            getAffineRecurrence(*getLoadStorePointerOperand(&Inst), L);
+        Type *const Ty = getAccessType(Inst);
+        if (!AR || !isElementType(Ty, DL) || Inst.isVolatile() ||
+            Inst.isAtomic() ||
+            AR->getStepRecurrence(*SE) !=
+                SE->getConstant(AR->getStepRecurrence(*SE)->getType(),
+                                DL.getTypeAllocSize(Ty))) {
+          return false;
+        }
+        Recurrences[&Inst] = AR;
+        Accesses.push_back(&Inst);
+        if (isa<StoreInst>(Inst)) {
+          Worklist.push_back(&Inst);
+        }
+      } else if (Inst.mayReadOrWriteMemory() || Inst.mayHaveSideEffects()) {
+        return false;
+      }
+      const bool IsUsedAfterLoop = any_of(Inst.users(), [&](const User *U) {
+        return !L.contains(cast<Instruction>(U));
+      });
+      if (IsUsedAfterLoop && !isReductionResult(Inst, L)) {
+        return false;
+      }
+    }
+    for (PHINode *const Phi : Reductions) {
+      Worklist.push_back(
+          cast<Instruction>(Phi->getIncomingValueForBlock(L.getLoopLatch())));
+    }
+
+    // Everything that the stores and the reductions compute from is
+    // widened, except for the addresses, which only the first lane needs.
+    while (!Worklist.empty()) {
+      Instruction *const Inst = Worklist.pop_back_val();
+      if (!L.contains(Inst) || !Widened.insert(Inst).second) {
+        continue;
+      }
+      if (!isWidenable(*Inst)) {
+        return false;
+      }
+      if (isa<StoreInst>(Inst)) {
+        if (Instruction *const Stored = dyn_cast<Instruction>(
+                cast<StoreInst>(Inst)->getValueOperand())) {
+          Worklist.push_back(Stored);
+        }
+      } else if (!isa<PHINode>(Inst) && !isa<LoadInst>(Inst)) {
+        for (Value *const Op : Inst->operands()) {
+          if (Instruction *const OpInst = dyn_cast<Instruction>(Op)) {
+            Worklist.push_back(OpInst);
+          }
+        }
+      }
+    }
+    return true;
+  }
+  /**
+   * @brief Return the number of iterations to run at once, such that the
+   *        widest of the widened values fills a vector, or 0 if it is too
+   *        wide for there to be more than one.
+   */
+  unsigned getVectorizationFactor(const Loop &L) const {
+    const DataLayout &DL = L.getHeader()->getModule()->getDataLayout();
+    uint64_t WidestBits = 0;
+    for (const Instruction *const Inst : Widened) {
+      Type *const Ty = isa<StoreInst>(Inst) ? getAccessType(*Inst)
+                       : isa<CmpInst>(Inst) ? Inst->getOperand(0)->getType()
+                                            : Inst->getType();
+      WidestBits = std::max<uint64_t>(WidestBits, DL.getTypeSizeInBits(Ty));
+    }
+    const unsigned Width =
+        VectorWidth ? VectorWidth
+                    : TTI->getLoadStoreVecRegBitWidth(/*AddrSpace=*/0);
+    return WidestBits && Width / WidestBits >= 2
+               ? PowerOf2Floor(Width / WidestBits)
+               : 0;
+  }
+  /**
+   * @brief Check that running VF iterations at once preserves the order of
+   *        every load and store with respect to the stores that may access
+   *        the same memory, or find which pairs of them to check at runtime
+   *        for that.
+   * @return whether the dependences allow the vectorization
+   */
+  bool checkDependences() {
+    for (auto First = Accesses.begin(); First != Accesses.end(); ++First) {
+      for (auto Second = std::next(First); Second != Accesses.end();
+           ++Second) {
+        if (isa<LoadInst>(*First) && isa<LoadInst>(*Second)) {
+          continue;
+        }
+        Value *const FirstPtr = getLoadStorePointerOperand(*First);
+        Value *const SecondPtr = getLoadStorePointerOperand(*Second);
+        if (AA->isNoAlias(MemoryLocation::getBeforeOrAfter(FirstPtr),
+                          MemoryLocation::getBeforeOrAfter(SecondPtr))) {
+          continue;
+        }
+        const SCEVAddRecExpr *const FirstAR = Recurrences.lookup(*First);
+        const SCEVAddRecExpr *const SecondAR = Recurrences.lookup(*Second);
+        const SCEVConstant *const Distance = dyn_cast<SCEVConstant>(
+            SE->getMinusSCEV(FirstAR->getStart(), SecondAR->getStart()));
+        if (Distance) {
+          // The vectorized loop runs the first access for all the lanes
+          // before the second, which is only wrong if the second accessed
+          // the same memory in an earlier iteration among the same VF.
+          const SCEVConstant *const Step =
+              cast<SCEVConstant>(FirstAR->getStepRecurrence(*SE));
+          if (Step != SecondAR->getStepRecurrence(*SE)) {
+            return false;
+          }
+          const int64_t Bytes = Distance->getAPInt().getSExtValue();
+          if (Bytes < 0 && Bytes > -static_cast<int64_t>(VF) *
+                                       Step->getAPInt().getSExtValue()) {
+            return false;
+          }
+          continue;
+        }
+        if (FirstPtr->getType()->getPointerAddressSpace() !=
+                SecondPtr->getType()->getPointerAddressSpace() ||
+            !isSafeToExpand(FirstAR->getStart(), *SE) ||
+            !isSafeToExpand(SecondAR->getStart(), *SE)) {
+          return false;
+        }
+        OverlapChecks.emplace_back(*First, *Second);
+      }
+    }
+    return OverlapChecks.size() <= MaxRuntimeChecks;
+  }
+
+  /**
+   * @brief Emit before @c InsertPt whether the addresses that @c First and
+   *        @c Second access over all the iterations overlap.
+   */
+  Value *createOverlapCheck(Instruction &First, Instruction &Second,
+                            SCEVExpander &Expander,
+                            Instruction *const InsertPt) const {
+    IRBuilder<> Builder(InsertPt);
+    auto GetBounds = [&](const Instruction &Access) {
+      const SCEVAddRecExpr *const AR = Recurrences.lookup(&Access);
+      Type *const PtrTy = Builder.getInt8PtrTy(
+          getLoadStorePointerOperand(&Access)->getType()
+              ->getPointerAddressSpace());
+      return std::make_pair(
+          Expander.expandCodeFor(AR->getStart(), PtrTy, InsertPt),
+          Expander.expandCodeFor(evaluateAt(*AR, TripCount), PtrTy,
+                                 InsertPt));
+    };
+    const auto FirstBounds = GetBounds(First);
+    const auto SecondBounds = GetBounds(Second);
+    return Builder.CreateAnd(
+        Builder.CreateICmpULT(FirstBounds.first, SecondBounds.second),
+        Builder.CreateICmpULT(SecondBounds.first, FirstBounds.second),
+        "vec.overlap");
+  }
+  /**
+   * @brief Emit at the end of @c BB the reduction of the lanes of @c Vector
+   *        with the operation @c Op , by halves.
+   */
+  Value *createReduction(const Instruction &Op, Value *Vector,
+                         BasicBlock *const BB) const {
+    IRBuilder<> Builder(BB->getTerminator());
+    for (unsigned Width = VF / 2; Width; Width /= 2) {
+      SmallVector<int, 16> Mask(VF, -1);
+      for (unsigned I = 0; I != Width; ++I) {
+        Mask[I] = Width + I;
+      }
+      Value *const Shuffle = Builder.CreateShuffleVector(
+          Vector, UndefValue::get(Vector->getType()), Mask, "rdx.shuf");
+      Vector = Builder.CreateBinOp(
+          static_cast<Instruction::BinaryOps>(Op.getOpcode()), Vector,
+          Shuffle, "bin.rdx");
+      if (isa<FPMathOperator>(Vector)) {
+        cast<Instruction>(Vector)->copyFastMathFlags(&Op);
+      }
+    }
+    return Builder.CreateExtractElement(Vector, static_cast<uint64_t>(0),
+                                        Op.getName() + ".reduced");
+  }
+  /**
+   * @brief Vectorize @c L , which runs @c TripCountV iterations, and emit
+   *        the checks of whether to run the vectorized loop in its
+   *        preheader.
+   * @return the vectorized loop
+   */
+  Loop *vectorize(Loop &L, Value *const TripCountV, SCEVExpander &Expander) {
+    BasicBlock *const Preheader = L.getLoopPreheader();
+    BasicBlock *const BB = L.getHeader();
+    BasicBlock *const ExitBlock = L.getExitBlock();
+    Function &F = *BB->getParent();
+    LLVMContext &Ctx = F.getContext();
+    Type *const Ty = TripCountV->getType();
+
+    IRBuilder<> Builder(Preheader->getTerminator());
+    Value *Skip = Builder.CreateICmpULT(TripCountV, ConstantInt::get(Ty, VF),
+                                        "vec.min.iters");
+    for (const auto &Check : OverlapChecks) {
+      Skip = Builder.CreateOr(Skip,
+                              createOverlapCheck(*Check.first, *Check.second,
+                                                 Expander,
+                                                 Preheader->getTerminator()),
+                              "vec.skip");
+    }
+    BasicBlock *const ScalarPreheader =
+        SplitBlock(Preheader, Preheader->getTerminator(), DT, LI);
+    ScalarPreheader->setName("scalar.ph");
+
+    // The vectorized loop and the block that it leaves through, in which the
+    // remaining iterations are either run by the original loop or none.
+    BasicBlock *const VectorPreheader =
+        BasicBlock::Create(Ctx, "vector.ph", &F, ScalarPreheader);
+    BasicBlock *const VectorBody =
+        BasicBlock::Create(Ctx, "vector.body", &F, ScalarPreheader);
+    BasicBlock *const MiddleBlock =
+        BasicBlock::Create(Ctx, "middle.block", &F, ScalarPreheader);
+    Loop *const VectorLoop = LI->AllocateLoop();
+    if (Loop *const ParentLoop = L.getParentLoop()) {
+      ParentLoop->addChildLoop(VectorLoop);
+      ParentLoop->addBasicBlockToLoop(VectorPreheader, *LI);
+      ParentLoop->addBasicBlockToLoop(MiddleBlock, *LI);
+    } else {
+      LI->addTopLevelLoop(VectorLoop);
+    }
+    VectorLoop->addBasicBlockToLoop(VectorBody, *LI);
+    ReplaceInstWithInst(
+        Preheader->getTerminator(),
+        BranchInst::Create(ScalarPreheader, VectorPreheader, Skip));
+
+    Builder.SetInsertPoint(VectorPreheader);
+    Value *const NumVectorized =
+        Builder.CreateAnd(TripCountV, ~static_cast<uint64_t>(VF - 1), "n.vec");
+    Builder.CreateBr(VectorBody);
+    Builder.SetInsertPoint(VectorBody);
+    PHINode *const Index = Builder.CreatePHI(Ty, 2, "index");
+    Value *const NextIndex = Builder.CreateAdd(
+        Index, ConstantInt::get(Ty, VF), "index.next", /*HasNUW=*/true);
+    Builder.CreateCondBr(
+        Builder.CreateICmpEQ(NextIndex, NumVectorized, "vec.done"),
+        MiddleBlock, VectorBody);
+    Index->addIncoming(ConstantInt::get(Ty, 0), VectorPreheader);
+    Index->addIncoming(NextIndex, VectorBody);
+    Builder.SetInsertPoint(MiddleBlock);
+    Builder.CreateCondBr(
+        Builder.CreateICmpEQ(TripCountV, NumVectorized, "vec.all"), ExitBlock,
+        ScalarPreheader);
+
+    // The widened instructions, in the same order as the original ones
+    DenseMap<const Value *, Value *> Vectors;
+    auto GetVector = [&](Value *const V) {
+      Value *&Vector = Vectors[V];
+      if (!Vector) {
+        IRBuilder<> PreheaderBuilder(VectorPreheader->getTerminator());
+        Vector = PreheaderBuilder.CreateVectorSplat(VF, V, "broadcast");
+      }
+      return Vector;
+    };
+    auto GetVectorName = [](const Value &V) {
+      return V.hasName() ? (V.getName() + ".vec").str() : std::string();
+    };
+    const SCEV *const IndexSCEV = SE->getUnknown(Index);
+    for (PHINode *const Phi : Reductions) {
+      const Instruction *const Op = cast<Instruction>(
+          Phi->getIncomingValueForBlock(L.getLoopLatch()));
+      IRBuilder<> PreheaderBuilder(VectorPreheader->getTerminator());
+      Builder.SetInsertPoint(VectorBody->getFirstNonPHI());
+      PHINode *const VectorPhi = Builder.CreatePHI(
+          FixedVectorType::get(Phi->getType(), VF), 2, GetVectorName(*Phi));
+      VectorPhi->addIncoming(
+          PreheaderBuilder.CreateInsertElement(
+              PreheaderBuilder.CreateVectorSplat(
+                  VF, ConstantExpr::getBinOpIdentity(Op->getOpcode(),
+                                                     Phi->getType())),
+              Phi->getIncomingValueForBlock(ScalarPreheader),
+              static_cast<uint64_t>(0)),
+          VectorPreheader);
+      Vectors[Phi] = VectorPhi;
+    }
+    Builder.SetInsertPoint(cast<Instruction>(NextIndex));
+    for (Instruction &Inst : *BB) {
+      if (!Widened.count(&Inst) || is_contained(Reductions, &Inst)) {
+        continue;
+      }
+      if (isa<LoadInst>(Inst) || isa<StoreInst>(Inst)) {
+        Type *const VectorTy =
+            FixedVectorType::get(getAccessType(Inst), VF);
+        Value *const Ptr = getLoadStorePointerOperand(&Inst);
+        Value *const VectorPtr = Builder.CreateBitCast(
+            Expander.expandCodeFor(
+                evaluateAt(*Recurrences.lookup(&Inst), IndexSCEV),
+                Ptr->getType(), &*Builder.GetInsertPoint()),
+            VectorTy->getPointerTo(Ptr->getType()->getPointerAddressSpace()));
+        if (LoadInst *const Load = dyn_cast<LoadInst>(&Inst)) {
+          Vectors[Load] = Builder.CreateAlignedLoad(
+              VectorTy, VectorPtr, Load->getAlign(), GetVectorName(*Load));
+        } else {
+          StoreInst &Store = cast<StoreInst>(Inst);
+          Builder.CreateAlignedStore(GetVector(Store.getValueOperand()),
+                                     VectorPtr, Store.getAlign());
+        }
+      } else if (PHINode *const Phi = dyn_cast<PHINode>(&Inst)) {
+        const SCEVAddRecExpr *const AR = Recurrences.lookup(Phi);
+        const int64_t Step = cast<SCEVConstant>(AR->getStepRecurrence(*SE))
+                                 ->getAPInt()
+                                 .getSExtValue();
+        SmallVector<Constant *, 16> Steps;
+        for (unsigned Lane = 0; Lane != VF; ++Lane) {
+          Steps.push_back(
+              ConstantInt::get(Phi->getType(), Lane * Step, /*isSigned=*/true));
+        }
+        Value *const First =
+            Expander.expandCodeFor(evaluateAt(*AR, IndexSCEV), Phi->getType(),
+                                   &*Builder.GetInsertPoint());
+        Vectors[Phi] =
+            Builder.CreateAdd(Builder.CreateVectorSplat(VF, First, "broadcast"),
+                              ConstantVector::get(Steps), GetVectorName(*Phi));
+      } else {
+        Instruction *const Clone = Inst.clone();
+        for (Use &Op : Clone->operands()) {
+          Op.set(GetVector(Op.get()));
+        }
+        Clone->mutateType(FixedVectorType::get(Inst.getType(), VF));
+        if (isReductionResult(Inst, L)) {
+          // The lanes are reassociated, hence may wrap where the original
+          // order does not.
+          Clone->dropPoisonGeneratingFlags();
+        }
+        Vectors[&Inst] = Builder.Insert(Clone, GetVectorName(Inst));
+      }
+    }
+
+    // The original loop resumes from where the vectorized loop stops, if it
+    // runs at all.
+    DenseMap<const Value *, Value *> Results;
+    for (PHINode &Phi : BB->phis()) {
+      Value *Resume;
+      if (is_contained(Reductions, &Phi)) {
+        Instruction *const Op = cast<Instruction>(
+            Phi.getIncomingValueForBlock(L.getLoopLatch()));
+        cast<PHINode>(Vectors[&Phi])->addIncoming(Vectors[Op], VectorBody);
+        Resume = Results[Op] = createReduction(*Op, Vectors[Op], MiddleBlock);
+      } else {
+        const SCEV *const Resumed = evaluateAt(*Recurrences.lookup(&Phi),
+                                               SE->getUnknown(NumVectorized));
+        Resume = Expander.expandCodeFor(Resumed, Phi.getType(),
+                                        MiddleBlock->getTerminator());
+      }
+      PHINode *const ResumePhi =
+          PHINode::Create(Phi.getType(), 2, Phi.getName() + ".resume",
+                          &ScalarPreheader->front());
+      const int Index = Phi.getBasicBlockIndex(ScalarPreheader);
+      ResumePhi->addIncoming(Phi.getIncomingValue(Index), Preheader);
+      ResumePhi->addIncoming(Resume, MiddleBlock);
+      Phi.setIncomingValue(Index, ResumePhi);
+    }
+    for (PHINode &Phi : ExitBlock->phis()) {
+      Value *const V = Phi.getIncomingValueForBlock(BB);
+      Value *const Result = Results.lookup(V);
+      Phi.addIncoming(Result ? Result : V, MiddleBlock);
+    }
+
+    DT->recalculate(F);
+    formDedicatedExitBlocks(&L, DT, LI, /*MSSAU=*/nullptr,
+                            /*PreserveLCSSA=*/true);
+    formLCSSARecursively(*VectorLoop, *DT, LI, SE);
+    addStringMetadataToLoop(&L, "llvm.loop.isvectorized", 1);
+    addStringMetadataToLoop(VectorLoop, "llvm.loop.isvectorized", 1);
+    return VectorLoop;
+  }
+
+public:
+  static char ID;
+
+  LoopVectorization() : LoopPass(ID) {}
+
+  virtual void getAnalysisUsage(AnalysisUsage &AU) const override {
+    AU.addRequired<DominatorTreeWrapperPass>();
+    AU.addPreserved<DominatorTreeWrapperPass>();
+    AU.addRequired<LoopInfoWrapperPass>();
+    AU.addPreserved<LoopInfoWrapperPass>();
+    AU.addRequired<ScalarEvolutionWrapperPass>();
+    AU.addPreserved<ScalarEvolutionWrapperPass>();
+    AU.addRequired<AAResultsWrapperPass>();
+    AU.addRequired<TargetTransformInfoWrapperPass>();
+    AU.addRequiredID(LoopSimplifyID);
+    AU.addPreservedID(LoopSimplifyID);
+    AU.addRequiredID(LCSSAID);
+    AU.addPreservedID(LCSSAID);
+  }
+
+  virtual bool runOnLoop(Loop *L, LPPassManager &LPM) override {
+    if (!L->isInnermost() || L->getNumBlocks() != 1 ||
+        !L->getLoopPreheader() || !L->getExitBlock() ||
+        getBooleanLoopAttribute(L, "llvm.loop.isvectorized")) {
+      return false;
+    }
+    LI = &getAnalysis<LoopInfoWrapperPass>().getLoopInfo();
+    DT = &getAnalysis<DominatorTreeWrapperPass>().getDomTree();
+    SE = &getAnalysis<ScalarEvolutionWrapperPass>().getSE();
+    AA = &getAnalysis<AAResultsWrapperPass>().getAAResults();
+    TTI = &getAnalysis<TargetTransformInfoWrapperPass>().getTTI(
+        *L->getHeader()->getParent());
+    Recurrences.clear();
+    Reductions.clear();
+    Accesses.clear();
+    Widened.clear();
+    OverlapChecks.clear();
+
+    const SCEV *const BackedgeTakenCount = SE->getBackedgeTakenCount(L);
+    if (isa<SCEVCouldNotCompute>(BackedgeTakenCount)) {
+      return false;
+    }
+    TripCount = SE->getAddExpr(BackedgeTakenCount,
+                               SE->getOne(BackedgeTakenCount->getType()));
+    if (!isSafeToExpand(TripCount, *SE) || !analyzeLoop(*L) ||
+        Widened.empty()) {
+      return false;
+    }
+    VF = getVectorizationFactor(*L);
+    const unsigned ConstantTripCount = SE->getSmallConstantTripCount(L);
+    if (!VF || (ConstantTripCount && ConstantTripCount < VF) ||
+        !checkDependences()) {
+      return false;
+    }
+    SCEVExpander Expander(*SE, L->getHeader()->getModule()->getDataLayout(),
+                          "vec");
+    Value *const TripCountV =
+        Expander.expandCodeFor(TripCount, TripCount->getType(),
+                               L->getLoopPreheader()->getTerminator());
+    const std::string Name = (L->getHeader()->getParent()->getName() + ", " +
+                              L->getHeader()->getName())
+                                 .str();
+    SE->forgetLoop(L);
+    LPM.addLoop(*vectorize(*L, TripCountV, Expander));
+    errs() << "Vectorization Factor (" << Name << "): " << VF << "\n"
+           << "Runtime Overlap Checks (" << Name
+           << "): " << OverlapChecks.size() << "\n";
+    return true;
+  }
+};
+
+char LoopVectorization::ID = 0;
+RegisterPass<LoopVectorization> X("loop-vectorization", "Loop Vectorization");
+
+} // anonymous namespace
@@ -2,6 +2,7 @@
  * @file Interference Graph Register Allocator
  */
 #include <llvm/Analysis/AliasAnalysis.h>
+#include <llvm/CodeGen/CalcSpillWeights.h>
 #include <llvm/CodeGen/LiveIntervals.h>
 #include <llvm/CodeGen/LiveRangeEdit.h>
 #include <llvm/CodeGen/LiveRegMatrix.h>
@@ -16,9 +17,11 @@
 #include <llvm/CodeGen/TargetRegisterInfo.h>
 #include <llvm/CodeGen/VirtRegMap.h>
 #include <llvm/InitializePasses.h>
+#include <llvm/Support/ErrorHandling.h>
 #include <llvm/Support/raw_ostream.h>
 #include <llvm/Target/TargetMachine.h>
 
+#include <algorithm>
 #include <cmath>
 #include <queue>
 #include <tuple>
@@ -44,13 +47,8 @@ struct hash<Register> {
 
 template <> //
 struct greater<LiveInterval *> {
-  bool operator()(LiveInterval *const &LHS, LiveInterval *const &RHS) {
-    /**
-     * @todo(cscd70) Please finish the implementation of this function that is
-     *               used for determining whether one live interval has spill
-     *               cost greater than the other.
-     */
-    return false;
+  bool operator()(LiveInterval *const &LHS, LiveInterval *const &RHS) const {
+    return LHS->weight() > RHS->weight();
   }
 };
 
@@ -92,9 +90,28 @@ private:
     RAIntfGraph *RA;
 
     /// Interference Relations
-    std::multimap<LiveInterval *, std::unordered_set<Register>,
-                  std::greater<LiveInterval *>>
-        IntfRels;
+    using IntfRels_t =
+        std::multimap<LiveInterval *, std::unordered_set<Register>,
+                      std::greater<LiveInterval *>>;
+    IntfRels_t IntfRels;
+    /// Spill costs of the virtual registers, from which their weights are
+    /// derived as the cost divided by the degree in the interference graph
+    std::unordered_map<Register, float> SpillCosts;
+
+    IntfRels_t::iterator find(const Register &Reg) {
+      return std::find_if(IntfRels.begin(), IntfRels.end(),
+                          [&Reg](const IntfRels_t::value_type &IntfRel) {
+                            return IntfRel.first->reg() == Reg;
+                          });
+    }
+    /**
+     * @brief Update the weight of the virtual register @c Reg after its degree
+     *        has changed.
+     *
+     * The live intervals are ordered by their weights, hence they need to be
+     * re-inserted into the graph for the order to remain valid.
+     */
+    void reweigh(const Register &Reg);
 
     /**
      * @brief  Try to materialize all the virtual registers (internal).
@@ -119,9 +136,11 @@ private:
     /**
      * @brief Erase a virtual register @c Reg from the interference graph.
      *
+     * @return whether @c Reg was in the graph
+     *
      * @sa RAIntfGraph::LRE_CanEraseVirtReg
      */
-    void erase(const Register &Reg);
+    bool erase(const Register &Reg);
     /**
      * @brief Build the whole graph.
      */
@@ -130,7 +149,10 @@ private:
      * @brief Try to materialize all the virtual registers.
      */
     void tryMaterializeAll();
-    void clear() { IntfRels.clear(); }
+    void clear() {
+      IntfRels.clear();
+      SpillCosts.clear();
+    }
   } G;
 
   SmallPtrSet<MachineInstr *, 32> DeadRemats;
@@ -152,19 +174,25 @@ private:
   /// The following two methods are inherited from @c LiveRangeEdit::Delegate
   /// and implicitly used by the spiller to edit the live ranges.
   bool LRE_CanEraseVirtReg(Register Reg) override {
-    /**
-     * @todo(cscd70) Please implement this method.
-     */
     // If the virtual register has been materialized, undo its physical
     // assignment and erase it from the interference graph.
+    if (VRM->hasPhys(Reg)) {
+      LRM->unassign(LIS->getInterval(Reg));
+    }
+    G.erase(Reg);
     return true;
   }
   void LRE_WillShrinkVirtReg(Register Reg) override {
-    /**
-     * @todo(cscd70) Please implement this method.
-     */
     // If the virtual register has been materialized, undo its physical
     // assignment and re-insert it into the interference graph.
+    if (VRM->hasPhys(Reg)) {
+      LRM->unassign(LIS->getInterval(Reg));
+    }
+    // The interferences of the interval before shrinking are a superset of
+    // those after.
+    if (G.erase(Reg)) {
+      G.insert(Reg);
+    }
   }
 
 public:
@@ -210,10 +238,14 @@ AllocationHints::AllocationHints(RAIntfGraph *const RA,
                                  const LiveInterval *const LI) {
   const TargetRegisterClass *const RC = RA->MRI->getRegClass(LI->reg());
 
-  /**
-   * @todo(cscd70) Please complete this part by constructing the allocation
-   *               hints, similar to the tutorial example.
-   */
+  ArrayRef<MCPhysReg> Order = RA->RCI.getOrder(RC);
+  const bool IsHardHint = RA->TRI->getRegAllocationHints(
+      LI->reg(), Order, Hints, *RA->MF, RA->VRM, RA->LRM);
+  if (!IsHardHint) {
+    for (const MCPhysReg &PhysReg : Order) {
+      Hints.push_back(PhysReg);
+    }
+  }
 
   outs() << "Hint Registers for Class " << RA->TRI->getRegClassName(RC)
          << ": [";
@@ -245,6 +277,10 @@ bool RAIntfGraph::runOnMachineFunction(MachineFunction &MF) {
   RCI.runOnMachineFunction(MF);
   MLI = &getAnalysis<MachineLoopInfo>();
 
+  // The spill costs are the initial weights of the live intervals.
+  VirtRegAuxInfo VRAI(MF, *LIS, *VRM, *MLI,
+                      getAnalysis<MachineBlockFrequencyInfo>());
+  VRAI.calculateSpillWeightsAndHints();
   SpillerInst.reset(createInlineSpiller(*this, MF, *VRM));
 
   G.build();
@@ -254,53 +290,156 @@ bool RAIntfGraph::runOnMachineFunction(MachineFunction &MF) {
   return true;
 }
 
+void RAIntfGraph::IntfGraph::reweigh(const Register &Reg) {
+  IntfRels_t::iterator It = find(Reg);
+  LiveInterval *const LI = It->first;
+  std::unordered_set<Register> IntfRegs = std::move(It->second);
+  IntfRels.erase(It);
+  LI->setWeight(SpillCosts.at(Reg) /
+                std::max<size_t>(IntfRegs.size(), 1));
+  IntfRels.emplace(LI, std::move(IntfRegs));
+}
+
 void RAIntfGraph::IntfGraph::insert(const Register &Reg) {
-  /**
-   * @todo(cscd70) Please implement this method.
-   */
+  if (RA->MRI->reg_nodbg_empty(Reg)) {
+    return;
+  }
+  LiveInterval *const LI = &RA->LIS->getInterval(Reg);
+  // The weight of a re-inserted interval is no longer its spill cost.
+  SpillCosts.emplace(Reg, LI->weight());
+
+  std::unordered_set<Register> IntfRegs;
   // 1. Collect all VIRTUAL registers that interfere with 'Reg'.
+  for (const IntfRels_t::value_type &IntfRel : IntfRels) {
+    if (IntfRel.first->overlaps(*LI)) {
+      IntfRegs.insert(IntfRel.first->reg());
+    }
+  }
   // 2. Collect all PHYSICAL registers that interfere with 'Reg'.
+  for (const MCPhysReg &PhysReg :
+       RA->RCI.getOrder(RA->MRI->getRegClass(Reg))) {
+    if (RA->LRM->checkInterference(*LI, PhysReg) != LiveRegMatrix::IK_Free) {
+      IntfRegs.insert(PhysReg);
+    }
+  }
   // 3. Update the weights of Reg (and its interfering neighbors), using the
   //    formula on "Lecture 6 Register Allocation Page 23".
   // 4. Insert 'Reg' into the graph.
+  IntfRels.emplace(LI, IntfRegs);
+  reweigh(Reg);
+  for (const Register &IntfReg : IntfRegs) {
+    if (IntfReg.isVirtual()) {
+      find(IntfReg)->second.insert(Reg);
+      reweigh(IntfReg);
+    }
+  }
 }
 
-void RAIntfGraph::IntfGraph::erase(const Register &Reg) {
-  /**
-   * @todo(cscd70) Please implement this method.
-   */
-  // 1. ∀n ∈ neighbors(Reg), erase 'Reg' from n's interfering set and update its
-  //    weights accordingly.
+bool RAIntfGraph::IntfGraph::erase(const Register &Reg) {
+  IntfRels_t::iterator It = find(Reg);
+  if (It == IntfRels.end()) {
+    return false;
+  }
+  const std::unordered_set<Register> IntfRegs = std::move(It->second);
   // 2. Erase 'Reg' from the interference graph.
+  IntfRels.erase(It);
+  // 1. ∀n ∈ neighbors(Reg), erase 'Reg' from n's interfering set and update
+  //    its weights accordingly.
+  for (const Register &IntfReg : IntfRegs) {
+    if (IntfReg.isVirtual()) {
+      find(IntfReg)->second.erase(Reg);
+      reweigh(IntfReg);
+    }
+  }
+  return true;
 }
 
 void RAIntfGraph::IntfGraph::build() {
-  /**
-   * @todo(cscd70) Please implement this method.
-   */
+  for (unsigned VirtRegIdx = 0; VirtRegIdx < RA->MRI->getNumVirtRegs();
+       ++VirtRegIdx) {
+    insert(Register::index2VirtReg(VirtRegIdx));
+  }
 }
 
 RAIntfGraph::IntfGraph::MaterializeResult_t
 RAIntfGraph::IntfGraph::tryMaterializeAllInternal() {
   std::unordered_map<LiveInterval *, MCPhysReg> PhysRegAssignment;
 
-  /**
-   * @todo(cscd70) Please implement this method.
-   */
   // ∀r ∈ IntfRels.keys, try to materialize it. If successful, cache it in
   // PhysRegAssignment, else mark it as to be spilled.
-
+  for (const IntfRels_t::value_type &IntfRel : IntfRels) {
+    LiveInterval *const LI = IntfRel.first;
+    MCPhysReg Materialized = 0;
+    for (const MCPhysReg &PhysReg : AllocationHints(RA, LI)) {
+      // The physical interferences are checked against the register units,
+      // which also covers the aliases of the physical registers.
+      if (RA->LRM->checkInterference(*LI, PhysReg) != LiveRegMatrix::IK_Free) {
+        continue;
+      }
+      if (any_of(IntfRel.second, [&](const Register &IntfReg) {
+            if (!IntfReg.isVirtual()) {
+              return false;
+            }
+            auto It = PhysRegAssignment.find(&RA->LIS->getInterval(IntfReg));
+            return It != PhysRegAssignment.end() &&
+                   RA->TRI->regsOverlap(It->second, PhysReg);
+          })) {
+        continue;
+      }
+      Materialized = PhysReg;
+      break;
+    }
+    if (Materialized) {
+      PhysRegAssignment.emplace(LI, Materialized);
+      continue;
+    }
+    // Spill the live interval, or, if it cannot be spilled (e.g., because it
+    // has been created by a previous spill), its cheapest neighbor.
+    LiveInterval *SpillLI = LI;
+    if (!LI->isSpillable()) {
+      SpillLI = nullptr;
+      for (const Register &IntfReg : IntfRel.second) {
+        if (!IntfReg.isVirtual()) {
+          continue;
+        }
+        LiveInterval *const IntfLI = &RA->LIS->getInterval(IntfReg);
+        if (IntfLI->isSpillable() &&
+            (!SpillLI || IntfLI->weight() < SpillLI->weight())) {
+          SpillLI = IntfLI;
+        }
+      }
+    }
+    if (!SpillLI) {
+      report_fatal_error("Ran out of registers during register allocation");
+    }
+    return std::make_tuple(SpillLI, PhysRegAssignment);
+  }
   return std::make_tuple(nullptr, PhysRegAssignment);
 }
 
 void RAIntfGraph::IntfGraph::tryMaterializeAll() {
   std::unordered_map<LiveInterval *, MCPhysReg> PhysRegAssignment;
 
-  /**
-   * @todo(cscd70) Please implement this method.
-   */
   // Keep looping until a valid assignment is made. In the case of spilling,
   // modify the interference graph accordingly.
+  LiveInterval *SpillLI;
+  std::tie(SpillLI, PhysRegAssignment) = tryMaterializeAllInternal();
+  while (SpillLI) {
+    outs() << "Spilling {Reg=" << *SpillLI << "}\n";
+    erase(SpillLI->reg());
+    SmallVector<Register, 4> SplitVirtRegs;
+    LiveRangeEdit LRE(SpillLI, SplitVirtRegs, *RA->MF, *RA->LIS, RA->VRM, RA,
+                      &RA->DeadRemats);
+    RA->SpillerInst->spill(LRE);
+    for (const Register &Reg : SplitVirtRegs) {
+      if (RA->MRI->reg_nodbg_empty(Reg)) {
+        RA->LIS->removeInterval(Reg);
+        continue;
+      }
+      insert(Reg);
+    }
+    std::tie(SpillLI, PhysRegAssignment) = tryMaterializeAllInternal();
+  }
 
   for (auto &PhysRegAssignPair : PhysRegAssignment) {
     RA->LRM->assign(*PhysRegAssignPair.first, PhysRegAssignPair.second);
@@ -0,0 +1,149 @@
+; RUN: opt -S -load %dylibdir/libLICM.so -code-sinking %s -o %basename_t \
+; RUN:     2>&1 | FileCheck --match-full-lines --check-prefix=REPORT %s
+; REPORT: Instructions Sunk to Exits (last, loop): 2
+; REPORT-NEXT: Instructions Sunk to Colder Blocks (last, loop): 0
+; REPORT-NEXT: Instructions Sunk to Exits (cold, loop): 0
+; REPORT-NEXT: Instructions Sunk to Colder Blocks (cold, loop): 2
+; REPORT-NOT: (hot, loop)
+; RUN: FileCheck --match-full-lines %s --input-file=%basename_t
+
+; The sum of squares is only used after the loop, hence only computed for the
+; last iteration.
+define i32 @last(i32 %n, i32 %k) {
+; CHECK-LABEL: define i32 @last(i32 %n, i32 %k) {
+; CHECK-NEXT: entry:
+; CHECK-NEXT:   br label %loop
+; CHECK-EMPTY:
+; CHECK-NEXT: loop:                                             ; preds = %loop, %entry
+; CHECK-NEXT:   %i = phi i32 [ 0, %entry ], [ %i.next, %loop ]
+; CHECK-NEXT:   %i.next = add i32 %i, 1
+; CHECK-NEXT:   %cond = icmp slt i32 %i.next, %n
+; CHECK-NEXT:   br i1 %cond, label %loop, label %exit
+; CHECK-EMPTY:
+; CHECK-NEXT: exit:                                             ; preds = %loop
+; CHECK-NEXT:   %i.lcssa = phi i32 [ %i, %loop ]
+; CHECK-NEXT:   %sq = mul i32 %i.lcssa, %i.lcssa
+; CHECK-NEXT:   %t = add i32 %sq, %k
+; CHECK-NEXT:   ret i32 %t
+entry:
+  br label %loop
+
+loop:
+  %i = phi i32 [ 0, %entry ], [ %i.next, %loop ]
+  %sq = mul i32 %i, %i
+  %t = add i32 %sq, %k
+  %i.next = add i32 %i, 1
+  %cond = icmp slt i32 %i.next, %n
+  br i1 %cond, label %loop, label %exit
+
+exit:
+  ret i32 %t
+}
+
+; The quotient is only used on the rarely taken path.
+define void @cold(i32* %a, i32 %n, i32 %d) {
+; CHECK-LABEL: define void @cold(i32* %a, i32 %n, i32 %d) {
+; CHECK-NEXT: entry:
+; CHECK-NEXT:   br label %loop
+; CHECK-EMPTY:
+; CHECK-NEXT: loop:                                             ; preds = %latch, %entry
+; CHECK-NEXT:   %i = phi i32 [ 0, %entry ], [ %i.next, %latch ]
+; CHECK-NEXT:   %ptr = getelementptr inbounds i32, i32* %a, i32 %i
+; CHECK-NEXT:   %x = load i32, i32* %ptr, align 4
+; CHECK-NEXT:   %big = icmp ugt i32 %x, 1000
+; CHECK-NEXT:   br i1 %big, label %clamp, label %latch, !prof !0
+; CHECK-EMPTY:
+; CHECK-NEXT: clamp:                                            ; preds = %loop
+; CHECK-NEXT:   %q = udiv i32 %x, %d
+; CHECK-NEXT:   %r = add i32 %q, 1
+; CHECK-NEXT:   store i32 %r, i32* %ptr, align 4
+; CHECK-NEXT:   br label %latch
+; CHECK-EMPTY:
+; CHECK-NEXT: latch:                                            ; preds = %clamp, %loop
+; CHECK-NEXT:   %i.next = add i32 %i, 1
+; CHECK-NEXT:   %cond = icmp slt i32 %i.next, %n
+; CHECK-NEXT:   br i1 %cond, label %loop, label %exit
+; CHECK-EMPTY:
+; CHECK-NEXT: exit:                                             ; preds = %latch
+; CHECK-NEXT:   ret void
+entry:
+  br label %loop
+
+loop:
+  %i = phi i32 [ 0, %entry ], [ %i.next, %latch ]
+  %ptr = getelementptr inbounds i32, i32* %a, i32 %i
+  %x = load i32, i32* %ptr
+  %q = udiv i32 %x, %d
+  %r = add i32 %q, 1
+  %big = icmp ugt i32 %x, 1000
+  br i1 %big, label %clamp, label %latch, !prof !0
+
+clamp:
+  store i32 %r, i32* %ptr
+  br label %latch
+
+latch:
+  %i.next = add i32 %i, 1
+  %cond = icmp slt i32 %i.next, %n
+  br i1 %cond, label %loop, label %exit
+
+exit:
+  ret void
+}
+
+; The quotient is used on every path, so that no block is colder.
+define void @hot(i32* %a, i32 %n, i32 %d) {
+; CHECK-LABEL: define void @hot(i32* %a, i32 %n, i32 %d) {
+; CHECK-NEXT: entry:
+; CHECK-NEXT:   br label %loop
+; CHECK-EMPTY:
+; CHECK-NEXT: loop:                                             ; preds = %latch, %entry
+; CHECK-NEXT:   %i = phi i32 [ 0, %entry ], [ %i.next, %latch ]
+; CHECK-NEXT:   %ptr = getelementptr inbounds i32, i32* %a, i32 %i
+; CHECK-NEXT:   %x = load i32, i32* %ptr, align 4
+; CHECK-NEXT:   %q = udiv i32 %x, %d
+; CHECK-NEXT:   %big = icmp ugt i32 %x, 1000
+; CHECK-NEXT:   br i1 %big, label %clamp, label %latch, !prof !0
+; CHECK-EMPTY:
+; CHECK-NEXT: clamp:                                            ; preds = %loop
+; CHECK-NEXT:   store i32 1000, i32* %ptr, align 4
+; CHECK-NEXT:   br label %latch
+; CHECK-EMPTY:
+; CHECK-NEXT: latch:                                            ; preds = %clamp, %loop
+; CHECK-NEXT:   %y = phi i32 [ %x, %loop ], [ 1000, %clamp ]
+; CHECK-NEXT:   %z = add i32 %y, %q
+; CHECK-NEXT:   store i32 %z, i32* %ptr, align 4
+; CHECK-NEXT:   %i.next = add i32 %i, 1
+; CHECK-NEXT:   %cond = icmp slt i32 %i.next, %n
+; CHECK-NEXT:   br i1 %cond, label %loop, label %exit
+; CHECK-EMPTY:
+; CHECK-NEXT: exit:                                             ; preds = %latch
+; CHECK-NEXT:   ret void
+entry:
+  br label %loop
+
+loop:
+  %i = phi i32 [ 0, %entry ], [ %i.next, %latch ]
+  %ptr = getelementptr inbounds i32, i32* %a, i32 %i
+  %x = load i32, i32* %ptr
+  %q = udiv i32 %x, %d
+  %big = icmp ugt i32 %x, 1000
+  br i1 %big, label %clamp, label %latch, !prof !0
+
+clamp:
+  store i32 1000, i32* %ptr
+  br label %latch
+
+latch:
+  %y = phi i32 [ %x, %loop ], [ 1000, %clamp ]
+  %z = add i32 %y, %q
+  store i32 %z, i32* %ptr
+  %i.next = add i32 %i, 1
+  %cond = icmp slt i32 %i.next, %n
+  br i1 %cond, label %loop, label %exit
+
+exit:
+  ret void
+}
+
+!0 = !{!"branch_weights", i32 1, i32 1000}
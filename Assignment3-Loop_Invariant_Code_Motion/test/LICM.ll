@@ -1,16 +1,25 @@
-; RUN: opt -S -load %dylibdir/libLICM.so \
-; RUN:     -loop-invariant-code-motion %s -o %basename_t
+; The register budget is that of x86-64, as the module has no target.
+; RUN: opt -S -load %dylibdir/libLICM.so -loop-invariant-code-motion \
+; RUN:     -licm-register-budget=16 %s -o %basename_t
 ; RUN: FileCheck --match-full-lines --check-prefix=CODEGEN %s --input-file=%basename_t
-; RUN: llc -load %dylibdir/libLICM.so -regalloc=basic %basename_t -o %basename_t.s
-
-; @todo(cscd70) Please replace the register allocator with 'intfgraph' after you
-;               have completed the interference graph register allocator.
-
+; RUN: llc -load %dylibdir/libLICM.so -regalloc=intfgraph %basename_t -o %basename_t.s
 ; RUN: clang %basename_t.s -o %basename_t.exe
 ; RUN: ./%basename_t.exe | FileCheck --match-full-lines --check-prefix=CORRECTNESS %s
 ; CORRECTNESS: 3,4,10,6,7,12,3,10
 ; CORRECTNESS-NEXT: 8,4,0,0,7,0,3,13
 
+; The dynamic instruction counts before and after the code motion:
+; RUN: opt -load %dylibdir/libLICM.so -dynamic-inst-count %s | \
+; RUN:     llc -o %basename_t.before.s
+; RUN: clang %basename_t.before.s -o %basename_t.before.exe
+; RUN: ./%basename_t.before.exe | FileCheck --match-full-lines --check-prefix=BEFORE %s
+; BEFORE: Dynamic Instructions: 97
+; RUN: opt -load %dylibdir/libLICM.so -dynamic-inst-count %basename_t | \
+; RUN:     llc -o %basename_t.after.s
+; RUN: clang %basename_t.after.s -o %basename_t.after.exe
+; RUN: ./%basename_t.after.exe | FileCheck --match-full-lines --check-prefix=AFTER %s
+; AFTER: Dynamic Instructions: 75
+
 ; #include <stdio.h>
 
 ; void foo(int c, int z) {
@@ -48,7 +57,44 @@
 
 define void @foo(i32 %0, i32 %1) {
 ; CODEGEN-LABEL: define void @foo(i32 %0, i32 %1) {
-; @todo(cscd70) Please complete the CHECK directives on the optimized code.
+; CODEGEN-NEXT:   %3 = add nsw i32 %0, 3
+; CODEGEN-NEXT:   %4 = add nsw i32 %0, 7
+; CODEGEN-NEXT:   %5 = add nsw i32 %0, 3
+; CODEGEN-NEXT:   %6 = add nsw i32 %3, 7
+; CODEGEN-NEXT:   %7 = add nsw i32 %0, 7
+; CODEGEN-NEXT:   %8 = add nsw i32 %4, 5
+; CODEGEN-NEXT:   %9 = add nsw i32 %0, 4
+; CODEGEN-NEXT:   br label %10
+; CODEGEN-EMPTY:
+; CODEGEN-NEXT: 10:                                               ; preds = %18, %2
+; CODEGEN-NEXT:   %.05 = phi i32 [ 0, %2 ], [ %8, %18 ]
+; CODEGEN-NEXT:   %.04 = phi i32 [ 0, %2 ], [ %19, %18 ]
+; CODEGEN-NEXT:   %.03 = phi i32 [ 0, %2 ], [ %6, %18 ]
+; CODEGEN-NEXT:   %.01 = phi i32 [ 9, %2 ], [ %.1, %18 ]
+; CODEGEN-NEXT:   %.0 = phi i32 [ %1, %2 ], [ %11, %18 ]
+; CODEGEN-NEXT:   %11 = add nsw i32 %.0, 1
+; CODEGEN-NEXT:   %12 = icmp slt i32 %11, 5
+; CODEGEN-NEXT:   br i1 %12, label %13, label %15
+; CODEGEN-EMPTY:
+; CODEGEN-NEXT: 13:                                               ; preds = %10
+; CODEGEN-NEXT:   %14 = add nsw i32 %.01, 2
+; CODEGEN-NEXT:   br label %18
+; CODEGEN-EMPTY:
+; CODEGEN-NEXT: 15:                                               ; preds = %10
+; CODEGEN-NEXT:   %16 = sub nsw i32 %.01, 1
+; CODEGEN-NEXT:   %17 = icmp sge i32 %11, 10
+; CODEGEN-NEXT:   br i1 %17, label %20, label %18
+; CODEGEN-EMPTY:
+; CODEGEN-NEXT: 18:                                               ; preds = %15, %13
+; CODEGEN-NEXT:   %.02 = phi i32 [ %5, %13 ], [ %9, %15 ]
+; CODEGEN-NEXT:   %.1 = phi i32 [ %14, %13 ], [ %16, %15 ]
+; CODEGEN-NEXT:   %19 = add nsw i32 %.02, 2
+; CODEGEN-NEXT:   br label %10
+; CODEGEN-EMPTY:
+; CODEGEN-NEXT: 20:                                               ; preds = %15
+; CODEGEN-NEXT:   %21 = call i32 (i8*, ...) @printf(i8* getelementptr inbounds ([25 x i8], [25 x i8]* @.str, i64 0, i64 0), i32 %16, i32 %9, i32 %.03, i32 %.04, i32 %4, i32 %.05, i32 %3, i32 %11)
+; CODEGEN-NEXT:   ret void
+; CODEGEN-NEXT: }
   br label %3
 
 3:                                                ; preds = %15, %2
@@ -0,0 +1,213 @@
+; The unrolling runs first, so that the code motion hoists the invariant
+; computations out of both the unrolled body and the remainder loop, each of
+; which has a preheader of its own. The register budget is that of x86-64, as
+; the module has no target.
+; RUN: opt -S -load %dylibdir/libLICM.so -loop-unrolling \
+; RUN:     -loop-invariant-code-motion -licm-register-budget=16 %s \
+; RUN:     -o %basename_t 2>&1 | \
+; RUN:     FileCheck --match-full-lines --check-prefix=REPORT %s
+; REPORT: Runtime Unroll Count (scale, loop): 8
+; REPORT-NEXT: Full Unroll Count (main, print): 17
+; RUN: FileCheck --match-full-lines %s --input-file=%basename_t
+; RUN: llc %basename_t -o %basename_t.s
+; RUN: clang %basename_t.s -o %basename_t.exe
+; RUN: ./%basename_t.exe | FileCheck --match-full-lines --check-prefix=CORRECTNESS %s
+; CORRECTNESS: 0,6,20,80,153,364,851,1250,2015,2952,3939,5368,7540,10370,13396,17402,20560,
+
+; The dynamic instruction counts of the unrolled loops before and after the
+; code motion:
+; RUN: opt -load %dylibdir/libLICM.so -loop-unrolling -dynamic-inst-count %s \
+; RUN:     2>/dev/null | llc -o %basename_t.before.s
+; RUN: clang %basename_t.before.s -o %basename_t.before.exe
+; RUN: ./%basename_t.before.exe | FileCheck --match-full-lines --check-prefix=BEFORE %s
+; BEFORE: Dynamic Instructions: 1424
+; RUN: opt -load %dylibdir/libLICM.so -dynamic-inst-count %basename_t | \
+; RUN:     llc -o %basename_t.after.s
+; RUN: clang %basename_t.after.s -o %basename_t.after.exe
+; RUN: ./%basename_t.after.exe | FileCheck --match-full-lines --check-prefix=AFTER %s
+; AFTER: Dynamic Instructions: 1324
+
+@.fmt = private constant [4 x i8] c"%d,\00"
+@.nl = private constant [2 x i8] c"\0A\00"
+@a = global [16 x i32] [i32 3, i32 1, i32 4, i32 1, i32 5, i32 9, i32 2, i32 6,
+                        i32 5, i32 3, i32 5, i32 8, i32 9, i32 7, i32 9, i32 3]
+
+declare i32 @printf(i8*, ...)
+
+; Each copy of the body recomputes the same weight from the invariant %k.
+; CHECK-LABEL: define i32 @scale(i32* %a, i32 %n, i32 %k) {
+; CHECK-NEXT: entry:
+; CHECK-NEXT:   %empty = icmp sle i32 %n, 0
+; CHECK-NEXT:   br i1 %empty, label %exit, label %loop.preheader
+; CHECK-EMPTY:
+; CHECK-NEXT: loop.preheader:                                   ; preds = %entry
+; CHECK-NEXT:   %unroll.iters = lshr i32 %n, 3
+; CHECK-NEXT:   %unroll.remaining = and i32 %n, 7
+; CHECK-NEXT:   %unroll.skip = icmp eq i32 %unroll.iters, 0
+; CHECK-NEXT:   br i1 %unroll.skip, label %loop.preheader.split.rem, label %loop.preheader.split
+; CHECK-EMPTY:
+; CHECK-NEXT: unroll.exit:                                      ; preds = %loop.7
+; CHECK-NEXT:   %s.next.7.lcssa = phi i32 [ %s.next.7, %loop.7 ]
+; CHECK-NEXT:   %i.next.7.lcssa = phi i32 [ %i.next.7, %loop.7 ]
+; CHECK-NEXT:   %unroll.done = icmp eq i32 %unroll.remaining, 0
+; CHECK-NEXT:   br i1 %unroll.done, label %exit.loopexit, label %loop.preheader.split.rem
+; CHECK-EMPTY:
+; CHECK-NEXT: loop.preheader.split.rem:                         ; preds = %loop.preheader, %unroll.exit
+; CHECK-NEXT:   %s.start = phi i32 [ 0, %loop.preheader ], [ %s.next.7.lcssa, %unroll.exit ]
+; CHECK-NEXT:   %i.start = phi i32 [ 0, %loop.preheader ], [ %i.next.7.lcssa, %unroll.exit ]
+; CHECK-NEXT:   %kk.rem = mul i32 %k, %k
+; CHECK-NEXT:   %w.rem = add i32 %kk.rem, 1
+; CHECK-NEXT:   br label %loop.rem
+; CHECK-EMPTY:
+; CHECK-NEXT: loop.rem:                                         ; preds = %loop.rem, %loop.preheader.split.rem
+; CHECK-NEXT:   %i.rem = phi i32 [ %i.next.rem, %loop.rem ], [ %i.start, %loop.preheader.split.rem ]
+; CHECK-NEXT:   %s.rem = phi i32 [ %s.next.rem, %loop.rem ], [ %s.start, %loop.preheader.split.rem ]
+; CHECK-NEXT:   %p.rem = getelementptr inbounds i32, i32* %a, i32 %i.rem
+; CHECK-NEXT:   %x.rem = load i32, i32* %p.rem, align 4
+; CHECK-NEXT:   %y.rem = mul i32 %x.rem, %w.rem
+; CHECK-NEXT:   %s.next.rem = add i32 %s.rem, %y.rem
+; CHECK-NEXT:   %i.next.rem = add nsw i32 %i.rem, 1
+; CHECK-NEXT:   %cond.rem = icmp slt i32 %i.next.rem, %n
+; CHECK-NEXT:   br i1 %cond.rem, label %loop.rem, label %exit.loopexit.loopexit, !llvm.loop !0
+; CHECK-EMPTY:
+; CHECK-NEXT: loop.preheader.split:                             ; preds = %loop.preheader
+; CHECK-NEXT:   %kk = mul i32 %k, %k
+; CHECK-NEXT:   %w = add i32 %kk, 1
+; CHECK-NEXT:   %kk.1 = mul i32 %k, %k
+; CHECK-NEXT:   %w.1 = add i32 %kk.1, 1
+; CHECK-NEXT:   %kk.2 = mul i32 %k, %k
+; CHECK-NEXT:   %w.2 = add i32 %kk.2, 1
+; CHECK-NEXT:   %kk.3 = mul i32 %k, %k
+; CHECK-NEXT:   %w.3 = add i32 %kk.3, 1
+; CHECK-NEXT:   %kk.4 = mul i32 %k, %k
+; CHECK-NEXT:   %w.4 = add i32 %kk.4, 1
+; CHECK-NEXT:   %kk.5 = mul i32 %k, %k
+; CHECK-NEXT:   %w.5 = add i32 %kk.5, 1
+; CHECK-NEXT:   %kk.6 = mul i32 %k, %k
+; CHECK-NEXT:   %w.6 = add i32 %kk.6, 1
+; CHECK-NEXT:   %kk.7 = mul i32 %k, %k
+; CHECK-NEXT:   %w.7 = add i32 %kk.7, 1
+; CHECK-NEXT:   br label %loop
+; CHECK-EMPTY:
+; CHECK-NEXT: loop:                                             ; preds = %loop.7, %loop.preheader.split
+; CHECK-NEXT:   %unroll.niter = phi i32 [ 0, %loop.preheader.split ], [ %unroll.niter.next, %loop.7 ]
+; CHECK-NEXT:   %i = phi i32 [ %i.next.7, %loop.7 ], [ 0, %loop.preheader.split ]
+; CHECK-NEXT:   %s = phi i32 [ %s.next.7, %loop.7 ], [ 0, %loop.preheader.split ]
+; CHECK-NEXT:   %p = getelementptr inbounds i32, i32* %a, i32 %i
+; CHECK-NEXT:   %x = load i32, i32* %p, align 4
+; CHECK-NEXT:   %y = mul i32 %x, %w
+; CHECK-NEXT:   %s.next = add i32 %s, %y
+; CHECK-NEXT:   %i.next = add nsw i32 %i, 1
+; CHECK-NEXT:   br label %loop.1
+; CHECK-EMPTY:
+; CHECK-NEXT: exit.loopexit.loopexit:                           ; preds = %loop.rem
+; CHECK-NEXT:   %s.next.lcssa.ph = phi i32 [ %s.next.rem, %loop.rem ]
+; CHECK-NEXT:   br label %exit.loopexit
+; CHECK-EMPTY:
+; CHECK-NEXT: exit.loopexit:                                    ; preds = %exit.loopexit.loopexit, %unroll.exit
+; CHECK-NEXT:   %s.next.lcssa = phi i32 [ %s.next.7.lcssa, %unroll.exit ], [ %s.next.lcssa.ph, %exit.loopexit.loopexit ]
+; CHECK-NEXT:   br label %exit
+; CHECK-EMPTY:
+; CHECK-NEXT: exit:                                             ; preds = %exit.loopexit, %entry
+; CHECK-NEXT:   %r = phi i32 [ 0, %entry ], [ %s.next.lcssa, %exit.loopexit ]
+; CHECK-NEXT:   ret i32 %r
+; CHECK-EMPTY:
+; CHECK-NEXT: loop.1:                                           ; preds = %loop
+; CHECK-NEXT:   %p.1 = getelementptr inbounds i32, i32* %a, i32 %i.next
+; CHECK-NEXT:   %x.1 = load i32, i32* %p.1, align 4
+; CHECK-NEXT:   %y.1 = mul i32 %x.1, %w.1
+; CHECK-NEXT:   %s.next.1 = add i32 %s.next, %y.1
+; CHECK-NEXT:   %i.next.1 = add nsw i32 %i.next, 1
+; CHECK-NEXT:   br label %loop.2
+; CHECK-EMPTY:
+; CHECK-NEXT: loop.2:                                           ; preds = %loop.1
+; CHECK-NEXT:   %p.2 = getelementptr inbounds i32, i32* %a, i32 %i.next.1
+; CHECK-NEXT:   %x.2 = load i32, i32* %p.2, align 4
+; CHECK-NEXT:   %y.2 = mul i32 %x.2, %w.2
+; CHECK-NEXT:   %s.next.2 = add i32 %s.next.1, %y.2
+; CHECK-NEXT:   %i.next.2 = add nsw i32 %i.next.1, 1
+; CHECK-NEXT:   br label %loop.3
+; CHECK-EMPTY:
+; CHECK-NEXT: loop.3:                                           ; preds = %loop.2
+; CHECK-NEXT:   %p.3 = getelementptr inbounds i32, i32* %a, i32 %i.next.2
+; CHECK-NEXT:   %x.3 = load i32, i32* %p.3, align 4
+; CHECK-NEXT:   %y.3 = mul i32 %x.3, %w.3
+; CHECK-NEXT:   %s.next.3 = add i32 %s.next.2, %y.3
+; CHECK-NEXT:   %i.next.3 = add nsw i32 %i.next.2, 1
+; CHECK-NEXT:   br label %loop.4
+; CHECK-EMPTY:
+; CHECK-NEXT: loop.4:                                           ; preds = %loop.3
+; CHECK-NEXT:   %p.4 = getelementptr inbounds i32, i32* %a, i32 %i.next.3
+; CHECK-NEXT:   %x.4 = load i32, i32* %p.4, align 4
+; CHECK-NEXT:   %y.4 = mul i32 %x.4, %w.4
+; CHECK-NEXT:   %s.next.4 = add i32 %s.next.3, %y.4
+; CHECK-NEXT:   %i.next.4 = add nsw i32 %i.next.3, 1
+; CHECK-NEXT:   br label %loop.5
+; CHECK-EMPTY:
+; CHECK-NEXT: loop.5:                                           ; preds = %loop.4
+; CHECK-NEXT:   %p.5 = getelementptr inbounds i32, i32* %a, i32 %i.next.4
+; CHECK-NEXT:   %x.5 = load i32, i32* %p.5, align 4
+; CHECK-NEXT:   %y.5 = mul i32 %x.5, %w.5
+; CHECK-NEXT:   %s.next.5 = add i32 %s.next.4, %y.5
+; CHECK-NEXT:   %i.next.5 = add nsw i32 %i.next.4, 1
+; CHECK-NEXT:   br label %loop.6
+; CHECK-EMPTY:
+; CHECK-NEXT: loop.6:                                           ; preds = %loop.5
+; CHECK-NEXT:   %p.6 = getelementptr inbounds i32, i32* %a, i32 %i.next.5
+; CHECK-NEXT:   %x.6 = load i32, i32* %p.6, align 4
+; CHECK-NEXT:   %y.6 = mul i32 %x.6, %w.6
+; CHECK-NEXT:   %s.next.6 = add i32 %s.next.5, %y.6
+; CHECK-NEXT:   %i.next.6 = add nsw i32 %i.next.5, 1
+; CHECK-NEXT:   br label %loop.7
+; CHECK-EMPTY:
+; CHECK-NEXT: loop.7:                                           ; preds = %loop.6
+; CHECK-NEXT:   %p.7 = getelementptr inbounds i32, i32* %a, i32 %i.next.6
+; CHECK-NEXT:   %x.7 = load i32, i32* %p.7, align 4
+; CHECK-NEXT:   %y.7 = mul i32 %x.7, %w.7
+; CHECK-NEXT:   %s.next.7 = add i32 %s.next.6, %y.7
+; CHECK-NEXT:   %i.next.7 = add nsw i32 %i.next.6, 1
+; CHECK-NEXT:   %unroll.niter.next = add i32 %unroll.niter, 1
+; CHECK-NEXT:   %unroll.more = icmp ult i32 %unroll.niter.next, %unroll.iters
+; CHECK-NEXT:   br i1 %unroll.more, label %loop, label %unroll.exit, !llvm.loop !2
+define i32 @scale(i32* %a, i32 %n, i32 %k) {
+entry:
+  %empty = icmp sle i32 %n, 0
+  br i1 %empty, label %exit, label %loop
+
+loop:
+  %i = phi i32 [ 0, %entry ], [ %i.next, %loop ]
+  %s = phi i32 [ 0, %entry ], [ %s.next, %loop ]
+  %kk = mul i32 %k, %k
+  %w = add i32 %kk, 1
+  %p = getelementptr inbounds i32, i32* %a, i32 %i
+  %x = load i32, i32* %p
+  %y = mul i32 %x, %w
+  %s.next = add i32 %s, %y
+  %i.next = add nsw i32 %i, 1
+  %cond = icmp slt i32 %i.next, %n
+  br i1 %cond, label %loop, label %exit
+
+exit:
+  %r = phi i32 [ 0, %entry ], [ %s.next, %loop ]
+  ret i32 %r
+}
+
+define i32 @main() {
+entry:
+  %a = getelementptr [16 x i32], [16 x i32]* @a, i32 0, i32 0
+  %f = getelementptr [4 x i8], [4 x i8]* @.fmt, i32 0, i32 0
+  br label %print
+
+print:
+  %n = phi i32 [ 0, %entry ], [ %n.next, %print ]
+  %s = call i32 @scale(i32* %a, i32 %n, i32 %n)
+  call i32 (i8*, ...) @printf(i8* %f, i32 %s)
+  %n.next = add i32 %n, 1
+  %c = icmp sle i32 %n.next, 16
+  br i1 %c, label %print, label %done
+
+done:
+  %nl = getelementptr [2 x i8], [2 x i8]* @.nl, i32 0, i32 0
+  call i32 (i8*, ...) @printf(i8* %nl)
+  ret i32 0
+}
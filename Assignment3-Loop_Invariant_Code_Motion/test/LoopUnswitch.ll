@@ -0,0 +1,283 @@
+; The CFG simplification folds the branches on constants that the unswitching
+; leaves in each version of the loop.
+; RUN: opt -S -load %dylibdir/libLICM.so -loop-unswitching -simplifycfg %s \
+; RUN:     -o %basename_t 2>&1 | FileCheck --match-full-lines --check-prefix=REPORT %s
+; REPORT: Unswitched Conditions (update, loop): 2
+; REPORT-NEXT: Code Size Growth (update, loop): 63
+; REPORT-NEXT: Unswitched Conditions (update, loop.us): 1
+; REPORT-NEXT: Code Size Growth (update, loop.us): 42
+; REPORT-NEXT: Unswitched Conditions (wide, loop): 1
+; REPORT-NEXT: Code Size Growth (wide, loop): 28
+; RUN: FileCheck --match-full-lines %s --input-file=%basename_t
+; RUN: llc %basename_t -o %basename_t.s
+; RUN: clang %basename_t.s -o %basename_t.exe
+; RUN: ./%basename_t.exe | FileCheck --match-full-lines --check-prefix=CORRECTNESS %s
+; CORRECTNESS: -6,-2,-8,-2,-10,-18,-4,-12,
+
+; The dynamic branch counts before and after the unswitching:
+; RUN: opt -load %dylibdir/libLICM.so -dynamic-inst-count %s | \
+; RUN:     llc -o %basename_t.before.s
+; RUN: clang %basename_t.before.s -o %basename_t.before.exe
+; RUN: ./%basename_t.before.exe | FileCheck --match-full-lines --check-prefix=BEFORE %s
+; BEFORE: Dynamic Branches: 80
+; RUN: opt -load %dylibdir/libLICM.so -dynamic-inst-count %basename_t | \
+; RUN:     llc -o %basename_t.after.s
+; RUN: clang %basename_t.after.s -o %basename_t.after.exe
+; RUN: ./%basename_t.after.exe | FileCheck --match-full-lines --check-prefix=AFTER %s
+; AFTER: Dynamic Branches: 38
+
+@.fmt = private constant [4 x i8] c"%d,\00"
+@.nl = private constant [2 x i8] c"\0A\00"
+@x = global [8 x i32] [i32 3, i32 1, i32 4, i32 1, i32 5, i32 9, i32 2, i32 6]
+@y = global [8 x i32] zeroinitializer
+
+declare i32 @printf(i8*, ...)
+
+; The flag and the operation are the same in every iteration, so that each
+; of their six combinations gets a version of the loop without branches.
+define void @update(i32* noalias %y, i32* noalias %x, i32 %n, i1 %add,
+                    i32 %op) {
+; CHECK-LABEL: define void @update(i32* noalias %y, i32* noalias %x, i32 %n, i1 %add, i32 %op) {
+; CHECK-NEXT: entry:
+; CHECK-NEXT:   %add.fr = freeze i1 %add
+; CHECK-NEXT:   br i1 %add.fr, label %entry.split, label %entry.split.us
+; CHECK-EMPTY:
+; CHECK-NEXT: entry.split.us:                                   ; preds = %entry
+; CHECK-NEXT:   %op.fr66 = freeze i32 %op
+; CHECK-NEXT:   switch i32 %op.fr66, label %loop.us.us46 [
+; CHECK-NEXT:     i32 0, label %loop.us
+; CHECK-NEXT:     i32 1, label %loop.us.us
+; CHECK-NEXT:   ]
+; CHECK-EMPTY:
+; CHECK-NEXT: loop.us.us:                                       ; preds = %entry.split.us, %loop.us.us
+; CHECK-NEXT:   %i.us.us = phi i32 [ %i.next.us.us, %loop.us.us ], [ 0, %entry.split.us ]
+; CHECK-NEXT:   %px.us.us = getelementptr inbounds i32, i32* %x, i32 %i.us.us
+; CHECK-NEXT:   %py.us.us = getelementptr inbounds i32, i32* %y, i32 %i.us.us
+; CHECK-NEXT:   %vx.us.us = load i32, i32* %px.us.us, align 4
+; CHECK-NEXT:   %vy.us.us = load i32, i32* %py.us.us, align 4
+; CHECK-NEXT:   %diff.us.us = sub i32 %vy.us.us, %vx.us.us
+; CHECK-NEXT:   %neg.us.us = sub i32 0, %diff.us.us
+; CHECK-NEXT:   store i32 %neg.us.us, i32* %py.us.us, align 4
+; CHECK-NEXT:   %i.next.us.us = add i32 %i.us.us, 1
+; CHECK-NEXT:   %cond.us.us = icmp slt i32 %i.next.us.us, %n
+; CHECK-NEXT:   br i1 %cond.us.us, label %loop.us.us, label %exit
+; CHECK-EMPTY:
+; CHECK-NEXT: loop.us.us46:                                     ; preds = %entry.split.us, %loop.us.us46
+; CHECK-NEXT:   %i.us.us47 = phi i32 [ %i.next.us.us64, %loop.us.us46 ], [ 0, %entry.split.us ]
+; CHECK-NEXT:   %px.us.us48 = getelementptr inbounds i32, i32* %x, i32 %i.us.us47
+; CHECK-NEXT:   %py.us.us49 = getelementptr inbounds i32, i32* %y, i32 %i.us.us47
+; CHECK-NEXT:   %vx.us.us50 = load i32, i32* %px.us.us48, align 4
+; CHECK-NEXT:   %vy.us.us51 = load i32, i32* %py.us.us49, align 4
+; CHECK-NEXT:   %diff.us.us53 = sub i32 %vy.us.us51, %vx.us.us50
+; CHECK-NEXT:   store i32 %diff.us.us53, i32* %py.us.us49, align 4
+; CHECK-NEXT:   %i.next.us.us64 = add i32 %i.us.us47, 1
+; CHECK-NEXT:   %cond.us.us65 = icmp slt i32 %i.next.us.us64, %n
+; CHECK-NEXT:   br i1 %cond.us.us65, label %loop.us.us46, label %exit
+; CHECK-EMPTY:
+; CHECK-NEXT: loop.us:                                          ; preds = %entry.split.us, %loop.us
+; CHECK-NEXT:   %i.us = phi i32 [ %i.next.us, %loop.us ], [ 0, %entry.split.us ]
+; CHECK-NEXT:   %px.us = getelementptr inbounds i32, i32* %x, i32 %i.us
+; CHECK-NEXT:   %py.us = getelementptr inbounds i32, i32* %y, i32 %i.us
+; CHECK-NEXT:   %vx.us = load i32, i32* %px.us, align 4
+; CHECK-NEXT:   %vy.us = load i32, i32* %py.us, align 4
+; CHECK-NEXT:   %diff.us = sub i32 %vy.us, %vx.us
+; CHECK-NEXT:   %twice.us = shl i32 %diff.us, 1
+; CHECK-NEXT:   store i32 %twice.us, i32* %py.us, align 4
+; CHECK-NEXT:   %i.next.us = add i32 %i.us, 1
+; CHECK-NEXT:   %cond.us = icmp slt i32 %i.next.us, %n
+; CHECK-NEXT:   br i1 %cond.us, label %loop.us, label %exit
+; CHECK-EMPTY:
+; CHECK-NEXT: entry.split:                                      ; preds = %entry
+; CHECK-NEXT:   %op.fr = freeze i32 %op
+; CHECK-NEXT:   switch i32 %op.fr, label %loop.us23 [
+; CHECK-NEXT:     i32 0, label %loop
+; CHECK-NEXT:     i32 1, label %loop.us2
+; CHECK-NEXT:   ]
+; CHECK-EMPTY:
+; CHECK-NEXT: loop.us2:                                         ; preds = %entry.split, %loop.us2
+; CHECK-NEXT:   %i.us3 = phi i32 [ %i.next.us20, %loop.us2 ], [ 0, %entry.split ]
+; CHECK-NEXT:   %px.us4 = getelementptr inbounds i32, i32* %x, i32 %i.us3
+; CHECK-NEXT:   %py.us5 = getelementptr inbounds i32, i32* %y, i32 %i.us3
+; CHECK-NEXT:   %vx.us6 = load i32, i32* %px.us4, align 4
+; CHECK-NEXT:   %vy.us7 = load i32, i32* %py.us5, align 4
+; CHECK-NEXT:   %sum.us11 = add i32 %vy.us7, %vx.us6
+; CHECK-NEXT:   %neg.us15 = sub i32 0, %sum.us11
+; CHECK-NEXT:   store i32 %neg.us15, i32* %py.us5, align 4
+; CHECK-NEXT:   %i.next.us20 = add i32 %i.us3, 1
+; CHECK-NEXT:   %cond.us21 = icmp slt i32 %i.next.us20, %n
+; CHECK-NEXT:   br i1 %cond.us21, label %loop.us2, label %exit
+; CHECK-EMPTY:
+; CHECK-NEXT: loop.us23:                                        ; preds = %entry.split, %loop.us23
+; CHECK-NEXT:   %i.us24 = phi i32 [ %i.next.us41, %loop.us23 ], [ 0, %entry.split ]
+; CHECK-NEXT:   %px.us25 = getelementptr inbounds i32, i32* %x, i32 %i.us24
+; CHECK-NEXT:   %py.us26 = getelementptr inbounds i32, i32* %y, i32 %i.us24
+; CHECK-NEXT:   %vx.us27 = load i32, i32* %px.us25, align 4
+; CHECK-NEXT:   %vy.us28 = load i32, i32* %py.us26, align 4
+; CHECK-NEXT:   %sum.us32 = add i32 %vy.us28, %vx.us27
+; CHECK-NEXT:   store i32 %sum.us32, i32* %py.us26, align 4
+; CHECK-NEXT:   %i.next.us41 = add i32 %i.us24, 1
+; CHECK-NEXT:   %cond.us42 = icmp slt i32 %i.next.us41, %n
+; CHECK-NEXT:   br i1 %cond.us42, label %loop.us23, label %exit
+; CHECK-EMPTY:
+; CHECK-NEXT: loop:                                             ; preds = %entry.split, %loop
+; CHECK-NEXT:   %i = phi i32 [ %i.next, %loop ], [ 0, %entry.split ]
+; CHECK-NEXT:   %px = getelementptr inbounds i32, i32* %x, i32 %i
+; CHECK-NEXT:   %py = getelementptr inbounds i32, i32* %y, i32 %i
+; CHECK-NEXT:   %vx = load i32, i32* %px, align 4
+; CHECK-NEXT:   %vy = load i32, i32* %py, align 4
+; CHECK-NEXT:   %sum = add i32 %vy, %vx
+; CHECK-NEXT:   %twice = shl i32 %sum, 1
+; CHECK-NEXT:   store i32 %twice, i32* %py, align 4
+; CHECK-NEXT:   %i.next = add i32 %i, 1
+; CHECK-NEXT:   %cond = icmp slt i32 %i.next, %n
+; CHECK-NEXT:   br i1 %cond, label %loop, label %exit
+; CHECK-EMPTY:
+; CHECK-NEXT: exit:                                             ; preds = %loop.us, %loop.us.us, %loop.us.us46, %loop, %loop.us2, %loop.us23
+; CHECK-NEXT:   ret void
+entry:
+  br label %loop
+
+loop:
+  %i = phi i32 [ 0, %entry ], [ %i.next, %latch ]
+  %px = getelementptr inbounds i32, i32* %x, i32 %i
+  %py = getelementptr inbounds i32, i32* %y, i32 %i
+  %vx = load i32, i32* %px
+  %vy = load i32, i32* %py
+  br i1 %add, label %plus, label %minus
+
+plus:
+  %sum = add i32 %vy, %vx
+  br label %select
+
+minus:
+  %diff = sub i32 %vy, %vx
+  br label %select
+
+select:
+  %v = phi i32 [ %sum, %plus ], [ %diff, %minus ]
+  switch i32 %op, label %latch [
+    i32 0, label %double
+    i32 1, label %negate
+  ]
+
+double:
+  %twice = shl i32 %v, 1
+  br label %latch
+
+negate:
+  %neg = sub i32 0, %v
+  br label %latch
+
+latch:
+  %r = phi i32 [ %v, %select ], [ %twice, %double ], [ %neg, %negate ]
+  store i32 %r, i32* %py
+  %i.next = add i32 %i, 1
+  %cond = icmp slt i32 %i.next, %n
+  br i1 %cond, label %loop, label %exit
+
+exit:
+  ret void
+}
+
+; The value for the default destination is searched among those of a switch
+; condition wider than 64 bits.
+define i32 @wide(i32* %a, i32 %n, i128 %op) {
+; CHECK-LABEL: define i32 @wide(i32* %a, i32 %n, i128 %op) {
+; CHECK-NEXT: entry:
+; CHECK-NEXT:   %op.fr = freeze i128 %op
+; CHECK-NEXT:   switch i128 %op.fr, label %loop.us2 [
+; CHECK-NEXT:     i128 0, label %loop
+; CHECK-NEXT:     i128 1, label %loop.us
+; CHECK-NEXT:   ]
+; CHECK-EMPTY:
+; CHECK-NEXT: loop.us:                                          ; preds = %entry, %loop.us
+; CHECK-NEXT:   %i.us = phi i32 [ %i.next.us, %loop.us ], [ 0, %entry ]
+; CHECK-NEXT:   %s.us = phi i32 [ %s.next.us, %loop.us ], [ 0, %entry ]
+; CHECK-NEXT:   %p.us = getelementptr inbounds i32, i32* %a, i32 %i.us
+; CHECK-NEXT:   %x.us = load i32, i32* %p.us, align 4
+; CHECK-NEXT:   %g.us = sub i32 0, %x.us
+; CHECK-NEXT:   %s.next.us = add i32 %s.us, %g.us
+; CHECK-NEXT:   %i.next.us = add nsw i32 %i.us, 1
+; CHECK-NEXT:   %cond.us = icmp slt i32 %i.next.us, %n
+; CHECK-NEXT:   br i1 %cond.us, label %loop.us, label %exit
+; CHECK-EMPTY:
+; CHECK-NEXT: loop.us2:                                         ; preds = %entry, %loop.us2
+; CHECK-NEXT:   %i.us3 = phi i32 [ %i.next.us14, %loop.us2 ], [ 0, %entry ]
+; CHECK-NEXT:   %s.us4 = phi i32 [ %s.next.us13, %loop.us2 ], [ 0, %entry ]
+; CHECK-NEXT:   %p.us5 = getelementptr inbounds i32, i32* %a, i32 %i.us3
+; CHECK-NEXT:   %x.us6 = load i32, i32* %p.us5, align 4
+; CHECK-NEXT:   %s.next.us13 = add i32 %s.us4, %x.us6
+; CHECK-NEXT:   %i.next.us14 = add nsw i32 %i.us3, 1
+; CHECK-NEXT:   %cond.us15 = icmp slt i32 %i.next.us14, %n
+; CHECK-NEXT:   br i1 %cond.us15, label %loop.us2, label %exit
+; CHECK-EMPTY:
+; CHECK-NEXT: loop:                                             ; preds = %entry, %loop
+; CHECK-NEXT:   %i = phi i32 [ %i.next, %loop ], [ 0, %entry ]
+; CHECK-NEXT:   %s = phi i32 [ %s.next, %loop ], [ 0, %entry ]
+; CHECK-NEXT:   %p = getelementptr inbounds i32, i32* %a, i32 %i
+; CHECK-NEXT:   %x = load i32, i32* %p, align 4
+; CHECK-NEXT:   %d = shl i32 %x, 1
+; CHECK-NEXT:   %s.next = add i32 %s, %d
+; CHECK-NEXT:   %i.next = add nsw i32 %i, 1
+; CHECK-NEXT:   %cond = icmp slt i32 %i.next, %n
+; CHECK-NEXT:   br i1 %cond, label %loop, label %exit
+; CHECK-EMPTY:
+; CHECK-NEXT: exit:                                             ; preds = %loop.us2, %loop.us, %loop
+; CHECK-NEXT:   %s.next.lcssa = phi i32 [ %s.next, %loop ], [ %s.next.us, %loop.us ], [ %s.next.us13, %loop.us2 ]
+; CHECK-NEXT:   ret i32 %s.next.lcssa
+entry:
+  br label %loop
+
+loop:
+  %i = phi i32 [ 0, %entry ], [ %i.next, %latch ]
+  %s = phi i32 [ 0, %entry ], [ %s.next, %latch ]
+  %p = getelementptr inbounds i32, i32* %a, i32 %i
+  %x = load i32, i32* %p
+  switch i128 %op, label %latch [
+    i128 0, label %double
+    i128 1, label %negate
+  ]
+
+double:
+  %d = shl i32 %x, 1
+  br label %latch
+
+negate:
+  %g = sub i32 0, %x
+  br label %latch
+
+latch:
+  %v = phi i32 [ %x, %loop ], [ %d, %double ], [ %g, %negate ]
+  %s.next = add i32 %s, %v
+  %i.next = add nsw i32 %i, 1
+  %cond = icmp slt i32 %i.next, %n
+  br i1 %cond, label %loop, label %exit
+
+exit:
+  ret i32 %s.next
+}
+
+define i32 @main() {
+entry:
+  %y = getelementptr [8 x i32], [8 x i32]* @y, i32 0, i32 0
+  %x = getelementptr [8 x i32], [8 x i32]* @x, i32 0, i32 0
+  call void @update(i32* %y, i32* %x, i32 8, i1 true, i32 0)
+  call void @update(i32* %y, i32* %x, i32 8, i1 false, i32 1)
+  call void @update(i32* %y, i32* %x, i32 8, i1 false, i32 2)
+  br label %print
+
+print:
+  %i = phi i32 [ 0, %entry ], [ %i.next, %print ]
+  %p = getelementptr inbounds i32, i32* %y, i32 %i
+  %v = load i32, i32* %p
+  %f = getelementptr [4 x i8], [4 x i8]* @.fmt, i32 0, i32 0
+  call i32 (i8*, ...) @printf(i8* %f, i32 %v)
+  %i.next = add i32 %i, 1
+  %c = icmp slt i32 %i.next, 8
+  br i1 %c, label %print, label %done
+
+done:
+  %nl = getelementptr [2 x i8], [2 x i8]* @.nl, i32 0, i32 0
+  call i32 (i8*, ...) @printf(i8* %nl)
+  ret i32 0
+}
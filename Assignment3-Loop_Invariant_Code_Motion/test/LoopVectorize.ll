@@ -0,0 +1,353 @@
+; RUN: opt -S -load %dylibdir/libLICM.so -loop-vectorization %s \
+; RUN:     -o %basename_t 2>&1 | FileCheck --match-full-lines --check-prefix=REPORT %s
+; REPORT: Vectorization Factor (add, loop): 4
+; REPORT-NEXT: Runtime Overlap Checks (add, loop): 0
+; REPORT-NEXT: Vectorization Factor (scale, loop): 4
+; REPORT-NEXT: Runtime Overlap Checks (scale, loop): 1
+; REPORT-NEXT: Vectorization Factor (sum, loop): 4
+; REPORT-NEXT: Runtime Overlap Checks (sum, loop): 0
+; REPORT-NOT: (prefix, loop)
+; RUN: FileCheck --match-full-lines %s --input-file=%basename_t
+; RUN: llc %basename_t -o %basename_t.s
+; RUN: clang %basename_t.s -o %basename_t.exe
+; RUN: ./%basename_t.exe | FileCheck --match-full-lines --check-prefix=CORRECTNESS %s
+; CORRECTNESS: 4,5,5,6,14,11,8,11,8,8,13,17,16,16,12,5,5,11,0,
+; CORRECTNESS-NEXT: 9,4,14,6,19,32,12,25,23,18,25,35,39,34,41,24,22,26,42,
+; CORRECTNESS-NEXT: 3,9,28,86,261,787,2366,6,5,3,5,8,9,7,9,3,2,3,8,
+; CORRECTNESS-NEXT: 3608,9,13,27,33,52,84,96,121,144,162,187,222,261,295,336,360,382,408,450,
+
+; The dynamic instruction counts before and after the vectorization:
+; RUN: opt -load %dylibdir/libLICM.so -dynamic-inst-count %s | \
+; RUN:     llc -o %basename_t.before.s
+; RUN: clang %basename_t.before.s -o %basename_t.before.exe
+; RUN: ./%basename_t.before.exe | FileCheck --match-full-lines --check-prefix=BEFORE %s
+; BEFORE: Dynamic Instructions: 1247
+; RUN: opt -load %dylibdir/libLICM.so -dynamic-inst-count %basename_t | \
+; RUN:     llc -o %basename_t.after.s
+; RUN: clang %basename_t.after.s -o %basename_t.after.exe
+; RUN: ./%basename_t.after.exe | FileCheck --match-full-lines --check-prefix=AFTER %s
+; AFTER: Dynamic Instructions: 1017
+
+@.fmt = private constant [4 x i8] c"%d,\00"
+@.nl = private constant [2 x i8] c"\0A\00"
+@x = global [19 x i32] [i32 3, i32 1, i32 4, i32 1, i32 5, i32 9, i32 2,
+                        i32 6, i32 5, i32 3, i32 5, i32 8, i32 9, i32 7,
+                        i32 9, i32 3, i32 2, i32 3, i32 8]
+@y = global [19 x i32] zeroinitializer
+
+declare i32 @printf(i8*, ...)
+
+; Alias analysis tells the arrays apart.
+; CHECK-LABEL: define void @add(i32* noalias %a, i32* noalias %b, i32* noalias %c, i64 %n) {
+; CHECK-NEXT: entry:
+; CHECK-NEXT:   %umax = call i64 @llvm.umax.i64(i64 %n, i64 1)
+; CHECK-NEXT:   %vec.min.iters = icmp ult i64 %umax, 4
+; CHECK-NEXT:   br i1 %vec.min.iters, label %scalar.ph, label %vector.ph
+; CHECK-EMPTY:
+; CHECK-NEXT: vector.ph:                                        ; preds = %entry
+; CHECK-NEXT:   %n.vec = and i64 %umax, -4
+; CHECK-NEXT:   br label %vector.body
+; CHECK-EMPTY:
+; CHECK-NEXT: vector.body:                                      ; preds = %vector.body, %vector.ph
+; CHECK-NEXT:   %index = phi i64 [ 0, %vector.ph ], [ %index.next, %vector.body ]
+; CHECK-NEXT:   %scevgep = getelementptr i32, i32* %b, i64 %index
+; CHECK-NEXT:   %0 = bitcast i32* %scevgep to <4 x i32>*
+; CHECK-NEXT:   %vb.vec = load <4 x i32>, <4 x i32>* %0, align 4
+; CHECK-NEXT:   %scevgep1 = getelementptr i32, i32* %c, i64 %index
+; CHECK-NEXT:   %1 = bitcast i32* %scevgep1 to <4 x i32>*
+; CHECK-NEXT:   %vc.vec = load <4 x i32>, <4 x i32>* %1, align 4
+; CHECK-NEXT:   %sum.vec = add nsw <4 x i32> %vb.vec, %vc.vec
+; CHECK-NEXT:   %scevgep2 = getelementptr i32, i32* %a, i64 %index
+; CHECK-NEXT:   %2 = bitcast i32* %scevgep2 to <4 x i32>*
+; CHECK-NEXT:   store <4 x i32> %sum.vec, <4 x i32>* %2, align 4
+; CHECK-NEXT:   %index.next = add nuw i64 %index, 4
+; CHECK-NEXT:   %vec.done = icmp eq i64 %index.next, %n.vec
+; CHECK-NEXT:   br i1 %vec.done, label %middle.block, label %vector.body, !llvm.loop !0
+; CHECK-EMPTY:
+; CHECK-NEXT: middle.block:                                     ; preds = %vector.body
+; CHECK-NEXT:   %vec.all = icmp eq i64 %umax, %n.vec
+; CHECK-NEXT:   br i1 %vec.all, label %exit, label %scalar.ph
+; CHECK-EMPTY:
+; CHECK-NEXT: scalar.ph:                                        ; preds = %middle.block, %entry
+; CHECK-NEXT:   %i.resume = phi i64 [ 0, %entry ], [ %n.vec, %middle.block ]
+; CHECK-NEXT:   br label %loop
+; CHECK-EMPTY:
+; CHECK-NEXT: loop:                                             ; preds = %loop, %scalar.ph
+; CHECK-NEXT:   %i = phi i64 [ %i.resume, %scalar.ph ], [ %i.next, %loop ]
+; CHECK-NEXT:   %pb = getelementptr inbounds i32, i32* %b, i64 %i
+; CHECK-NEXT:   %pc = getelementptr inbounds i32, i32* %c, i64 %i
+; CHECK-NEXT:   %pa = getelementptr inbounds i32, i32* %a, i64 %i
+; CHECK-NEXT:   %vb = load i32, i32* %pb, align 4
+; CHECK-NEXT:   %vc = load i32, i32* %pc, align 4
+; CHECK-NEXT:   %sum = add nsw i32 %vb, %vc
+; CHECK-NEXT:   store i32 %sum, i32* %pa, align 4
+; CHECK-NEXT:   %i.next = add nuw nsw i64 %i, 1
+; CHECK-NEXT:   %cond = icmp ult i64 %i.next, %n
+; CHECK-NEXT:   br i1 %cond, label %loop, label %exit.loopexit, !llvm.loop !2
+; CHECK-EMPTY:
+; CHECK-NEXT: exit.loopexit:                                    ; preds = %loop
+; CHECK-NEXT:   br label %exit
+; CHECK-EMPTY:
+; CHECK-NEXT: exit:                                             ; preds = %exit.loopexit, %middle.block
+; CHECK-NEXT:   ret void
+define void @add(i32* noalias %a, i32* noalias %b, i32* noalias %c, i64 %n) {
+entry:
+  br label %loop
+
+loop:
+  %i = phi i64 [ 0, %entry ], [ %i.next, %loop ]
+  %pb = getelementptr inbounds i32, i32* %b, i64 %i
+  %pc = getelementptr inbounds i32, i32* %c, i64 %i
+  %pa = getelementptr inbounds i32, i32* %a, i64 %i
+  %vb = load i32, i32* %pb
+  %vc = load i32, i32* %pc
+  %sum = add nsw i32 %vb, %vc
+  store i32 %sum, i32* %pa
+  %i.next = add nuw nsw i64 %i, 1
+  %cond = icmp ult i64 %i.next, %n
+  br i1 %cond, label %loop, label %exit
+
+exit:
+  ret void
+}
+
+; The arrays may overlap, which is checked at runtime.
+; CHECK-LABEL: define void @scale(i32* %a, i32* %b, i32 %n) {
+; CHECK-NEXT: entry:
+; CHECK-NEXT:   %a2 = bitcast i32* %a to i8*
+; CHECK-NEXT:   %b5 = bitcast i32* %b to i8*
+; CHECK-NEXT:   %empty = icmp sle i32 %n, 0
+; CHECK-NEXT:   br i1 %empty, label %exit, label %loop.preheader
+; CHECK-EMPTY:
+; CHECK-NEXT: loop.preheader:                                   ; preds = %entry
+; CHECK-NEXT:   %vec.min.iters = icmp ult i32 %n, 4
+; CHECK-NEXT:   %0 = zext i32 %n to i64
+; CHECK-NEXT:   %scevgep = getelementptr i32, i32* %a, i64 %0
+; CHECK-NEXT:   %scevgep1 = bitcast i32* %scevgep to i8*
+; CHECK-NEXT:   %scevgep3 = getelementptr i32, i32* %b, i64 %0
+; CHECK-NEXT:   %scevgep34 = bitcast i32* %scevgep3 to i8*
+; CHECK-NEXT:   %1 = icmp ult i8* %b5, %scevgep1
+; CHECK-NEXT:   %2 = icmp ult i8* %a2, %scevgep34
+; CHECK-NEXT:   %vec.overlap = and i1 %2, %1
+; CHECK-NEXT:   %vec.skip = or i1 %vec.min.iters, %vec.overlap
+; CHECK-NEXT:   br i1 %vec.skip, label %scalar.ph, label %vector.ph
+; CHECK-EMPTY:
+; CHECK-NEXT: vector.ph:                                        ; preds = %loop.preheader
+; CHECK-NEXT:   %n.vec = and i32 %n, -4
+; CHECK-NEXT:   br label %vector.body
+; CHECK-EMPTY:
+; CHECK-NEXT: vector.body:                                      ; preds = %vector.body, %vector.ph
+; CHECK-NEXT:   %index = phi i32 [ 0, %vector.ph ], [ %index.next, %vector.body ]
+; CHECK-NEXT:   %broadcast.splatinsert = insertelement <4 x i32> poison, i32 %index, i32 0
+; CHECK-NEXT:   %broadcast.splat = shufflevector <4 x i32> %broadcast.splatinsert, <4 x i32> poison, <4 x i32> zeroinitializer
+; CHECK-NEXT:   %i.vec = add <4 x i32> %broadcast.splat, <i32 0, i32 1, i32 2, i32 3>
+; CHECK-NEXT:   %3 = zext i32 %index to i64
+; CHECK-NEXT:   %scevgep6 = getelementptr i32, i32* %a, i64 %3
+; CHECK-NEXT:   %4 = bitcast i32* %scevgep6 to <4 x i32>*
+; CHECK-NEXT:   %va.vec = load <4 x i32>, <4 x i32>* %4, align 4
+; CHECK-NEXT:   %scaled.vec = mul nsw <4 x i32> %va.vec, <i32 3, i32 3, i32 3, i32 3>
+; CHECK-NEXT:   %shifted.vec = add nsw <4 x i32> %scaled.vec, %i.vec
+; CHECK-NEXT:   %scevgep7 = getelementptr i32, i32* %b, i64 %3
+; CHECK-NEXT:   %5 = bitcast i32* %scevgep7 to <4 x i32>*
+; CHECK-NEXT:   store <4 x i32> %shifted.vec, <4 x i32>* %5, align 4
+; CHECK-NEXT:   %index.next = add nuw i32 %index, 4
+; CHECK-NEXT:   %vec.done = icmp eq i32 %index.next, %n.vec
+; CHECK-NEXT:   br i1 %vec.done, label %middle.block, label %vector.body, !llvm.loop !3
+; CHECK-EMPTY:
+; CHECK-NEXT: middle.block:                                     ; preds = %vector.body
+; CHECK-NEXT:   %vec.all = icmp eq i32 %n, %n.vec
+; CHECK-NEXT:   br i1 %vec.all, label %exit.loopexit, label %scalar.ph
+; CHECK-EMPTY:
+; CHECK-NEXT: scalar.ph:                                        ; preds = %middle.block, %loop.preheader
+; CHECK-NEXT:   %i.resume = phi i32 [ 0, %loop.preheader ], [ %n.vec, %middle.block ]
+; CHECK-NEXT:   br label %loop
+; CHECK-EMPTY:
+; CHECK-NEXT: loop:                                             ; preds = %scalar.ph, %loop
+; CHECK-NEXT:   %i = phi i32 [ %i.next, %loop ], [ %i.resume, %scalar.ph ]
+; CHECK-NEXT:   %idx = sext i32 %i to i64
+; CHECK-NEXT:   %pa = getelementptr inbounds i32, i32* %a, i64 %idx
+; CHECK-NEXT:   %pb = getelementptr inbounds i32, i32* %b, i64 %idx
+; CHECK-NEXT:   %va = load i32, i32* %pa, align 4
+; CHECK-NEXT:   %scaled = mul nsw i32 %va, 3
+; CHECK-NEXT:   %shifted = add nsw i32 %scaled, %i
+; CHECK-NEXT:   store i32 %shifted, i32* %pb, align 4
+; CHECK-NEXT:   %i.next = add nsw i32 %i, 1
+; CHECK-NEXT:   %cond = icmp slt i32 %i.next, %n
+; CHECK-NEXT:   br i1 %cond, label %loop, label %exit.loopexit.loopexit, !llvm.loop !4
+; CHECK-EMPTY:
+; CHECK-NEXT: exit.loopexit.loopexit:                           ; preds = %loop
+; CHECK-NEXT:   br label %exit.loopexit
+; CHECK-EMPTY:
+; CHECK-NEXT: exit.loopexit:                                    ; preds = %exit.loopexit.loopexit, %middle.block
+; CHECK-NEXT:   br label %exit
+; CHECK-EMPTY:
+; CHECK-NEXT: exit:                                             ; preds = %exit.loopexit, %entry
+; CHECK-NEXT:   ret void
+define void @scale(i32* %a, i32* %b, i32 %n) {
+entry:
+  %empty = icmp sle i32 %n, 0
+  br i1 %empty, label %exit, label %loop
+
+loop:
+  %i = phi i32 [ 0, %entry ], [ %i.next, %loop ]
+  %idx = sext i32 %i to i64
+  %pa = getelementptr inbounds i32, i32* %a, i64 %idx
+  %pb = getelementptr inbounds i32, i32* %b, i64 %idx
+  %va = load i32, i32* %pa
+  %scaled = mul nsw i32 %va, 3
+  %shifted = add nsw i32 %scaled, %i
+  store i32 %shifted, i32* %pb
+  %i.next = add nsw i32 %i, 1
+  %cond = icmp slt i32 %i.next, %n
+  br i1 %cond, label %loop, label %exit
+
+exit:
+  ret void
+}
+
+; The sum is reduced from the lanes after the loop.
+; CHECK-LABEL: define i32 @sum(i32* %a, i32 %n) {
+; CHECK-NEXT: entry:
+; CHECK-NEXT:   %empty = icmp sle i32 %n, 0
+; CHECK-NEXT:   br i1 %empty, label %exit, label %loop.preheader
+; CHECK-EMPTY:
+; CHECK-NEXT: loop.preheader:                                   ; preds = %entry
+; CHECK-NEXT:   %vec.min.iters = icmp ult i32 %n, 4
+; CHECK-NEXT:   br i1 %vec.min.iters, label %scalar.ph, label %vector.ph
+; CHECK-EMPTY:
+; CHECK-NEXT: vector.ph:                                        ; preds = %loop.preheader
+; CHECK-NEXT:   %n.vec = and i32 %n, -4
+; CHECK-NEXT:   br label %vector.body
+; CHECK-EMPTY:
+; CHECK-NEXT: vector.body:                                      ; preds = %vector.body, %vector.ph
+; CHECK-NEXT:   %index = phi i32 [ 0, %vector.ph ], [ %index.next, %vector.body ]
+; CHECK-NEXT:   %s.vec = phi <4 x i32> [ zeroinitializer, %vector.ph ], [ %s.next.vec, %vector.body ]
+; CHECK-NEXT:   %0 = zext i32 %index to i64
+; CHECK-NEXT:   %scevgep = getelementptr i32, i32* %a, i64 %0
+; CHECK-NEXT:   %1 = bitcast i32* %scevgep to <4 x i32>*
+; CHECK-NEXT:   %x.vec = load <4 x i32>, <4 x i32>* %1, align 4
+; CHECK-NEXT:   %s.next.vec = add <4 x i32> %s.vec, %x.vec
+; CHECK-NEXT:   %index.next = add nuw i32 %index, 4
+; CHECK-NEXT:   %vec.done = icmp eq i32 %index.next, %n.vec
+; CHECK-NEXT:   br i1 %vec.done, label %middle.block, label %vector.body, !llvm.loop !5
+; CHECK-EMPTY:
+; CHECK-NEXT: middle.block:                                     ; preds = %vector.body
+; CHECK-NEXT:   %s.next.vec.lcssa = phi <4 x i32> [ %s.next.vec, %vector.body ]
+; CHECK-NEXT:   %vec.all = icmp eq i32 %n, %n.vec
+; CHECK-NEXT:   %rdx.shuf = shufflevector <4 x i32> %s.next.vec.lcssa, <4 x i32> undef, <4 x i32> <i32 2, i32 3, i32 undef, i32 undef>
+; CHECK-NEXT:   %bin.rdx = add <4 x i32> %s.next.vec.lcssa, %rdx.shuf
+; CHECK-NEXT:   %rdx.shuf1 = shufflevector <4 x i32> %bin.rdx, <4 x i32> undef, <4 x i32> <i32 1, i32 undef, i32 undef, i32 undef>
+; CHECK-NEXT:   %bin.rdx2 = add <4 x i32> %bin.rdx, %rdx.shuf1
+; CHECK-NEXT:   %s.next.reduced = extractelement <4 x i32> %bin.rdx2, i64 0
+; CHECK-NEXT:   br i1 %vec.all, label %exit.loopexit, label %scalar.ph
+; CHECK-EMPTY:
+; CHECK-NEXT: scalar.ph:                                        ; preds = %middle.block, %loop.preheader
+; CHECK-NEXT:   %s.resume = phi i32 [ 0, %loop.preheader ], [ %s.next.reduced, %middle.block ]
+; CHECK-NEXT:   %i.resume = phi i32 [ 0, %loop.preheader ], [ %n.vec, %middle.block ]
+; CHECK-NEXT:   br label %loop
+; CHECK-EMPTY:
+; CHECK-NEXT: loop:                                             ; preds = %scalar.ph, %loop
+; CHECK-NEXT:   %i = phi i32 [ %i.next, %loop ], [ %i.resume, %scalar.ph ]
+; CHECK-NEXT:   %s = phi i32 [ %s.next, %loop ], [ %s.resume, %scalar.ph ]
+; CHECK-NEXT:   %idx = zext i32 %i to i64
+; CHECK-NEXT:   %p = getelementptr inbounds i32, i32* %a, i64 %idx
+; CHECK-NEXT:   %x = load i32, i32* %p, align 4
+; CHECK-NEXT:   %s.next = add nsw i32 %s, %x
+; CHECK-NEXT:   %i.next = add nuw nsw i32 %i, 1
+; CHECK-NEXT:   %cond = icmp ult i32 %i.next, %n
+; CHECK-NEXT:   br i1 %cond, label %loop, label %exit.loopexit.loopexit, !llvm.loop !6
+; CHECK-EMPTY:
+; CHECK-NEXT: exit.loopexit.loopexit:                           ; preds = %loop
+; CHECK-NEXT:   %s.next.lcssa.ph = phi i32 [ %s.next, %loop ]
+; CHECK-NEXT:   br label %exit.loopexit
+; CHECK-EMPTY:
+; CHECK-NEXT: exit.loopexit:                                    ; preds = %exit.loopexit.loopexit, %middle.block
+; CHECK-NEXT:   %s.next.lcssa = phi i32 [ %s.next.reduced, %middle.block ], [ %s.next.lcssa.ph, %exit.loopexit.loopexit ]
+; CHECK-NEXT:   br label %exit
+; CHECK-EMPTY:
+; CHECK-NEXT: exit:                                             ; preds = %exit.loopexit, %entry
+; CHECK-NEXT:   %r = phi i32 [ 0, %entry ], [ %s.next.lcssa, %exit.loopexit ]
+; CHECK-NEXT:   ret i32 %r
+define i32 @sum(i32* %a, i32 %n) {
+entry:
+  %empty = icmp sle i32 %n, 0
+  br i1 %empty, label %exit, label %loop
+
+loop:
+  %i = phi i32 [ 0, %entry ], [ %i.next, %loop ]
+  %s = phi i32 [ 0, %entry ], [ %s.next, %loop ]
+  %idx = zext i32 %i to i64
+  %p = getelementptr inbounds i32, i32* %a, i64 %idx
+  %x = load i32, i32* %p
+  %s.next = add nsw i32 %s, %x
+  %i.next = add nuw nsw i32 %i, 1
+  %cond = icmp ult i32 %i.next, %n
+  br i1 %cond, label %loop, label %exit
+
+exit:
+  %r = phi i32 [ 0, %entry ], [ %s.next, %loop ]
+  ret i32 %r
+}
+
+; Each iteration reads what the previous one writes.
+define void @prefix(i32* %a, i64 %n) {
+entry:
+  br label %loop
+
+loop:
+  %i = phi i64 [ 1, %entry ], [ %i.next, %loop ]
+  %prev = add nsw i64 %i, -1
+  %pp = getelementptr inbounds i32, i32* %a, i64 %prev
+  %p = getelementptr inbounds i32, i32* %a, i64 %i
+  %vp = load i32, i32* %pp
+  %v = load i32, i32* %p
+  %s = add nsw i32 %vp, %v
+  store i32 %s, i32* %p
+  %i.next = add nuw nsw i64 %i, 1
+  %cond = icmp ult i64 %i.next, %n
+  br i1 %cond, label %loop, label %exit
+
+exit:
+  ret void
+}
+
+define void @print(i32* %a, i32 %n) {
+entry:
+  %f = getelementptr [4 x i8], [4 x i8]* @.fmt, i32 0, i32 0
+  br label %loop
+
+loop:
+  %i = phi i32 [ 0, %entry ], [ %i.next, %loop ]
+  %p = getelementptr inbounds i32, i32* %a, i32 %i
+  %v = load i32, i32* %p
+  call i32 (i8*, ...) @printf(i8* %f, i32 %v)
+  %i.next = add i32 %i, 1
+  %cond = icmp slt i32 %i.next, %n
+  br i1 %cond, label %loop, label %exit
+
+exit:
+  %nl = getelementptr [2 x i8], [2 x i8]* @.nl, i32 0, i32 0
+  call i32 (i8*, ...) @printf(i8* %nl)
+  ret void
+}
+
+define i32 @main() {
+entry:
+  %x = getelementptr [19 x i32], [19 x i32]* @x, i32 0, i32 0
+  %x1 = getelementptr [19 x i32], [19 x i32]* @x, i32 0, i32 1
+  %y = getelementptr [19 x i32], [19 x i32]* @y, i32 0, i32 0
+  call void @add(i32* %y, i32* %x, i32* %x1, i64 18)
+  call void @print(i32* %y, i32 19)
+  ; The first call may run vectorized, unlike the second, whose arrays
+  ; overlap.
+  call void @scale(i32* %x, i32* %y, i32 19)
+  call void @print(i32* %y, i32 19)
+  call void @scale(i32* %x, i32* %x1, i32 6)
+  call void @print(i32* %x, i32 19)
+  %s = call i32 @sum(i32* %x, i32 19)
+  %f = getelementptr [4 x i8], [4 x i8]* @.fmt, i32 0, i32 0
+  call i32 (i8*, ...) @printf(i8* %f, i32 %s)
+  call void @prefix(i32* %y, i64 19)
+  call void @print(i32* %y, i32 19)
+  ret i32 0
+}
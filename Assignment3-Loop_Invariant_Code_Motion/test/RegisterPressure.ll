@@ -0,0 +1,71 @@
+; RUN: opt -S -load %dylibdir/libLICM.so \
+; RUN:     -loop-invariant-code-motion -licm-register-budget=9 %s -o %basename_t
+; RUN: FileCheck --match-full-lines %s --input-file=%basename_t
+
+; Hoisting either %xy or %x1 keeps one more value live throughout the loop,
+; which the budget only leaves room for once. %xy executes on every iteration
+; whereas %x1 only executes on some of them, hence %xy is the one hoisted,
+; and %x1 is recomputed in the loop.
+define i32 @pressure(i32* noalias %a, i32 %n, i32 %x, i32 %y) {
+; CHECK-LABEL: define i32 @pressure(i32* noalias %a, i32 %n, i32 %x, i32 %y) {
+; CHECK-NEXT: entry:
+; CHECK-NEXT:   %xy = mul i32 %x, %y
+; CHECK-NEXT:   br label %loop
+; CHECK-EMPTY:
+; CHECK-NEXT: loop:                                             ; preds = %latch, %entry
+; CHECK-NEXT:   %i = phi i32 [ 0, %entry ], [ %i.next, %latch ]
+; CHECK-NEXT:   %sum = phi i32 [ 0, %entry ], [ %sum.next, %latch ]
+; CHECK-NEXT:   %ptr = getelementptr inbounds i32, i32* %a, i32 %i
+; CHECK-NEXT:   %v = load i32, i32* %ptr, align 4
+; CHECK-NEXT:   %vx = add i32 %v, %x
+; CHECK-NEXT:   %vxy = add i32 %vx, %y
+; CHECK-NEXT:   %odd = and i32 %v, 1
+; CHECK-NEXT:   %even = icmp eq i32 %odd, 0
+; CHECK-NEXT:   br i1 %even, label %scale, label %latch
+; CHECK-EMPTY:
+; CHECK-NEXT: scale:                                            ; preds = %loop
+; CHECK-NEXT:   %x1 = add i32 %x, 1
+; CHECK-NEXT:   %u = mul i32 %vxy, %x1
+; CHECK-NEXT:   br label %latch
+; CHECK-EMPTY:
+; CHECK-NEXT: latch:                                            ; preds = %scale, %loop
+; CHECK-NEXT:   %w = phi i32 [ %u, %scale ], [ %vxy, %loop ]
+; CHECK-NEXT:   %t = add i32 %w, %xy
+; CHECK-NEXT:   %sum.next = add i32 %sum, %t
+; CHECK-NEXT:   %i.next = add i32 %i, 1
+; CHECK-NEXT:   %cond = icmp slt i32 %i.next, %n
+; CHECK-NEXT:   br i1 %cond, label %loop, label %exit
+; CHECK-EMPTY:
+; CHECK-NEXT: exit:                                             ; preds = %latch
+; CHECK-NEXT:   ret i32 %sum.next
+entry:
+  br label %loop
+
+loop:
+  %i = phi i32 [ 0, %entry ], [ %i.next, %latch ]
+  %sum = phi i32 [ 0, %entry ], [ %sum.next, %latch ]
+  %ptr = getelementptr inbounds i32, i32* %a, i32 %i
+  %v = load i32, i32* %ptr
+  %vx = add i32 %v, %x
+  %vxy = add i32 %vx, %y
+  %odd = and i32 %v, 1
+  %even = icmp eq i32 %odd, 0
+  br i1 %even, label %scale, label %latch
+
+scale:
+  %x1 = add i32 %x, 1
+  %u = mul i32 %vxy, %x1
+  br label %latch
+
+latch:
+  %w = phi i32 [ %u, %scale ], [ %vxy, %loop ]
+  %xy = mul i32 %x, %y
+  %t = add i32 %w, %xy
+  %sum.next = add i32 %sum, %t
+  %i.next = add i32 %i, 1
+  %cond = icmp slt i32 %i.next, %n
+  br i1 %cond, label %loop, label %exit
+
+exit:
+  ret i32 %sum.next
+}
@@ -0,0 +1,170 @@
+; RUN: opt -S -load %dylibdir/libLICM.so \
+; RUN:     -loop-invariant-code-motion -licm-promote-scalars %s -o %basename_t
+; RUN: FileCheck --match-full-lines %s --input-file=%basename_t
+@g = global i32 0
+
+; The accumulator in @g is promoted to a register, loaded once in the
+; preheader and stored back in the exit block.
+define void @sum(i32* noalias %a, i32 %n) {
+; CHECK-LABEL: define void @sum(i32* noalias %a, i32 %n) {
+; CHECK-NEXT: entry:
+; CHECK-NEXT:   %g.promoted = load i32, i32* @g, align 4
+; CHECK-NEXT:   br label %loop
+; CHECK-EMPTY:
+; CHECK-NEXT: loop:                                             ; preds = %loop, %entry
+; CHECK-NEXT:   %acc1 = phi i32 [ %g.promoted, %entry ], [ %acc.next, %loop ]
+; CHECK-NEXT:   %i = phi i32 [ 0, %entry ], [ %i.next, %loop ]
+; CHECK-NEXT:   %ptr = getelementptr inbounds i32, i32* %a, i32 %i
+; CHECK-NEXT:   %x = load i32, i32* %ptr, align 4
+; CHECK-NEXT:   %acc.next = add i32 %acc1, %x
+; CHECK-NEXT:   %i.next = add i32 %i, 1
+; CHECK-NEXT:   %cond = icmp slt i32 %i.next, %n
+; CHECK-NEXT:   br i1 %cond, label %loop, label %exit
+; CHECK-EMPTY:
+; CHECK-NEXT: exit:                                             ; preds = %loop
+; CHECK-NEXT:   store i32 %acc.next, i32* @g, align 4
+; CHECK-NEXT:   ret void
+entry:
+  br label %loop
+
+loop:
+  %i = phi i32 [ 0, %entry ], [ %i.next, %loop ]
+  %ptr = getelementptr inbounds i32, i32* %a, i32 %i
+  %x = load i32, i32* %ptr
+  %acc = load i32, i32* @g
+  %acc.next = add i32 %acc, %x
+  store i32 %acc.next, i32* @g
+  %i.next = add i32 %i, 1
+  %cond = icmp slt i32 %i.next, %n
+  br i1 %cond, label %loop, label %exit
+
+exit:
+  ret void
+}
+
+; %a may point to @g, hence @g cannot be promoted.
+define void @sum_alias(i32* %a, i32 %n) {
+; CHECK-LABEL: define void @sum_alias(i32* %a, i32 %n) {
+; CHECK-NEXT: entry:
+; CHECK-NEXT:   br label %loop
+; CHECK-EMPTY:
+; CHECK-NEXT: loop:                                             ; preds = %loop, %entry
+; CHECK-NEXT:   %i = phi i32 [ 0, %entry ], [ %i.next, %loop ]
+; CHECK-NEXT:   %ptr = getelementptr inbounds i32, i32* %a, i32 %i
+; CHECK-NEXT:   %x = load i32, i32* %ptr, align 4
+; CHECK-NEXT:   %acc = load i32, i32* @g, align 4
+; CHECK-NEXT:   %acc.next = add i32 %acc, %x
+; CHECK-NEXT:   store i32 %acc.next, i32* @g, align 4
+; CHECK-NEXT:   %i.next = add i32 %i, 1
+; CHECK-NEXT:   %cond = icmp slt i32 %i.next, %n
+; CHECK-NEXT:   br i1 %cond, label %loop, label %exit
+; CHECK-EMPTY:
+; CHECK-NEXT: exit:                                             ; preds = %loop
+; CHECK-NEXT:   ret void
+entry:
+  br label %loop
+
+loop:
+  %i = phi i32 [ 0, %entry ], [ %i.next, %loop ]
+  %ptr = getelementptr inbounds i32, i32* %a, i32 %i
+  %x = load i32, i32* %ptr
+  %acc = load i32, i32* @g
+  %acc.next = add i32 %acc, %x
+  store i32 %acc.next, i32* @g
+  %i.next = add i32 %i, 1
+  %cond = icmp slt i32 %i.next, %n
+  br i1 %cond, label %loop, label %exit
+
+exit:
+  ret void
+}
+
+; The loop does not always write to %p, hence storing to it after the loop
+; could race with other threads.
+define void @max(i32* noalias %a, i32* noalias %p, i32 %n) {
+; CHECK-LABEL: define void @max(i32* noalias %a, i32* noalias %p, i32 %n) {
+; CHECK-NEXT: entry:
+; CHECK-NEXT:   br label %loop
+; CHECK-EMPTY:
+; CHECK-NEXT: loop:                                             ; preds = %latch, %entry
+; CHECK-NEXT:   %i = phi i32 [ 0, %entry ], [ %i.next, %latch ]
+; CHECK-NEXT:   %ptr = getelementptr inbounds i32, i32* %a, i32 %i
+; CHECK-NEXT:   %x = load i32, i32* %ptr, align 4
+; CHECK-NEXT:   %max = load i32, i32* %p, align 4
+; CHECK-NEXT:   %gt = icmp sgt i32 %x, %max
+; CHECK-NEXT:   br i1 %gt, label %update, label %latch
+; CHECK-EMPTY:
+; CHECK-NEXT: update:                                           ; preds = %loop
+; CHECK-NEXT:   store i32 %x, i32* %p, align 4
+; CHECK-NEXT:   br label %latch
+; CHECK-EMPTY:
+; CHECK-NEXT: latch:                                            ; preds = %update, %loop
+; CHECK-NEXT:   %i.next = add i32 %i, 1
+; CHECK-NEXT:   %cond = icmp slt i32 %i.next, %n
+; CHECK-NEXT:   br i1 %cond, label %loop, label %exit
+; CHECK-EMPTY:
+; CHECK-NEXT: exit:                                             ; preds = %latch
+; CHECK-NEXT:   ret void
+entry:
+  br label %loop
+
+loop:
+  %i = phi i32 [ 0, %entry ], [ %i.next, %latch ]
+  %ptr = getelementptr inbounds i32, i32* %a, i32 %i
+  %x = load i32, i32* %ptr
+  %max = load i32, i32* %p
+  %gt = icmp sgt i32 %x, %max
+  br i1 %gt, label %update, label %latch
+
+update:
+  store i32 %x, i32* %p
+  br label %latch
+
+latch:
+  %i.next = add i32 %i, 1
+  %cond = icmp slt i32 %i.next, %n
+  br i1 %cond, label %loop, label %exit
+
+exit:
+  ret void
+}
+
+; The loop only reads from @g, which is loaded once in the preheader and not
+; stored back.
+define i32 @scale(i32* noalias %a, i32 %n) {
+; CHECK-LABEL: define i32 @scale(i32* noalias %a, i32 %n) {
+; CHECK-NEXT: entry:
+; CHECK-NEXT:   %g.promoted = load i32, i32* @g, align 4
+; CHECK-NEXT:   br label %loop
+; CHECK-EMPTY:
+; CHECK-NEXT: loop:                                             ; preds = %loop, %entry
+; CHECK-NEXT:   %i = phi i32 [ 0, %entry ], [ %i.next, %loop ]
+; CHECK-NEXT:   %sum = phi i32 [ 0, %entry ], [ %sum.next, %loop ]
+; CHECK-NEXT:   %ptr = getelementptr inbounds i32, i32* %a, i32 %i
+; CHECK-NEXT:   %x = load i32, i32* %ptr, align 4
+; CHECK-NEXT:   %y = mul i32 %x, %g.promoted
+; CHECK-NEXT:   %sum.next = add i32 %sum, %y
+; CHECK-NEXT:   %i.next = add i32 %i, 1
+; CHECK-NEXT:   %cond = icmp slt i32 %i.next, %n
+; CHECK-NEXT:   br i1 %cond, label %loop, label %exit
+; CHECK-EMPTY:
+; CHECK-NEXT: exit:                                             ; preds = %loop
+; CHECK-NEXT:   ret i32 %sum.next
+entry:
+  br label %loop
+
+loop:
+  %i = phi i32 [ 0, %entry ], [ %i.next, %loop ]
+  %sum = phi i32 [ 0, %entry ], [ %sum.next, %loop ]
+  %ptr = getelementptr inbounds i32, i32* %a, i32 %i
+  %x = load i32, i32* %ptr
+  %factor = load i32, i32* @g
+  %y = mul i32 %x, %factor
+  %sum.next = add i32 %sum, %y
+  %i.next = add i32 %i, 1
+  %cond = icmp slt i32 %i.next, %n
+  br i1 %cond, label %loop, label %exit
+
+exit:
+  ret i32 %sum.next
+}